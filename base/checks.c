@@ -97,6 +97,9 @@ extern int      max_service_check_spread;
 extern int      use_large_installation_tweaks;
 extern int      free_child_process_memory;
 extern int      child_processes_fork_twice;
+extern int      use_check_result_channel;
+
+extern int      check_result_reaper_threads;
 
 extern int      stalking_event_handlers_for_hosts;
 extern int      stalking_event_handlers_for_services;
@@ -129,10 +132,193 @@ extern unsigned long max_debug_file_size;
 extern int      use_embedded_perl;
 #endif
 
+/* OBJECT_QUEUE structure - heap of hosts or services ordered by the time they need to be looked at again */
+typedef struct object_queue_entry_struct {
+	time_t expiration_time;
+	time_t queued_time;
+	void *object;
+	int *queue_index;					/* the object's index into the queue, -1 if not queued */
+} object_queue_entry;
+
+typedef struct object_queue_struct {
+	object_queue_entry *entries;
+	int count;
+	int size;
+	int is_built;
+} object_queue;
+
+#define OBJECT_QUEUE_GROWTH	1024
+
+static object_queue service_freshness_queue = { NULL, 0, 0, FALSE };
+static object_queue host_freshness_queue = { NULL, 0, 0, FALSE };
+
+/* checks that have been started and whose results haven't come in yet, by the time they're considered orphaned */
+static object_queue running_service_checks = { NULL, 0, 0, FALSE };
+static object_queue running_host_checks = { NULL, 0, 0, FALSE };
+
+static time_t get_service_result_expiration_time(service *, int *);
+static time_t get_host_result_expiration_time(host *, int *);
+
+
 /******************************************************************/
 /********************* MISCELLANEOUS FUNCTIONS ********************/
 /******************************************************************/
 
+/* swaps two entries of an object queue */
+static void swap_object_queue_entries(object_queue *queue, int a, int b) {
+	object_queue_entry temp_entry;
+
+	temp_entry = queue->entries[a];
+	queue->entries[a] = queue->entries[b];
+	queue->entries[b] = temp_entry;
+
+	*queue->entries[a].queue_index = a;
+	*queue->entries[b].queue_index = b;
+
+	return;
+}
+
+
+
+/* moves an object queue entry up or down to its place in the heap */
+static void sift_object_queue_entry(object_queue *queue, int x) {
+	int parent = 0;
+	int child = 0;
+
+	while (x > 0) {
+		parent = (x - 1) / 2;
+		if (queue->entries[parent].expiration_time <= queue->entries[x].expiration_time)
+			break;
+		swap_object_queue_entries(queue, x, parent);
+		x = parent;
+	}
+
+	while ((child = (2 * x) + 1) < queue->count) {
+		if (child + 1 < queue->count && queue->entries[child + 1].expiration_time < queue->entries[child].expiration_time)
+			child++;
+		if (queue->entries[x].expiration_time <= queue->entries[child].expiration_time)
+			break;
+		swap_object_queue_entries(queue, x, child);
+		x = child;
+	}
+
+	return;
+}
+
+
+
+/* adds an object to an object queue or moves it to a new expiration time */
+static void set_object_queue_entry(object_queue *queue, void *object, int *queue_index, time_t expiration_time) {
+	object_queue_entry *new_entries = NULL;
+	int x = *queue_index;
+
+	if (x < 0) {
+		if (queue->count == queue->size) {
+			if ((new_entries = (object_queue_entry *)realloc(queue->entries, sizeof(object_queue_entry) * (queue->size + OBJECT_QUEUE_GROWTH))) == NULL)
+				return;
+			queue->entries = new_entries;
+			queue->size += OBJECT_QUEUE_GROWTH;
+		}
+		x = queue->count++;
+		queue->entries[x].object = object;
+		queue->entries[x].queue_index = queue_index;
+		time(&queue->entries[x].queued_time);
+		*queue_index = x;
+	}
+
+	queue->entries[x].expiration_time = expiration_time;
+
+	sift_object_queue_entry(queue, x);
+
+	return;
+}
+
+
+
+/* removes an object from an object queue */
+static void remove_object_queue_entry(object_queue *queue, int *queue_index) {
+	int x = *queue_index;
+
+	if (x < 0)
+		return;
+
+	*queue_index = -1;
+
+	/* fill the gap with the last entry */
+	queue->count--;
+	if (x != queue->count) {
+		queue->entries[x] = queue->entries[queue->count];
+		*queue->entries[x].queue_index = x;
+		sift_object_queue_entry(queue, x);
+	}
+
+	return;
+}
+
+
+
+/* frees an object queue */
+static void free_object_queue(object_queue *queue) {
+
+	my_free(queue->entries);
+	queue->count = 0;
+	queue->size = 0;
+	queue->is_built = FALSE;
+
+	return;
+}
+
+
+
+/* frees the freshness and running check queues (the freshness queues are rebuilt on the next freshness check) */
+void free_check_queues(void) {
+
+	free_object_queue(&service_freshness_queue);
+	free_object_queue(&host_freshness_queue);
+	free_object_queue(&running_service_checks);
+	free_object_queue(&running_host_checks);
+
+	return;
+}
+
+
+
+/* logs how many checks are running and for how long the oldest of them has been running */
+static void log_running_checks(object_queue *queue, char *check_type, time_t current_time) {
+	time_t oldest_time = current_time;
+	int x = 0;
+
+	if (!log_level(DEBUGL_CHECKS, 1))
+		return;
+
+	for (x = 0; x < queue->count; x++) {
+		if (queue->entries[x].queued_time < oldest_time)
+			oldest_time = queue->entries[x].queued_time;
+	}
+
+	log_debug_info(DEBUGL_CHECKS, 1, "%d %s checks running, the oldest one for %lu seconds\n", queue->count, check_type, (unsigned long)(current_time - oldest_time));
+
+	return;
+}
+
+
+
+/* determines the time at which the results of a running service check should have come in (allow 10 minutes slack time) */
+static time_t get_service_check_orphan_time(service *svc) {
+
+	return (time_t)(svc->next_check + svc->latency + service_check_timeout + check_reaper_interval + 600);
+}
+
+
+
+/* determines the time at which the results of a running host check should have come in (allow 10 minutes slack time) */
+static time_t get_host_check_orphan_time(host *hst) {
+
+	return (time_t)(hst->next_check + hst->latency + host_check_timeout + check_reaper_interval + 600);
+}
+
+
+
 /* extract check result */
 static void extract_check_result(FILE *fp, dbuf *checkresult_dbuf) {
 	char output_buffer[MAX_INPUT_BUFFER] = "";
@@ -150,7 +336,7 @@ static void extract_check_result(FILE *fp, dbuf *checkresult_dbuf) {
 }
 
 /* convert a command line to an array of arguments, suitable for exec* functions */
-static int parse_command_line(char *cmd, char *argv[MAX_CMD_ARGS]) {
+int parse_command_line(char *cmd, char *argv[MAX_CMD_ARGS]) {
 	unsigned int argc = 0;
 	char *parsed_cmd;
 
@@ -191,7 +377,7 @@ static int parse_command_line(char *cmd, char *argv[MAX_CMD_ARGS]) {
 
 		if (argc >= MAX_CMD_ARGS - 1) {
 			logit(NSLOG_RUNTIME_WARNING, TRUE, "overlimit args for command %s\n", argv[0]);
-			_exit(STATE_UNKNOWN);
+			return ERROR;
 		} else
 			*(parsed_cmd++) = '\0';
 	}
@@ -230,7 +416,8 @@ static int run_check(char *processed_command, dbuf *checkresult_dbuf) {
 			close(pipefds[1]);
 
 			/* extract command args for execv */
-			parse_command_line(processed_command, argv);
+			if (parse_command_line(processed_command, argv) == ERROR)
+				_exit(STATE_UNKNOWN);
 
 			if (!argv[0]) {
 				logit(NSLOG_RUNTIME_WARNING, TRUE, "plugin command definition empty\n");
@@ -287,92 +474,133 @@ static int run_check(char *processed_command, dbuf *checkresult_dbuf) {
 
 /* reaps host and service check results */
 int reap_check_results(void) {
+	static decoded_check_result *decoded_results = NULL;
+	decoded_check_result *decoded = NULL;
 	check_result *queued_check_result = NULL;
-	service *temp_service = NULL;
-	host *temp_host = NULL;
 	time_t current_time = 0L;
 	time_t reaper_start_time = 0L;
 	int reaped_checks = 0;
+	int batch_size = 0;
+	int max_batch_size = 1;
+	int bail_out = FALSE;
+	register int x = 0;
 
 	log_debug_info(DEBUGL_FUNCTIONS, 0, "reap_check_results() start\n");
 	log_debug_info(DEBUGL_CHECKS, 0, "Starting to reap check results.\n");
 
+	/* collect results from the check workers and the check result channel */
+	reap_check_worker_results();
+	read_check_result_channel();
+
 	/* get the start time */
 	time(&reaper_start_time);
 
 	/* process files in the check result queue */
 	process_check_result_queue(check_result_path);
 
+	/* hand results to the reaper threads in batches, one at a time otherwise */
+	if (check_result_reaper_threads > 0) {
+		if (decoded_results == NULL)
+			decoded_results = (decoded_check_result *)malloc(sizeof(decoded_check_result) * CHECK_RESULT_REAPER_BATCH_SIZE);
+		if (decoded_results != NULL)
+			max_batch_size = CHECK_RESULT_REAPER_BATCH_SIZE;
+	}
+	if (max_batch_size == 1 && decoded_results == NULL)
+		decoded_results = (decoded_check_result *)malloc(sizeof(decoded_check_result));
+	if (decoded_results == NULL)
+		return ERROR;
+
 	/* read all check results that have come in... */
-	while ((queued_check_result = read_check_result())) {
+	while (bail_out == FALSE) {
 
-		reaped_checks++;
+		for (batch_size = 0; batch_size < max_batch_size; batch_size++) {
+			if ((queued_check_result = read_check_result()) == NULL)
+				break;
+			init_decoded_check_result(&decoded_results[batch_size], queued_check_result);
+		}
+		if (batch_size == 0)
+			break;
 
-		log_debug_info(DEBUGL_CHECKS, 2, "Found a check result (#%d) to handle...\n", reaped_checks);
+		/* the reaper threads look up the objects and parse the output in the background */
+		queue_check_results_for_decoding(decoded_results, batch_size);
 
-		/* service check */
-		if (queued_check_result->object_check_type == SERVICE_CHECK) {
+		for (x = 0; x < batch_size; x++) {
 
-			/* make sure the service exists */
-			if ((temp_service = find_service(queued_check_result->host_name, queued_check_result->service_description)) == NULL) {
+			/* wait until this result has been decoded (or decode it ourselves) */
+			decoded = get_decoded_check_result(x);
+			queued_check_result = decoded->cr;
 
-				logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Check result queue contained results for service '%s' on host '%s', but the service could not be found!  Perhaps you forgot to define the service in your config files?\n", queued_check_result->service_description, queued_check_result->host_name);
+			reaped_checks++;
 
-				/* free memory */
-				free_check_result(queued_check_result);
-				my_free(queued_check_result);
+			log_debug_info(DEBUGL_CHECKS, 2, "Found a check result (#%d) to handle...\n", reaped_checks);
 
-				/* TODO - add new service definition automatically */
+			/* service check */
+			if (queued_check_result->object_check_type == SERVICE_CHECK) {
 
-				continue;
-			}
+				/* make sure the service exists */
+				if (decoded->svc == NULL) {
 
-			log_debug_info(DEBUGL_CHECKS, 1, "Handling check result for service '%s' on host '%s'...\n", temp_service->description, temp_service->host_name);
+					logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Check result queue contained results for service '%s' on host '%s', but the service could not be found!  Perhaps you forgot to define the service in your config files?\n", queued_check_result->service_description, queued_check_result->host_name);
 
-			/* process the check result */
-			handle_async_service_check_result(temp_service, queued_check_result);
-		}
+					/* TODO - add new service definition automatically */
+				}
 
-		/* host check */
-		else {
-			if ((temp_host = find_host(queued_check_result->host_name)) == NULL) {
+				else {
+					log_debug_info(DEBUGL_CHECKS, 1, "Handling check result for service '%s' on host '%s'...\n", decoded->svc->description, decoded->svc->host_name);
 
-				/* make sure the host exists */
-				logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Check result queue contained results for host '%s', but the host could not be found!  Perhaps you forgot to define the host in your config files?\n", queued_check_result->host_name);
+					/* process the check result */
+					handle_decoded_service_check_result(decoded->svc, queued_check_result, decoded);
+				}
+			}
 
-				/* free memory */
-				free_check_result(queued_check_result);
-				my_free(queued_check_result);
+			/* host check */
+			else {
 
-				/* TODO - add new host definition automatically */
+				/* make sure the host exists */
+				if (decoded->hst == NULL) {
 
-				continue;
-			}
+					logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Check result queue contained results for host '%s', but the host could not be found!  Perhaps you forgot to define the host in your config files?\n", queued_check_result->host_name);
+
+					/* TODO - add new host definition automatically */
+				}
 
-			log_debug_info(DEBUGL_CHECKS, 1, "Handling check result for host '%s'...\n", temp_host->name);
+				else {
+					log_debug_info(DEBUGL_CHECKS, 1, "Handling check result for host '%s'...\n", decoded->hst->name);
 
-			/* process the check result */
-			handle_async_host_check_result_3x(temp_host, queued_check_result);
-		}
+					/* process the check result */
+					handle_decoded_host_check_result_3x(decoded->hst, queued_check_result, decoded);
+				}
+			}
 
-		log_debug_info(DEBUGL_CHECKS | DEBUGL_IPC, 1, "Deleted check result file '%s'\n", queued_check_result->output_file);
+			/* free allocated memory */
+			free_decoded_check_result(decoded);
 
-		/* free allocated memory */
-		free_check_result(queued_check_result);
-		my_free(queued_check_result);
+			/* break out if we've been here too long (max_check_reaper_time seconds) */
+			time(&current_time);
+			if ((int)(current_time - reaper_start_time) > max_check_reaper_time) {
+				log_debug_info(DEBUGL_CHECKS, 0, "Breaking out of check result reaper: max reaper time exceeded\n");
+				logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Breaking out of check result reaper: max reaper time (%d) exceeded. Reaped %d results, but more checkresults to process. Perhaps check core performance tuning tips?\n", max_check_reaper_time, reaped_checks);
+				bail_out = TRUE;
+				break;
+			}
 
-		/* break out if we've been here too long (max_check_reaper_time seconds) */
-		time(&current_time);
-		if ((int)(current_time - reaper_start_time) > max_check_reaper_time) {
-			log_debug_info(DEBUGL_CHECKS, 0, "Breaking out of check result reaper: max reaper time exceeded\n");
-			logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Breaking out of check result reaper: max reaper time (%d) exceeded. Reaped %d results, but more checkresults to process. Perhaps check core performance tuning tips?\n", max_check_reaper_time, reaped_checks);
-			break;
+			/* bail out if we encountered a signal */
+			if (sigshutdown == TRUE || sigrestart == TRUE) {
+				log_debug_info(DEBUGL_CHECKS, 0, "Breaking out of check result reaper: signal encountered\n");
+				bail_out = TRUE;
+				break;
+			}
 		}
 
-		/* bail out if we encountered a signal */
-		if (sigshutdown == TRUE || sigrestart == TRUE) {
-			log_debug_info(DEBUGL_CHECKS, 0, "Breaking out of check result reaper: signal encountered\n");
-			break;
+		/* make sure the reaper threads are done with this batch */
+		finish_check_result_decoding();
+
+		/* put results we didn't get to back on the list for the next run */
+		for (x++; x < batch_size; x++) {
+			queued_check_result = decoded_results[x].cr;
+			decoded_results[x].cr = NULL;
+			free_decoded_check_result(&decoded_results[x]);
+			add_check_result_to_list(queued_check_result);
 		}
 	}
 
@@ -384,6 +612,91 @@ int reap_check_results(void) {
 
 
 
+/* prepares a check result for decoding */
+void init_decoded_check_result(decoded_check_result *decoded, check_result *cr) {
+
+	decoded->cr = cr;
+	decoded->hst = NULL;
+	decoded->svc = NULL;
+	decoded->output_parsed = FALSE;
+	decoded->short_output = NULL;
+	decoded->long_output = NULL;
+	decoded->perf_data = NULL;
+	decoded->is_decoded = FALSE;
+
+	return;
+}
+
+
+
+/*
+ * does the object independent work on a check result: looks up the
+ * host/service and parses the plugin output, if the result handler
+ * would do so. this runs in the reaper threads, so it must not touch
+ * any object state.
+ */
+int decode_check_result(decoded_check_result *decoded) {
+	check_result *cr = NULL;
+
+	if (decoded == NULL || (cr = decoded->cr) == NULL)
+		return ERROR;
+
+	if (cr->object_check_type == SERVICE_CHECK) {
+		if ((decoded->svc = find_service(cr->host_name, cr->service_description)) == NULL)
+			return ERROR;
+
+		/* output of broken checks is replaced by an error message */
+		if (cr->exited_ok == FALSE || cr->return_code < 0 || cr->return_code > 3)
+			return OK;
+	} else {
+		if ((decoded->hst = find_host(cr->host_name)) == NULL)
+			return ERROR;
+	}
+
+	/* parse check output to get: (1) short output, (2) long output, (3) perf data */
+	parse_check_output(cr->output, &decoded->short_output, &decoded->long_output, &decoded->perf_data, TRUE, TRUE);
+	decoded->output_parsed = TRUE;
+
+	return OK;
+}
+
+
+
+/* hands the parsed check output over to the caller */
+void take_decoded_check_output(decoded_check_result *decoded, char **short_output, char **long_output, char **perf_data) {
+
+	*short_output = decoded->short_output;
+	*long_output = decoded->long_output;
+	*perf_data = decoded->perf_data;
+
+	decoded->short_output = NULL;
+	decoded->long_output = NULL;
+	decoded->perf_data = NULL;
+	decoded->output_parsed = FALSE;
+
+	return;
+}
+
+
+
+/* frees memory associated with a decoded check result, including the check result itself */
+void free_decoded_check_result(decoded_check_result *decoded) {
+
+	if (decoded->cr != NULL) {
+		free_check_result(decoded->cr);
+		my_free(decoded->cr);
+	}
+
+	my_free(decoded->short_output);
+	my_free(decoded->long_output);
+	my_free(decoded->perf_data);
+	decoded->output_parsed = FALSE;
+
+	return;
+}
+
+
+
 
 /******************************************************************/
 /****************** SERVICE MONITORING FUNCTIONS ******************/
@@ -484,7 +797,6 @@ int run_scheduled_service_check(service *svc, int check_options, double latency)
 /* forks a child process to run a service check, but does not wait for the service check result */
 int run_async_service_check(service *svc, int check_options, double latency, int scheduled_check, int reschedule_check, int *time_is_valid, time_t *preferred_time) {
 	icinga_macros mac;
-	char *raw_command = NULL;
 	char *processed_command = NULL;
 	struct timeval start_time, end_time;
 	pid_t pid = 0;
@@ -494,6 +806,7 @@ int run_async_service_check(service *svc, int check_options, double latency, int
 	mode_t new_umask = 077;
 	mode_t old_umask;
 	char *output_file = NULL;
+	check_result worker_cr;
 	double old_latency = 0.0;
 	dbuf checkresult_dbuf;
 	int dbuf_chunk = 1024;
@@ -580,21 +893,8 @@ int run_async_service_check(service *svc, int check_options, double latency, int
 	grab_host_macros_r(&mac, temp_host);
 	grab_service_macros_r(&mac, svc);
 
-	/* get the raw command line */
-	get_raw_command_line_r(&mac, svc->check_command_ptr, svc->service_check_command, &raw_command, 0);
-	if (raw_command == NULL) {
-		clear_volatile_macros_r(&mac);
-		log_debug_info(DEBUGL_CHECKS, 0, "Raw check command for service '%s' on host '%s' was NULL - aborting.\n", svc->description, svc->host_name);
-		if (preferred_time)
-			*preferred_time += (svc->check_interval * interval_length);
-		svc->latency = old_latency;
-		return ERROR;
-	}
-
-	/* process any macros contained in the argument */
-	process_macros_r(&mac, raw_command, &processed_command, 0);
-
-	my_free(raw_command);
+	/* get the command line and process any macros contained in it */
+	get_processed_command_line_r(&mac, svc->check_command_ptr, svc->service_check_command, &processed_command, 0);
 
 	if (processed_command == NULL) {
 		clear_volatile_macros_r(&mac);
@@ -629,6 +929,7 @@ int run_async_service_check(service *svc, int check_options, double latency, int
 
 	/* set the execution flag */
 	svc->is_executing = TRUE;
+	set_object_queue_entry(&running_service_checks, svc, &svc->running_queue_index, get_service_check_orphan_time(svc));
 
 	/* start save check info */
 	check_result_info.object_check_type = SERVICE_CHECK;
@@ -636,6 +937,7 @@ int run_async_service_check(service *svc, int check_options, double latency, int
 	check_result_info.check_options = check_options;
 	check_result_info.scheduled_check = scheduled_check;
 	check_result_info.reschedule_check = reschedule_check;
+	check_result_info.latency = latency;
 	check_result_info.start_time = start_time;
 	check_result_info.finish_time = start_time;
 	check_result_info.early_timeout = FALSE;
@@ -643,10 +945,29 @@ int run_async_service_check(service *svc, int check_options, double latency, int
 	check_result_info.return_code = STATE_OK;
 	check_result_info.output = NULL;
 
-	/* open a temp file for storing check output */
+	/* hand the check over to a check worker instead of forking, if possible */
+	worker_cr = check_result_info;
+	worker_cr.host_name = svc->host_name;
+	worker_cr.service_description = svc->description;
+	worker_cr.latency = svc->latency;
+	if (run_check_via_worker(&worker_cr, service_check_timeout, processed_command, &mac) == OK) {
+
+		/* reset latency (permanent value will be set later) */
+		svc->latency = old_latency;
+
+		/* update check statistics */
+		update_check_stats((scheduled_check == TRUE) ? ACTIVE_SCHEDULED_SERVICE_CHECK_STATS : ACTIVE_ONDEMAND_SERVICE_CHECK_STATS, start_time.tv_sec);
+
+		clear_volatile_macros_r(&mac);
+		my_free(processed_command);
+
+		return OK;
+	}
+
+	/* open a temp file for storing check output, unless the result gets passed through the check result channel */
 	old_umask = umask(new_umask);
 	asprintf(&output_file, "%s/checkXXXXXX", temp_path);
-	check_result_info.output_file_fd = mkstemp(output_file);
+	check_result_info.output_file_fd = (use_check_result_channel == TRUE) ? -1 : mkstemp(output_file);
 	if (check_result_info.output_file_fd >= 0)
 		check_result_info.output_file_fp = fdopen(check_result_info.output_file_fd, "w");
 	else {
@@ -785,7 +1106,8 @@ int run_async_service_check(service *svc, int check_options, double latency, int
 
 				/* move check result to queue directory */
 				move_check_result_to_queue(check_result_info.output_file);
-			}
+			} else
+				submit_check_result(&check_result_info, checkresult_dbuf.buf);
 
 			/* free memory */
 			dbuf_free(&checkresult_dbuf);
@@ -928,7 +1250,8 @@ int run_async_service_check(service *svc, int check_options, double latency, int
 
 					/* move check result to queue directory */
 					move_check_result_to_queue(check_result_info.output_file);
-				}
+				} else
+					submit_check_result(&check_result_info, checkresult_dbuf.buf);
 
 				/* free memory */
 				dbuf_free(&checkresult_dbuf);
@@ -987,11 +1310,11 @@ int run_async_service_check(service *svc, int check_options, double latency, int
 
 				/* move check result to queue directory */
 				move_check_result_to_queue(check_result_info.output_file);
-			}
+			} else
+				submit_check_result(&check_result_info, checkresult_dbuf.buf);
 
 			/* free memory */
 			dbuf_free(&checkresult_dbuf);
-			my_free(raw_command);
 			my_free(processed_command);
 
 			/* free check result memory */
@@ -1030,7 +1353,6 @@ int run_async_service_check(service *svc, int check_options, double latency, int
 		free_check_result(&check_result_info);
 
 		/* free memory */
-		my_free(raw_command);
 		my_free(processed_command);
 
 		/* wait for the first child to return */
@@ -1050,6 +1372,14 @@ int run_async_service_check(service *svc, int check_options, double latency, int
 
 /* handles asynchronous service check results */
 int handle_async_service_check_result(service *temp_service, check_result *queued_check_result) {
+
+	return handle_decoded_service_check_result(temp_service, queued_check_result, NULL);
+}
+
+
+
+/* handles asynchronous service check results, using output already parsed by the reaper threads if available */
+int handle_decoded_service_check_result(service *temp_service, check_result *queued_check_result, decoded_check_result *decoded) {
 	host *temp_host = NULL;
 	time_t next_service_check = 0L;
 	time_t preferred_time = 0L;
@@ -1074,7 +1404,7 @@ int handle_async_service_check_result(service *temp_service, check_result *queue
 	void *ptr = NULL;
 
 
-	log_debug_info(DEBUGL_FUNCTIONS, 0, "handle_async_service_check_result()\n");
+	log_debug_info(DEBUGL_FUNCTIONS, 0, "handle_decoded_service_check_result()\n");
 
 	/* make sure we have what we need */
 	if (temp_service == NULL || queued_check_result == NULL)
@@ -1107,8 +1437,10 @@ int handle_async_service_check_result(service *temp_service, check_result *queue
 		temp_service->is_being_freshened = FALSE;
 
 	/* clear the execution flag if this was an active check */
-	if (queued_check_result->check_type == SERVICE_CHECK_ACTIVE)
+	if (queued_check_result->check_type == SERVICE_CHECK_ACTIVE) {
 		temp_service->is_executing = FALSE;
+		remove_object_queue_entry(&running_service_checks, &temp_service->running_queue_index);
+	}
 
 	/* DISCARD INVALID FRESHNESS CHECK RESULTS */
 	/* If a services goes stale, Icinga will initiate a forced check in order to freshen it.  There is a race condition whereby a passive check
@@ -1181,7 +1513,10 @@ int handle_async_service_check_result(service *temp_service, check_result *queue
 	else {
 
 		/* parse check output to get: (1) short output, (2) long output, (3) perf data */
-		parse_check_output(queued_check_result->output, &temp_service->plugin_output, &temp_service->long_plugin_output, &temp_service->perf_data, TRUE, TRUE);
+		if (decoded != NULL && decoded->output_parsed == TRUE)
+			take_decoded_check_output(decoded, &temp_service->plugin_output, &temp_service->long_plugin_output, &temp_service->perf_data);
+		else
+			parse_check_output(queued_check_result->output, &temp_service->plugin_output, &temp_service->long_plugin_output, &temp_service->perf_data, TRUE, TRUE);
 
 		/* make sure the plugin output isn't null */
 		if (temp_service->plugin_output == NULL)
@@ -1556,6 +1891,7 @@ int handle_async_service_check_result(service *temp_service, check_result *queue
 				if (temp_host->has_been_checked == FALSE) {
 					temp_host->has_been_checked = TRUE;
 					temp_host->last_check = temp_service->last_check;
+					update_host_freshness(temp_host);
 				}
 
 				/* fake the route check result */
@@ -1847,6 +2183,9 @@ int handle_async_service_check_result(service *temp_service, check_result *queue
 	/* update service performance info */
 	update_service_performance_data(temp_service);
 
+	/* requeue the service for freshness checking */
+	update_service_freshness(temp_service);
+
 	/* free allocated memory */
 	my_free(temp_plugin_output);
 	my_free(old_plugin_output);
@@ -2148,15 +2487,16 @@ void check_for_orphaned_services(void) {
 	/* get the current time */
 	time(&current_time);
 
-	/* check all services... */
-	for (temp_service = service_list; temp_service != NULL; temp_service = temp_service->next) {
+	log_running_checks(&running_service_checks, "service", current_time);
 
-		/* skip services that are not currently executing */
-		if (temp_service->is_executing == FALSE)
-			continue;
+	/* check all running services whose results are overdue... */
+	while (running_service_checks.count > 0 && running_service_checks.entries[0].expiration_time < current_time) {
+
+		temp_service = (service *)running_service_checks.entries[0].object;
 
-		/* determine the time at which the check results should have come in (allow 10 minutes slack time) */
-		expected_time = (time_t)(temp_service->next_check + temp_service->latency + service_check_timeout + check_reaper_interval + 600);
+		/* determine the time at which the check results should have come in (the service may have been rescheduled since the check started) */
+		expected_time = get_service_check_orphan_time(temp_service);
+		set_object_queue_entry(&running_service_checks, temp_service, &temp_service->running_queue_index, expected_time);
 
 		/* this service was supposed to have executed a while ago, but for some reason the results haven't come back in... */
 		if (expected_time < current_time) {
@@ -2177,6 +2517,7 @@ void check_for_orphaned_services(void) {
 
 			/* disable the executing flag */
 			temp_service->is_executing = FALSE;
+			remove_object_queue_entry(&running_service_checks, &temp_service->running_queue_index);
 
 			/* schedule an immediate check of the service */
 			schedule_service_check(temp_service, current_time, CHECK_OPTION_ORPHAN_CHECK);
@@ -2189,10 +2530,30 @@ void check_for_orphaned_services(void) {
 
 
 
+/* (re)queues a service for freshness checking - called whenever its results or freshness settings change */
+void update_service_freshness(service *svc) {
+
+	if (svc == NULL || service_freshness_queue.is_built == FALSE)
+		return;
+
+	/* don't check freshness of services without regular check intervals if we're using auto-freshness threshold */
+	if (svc->check_freshness == FALSE || (svc->check_interval == 0 && svc->freshness_threshold == 0)) {
+		remove_object_queue_entry(&service_freshness_queue, &svc->freshness_queue_index);
+		return;
+	}
+
+	set_object_queue_entry(&service_freshness_queue, svc, &svc->freshness_queue_index, get_service_result_expiration_time(svc, NULL));
+
+	return;
+}
+
+
+
 /* check freshness of service results */
 void check_service_result_freshness(void) {
 	service *temp_service = NULL;
 	time_t current_time = 0L;
+	time_t next_valid_time = 0L;
 
 
 	log_debug_info(DEBUGL_FUNCTIONS, 0, "check_service_result_freshness()\n");
@@ -2207,12 +2568,20 @@ void check_service_result_freshness(void) {
 	/* get the current time */
 	time(&current_time);
 
-	/* check all services... */
-	for (temp_service = service_list; temp_service != NULL; temp_service = temp_service->next) {
+	/* queue all services by the time their results expire - from now on they're requeued as results come in */
+	if (service_freshness_queue.is_built == FALSE) {
+		service_freshness_queue.is_built = TRUE;
+		for (temp_service = service_list; temp_service != NULL; temp_service = temp_service->next)
+			update_service_freshness(temp_service);
+	}
 
-		/* skip services we shouldn't be checking for freshness */
-		if (temp_service->check_freshness == FALSE)
-			continue;
+	/* check all services whose results have expired... */
+	while (service_freshness_queue.count > 0 && service_freshness_queue.entries[0].expiration_time < current_time) {
+
+		temp_service = (service *)service_freshness_queue.entries[0].object;
+
+		/* services we skip for now are looked at again on the next run */
+		set_object_queue_entry(&service_freshness_queue, temp_service, &temp_service->freshness_queue_index, current_time);
 
 		/* skip services that are currently executing (problems here will be caught by orphaned service check) */
 		if (temp_service->is_executing == TRUE)
@@ -2227,13 +2596,14 @@ void check_service_result_freshness(void) {
 			continue;
 
 		/* see if the time is right... */
-		if (check_time_against_period(current_time, temp_service->check_period_ptr) == ERROR)
-			continue;
+		if (check_time_against_period(current_time, temp_service->check_period_ptr) == ERROR) {
 
-		/* EXCEPTION */
-		/* don't check freshness of services without regular check intervals if we're using auto-freshness threshold */
-		if (temp_service->check_interval == 0 && temp_service->freshness_threshold == 0)
+			/* don't look at the service again before the check period starts */
+			get_next_valid_time(current_time, &next_valid_time, temp_service->check_period_ptr);
+			if (next_valid_time > current_time)
+				set_object_queue_entry(&service_freshness_queue, temp_service, &temp_service->freshness_queue_index, next_valid_time - 1);
 			continue;
+		}
 
 		/* the results for the last check of this service are stale! */
 		if (is_service_result_fresh(temp_service, current_time, TRUE) == FALSE) {
@@ -2245,6 +2615,9 @@ void check_service_result_freshness(void) {
 			schedule_service_check(temp_service, current_time, CHECK_OPTION_FORCE_EXECUTION | CHECK_OPTION_FRESHNESS_CHECK);
 		}
 
+		/* the results are still fresh, wait until they expire */
+		else
+			update_service_freshness(temp_service);
 	}
 
 	return;
@@ -2252,20 +2625,10 @@ void check_service_result_freshness(void) {
 
 
 
-/* tests whether or not a service's check results are fresh */
-int is_service_result_fresh(service *temp_service, time_t current_time, int log_this) {
+/* calculates the time a service's check results expire */
+static time_t get_service_result_expiration_time(service *temp_service, int *threshold) {
 	int freshness_threshold = 0;
 	time_t expiration_time = 0L;
-	int days = 0;
-	int hours = 0;
-	int minutes = 0;
-	int seconds = 0;
-	int tdays = 0;
-	int thours = 0;
-	int tminutes = 0;
-	int tseconds = 0;
-
-	log_debug_info(DEBUGL_CHECKS, 2, "Checking freshness of service '%s' on host '%s'...\n", temp_service->description, temp_service->host_name);
 
 	/* use user-supplied freshness threshold or auto-calculate a freshness threshold to use? */
 	if (temp_service->freshness_threshold == 0) {
@@ -2276,8 +2639,6 @@ int is_service_result_fresh(service *temp_service, time_t current_time, int log_
 	} else
 		freshness_threshold = temp_service->freshness_threshold;
 
-	log_debug_info(DEBUGL_CHECKS, 2, "Freshness thresholds: service=%d, use=%d\n", temp_service->freshness_threshold, freshness_threshold);
-
 	/* calculate expiration time */
 	/* 
 	 * CHANGED 11/10/05 EG
@@ -2314,6 +2675,33 @@ int is_service_result_fresh(service *temp_service, time_t current_time, int log_
 	else
 		expiration_time = (time_t)(temp_service->last_check + freshness_threshold);
 
+	if (threshold != NULL)
+		*threshold = freshness_threshold;
+
+	return expiration_time;
+}
+
+
+
+/* tests whether or not a service's check results are fresh */
+int is_service_result_fresh(service *temp_service, time_t current_time, int log_this) {
+	int freshness_threshold = 0;
+	time_t expiration_time = 0L;
+	int days = 0;
+	int hours = 0;
+	int minutes = 0;
+	int seconds = 0;
+	int tdays = 0;
+	int thours = 0;
+	int tminutes = 0;
+	int tseconds = 0;
+
+	log_debug_info(DEBUGL_CHECKS, 2, "Checking freshness of service '%s' on host '%s'...\n", temp_service->description, temp_service->host_name);
+
+	expiration_time = get_service_result_expiration_time(temp_service, &freshness_threshold);
+
+	log_debug_info(DEBUGL_CHECKS, 2, "Freshness thresholds: service=%d, use=%d\n", temp_service->freshness_threshold, freshness_threshold);
+
 	log_debug_info(DEBUGL_CHECKS, 2, "SERVICE: HBC (has_been_checked): %d, PS (program_start): %lu, ES (event_start): %lu, LC (last_check): %lu, CT (current_time): %lu, ET (expiration_time): %lu\n", temp_service->has_been_checked, (unsigned long)program_start, (unsigned long)event_start, (unsigned long)temp_service->last_check, (unsigned long)current_time, (unsigned long)expiration_time);
 
 	/* the results for the last check of this service are stale */
@@ -2564,19 +2952,22 @@ void check_for_orphaned_hosts(void) {
 	/* get the current time */
 	time(&current_time);
 
-	/* check all hosts... */
-	for (temp_host = host_list; temp_host != NULL; temp_host = temp_host->next) {
+	log_running_checks(&running_host_checks, "host", current_time);
 
-		/* skip hosts that don't have a set check interval (on-demand checks are missed by the orphan logic) */
-		if (temp_host->next_check == (time_t)0L)
-			continue;
+	/* check all running hosts whose results are overdue... */
+	while (running_host_checks.count > 0 && running_host_checks.entries[0].expiration_time < current_time) {
+
+		temp_host = (host *)running_host_checks.entries[0].object;
 
-		/* skip hosts that are not currently executing */
-		if (temp_host->is_executing == FALSE)
+		/* skip hosts that don't have a set check interval (on-demand checks are missed by the orphan logic) - look at them again on the next run */
+		if (temp_host->next_check == (time_t)0L) {
+			set_object_queue_entry(&running_host_checks, temp_host, &temp_host->running_queue_index, current_time);
 			continue;
+		}
 
-		/* determine the time at which the check results should have come in (allow 10 minutes slack time) */
-		expected_time = (time_t)(temp_host->next_check + temp_host->latency + host_check_timeout + check_reaper_interval + 600);
+		/* determine the time at which the check results should have come in (the host may have been rescheduled since the check started) */
+		expected_time = get_host_check_orphan_time(temp_host);
+		set_object_queue_entry(&running_host_checks, temp_host, &temp_host->running_queue_index, expected_time);
 
 		/* this host was supposed to have executed a while ago, but for some reason the results haven't come back in... */
 		if (expected_time < current_time) {
@@ -2592,6 +2983,7 @@ void check_for_orphaned_hosts(void) {
 
 			/* disable the executing flag */
 			temp_host->is_executing = FALSE;
+			remove_object_queue_entry(&running_host_checks, &temp_host->running_queue_index);
 
 			/* schedule an immediate check of the host */
 			schedule_host_check(temp_host, current_time, CHECK_OPTION_ORPHAN_CHECK);
@@ -2604,10 +2996,29 @@ void check_for_orphaned_hosts(void) {
 
 
 
+/* (re)queues a host for freshness checking - called whenever its results or freshness settings change */
+void update_host_freshness(host *hst) {
+
+	if (hst == NULL || host_freshness_queue.is_built == FALSE)
+		return;
+
+	if (hst->check_freshness == FALSE) {
+		remove_object_queue_entry(&host_freshness_queue, &hst->freshness_queue_index);
+		return;
+	}
+
+	set_object_queue_entry(&host_freshness_queue, hst, &hst->freshness_queue_index, get_host_result_expiration_time(hst, NULL));
+
+	return;
+}
+
+
+
 /* check freshness of host results */
 void check_host_result_freshness(void) {
 	host *temp_host = NULL;
 	time_t current_time = 0L;
+	time_t next_valid_time = 0L;
 
 
 	log_debug_info(DEBUGL_FUNCTIONS, 0, "check_host_result_freshness()\n");
@@ -2622,12 +3033,20 @@ void check_host_result_freshness(void) {
 	/* get the current time */
 	time(&current_time);
 
-	/* check all hosts... */
-	for (temp_host = host_list; temp_host != NULL; temp_host = temp_host->next) {
+	/* queue all hosts by the time their results expire - from now on they're requeued as results come in */
+	if (host_freshness_queue.is_built == FALSE) {
+		host_freshness_queue.is_built = TRUE;
+		for (temp_host = host_list; temp_host != NULL; temp_host = temp_host->next)
+			update_host_freshness(temp_host);
+	}
 
-		/* skip hosts we shouldn't be checking for freshness */
-		if (temp_host->check_freshness == FALSE)
-			continue;
+	/* check all hosts whose results have expired... */
+	while (host_freshness_queue.count > 0 && host_freshness_queue.entries[0].expiration_time < current_time) {
+
+		temp_host = (host *)host_freshness_queue.entries[0].object;
+
+		/* hosts we skip for now are looked at again on the next run */
+		set_object_queue_entry(&host_freshness_queue, temp_host, &temp_host->freshness_queue_index, current_time);
 
 		/* skip hosts that have both active and passive checks disabled */
 		if (temp_host->checks_enabled == FALSE && temp_host->accept_passive_host_checks == FALSE)
@@ -2642,8 +3061,14 @@ void check_host_result_freshness(void) {
 			continue;
 
 		/* see if the time is right... */
-		if (check_time_against_period(current_time, temp_host->check_period_ptr) == ERROR)
+		if (check_time_against_period(current_time, temp_host->check_period_ptr) == ERROR) {
+
+			/* don't look at the host again before the check period starts */
+			get_next_valid_time(current_time, &next_valid_time, temp_host->check_period_ptr);
+			if (next_valid_time > current_time)
+				set_object_queue_entry(&host_freshness_queue, temp_host, &temp_host->freshness_queue_index, next_valid_time - 1);
 			continue;
+		}
 
 		/* the results for the last check of this host are stale */
 		if (is_host_result_fresh(temp_host, current_time, TRUE) == FALSE) {
@@ -2654,6 +3079,10 @@ void check_host_result_freshness(void) {
 			/* schedule an immediate forced check of the host */
 			schedule_host_check(temp_host, current_time, CHECK_OPTION_FORCE_EXECUTION | CHECK_OPTION_FRESHNESS_CHECK);
 		}
+
+		/* the results are still fresh, wait until they expire */
+		else
+			update_host_freshness(temp_host);
 	}
 
 	return;
@@ -2661,20 +3090,10 @@ void check_host_result_freshness(void) {
 
 
 
-/* checks to see if a hosts's check results are fresh */
-int is_host_result_fresh(host *temp_host, time_t current_time, int log_this) {
+/* calculates the time a host's check results expire */
+static time_t get_host_result_expiration_time(host *temp_host, int *threshold) {
 	time_t expiration_time = 0L;
 	int freshness_threshold = 0;
-	int days = 0;
-	int hours = 0;
-	int minutes = 0;
-	int seconds = 0;
-	int tdays = 0;
-	int thours = 0;
-	int tminutes = 0;
-	int tseconds = 0;
-
-	log_debug_info(DEBUGL_CHECKS, 2, "Checking freshness of host '%s'...\n", temp_host->name);
 
 	/* use user-supplied freshness threshold or auto-calculate a freshness threshold to use? */
 	if (temp_host->freshness_threshold == 0)
@@ -2685,8 +3104,6 @@ int is_host_result_fresh(host *temp_host, time_t current_time, int log_this) {
 	else
 		freshness_threshold = temp_host->freshness_threshold;
 
-	log_debug_info(DEBUGL_CHECKS, 2, "Freshness thresholds: host=%d, use=%d\n", temp_host->freshness_threshold, freshness_threshold);
-
 	/* calculate expiration time */
 	/* 
 	 * CHANGED 11/10/05 EG 
@@ -2713,6 +3130,33 @@ int is_host_result_fresh(host *temp_host, time_t current_time, int log_this) {
 	else
 		expiration_time = (time_t)(temp_host->last_check + freshness_threshold);
 
+	if (threshold != NULL)
+		*threshold = freshness_threshold;
+
+	return expiration_time;
+}
+
+
+
+/* checks to see if a hosts's check results are fresh */
+int is_host_result_fresh(host *temp_host, time_t current_time, int log_this) {
+	time_t expiration_time = 0L;
+	int freshness_threshold = 0;
+	int days = 0;
+	int hours = 0;
+	int minutes = 0;
+	int seconds = 0;
+	int tdays = 0;
+	int thours = 0;
+	int tminutes = 0;
+	int tseconds = 0;
+
+	log_debug_info(DEBUGL_CHECKS, 2, "Checking freshness of host '%s'...\n", temp_host->name);
+
+	expiration_time = get_host_result_expiration_time(temp_host, &freshness_threshold);
+
+	log_debug_info(DEBUGL_CHECKS, 2, "Freshness thresholds: host=%d, use=%d\n", temp_host->freshness_threshold, freshness_threshold);
+
 	log_debug_info(DEBUGL_CHECKS, 2, "HOST: HBC (has_been_checked): %d, PS (program_start): %lu, ES (event_start): %lu, LC (last_check): %lu, CT (current_time): %lu, ET (expiration_time): %lu\n", temp_host->has_been_checked, (unsigned long)program_start, (unsigned long)event_start, (unsigned long)temp_host->last_check, (unsigned long)current_time, (unsigned long)expiration_time);
 
 	/* the results for the last check of this host are stale */
@@ -3142,7 +3586,6 @@ int run_scheduled_host_check_3x(host *hst, int check_options, double latency) {
 /* scheduled host checks will use this, as will some checks that result from on-demand checks... */
 int run_async_host_check_3x(host *hst, int check_options, double latency, int scheduled_check, int reschedule_check, int *time_is_valid, time_t *preferred_time) {
 	icinga_macros mac;
-	char *raw_command = NULL;
 	char *processed_command = NULL;
 	struct timeval start_time, end_time;
 	pid_t pid = 0;
@@ -3151,6 +3594,7 @@ int run_async_host_check_3x(host *hst, int check_options, double latency, int sc
 	mode_t new_umask = 077;
 	mode_t old_umask;
 	char *output_file = NULL;
+	check_result worker_cr;
 	double old_latency = 0.0;
 	dbuf checkresult_dbuf;
 	int dbuf_chunk = 1024;
@@ -3217,18 +3661,8 @@ int run_async_host_check_3x(host *hst, int check_options, double latency, int sc
 	memset(&mac, 0, sizeof(mac));
 	grab_host_macros_r(&mac, hst);
 
-	/* get the raw command line */
-	get_raw_command_line_r(&mac, hst->check_command_ptr, hst->host_check_command, &raw_command, 0);
-	if (raw_command == NULL) {
-		clear_volatile_macros_r(&mac);
-		log_debug_info(DEBUGL_CHECKS, 0, "Raw check command for host '%s' was NULL - aborting.\n", hst->name);
-		return ERROR;
-	}
-
-	/* process any macros contained in the argument */
-	process_macros_r(&mac, raw_command, &processed_command, 0);
-
-	my_free(raw_command);
+	/* get the command line and process any macros contained in it */
+	get_processed_command_line_r(&mac, hst->check_command_ptr, hst->host_check_command, &processed_command, 0);
 
 	if (processed_command == NULL) {
 		clear_volatile_macros_r(&mac);
@@ -3247,11 +3681,41 @@ int run_async_host_check_3x(host *hst, int check_options, double latency, int sc
 
 	/* set the execution flag */
 	hst->is_executing = TRUE;
+	set_object_queue_entry(&running_host_checks, hst, &hst->running_queue_index, get_host_check_orphan_time(hst));
+
+	/* hand the check over to a check worker instead of forking, if possible */
+	init_check_result(&worker_cr);
+	worker_cr.host_name = hst->name;
+	worker_cr.check_type = HOST_CHECK_ACTIVE;
+	worker_cr.check_options = check_options;
+	worker_cr.scheduled_check = scheduled_check;
+	worker_cr.reschedule_check = reschedule_check;
+	worker_cr.latency = hst->latency;
+	worker_cr.start_time = start_time;
+	if (run_check_via_worker(&worker_cr, host_check_timeout, processed_command, &mac) == OK) {
+
+#ifdef USE_EVENT_BROKER
+		/* send data to event broker */
+		broker_host_check(NEBTYPE_HOSTCHECK_INITIATE, NEBFLAG_NONE, NEBATTR_NONE, hst, HOST_CHECK_ACTIVE, hst->current_state, hst->state_type, start_time, end_time, hst->host_check_command, hst->latency, 0.0, host_check_timeout, FALSE, 0, processed_command, NULL, NULL, NULL, NULL);
+#endif
 
-	/* open a temp file for storing check output */
+		/* reset latency (permanent value for this check will get set later) */
+		hst->latency = old_latency;
+
+		/* update check statistics */
+		update_check_stats((scheduled_check == TRUE) ? ACTIVE_SCHEDULED_HOST_CHECK_STATS : ACTIVE_ONDEMAND_HOST_CHECK_STATS, start_time.tv_sec);
+		update_check_stats(PARALLEL_HOST_CHECK_STATS, start_time.tv_sec);
+
+		clear_volatile_macros_r(&mac);
+		my_free(processed_command);
+
+		return OK;
+	}
+
+	/* open a temp file for storing check output, unless the result gets passed through the check result channel */
 	old_umask = umask(new_umask);
 	asprintf(&output_file, "%s/checkXXXXXX", temp_path);
-	check_result_info.output_file_fd = mkstemp(output_file);
+	check_result_info.output_file_fd = (use_check_result_channel == TRUE) ? -1 : mkstemp(output_file);
 	if (check_result_info.output_file_fd >= 0)
 		check_result_info.output_file_fp = fdopen(check_result_info.output_file_fd, "w");
 	else {
@@ -3420,11 +3884,11 @@ int run_async_host_check_3x(host *hst, int check_options, double latency, int sc
 
 				/* move check result to queue directory */
 				move_check_result_to_queue(check_result_info.output_file);
-			}
+			} else
+				submit_check_result(&check_result_info, checkresult_dbuf.buf);
 
 			/* free memory */
 			dbuf_free(&checkresult_dbuf);
-			my_free(raw_command);
 			my_free(processed_command);
 
 			/* free check result memory */
@@ -3463,7 +3927,6 @@ int run_async_host_check_3x(host *hst, int check_options, double latency, int sc
 		free_check_result(&check_result_info);
 
 		/* free memory */
-		my_free(raw_command);
 		my_free(processed_command);
 
 		/* wait for the first child to return */
@@ -3483,6 +3946,14 @@ int run_async_host_check_3x(host *hst, int check_options, double latency, int sc
 
 /* process results of an asynchronous host check */
 int handle_async_host_check_result_3x(host *temp_host, check_result *queued_check_result) {
+
+	return handle_decoded_host_check_result_3x(temp_host, queued_check_result, NULL);
+}
+
+
+
+/* process results of an asynchronous host check, using output already parsed by the reaper threads if available */
+int handle_decoded_host_check_result_3x(host *temp_host, check_result *queued_check_result, decoded_check_result *decoded) {
 	time_t current_time;
 	int result = STATE_OK;
 	int reschedule_check = FALSE;
@@ -3491,7 +3962,7 @@ int handle_async_host_check_result_3x(host *temp_host, check_result *queued_chec
 	struct timeval start_time_hires;
 	struct timeval end_time_hires;
 
-	log_debug_info(DEBUGL_FUNCTIONS, 0, "handle_async_host_check_result_3x()\n");
+	log_debug_info(DEBUGL_FUNCTIONS, 0, "handle_decoded_host_check_result_3x()\n");
 
 	/* make sure we have what we need */
 	if (temp_host == NULL || queued_check_result == NULL)
@@ -3562,8 +4033,10 @@ int handle_async_host_check_result_3x(host *temp_host, check_result *queued_chec
 	temp_host->has_been_checked = TRUE;
 
 	/* clear the execution flag if this was an active check */
-	if (queued_check_result->check_type == HOST_CHECK_ACTIVE)
+	if (queued_check_result->check_type == HOST_CHECK_ACTIVE) {
 		temp_host->is_executing = FALSE;
+		remove_object_queue_entry(&running_host_checks, &temp_host->running_queue_index);
+	}
 
 	/* get the last check time */
 	temp_host->last_check = queued_check_result->start_time.tv_sec;
@@ -3586,7 +4059,10 @@ int handle_async_host_check_result_3x(host *temp_host, check_result *queued_chec
 	my_free(temp_host->perf_data);
 
 	/* parse check output to get: (1) short output, (2) long output, (3) perf data */
-	parse_check_output(queued_check_result->output, &temp_host->plugin_output, &temp_host->long_plugin_output, &temp_host->perf_data, TRUE, TRUE);
+	if (decoded != NULL && decoded->output_parsed == TRUE)
+		take_decoded_check_output(decoded, &temp_host->plugin_output, &temp_host->long_plugin_output, &temp_host->perf_data);
+	else
+		parse_check_output(queued_check_result->output, &temp_host->plugin_output, &temp_host->long_plugin_output, &temp_host->perf_data, TRUE, TRUE);
 
 	/* make sure we have some data */
 	if (temp_host->plugin_output == NULL || !strcmp(temp_host->plugin_output, "")) {
@@ -4133,6 +4609,9 @@ int process_host_check_result_3x(host *hst, int new_state, char *old_plugin_outp
 	/* update host status - for both active (scheduled) and passive (non-scheduled) hosts */
 	update_host_status(hst, FALSE);
 
+	/* requeue the host for freshness checking */
+	update_host_freshness(hst);
+
 	/* run async checks of all hosts we added above */
 	/* don't run a check if one is already executing or we can get by with a cached state */
 	for (hostlist_item = check_hostlist; hostlist_item != NULL; hostlist_item = hostlist_item->next) {
@@ -4464,11 +4943,14 @@ int parse_check_output(char *buf, char **short_output, char **long_output, char
 	dbuf db1;
 	dbuf db2;
 	char *ptr = NULL;
+	char *saveptr = NULL;
 	int in_perf_data = FALSE;
 	char *tempbuf = NULL;
 	register int x = 0;
 	register int y = 0;
 
+	/* NOTE: this is called from the check result reaper threads, so it must stay reentrant */
+
 	/* initialize values */
 	if (short_output)
 		*short_output = NULL;
@@ -4530,12 +5012,12 @@ int parse_check_output(char *buf, char **short_output, char **long_output, char
 				if (current_line == 1) {
 
 					/* get the short plugin output */
-					if ((ptr = strtok(tempbuf, "|"))) {
+					if ((ptr = strtok_r(tempbuf, "|", &saveptr))) {
 						if (short_output)
 							*short_output = (char *)strdup(ptr);
 
 						/* get the optional perf data */
-						if ((ptr = strtok(NULL, "\n")))
+						if ((ptr = strtok_r(NULL, "\n", &saveptr)))
 							dbuf_strcat(&db2, ptr);
 					}
 				}
@@ -4555,16 +5037,18 @@ int parse_check_output(char *buf, char **short_output, char **long_output, char
 						/* perf data separator has been found */
 						if (strstr(tempbuf, "|")) {
 
-							/* NOTE: strtok() causes problems if first character of tempbuf='|', so use my_strtok() instead */
+							/* NOTE: strtok() causes problems if first character of tempbuf='|', so split at the first separator by hand */
 							/* get the remaining long plugin output */
-							if ((ptr = my_strtok(tempbuf, "|"))) {
+							if ((ptr = strchr(tempbuf, '|'))) {
+
+								*ptr++ = '\x0';
 
 								if (current_line > 2)
 									dbuf_strcat(&db1, "\n");
-								dbuf_strcat(&db1, ptr);
+								dbuf_strcat(&db1, tempbuf);
 
 								/* get the perf data */
-								if ((ptr = my_strtok(NULL, "\n"))) {
+								if (*ptr != '\x0') {
 									dbuf_strcat(&db2, ptr);
 									dbuf_strcat(&db2, " ");
 								}
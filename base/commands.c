@@ -69,6 +69,8 @@ extern int      log_external_commands;
 extern int      log_passive_checks;
 extern int      log_anonymized_external_command_author;
 
+extern int      use_check_result_channel;
+
 extern unsigned long    modified_host_process_attributes;
 extern unsigned long    modified_service_process_attributes;
 
@@ -94,6 +96,355 @@ extern int             external_command_buffer_slots;
 /****************** EXTERNAL COMMAND PROCESSING *******************/
 /******************************************************************/
 
+/* maps external command names to command types, sorted by name the first time a command is looked up */
+struct external_command_type {
+	char *name;
+	int command_type;
+	int author_position;		/* argument holding the author's name (0 if none) */
+};
+
+static struct external_command_type external_command_types[] = {
+	{ "ENTER_STANDBY_MODE", CMD_DISABLE_NOTIFICATIONS, 0 },
+	{ "DISABLE_NOTIFICATIONS", CMD_DISABLE_NOTIFICATIONS, 0 },
+	{ "ENTER_ACTIVE_MODE", CMD_ENABLE_NOTIFICATIONS, 0 },
+	{ "ENABLE_NOTIFICATIONS", CMD_ENABLE_NOTIFICATIONS, 0 },
+	{ "DISABLE_NOTIFICATIONS_EXPIRE_TIME", CMD_DISABLE_NOTIFICATIONS_EXPIRE_TIME, 0 },
+
+	{ "SHUTDOWN_PROGRAM", CMD_SHUTDOWN_PROCESS, 0 },
+	{ "SHUTDOWN_PROCESS", CMD_SHUTDOWN_PROCESS, 0 },
+	{ "RESTART_PROGRAM", CMD_RESTART_PROCESS, 0 },
+	{ "RESTART_PROCESS", CMD_RESTART_PROCESS, 0 },
+
+	{ "SAVE_STATE_INFORMATION", CMD_SAVE_STATE_INFORMATION, 0 },
+	{ "READ_STATE_INFORMATION", CMD_READ_STATE_INFORMATION, 0 },
+	{ "SYNC_STATE_INFORMATION", CMD_SYNC_STATE_INFORMATION, 0 },
+
+	{ "ENABLE_EVENT_HANDLERS", CMD_ENABLE_EVENT_HANDLERS, 0 },
+	{ "DISABLE_EVENT_HANDLERS", CMD_DISABLE_EVENT_HANDLERS, 0 },
+
+	{ "FLUSH_PENDING_COMMANDS", CMD_FLUSH_PENDING_COMMANDS, 0 },
+
+	{ "ENABLE_FAILURE_PREDICTION", CMD_ENABLE_FAILURE_PREDICTION, 0 },
+	{ "DISABLE_FAILURE_PREDICTION", CMD_DISABLE_FAILURE_PREDICTION, 0 },
+
+	{ "ENABLE_PERFORMANCE_DATA", CMD_ENABLE_PERFORMANCE_DATA, 0 },
+	{ "DISABLE_PERFORMANCE_DATA", CMD_DISABLE_PERFORMANCE_DATA, 0 },
+
+	{ "START_EXECUTING_HOST_CHECKS", CMD_START_EXECUTING_HOST_CHECKS, 0 },
+	{ "STOP_EXECUTING_HOST_CHECKS", CMD_STOP_EXECUTING_HOST_CHECKS, 0 },
+
+	{ "START_EXECUTING_SVC_CHECKS", CMD_START_EXECUTING_SVC_CHECKS, 0 },
+	{ "STOP_EXECUTING_SVC_CHECKS", CMD_STOP_EXECUTING_SVC_CHECKS, 0 },
+
+	{ "START_ACCEPTING_PASSIVE_HOST_CHECKS", CMD_START_ACCEPTING_PASSIVE_HOST_CHECKS, 0 },
+	{ "STOP_ACCEPTING_PASSIVE_HOST_CHECKS", CMD_STOP_ACCEPTING_PASSIVE_HOST_CHECKS, 0 },
+
+	{ "START_ACCEPTING_PASSIVE_SVC_CHECKS", CMD_START_ACCEPTING_PASSIVE_SVC_CHECKS, 0 },
+	{ "STOP_ACCEPTING_PASSIVE_SVC_CHECKS", CMD_STOP_ACCEPTING_PASSIVE_SVC_CHECKS, 0 },
+
+	{ "START_OBSESSING_OVER_HOST_CHECKS", CMD_START_OBSESSING_OVER_HOST_CHECKS, 0 },
+	{ "STOP_OBSESSING_OVER_HOST_CHECKS", CMD_STOP_OBSESSING_OVER_HOST_CHECKS, 0 },
+
+	{ "START_OBSESSING_OVER_SVC_CHECKS", CMD_START_OBSESSING_OVER_SVC_CHECKS, 0 },
+	{ "STOP_OBSESSING_OVER_SVC_CHECKS", CMD_STOP_OBSESSING_OVER_SVC_CHECKS, 0 },
+
+	{ "ENABLE_FLAP_DETECTION", CMD_ENABLE_FLAP_DETECTION, 0 },
+	{ "DISABLE_FLAP_DETECTION", CMD_DISABLE_FLAP_DETECTION, 0 },
+
+	{ "CHANGE_GLOBAL_HOST_EVENT_HANDLER", CMD_CHANGE_GLOBAL_HOST_EVENT_HANDLER, 0 },
+	{ "CHANGE_GLOBAL_SVC_EVENT_HANDLER", CMD_CHANGE_GLOBAL_SVC_EVENT_HANDLER, 0 },
+
+	{ "ENABLE_SERVICE_FRESHNESS_CHECKS", CMD_ENABLE_SERVICE_FRESHNESS_CHECKS, 0 },
+	{ "DISABLE_SERVICE_FRESHNESS_CHECKS", CMD_DISABLE_SERVICE_FRESHNESS_CHECKS, 0 },
+
+	{ "ENABLE_HOST_FRESHNESS_CHECKS", CMD_ENABLE_HOST_FRESHNESS_CHECKS, 0 },
+	{ "DISABLE_HOST_FRESHNESS_CHECKS", CMD_DISABLE_HOST_FRESHNESS_CHECKS, 0 },
+
+	/*******************************/
+	/**** HOST-RELATED COMMANDS ****/
+	/*******************************/
+
+	{ "ADD_HOST_COMMENT", CMD_ADD_HOST_COMMENT, 3 },
+	{ "DEL_HOST_COMMENT", CMD_DEL_HOST_COMMENT, 0 },
+	{ "DEL_ALL_HOST_COMMENTS", CMD_DEL_ALL_HOST_COMMENTS, 0 },
+
+	{ "DELAY_HOST_NOTIFICATION", CMD_DELAY_HOST_NOTIFICATION, 0 },
+
+	{ "ENABLE_HOST_NOTIFICATIONS", CMD_ENABLE_HOST_NOTIFICATIONS, 0 },
+	{ "DISABLE_HOST_NOTIFICATIONS", CMD_DISABLE_HOST_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_ALL_NOTIFICATIONS_BEYOND_HOST", CMD_ENABLE_ALL_NOTIFICATIONS_BEYOND_HOST, 0 },
+	{ "DISABLE_ALL_NOTIFICATIONS_BEYOND_HOST", CMD_DISABLE_ALL_NOTIFICATIONS_BEYOND_HOST, 0 },
+
+	{ "ENABLE_HOST_AND_CHILD_NOTIFICATIONS", CMD_ENABLE_HOST_AND_CHILD_NOTIFICATIONS, 0 },
+	{ "DISABLE_HOST_AND_CHILD_NOTIFICATIONS", CMD_DISABLE_HOST_AND_CHILD_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_HOST_SVC_NOTIFICATIONS", CMD_ENABLE_HOST_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_HOST_SVC_NOTIFICATIONS", CMD_DISABLE_HOST_SVC_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_HOST_SVC_CHECKS", CMD_ENABLE_HOST_SVC_CHECKS, 0 },
+	{ "DISABLE_HOST_SVC_CHECKS", CMD_DISABLE_HOST_SVC_CHECKS, 0 },
+
+	{ "ENABLE_PASSIVE_HOST_CHECKS", CMD_ENABLE_PASSIVE_HOST_CHECKS, 0 },
+	{ "DISABLE_PASSIVE_HOST_CHECKS", CMD_DISABLE_PASSIVE_HOST_CHECKS, 0 },
+
+	{ "SCHEDULE_HOST_SVC_CHECKS", CMD_SCHEDULE_HOST_SVC_CHECKS, 0 },
+	{ "SCHEDULE_FORCED_HOST_SVC_CHECKS", CMD_SCHEDULE_FORCED_HOST_SVC_CHECKS, 0 },
+
+	{ "ACKNOWLEDGE_HOST_PROBLEM", CMD_ACKNOWLEDGE_HOST_PROBLEM, 5 },
+	{ "ACKNOWLEDGE_HOST_PROBLEM_EXPIRE", CMD_ACKNOWLEDGE_HOST_PROBLEM_EXPIRE, 6 },
+	{ "REMOVE_HOST_ACKNOWLEDGEMENT", CMD_REMOVE_HOST_ACKNOWLEDGEMENT, 0 },
+
+	{ "ACKNOWLEDGE_HOST_SVC_PROBLEM", CMD_ACKNOWLEDGE_HOST_SVC_PROBLEM, 0 },
+
+	{ "ENABLE_HOST_EVENT_HANDLER", CMD_ENABLE_HOST_EVENT_HANDLER, 0 },
+	{ "DISABLE_HOST_EVENT_HANDLER", CMD_DISABLE_HOST_EVENT_HANDLER, 0 },
+
+	{ "ENABLE_HOST_CHECK", CMD_ENABLE_HOST_CHECK, 0 },
+	{ "DISABLE_HOST_CHECK", CMD_DISABLE_HOST_CHECK, 0 },
+
+	{ "SCHEDULE_HOST_CHECK", CMD_SCHEDULE_HOST_CHECK, 0 },
+	{ "SCHEDULE_FORCED_HOST_CHECK", CMD_SCHEDULE_FORCED_HOST_CHECK, 0 },
+
+	{ "SCHEDULE_HOST_DOWNTIME", CMD_SCHEDULE_HOST_DOWNTIME, 7 },
+	{ "SCHEDULE_HOST_SVC_DOWNTIME", CMD_SCHEDULE_HOST_SVC_DOWNTIME, 7 },
+	{ "DEL_HOST_DOWNTIME", CMD_DEL_HOST_DOWNTIME, 0 },
+	{ "DEL_DOWNTIME_BY_HOST_NAME", CMD_DEL_DOWNTIME_BY_HOST_NAME, 0 },
+	{ "DEL_DOWNTIME_BY_HOSTGROUP_NAME", CMD_DEL_DOWNTIME_BY_HOSTGROUP_NAME, 0 },
+
+	{ "DEL_DOWNTIME_BY_START_TIME_COMMENT", CMD_DEL_DOWNTIME_BY_START_TIME_COMMENT, 0 },
+
+	{ "ENABLE_HOST_FLAP_DETECTION", CMD_ENABLE_HOST_FLAP_DETECTION, 0 },
+	{ "DISABLE_HOST_FLAP_DETECTION", CMD_DISABLE_HOST_FLAP_DETECTION, 0 },
+
+	{ "START_OBSESSING_OVER_HOST", CMD_START_OBSESSING_OVER_HOST, 0 },
+	{ "STOP_OBSESSING_OVER_HOST", CMD_STOP_OBSESSING_OVER_HOST, 0 },
+
+	{ "CHANGE_HOST_EVENT_HANDLER", CMD_CHANGE_HOST_EVENT_HANDLER, 0 },
+	{ "CHANGE_HOST_CHECK_COMMAND", CMD_CHANGE_HOST_CHECK_COMMAND, 0 },
+
+	{ "CHANGE_NORMAL_HOST_CHECK_INTERVAL", CMD_CHANGE_NORMAL_HOST_CHECK_INTERVAL, 0 },
+	{ "CHANGE_RETRY_HOST_CHECK_INTERVAL", CMD_CHANGE_RETRY_HOST_CHECK_INTERVAL, 0 },
+
+	{ "CHANGE_MAX_HOST_CHECK_ATTEMPTS", CMD_CHANGE_MAX_HOST_CHECK_ATTEMPTS, 0 },
+
+	{ "SCHEDULE_AND_PROPAGATE_TRIGGERED_HOST_DOWNTIME", CMD_SCHEDULE_AND_PROPAGATE_TRIGGERED_HOST_DOWNTIME, 7 },
+
+	{ "SCHEDULE_AND_PROPAGATE_HOST_DOWNTIME", CMD_SCHEDULE_AND_PROPAGATE_HOST_DOWNTIME, 7 },
+
+	{ "SET_HOST_NOTIFICATION_NUMBER", CMD_SET_HOST_NOTIFICATION_NUMBER, 0 },
+
+	{ "CHANGE_HOST_CHECK_TIMEPERIOD", CMD_CHANGE_HOST_CHECK_TIMEPERIOD, 0 },
+
+	{ "CHANGE_CUSTOM_HOST_VAR", CMD_CHANGE_CUSTOM_HOST_VAR, 0 },
+
+	{ "SEND_CUSTOM_HOST_NOTIFICATION", CMD_SEND_CUSTOM_HOST_NOTIFICATION, 3 },
+
+	{ "CHANGE_HOST_NOTIFICATION_TIMEPERIOD", CMD_CHANGE_HOST_NOTIFICATION_TIMEPERIOD, 0 },
+
+	{ "CHANGE_HOST_MODATTR", CMD_CHANGE_HOST_MODATTR, 0 },
+
+	/************************************/
+	/**** HOSTGROUP-RELATED COMMANDS ****/
+	/************************************/
+
+	{ "ENABLE_HOSTGROUP_HOST_NOTIFICATIONS", CMD_ENABLE_HOSTGROUP_HOST_NOTIFICATIONS, 0 },
+	{ "DISABLE_HOSTGROUP_HOST_NOTIFICATIONS", CMD_DISABLE_HOSTGROUP_HOST_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_HOSTGROUP_SVC_NOTIFICATIONS", CMD_ENABLE_HOSTGROUP_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_HOSTGROUP_SVC_NOTIFICATIONS", CMD_DISABLE_HOSTGROUP_SVC_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_HOSTGROUP_HOST_CHECKS", CMD_ENABLE_HOSTGROUP_HOST_CHECKS, 0 },
+	{ "DISABLE_HOSTGROUP_HOST_CHECKS", CMD_DISABLE_HOSTGROUP_HOST_CHECKS, 0 },
+
+	{ "ENABLE_HOSTGROUP_PASSIVE_HOST_CHECKS", CMD_ENABLE_HOSTGROUP_PASSIVE_HOST_CHECKS, 0 },
+	{ "DISABLE_HOSTGROUP_PASSIVE_HOST_CHECKS", CMD_DISABLE_HOSTGROUP_PASSIVE_HOST_CHECKS, 0 },
+
+	{ "ENABLE_HOSTGROUP_SVC_CHECKS", CMD_ENABLE_HOSTGROUP_SVC_CHECKS, 0 },
+	{ "DISABLE_HOSTGROUP_SVC_CHECKS", CMD_DISABLE_HOSTGROUP_SVC_CHECKS, 0 },
+
+	{ "ENABLE_HOSTGROUP_PASSIVE_SVC_CHECKS", CMD_ENABLE_HOSTGROUP_PASSIVE_SVC_CHECKS, 0 },
+	{ "DISABLE_HOSTGROUP_PASSIVE_SVC_CHECKS", CMD_DISABLE_HOSTGROUP_PASSIVE_SVC_CHECKS, 0 },
+
+	{ "SCHEDULE_HOSTGROUP_HOST_DOWNTIME", CMD_SCHEDULE_HOSTGROUP_HOST_DOWNTIME, 7 },
+	{ "SCHEDULE_HOSTGROUP_SVC_DOWNTIME", CMD_SCHEDULE_HOSTGROUP_SVC_DOWNTIME, 7 },
+
+	/**********************************/
+	/**** SERVICE-RELATED COMMANDS ****/
+	/**********************************/
+
+	{ "ADD_SVC_COMMENT", CMD_ADD_SVC_COMMENT, 4 },
+	{ "DEL_SVC_COMMENT", CMD_DEL_SVC_COMMENT, 0 },
+	{ "DEL_ALL_SVC_COMMENTS", CMD_DEL_ALL_SVC_COMMENTS, 0 },
+
+	{ "SCHEDULE_SVC_CHECK", CMD_SCHEDULE_SVC_CHECK, 0 },
+	{ "SCHEDULE_FORCED_SVC_CHECK", CMD_SCHEDULE_FORCED_SVC_CHECK, 0 },
+
+	{ "ENABLE_SVC_CHECK", CMD_ENABLE_SVC_CHECK, 0 },
+	{ "DISABLE_SVC_CHECK", CMD_DISABLE_SVC_CHECK, 0 },
+
+	{ "ENABLE_PASSIVE_SVC_CHECKS", CMD_ENABLE_PASSIVE_SVC_CHECKS, 0 },
+	{ "DISABLE_PASSIVE_SVC_CHECKS", CMD_DISABLE_PASSIVE_SVC_CHECKS, 0 },
+
+	{ "DELAY_SVC_NOTIFICATION", CMD_DELAY_SVC_NOTIFICATION, 0 },
+	{ "ENABLE_SVC_NOTIFICATIONS", CMD_ENABLE_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_SVC_NOTIFICATIONS", CMD_DISABLE_SVC_NOTIFICATIONS, 0 },
+
+	{ "PROCESS_SERVICE_CHECK_RESULT", CMD_PROCESS_SERVICE_CHECK_RESULT, 0 },
+	{ "PROCESS_HOST_CHECK_RESULT", CMD_PROCESS_HOST_CHECK_RESULT, 0 },
+
+	{ "ENABLE_SVC_EVENT_HANDLER", CMD_ENABLE_SVC_EVENT_HANDLER, 0 },
+	{ "DISABLE_SVC_EVENT_HANDLER", CMD_DISABLE_SVC_EVENT_HANDLER, 0 },
+
+	{ "ENABLE_SVC_FLAP_DETECTION", CMD_ENABLE_SVC_FLAP_DETECTION, 0 },
+	{ "DISABLE_SVC_FLAP_DETECTION", CMD_DISABLE_SVC_FLAP_DETECTION, 0 },
+
+	{ "SCHEDULE_SVC_DOWNTIME", CMD_SCHEDULE_SVC_DOWNTIME, 8 },
+	{ "DEL_SVC_DOWNTIME", CMD_DEL_SVC_DOWNTIME, 0 },
+	{ "ACKNOWLEDGE_SVC_PROBLEM", CMD_ACKNOWLEDGE_SVC_PROBLEM, 6 },
+	{ "ACKNOWLEDGE_SVC_PROBLEM_EXPIRE", CMD_ACKNOWLEDGE_SVC_PROBLEM_EXPIRE, 7 },
+	{ "REMOVE_SVC_ACKNOWLEDGEMENT", CMD_REMOVE_SVC_ACKNOWLEDGEMENT, 0 },
+
+	{ "START_OBSESSING_OVER_SVC", CMD_START_OBSESSING_OVER_SVC, 0 },
+	{ "STOP_OBSESSING_OVER_SVC", CMD_STOP_OBSESSING_OVER_SVC, 0 },
+
+	{ "CHANGE_SVC_EVENT_HANDLER", CMD_CHANGE_SVC_EVENT_HANDLER, 0 },
+	{ "CHANGE_SVC_CHECK_COMMAND", CMD_CHANGE_SVC_CHECK_COMMAND, 0 },
+
+	{ "CHANGE_NORMAL_SVC_CHECK_INTERVAL", CMD_CHANGE_NORMAL_SVC_CHECK_INTERVAL, 0 },
+	{ "CHANGE_RETRY_SVC_CHECK_INTERVAL", CMD_CHANGE_RETRY_SVC_CHECK_INTERVAL, 0 },
+
+	{ "CHANGE_MAX_SVC_CHECK_ATTEMPTS", CMD_CHANGE_MAX_SVC_CHECK_ATTEMPTS, 0 },
+
+	{ "SET_SVC_NOTIFICATION_NUMBER", CMD_SET_SVC_NOTIFICATION_NUMBER, 0 },
+
+	{ "CHANGE_SVC_CHECK_TIMEPERIOD", CMD_CHANGE_SVC_CHECK_TIMEPERIOD, 0 },
+
+	{ "CHANGE_CUSTOM_SVC_VAR", CMD_CHANGE_CUSTOM_SVC_VAR, 0 },
+
+	{ "CHANGE_CUSTOM_CONTACT_VAR", CMD_CHANGE_CUSTOM_CONTACT_VAR, 0 },
+
+	{ "SEND_CUSTOM_SVC_NOTIFICATION", CMD_SEND_CUSTOM_SVC_NOTIFICATION, 4 },
+
+	{ "CHANGE_SVC_NOTIFICATION_TIMEPERIOD", CMD_CHANGE_SVC_NOTIFICATION_TIMEPERIOD, 0 },
+
+	{ "CHANGE_SVC_MODATTR", CMD_CHANGE_SVC_MODATTR, 0 },
+
+	/***************************************/
+	/**** SERVICEGROUP-RELATED COMMANDS ****/
+	/***************************************/
+
+	{ "ENABLE_SERVICEGROUP_HOST_NOTIFICATIONS", CMD_ENABLE_SERVICEGROUP_HOST_NOTIFICATIONS, 0 },
+	{ "DISABLE_SERVICEGROUP_HOST_NOTIFICATIONS", CMD_DISABLE_SERVICEGROUP_HOST_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_SERVICEGROUP_SVC_NOTIFICATIONS", CMD_ENABLE_SERVICEGROUP_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_SERVICEGROUP_SVC_NOTIFICATIONS", CMD_DISABLE_SERVICEGROUP_SVC_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_SERVICEGROUP_HOST_CHECKS", CMD_ENABLE_SERVICEGROUP_HOST_CHECKS, 0 },
+	{ "DISABLE_SERVICEGROUP_HOST_CHECKS", CMD_DISABLE_SERVICEGROUP_HOST_CHECKS, 0 },
+
+	{ "ENABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS", CMD_ENABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS, 0 },
+	{ "DISABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS", CMD_DISABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS, 0 },
+
+	{ "ENABLE_SERVICEGROUP_SVC_CHECKS", CMD_ENABLE_SERVICEGROUP_SVC_CHECKS, 0 },
+	{ "DISABLE_SERVICEGROUP_SVC_CHECKS", CMD_DISABLE_SERVICEGROUP_SVC_CHECKS, 0 },
+
+	{ "ENABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS", CMD_ENABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS, 0 },
+	{ "DISABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS", CMD_DISABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS, 0 },
+
+	{ "SCHEDULE_SERVICEGROUP_HOST_DOWNTIME", CMD_SCHEDULE_SERVICEGROUP_HOST_DOWNTIME, 7 },
+	{ "SCHEDULE_SERVICEGROUP_SVC_DOWNTIME", CMD_SCHEDULE_SERVICEGROUP_SVC_DOWNTIME, 7 },
+
+	/**********************************/
+	/**** CONTACT-RELATED COMMANDS ****/
+	/**********************************/
+
+	{ "ENABLE_CONTACT_HOST_NOTIFICATIONS", CMD_ENABLE_CONTACT_HOST_NOTIFICATIONS, 0 },
+	{ "DISABLE_CONTACT_HOST_NOTIFICATIONS", CMD_DISABLE_CONTACT_HOST_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_CONTACT_SVC_NOTIFICATIONS", CMD_ENABLE_CONTACT_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_CONTACT_SVC_NOTIFICATIONS", CMD_DISABLE_CONTACT_SVC_NOTIFICATIONS, 0 },
+
+	{ "CHANGE_CONTACT_HOST_NOTIFICATION_TIMEPERIOD", CMD_CHANGE_CONTACT_HOST_NOTIFICATION_TIMEPERIOD, 0 },
+
+	{ "CHANGE_CONTACT_SVC_NOTIFICATION_TIMEPERIOD", CMD_CHANGE_CONTACT_SVC_NOTIFICATION_TIMEPERIOD, 0 },
+
+	{ "CHANGE_CONTACT_MODATTR", CMD_CHANGE_CONTACT_MODATTR, 0 },
+	{ "CHANGE_CONTACT_MODHATTR", CMD_CHANGE_CONTACT_MODHATTR, 0 },
+	{ "CHANGE_CONTACT_MODSATTR", CMD_CHANGE_CONTACT_MODSATTR, 0 },
+
+	/***************************************/
+	/**** CONTACTGROUP-RELATED COMMANDS ****/
+	/***************************************/
+
+	{ "ENABLE_CONTACTGROUP_HOST_NOTIFICATIONS", CMD_ENABLE_CONTACTGROUP_HOST_NOTIFICATIONS, 0 },
+	{ "DISABLE_CONTACTGROUP_HOST_NOTIFICATIONS", CMD_DISABLE_CONTACTGROUP_HOST_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_CONTACTGROUP_SVC_NOTIFICATIONS", CMD_ENABLE_CONTACTGROUP_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_CONTACTGROUP_SVC_NOTIFICATIONS", CMD_DISABLE_CONTACTGROUP_SVC_NOTIFICATIONS, 0 },
+
+	/**************************/
+	/****** MISC COMMANDS *****/
+	/**************************/
+
+	{ "PROCESS_FILE", CMD_PROCESS_FILE, 0 },
+};
+
+#define EXTERNAL_COMMAND_TYPES	(sizeof(external_command_types) / sizeof(external_command_types[0]))
+
+static int external_command_types_sorted = FALSE;
+
+
+static int external_command_type_cmp(const void *a_, const void *b_) {
+	struct external_command_type *a = (struct external_command_type *)a_;
+	struct external_command_type *b = (struct external_command_type *)b_;
+
+	return strcmp(a->name, b->name);
+}
+
+
+/* locates an external command by its name using a binary search */
+static const struct external_command_type *find_external_command_type(const char *name) {
+	unsigned int high, low = 0;
+	int value;
+	struct external_command_type *type;
+
+	if (external_command_types_sorted == FALSE) {
+		qsort(external_command_types, EXTERNAL_COMMAND_TYPES, sizeof(struct external_command_type), external_command_type_cmp);
+		external_command_types_sorted = TRUE;
+	}
+
+	high = EXTERNAL_COMMAND_TYPES;
+	while (high - low > 0) {
+		unsigned int mid = low + ((high - low) / 2);
+		type = &external_command_types[mid];
+		value = strcmp(name, type->name);
+		if (value == 0)
+			return type;
+		if (value > 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return NULL;
+}
+
+
+/* returns the type of an external command and the argument holding its author's name, CMD_NONE if it's unknown */
+int get_external_command_type(const char *name, int *author_position) {
+	const struct external_command_type *type = NULL;
+
+	if ((type = find_external_command_type(name)) == NULL)
+		return CMD_NONE;
+
+	if (author_position != NULL)
+		*author_position = type->author_position;
+
+	return type->command_type;
+}
+
+
 /* error string helper */
 static const char *cmd_error_strerror(int code) {
 	switch(code) {
@@ -116,6 +467,8 @@ static const char *cmd_error_strerror(int code) {
 /* checks for the existence of the external command file and processes all commands found in it */
 int check_for_external_commands(void) {
 	char *buffer = NULL;
+	char *block = NULL;
+	char *next = NULL;
 	int update_status = FALSE;
 	int result;
 
@@ -143,6 +496,23 @@ int check_for_external_commands(void) {
 	passive_check_result_list = NULL;
 	passive_check_result_list_tail = NULL;
 
+	/* process all commands read from the command file, in place */
+	while ((block = get_command_file_block()) != NULL) {
+
+		for (buffer = block; *buffer != '\x0'; buffer = next) {
+
+			/* remember where the next line starts, the command gets modified while it's processed */
+			next = buffer + strlen(buffer) + 1;
+
+			if ((result = process_external_command1(buffer)) != CMD_ERROR_OK) {
+				logit(NSLOG_EXTERNAL_COMMAND | NSLOG_RUNTIME_WARNING, TRUE, "External command error: %s\n", cmd_error_strerror(result));
+			}
+		}
+
+		my_free(block);
+	}
+	buffer = NULL;
+
 	/* process all commands found in the buffer */
 	while (1) {
 
@@ -242,6 +612,7 @@ int process_external_command1(char *cmd) {
 	time_t entry_time = 0L;
 	int command_type = CMD_NONE;
 	char *temp_ptr = NULL;
+	const struct external_command_type *type = NULL;
 	int author_position = 0;
 	int position = 1;
 	int result = OK;
@@ -256,527 +627,39 @@ int process_external_command1(char *cmd) {
 
 	log_debug_info(DEBUGL_EXTERNALCOMMANDS, 2, "Raw command entry: %s\n", cmd);
 
-	/* get the command entry time */
-	if ((temp_ptr = my_strtok(cmd, "[")) == NULL)
+	/* get the command entry time - everything is parsed in place */
+	if ((temp_ptr = strchr(cmd, '[')) == NULL || temp_ptr[1] == '\x0')
 		return CMD_ERROR_MALFORMED_COMMAND;
-	if ((temp_ptr = my_strtok(NULL, "]")) == NULL)
-		return CMD_ERROR_MALFORMED_COMMAND;
-	entry_time = (time_t)strtoul(temp_ptr, NULL, 10);
-
-	/* get the command identifier */
-	if ((temp_ptr = my_strtok(NULL, ";")) == NULL)
+	entry_time = (time_t)strtoul(temp_ptr + 1, NULL, 10);
+	if ((temp_ptr = strchr(temp_ptr + 1, ']')) == NULL || temp_ptr[1] == '\x0')
 		return CMD_ERROR_MALFORMED_COMMAND;
-	if ((command_id = (char *)strdup(temp_ptr + 1)) == NULL)
-		return CMD_ERROR_INTERNAL_ERROR;
 
-	/* get the command arguments */
-	if ((temp_ptr = my_strtok(NULL, "\n")) == NULL)
-		args = (char *)strdup("");
+	/* get the command identifier (skipping the blank after the timestamp) and its arguments */
+	command_id = temp_ptr + 1;
+	if ((args = strchr(command_id, ';')) != NULL)
+		*(args++) = '\x0';
 	else
-		args = (char *)strdup(temp_ptr);
-
-	if (args == NULL) {
-		my_free(command_id);
-		return CMD_ERROR_INTERNAL_ERROR;
-	}
+		args = command_id + strlen(command_id);
+	if (command_id[0] != '\x0')
+		command_id++;
+	if ((temp_ptr = strchr(args, '\n')) != NULL)
+		*temp_ptr = '\x0';
 
 	/* decide what type of command this is... */
-
-	/**************************/
-	/**** PROCESS COMMANDS ****/
-	/**************************/
-
-	if (!strcmp(command_id, "ENTER_STANDBY_MODE") || !strcmp(command_id, "DISABLE_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_NOTIFICATIONS;
-	else if (!strcmp(command_id, "ENTER_ACTIVE_MODE") || !strcmp(command_id, "ENABLE_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_NOTIFICATIONS_EXPIRE_TIME"))
-		command_type = CMD_DISABLE_NOTIFICATIONS_EXPIRE_TIME;
-
-	else if (!strcmp(command_id, "SHUTDOWN_PROGRAM") || !strcmp(command_id, "SHUTDOWN_PROCESS"))
-		command_type = CMD_SHUTDOWN_PROCESS;
-	else if (!strcmp(command_id, "RESTART_PROGRAM") || !strcmp(command_id, "RESTART_PROCESS"))
-		command_type = CMD_RESTART_PROCESS;
-
-	else if (!strcmp(command_id, "SAVE_STATE_INFORMATION"))
-		command_type = CMD_SAVE_STATE_INFORMATION;
-	else if (!strcmp(command_id, "READ_STATE_INFORMATION"))
-		command_type = CMD_READ_STATE_INFORMATION;
-	else if (!strcmp(command_id, "SYNC_STATE_INFORMATION"))
-		command_type = CMD_SYNC_STATE_INFORMATION;
-
-	else if (!strcmp(command_id, "ENABLE_EVENT_HANDLERS"))
-		command_type = CMD_ENABLE_EVENT_HANDLERS;
-	else if (!strcmp(command_id, "DISABLE_EVENT_HANDLERS"))
-		command_type = CMD_DISABLE_EVENT_HANDLERS;
-
-	else if (!strcmp(command_id, "FLUSH_PENDING_COMMANDS"))
-		command_type = CMD_FLUSH_PENDING_COMMANDS;
-
-	else if (!strcmp(command_id, "ENABLE_FAILURE_PREDICTION"))
-		command_type = CMD_ENABLE_FAILURE_PREDICTION;
-	else if (!strcmp(command_id, "DISABLE_FAILURE_PREDICTION"))
-		command_type = CMD_DISABLE_FAILURE_PREDICTION;
-
-	else if (!strcmp(command_id, "ENABLE_PERFORMANCE_DATA"))
-		command_type = CMD_ENABLE_PERFORMANCE_DATA;
-	else if (!strcmp(command_id, "DISABLE_PERFORMANCE_DATA"))
-		command_type = CMD_DISABLE_PERFORMANCE_DATA;
-
-	else if (!strcmp(command_id, "START_EXECUTING_HOST_CHECKS"))
-		command_type = CMD_START_EXECUTING_HOST_CHECKS;
-	else if (!strcmp(command_id, "STOP_EXECUTING_HOST_CHECKS"))
-		command_type = CMD_STOP_EXECUTING_HOST_CHECKS;
-
-	else if (!strcmp(command_id, "START_EXECUTING_SVC_CHECKS"))
-		command_type = CMD_START_EXECUTING_SVC_CHECKS;
-	else if (!strcmp(command_id, "STOP_EXECUTING_SVC_CHECKS"))
-		command_type = CMD_STOP_EXECUTING_SVC_CHECKS;
-
-	else if (!strcmp(command_id, "START_ACCEPTING_PASSIVE_HOST_CHECKS"))
-		command_type = CMD_START_ACCEPTING_PASSIVE_HOST_CHECKS;
-	else if (!strcmp(command_id, "STOP_ACCEPTING_PASSIVE_HOST_CHECKS"))
-		command_type = CMD_STOP_ACCEPTING_PASSIVE_HOST_CHECKS;
-
-	else if (!strcmp(command_id, "START_ACCEPTING_PASSIVE_SVC_CHECKS"))
-		command_type = CMD_START_ACCEPTING_PASSIVE_SVC_CHECKS;
-	else if (!strcmp(command_id, "STOP_ACCEPTING_PASSIVE_SVC_CHECKS"))
-		command_type = CMD_STOP_ACCEPTING_PASSIVE_SVC_CHECKS;
-
-	else if (!strcmp(command_id, "START_OBSESSING_OVER_HOST_CHECKS"))
-		command_type = CMD_START_OBSESSING_OVER_HOST_CHECKS;
-	else if (!strcmp(command_id, "STOP_OBSESSING_OVER_HOST_CHECKS"))
-		command_type = CMD_STOP_OBSESSING_OVER_HOST_CHECKS;
-
-	else if (!strcmp(command_id, "START_OBSESSING_OVER_SVC_CHECKS"))
-		command_type = CMD_START_OBSESSING_OVER_SVC_CHECKS;
-	else if (!strcmp(command_id, "STOP_OBSESSING_OVER_SVC_CHECKS"))
-		command_type = CMD_STOP_OBSESSING_OVER_SVC_CHECKS;
-
-	else if (!strcmp(command_id, "ENABLE_FLAP_DETECTION"))
-		command_type = CMD_ENABLE_FLAP_DETECTION;
-	else if (!strcmp(command_id, "DISABLE_FLAP_DETECTION"))
-		command_type = CMD_DISABLE_FLAP_DETECTION;
-
-	else if (!strcmp(command_id, "CHANGE_GLOBAL_HOST_EVENT_HANDLER"))
-		command_type = CMD_CHANGE_GLOBAL_HOST_EVENT_HANDLER;
-	else if (!strcmp(command_id, "CHANGE_GLOBAL_SVC_EVENT_HANDLER"))
-		command_type = CMD_CHANGE_GLOBAL_SVC_EVENT_HANDLER;
-
-	else if (!strcmp(command_id, "ENABLE_SERVICE_FRESHNESS_CHECKS"))
-		command_type = CMD_ENABLE_SERVICE_FRESHNESS_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_SERVICE_FRESHNESS_CHECKS"))
-		command_type = CMD_DISABLE_SERVICE_FRESHNESS_CHECKS;
-
-	else if (!strcmp(command_id, "ENABLE_HOST_FRESHNESS_CHECKS"))
-		command_type = CMD_ENABLE_HOST_FRESHNESS_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_HOST_FRESHNESS_CHECKS"))
-		command_type = CMD_DISABLE_HOST_FRESHNESS_CHECKS;
-
-
-	/*******************************/
-	/**** HOST-RELATED COMMANDS ****/
-	/*******************************/
-
-	else if (!strcmp(command_id, "ADD_HOST_COMMENT")) {
-		command_type = CMD_ADD_HOST_COMMENT;
-		author_position = 3;
-	} else if (!strcmp(command_id, "DEL_HOST_COMMENT"))
-		command_type = CMD_DEL_HOST_COMMENT;
-	else if (!strcmp(command_id, "DEL_ALL_HOST_COMMENTS"))
-		command_type = CMD_DEL_ALL_HOST_COMMENTS;
-
-	else if (!strcmp(command_id, "DELAY_HOST_NOTIFICATION"))
-		command_type = CMD_DELAY_HOST_NOTIFICATION;
-
-	else if (!strcmp(command_id, "ENABLE_HOST_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_HOST_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_HOST_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_HOST_NOTIFICATIONS;
-
-	else if (!strcmp(command_id, "ENABLE_ALL_NOTIFICATIONS_BEYOND_HOST"))
-		command_type = CMD_ENABLE_ALL_NOTIFICATIONS_BEYOND_HOST;
-	else if (!strcmp(command_id, "DISABLE_ALL_NOTIFICATIONS_BEYOND_HOST"))
-		command_type = CMD_DISABLE_ALL_NOTIFICATIONS_BEYOND_HOST;
-
-	else if (!strcmp(command_id, "ENABLE_HOST_AND_CHILD_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_HOST_AND_CHILD_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_HOST_AND_CHILD_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_HOST_AND_CHILD_NOTIFICATIONS;
-
-	else if (!strcmp(command_id, "ENABLE_HOST_SVC_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_HOST_SVC_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_HOST_SVC_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_HOST_SVC_NOTIFICATIONS;
-
-	else if (!strcmp(command_id, "ENABLE_HOST_SVC_CHECKS"))
-		command_type = CMD_ENABLE_HOST_SVC_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_HOST_SVC_CHECKS"))
-		command_type = CMD_DISABLE_HOST_SVC_CHECKS;
-
-	else if (!strcmp(command_id, "ENABLE_PASSIVE_HOST_CHECKS"))
-		command_type = CMD_ENABLE_PASSIVE_HOST_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_PASSIVE_HOST_CHECKS"))
-		command_type = CMD_DISABLE_PASSIVE_HOST_CHECKS;
-
-	else if (!strcmp(command_id, "SCHEDULE_HOST_SVC_CHECKS"))
-		command_type = CMD_SCHEDULE_HOST_SVC_CHECKS;
-	else if (!strcmp(command_id, "SCHEDULE_FORCED_HOST_SVC_CHECKS"))
-		command_type = CMD_SCHEDULE_FORCED_HOST_SVC_CHECKS;
-
-	else if (!strcmp(command_id, "ACKNOWLEDGE_HOST_PROBLEM")) {
-		command_type = CMD_ACKNOWLEDGE_HOST_PROBLEM;
-		author_position = 5;
-	} else if (!strcmp(command_id, "ACKNOWLEDGE_HOST_PROBLEM_EXPIRE")) {
-		command_type = CMD_ACKNOWLEDGE_HOST_PROBLEM_EXPIRE;
-		author_position = 6;
-	} else if (!strcmp(command_id, "REMOVE_HOST_ACKNOWLEDGEMENT"))
-		command_type = CMD_REMOVE_HOST_ACKNOWLEDGEMENT;
-
-	else if (!strcmp(command_id, "ACKNOWLEDGE_HOST_SVC_PROBLEM"))
-		command_type = CMD_ACKNOWLEDGE_HOST_SVC_PROBLEM;
-
-	else if (!strcmp(command_id, "ENABLE_HOST_EVENT_HANDLER"))
-		command_type = CMD_ENABLE_HOST_EVENT_HANDLER;
-	else if (!strcmp(command_id, "DISABLE_HOST_EVENT_HANDLER"))
-		command_type = CMD_DISABLE_HOST_EVENT_HANDLER;
-
-	else if (!strcmp(command_id, "ENABLE_HOST_CHECK"))
-		command_type = CMD_ENABLE_HOST_CHECK;
-	else if (!strcmp(command_id, "DISABLE_HOST_CHECK"))
-		command_type = CMD_DISABLE_HOST_CHECK;
-
-	else if (!strcmp(command_id, "SCHEDULE_HOST_CHECK"))
-		command_type = CMD_SCHEDULE_HOST_CHECK;
-	else if (!strcmp(command_id, "SCHEDULE_FORCED_HOST_CHECK"))
-		command_type = CMD_SCHEDULE_FORCED_HOST_CHECK;
-
-	else if (!strcmp(command_id, "SCHEDULE_HOST_DOWNTIME")) {
-		command_type = CMD_SCHEDULE_HOST_DOWNTIME;
-		author_position = 7;
-	} else if (!strcmp(command_id, "SCHEDULE_HOST_SVC_DOWNTIME")) {
-		command_type = CMD_SCHEDULE_HOST_SVC_DOWNTIME;
-		author_position = 7;
-	} else if (!strcmp(command_id, "DEL_HOST_DOWNTIME"))
-		command_type = CMD_DEL_HOST_DOWNTIME;
-	else if (!strcmp(command_id, "DEL_DOWNTIME_BY_HOST_NAME"))
-		command_type = CMD_DEL_DOWNTIME_BY_HOST_NAME;
-	else if (!strcmp(command_id, "DEL_DOWNTIME_BY_HOSTGROUP_NAME"))
-		command_type = CMD_DEL_DOWNTIME_BY_HOSTGROUP_NAME;
-
-	else if (!strcmp(command_id, "DEL_DOWNTIME_BY_START_TIME_COMMENT"))
-		command_type = CMD_DEL_DOWNTIME_BY_START_TIME_COMMENT;
-
-	else if (!strcmp(command_id, "ENABLE_HOST_FLAP_DETECTION"))
-		command_type = CMD_ENABLE_HOST_FLAP_DETECTION;
-	else if (!strcmp(command_id, "DISABLE_HOST_FLAP_DETECTION"))
-		command_type = CMD_DISABLE_HOST_FLAP_DETECTION;
-
-	else if (!strcmp(command_id, "START_OBSESSING_OVER_HOST"))
-		command_type = CMD_START_OBSESSING_OVER_HOST;
-	else if (!strcmp(command_id, "STOP_OBSESSING_OVER_HOST"))
-		command_type = CMD_STOP_OBSESSING_OVER_HOST;
-
-	else if (!strcmp(command_id, "CHANGE_HOST_EVENT_HANDLER"))
-		command_type = CMD_CHANGE_HOST_EVENT_HANDLER;
-	else if (!strcmp(command_id, "CHANGE_HOST_CHECK_COMMAND"))
-		command_type = CMD_CHANGE_HOST_CHECK_COMMAND;
-
-	else if (!strcmp(command_id, "CHANGE_NORMAL_HOST_CHECK_INTERVAL"))
-		command_type = CMD_CHANGE_NORMAL_HOST_CHECK_INTERVAL;
-	else if (!strcmp(command_id, "CHANGE_RETRY_HOST_CHECK_INTERVAL"))
-		command_type = CMD_CHANGE_RETRY_HOST_CHECK_INTERVAL;
-
-	else if (!strcmp(command_id, "CHANGE_MAX_HOST_CHECK_ATTEMPTS"))
-		command_type = CMD_CHANGE_MAX_HOST_CHECK_ATTEMPTS;
-
-	else if (!strcmp(command_id, "SCHEDULE_AND_PROPAGATE_TRIGGERED_HOST_DOWNTIME")) {
-		command_type = CMD_SCHEDULE_AND_PROPAGATE_TRIGGERED_HOST_DOWNTIME;
-		author_position = 7;
-
-	} else if (!strcmp(command_id, "SCHEDULE_AND_PROPAGATE_HOST_DOWNTIME")) {
-		command_type = CMD_SCHEDULE_AND_PROPAGATE_HOST_DOWNTIME;
-		author_position = 7;
-
-	} else if (!strcmp(command_id, "SET_HOST_NOTIFICATION_NUMBER"))
-		command_type = CMD_SET_HOST_NOTIFICATION_NUMBER;
-
-	else if (!strcmp(command_id, "CHANGE_HOST_CHECK_TIMEPERIOD"))
-		command_type = CMD_CHANGE_HOST_CHECK_TIMEPERIOD;
-
-	else if (!strcmp(command_id, "CHANGE_CUSTOM_HOST_VAR"))
-		command_type = CMD_CHANGE_CUSTOM_HOST_VAR;
-
-	else if (!strcmp(command_id, "SEND_CUSTOM_HOST_NOTIFICATION")) {
-		command_type = CMD_SEND_CUSTOM_HOST_NOTIFICATION;
-		author_position = 3;
-
-	} else if (!strcmp(command_id, "CHANGE_HOST_NOTIFICATION_TIMEPERIOD"))
-		command_type = CMD_CHANGE_HOST_NOTIFICATION_TIMEPERIOD;
-
-	else if (!strcmp(command_id, "CHANGE_HOST_MODATTR"))
-		command_type = CMD_CHANGE_HOST_MODATTR;
-
-
-	/************************************/
-	/**** HOSTGROUP-RELATED COMMANDS ****/
-	/************************************/
-
-	else if (!strcmp(command_id, "ENABLE_HOSTGROUP_HOST_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_HOSTGROUP_HOST_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_HOSTGROUP_HOST_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_HOSTGROUP_HOST_NOTIFICATIONS;
-
-	else if (!strcmp(command_id, "ENABLE_HOSTGROUP_SVC_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_HOSTGROUP_SVC_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_HOSTGROUP_SVC_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_HOSTGROUP_SVC_NOTIFICATIONS;
-
-	else if (!strcmp(command_id, "ENABLE_HOSTGROUP_HOST_CHECKS"))
-		command_type = CMD_ENABLE_HOSTGROUP_HOST_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_HOSTGROUP_HOST_CHECKS"))
-		command_type = CMD_DISABLE_HOSTGROUP_HOST_CHECKS;
-
-	else if (!strcmp(command_id, "ENABLE_HOSTGROUP_PASSIVE_HOST_CHECKS"))
-		command_type = CMD_ENABLE_HOSTGROUP_PASSIVE_HOST_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_HOSTGROUP_PASSIVE_HOST_CHECKS"))
-		command_type = CMD_DISABLE_HOSTGROUP_PASSIVE_HOST_CHECKS;
-
-	else if (!strcmp(command_id, "ENABLE_HOSTGROUP_SVC_CHECKS"))
-		command_type = CMD_ENABLE_HOSTGROUP_SVC_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_HOSTGROUP_SVC_CHECKS"))
-		command_type = CMD_DISABLE_HOSTGROUP_SVC_CHECKS;
-
-	else if (!strcmp(command_id, "ENABLE_HOSTGROUP_PASSIVE_SVC_CHECKS"))
-		command_type = CMD_ENABLE_HOSTGROUP_PASSIVE_SVC_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_HOSTGROUP_PASSIVE_SVC_CHECKS"))
-		command_type = CMD_DISABLE_HOSTGROUP_PASSIVE_SVC_CHECKS;
-
-	else if (!strcmp(command_id, "SCHEDULE_HOSTGROUP_HOST_DOWNTIME")) {
-		command_type = CMD_SCHEDULE_HOSTGROUP_HOST_DOWNTIME;
-		author_position = 7;
-	} else if (!strcmp(command_id, "SCHEDULE_HOSTGROUP_SVC_DOWNTIME")) {
-		command_type = CMD_SCHEDULE_HOSTGROUP_SVC_DOWNTIME;
-		author_position = 7;
-	}
-
-
-	/**********************************/
-	/**** SERVICE-RELATED COMMANDS ****/
-	/**********************************/
-
-	else if (!strcmp(command_id, "ADD_SVC_COMMENT")) {
-		command_type = CMD_ADD_SVC_COMMENT;
-		author_position = 4;
-	} else if (!strcmp(command_id, "DEL_SVC_COMMENT"))
-		command_type = CMD_DEL_SVC_COMMENT;
-	else if (!strcmp(command_id, "DEL_ALL_SVC_COMMENTS"))
-		command_type = CMD_DEL_ALL_SVC_COMMENTS;
-
-	else if (!strcmp(command_id, "SCHEDULE_SVC_CHECK"))
-		command_type = CMD_SCHEDULE_SVC_CHECK;
-	else if (!strcmp(command_id, "SCHEDULE_FORCED_SVC_CHECK"))
-		command_type = CMD_SCHEDULE_FORCED_SVC_CHECK;
-
-	else if (!strcmp(command_id, "ENABLE_SVC_CHECK"))
-		command_type = CMD_ENABLE_SVC_CHECK;
-	else if (!strcmp(command_id, "DISABLE_SVC_CHECK"))
-		command_type = CMD_DISABLE_SVC_CHECK;
-
-	else if (!strcmp(command_id, "ENABLE_PASSIVE_SVC_CHECKS"))
-		command_type = CMD_ENABLE_PASSIVE_SVC_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_PASSIVE_SVC_CHECKS"))
-		command_type = CMD_DISABLE_PASSIVE_SVC_CHECKS;
-
-	else if (!strcmp(command_id, "DELAY_SVC_NOTIFICATION"))
-		command_type = CMD_DELAY_SVC_NOTIFICATION;
-	else if (!strcmp(command_id, "ENABLE_SVC_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_SVC_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_SVC_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_SVC_NOTIFICATIONS;
-
-	else if (!strcmp(command_id, "PROCESS_SERVICE_CHECK_RESULT"))
-		command_type = CMD_PROCESS_SERVICE_CHECK_RESULT;
-	else if (!strcmp(command_id, "PROCESS_HOST_CHECK_RESULT"))
-		command_type = CMD_PROCESS_HOST_CHECK_RESULT;
-
-	else if (!strcmp(command_id, "ENABLE_SVC_EVENT_HANDLER"))
-		command_type = CMD_ENABLE_SVC_EVENT_HANDLER;
-	else if (!strcmp(command_id, "DISABLE_SVC_EVENT_HANDLER"))
-		command_type = CMD_DISABLE_SVC_EVENT_HANDLER;
-
-	else if (!strcmp(command_id, "ENABLE_SVC_FLAP_DETECTION"))
-		command_type = CMD_ENABLE_SVC_FLAP_DETECTION;
-	else if (!strcmp(command_id, "DISABLE_SVC_FLAP_DETECTION"))
-		command_type = CMD_DISABLE_SVC_FLAP_DETECTION;
-
-	else if (!strcmp(command_id, "SCHEDULE_SVC_DOWNTIME")) {
-		command_type = CMD_SCHEDULE_SVC_DOWNTIME;
-		author_position = 8;
-	} else if (!strcmp(command_id, "DEL_SVC_DOWNTIME"))
-		command_type = CMD_DEL_SVC_DOWNTIME;
-	else if (!strcmp(command_id, "ACKNOWLEDGE_SVC_PROBLEM")) {
-		command_type = CMD_ACKNOWLEDGE_SVC_PROBLEM;
-		author_position = 6;
-	} else if (!strcmp(command_id, "ACKNOWLEDGE_SVC_PROBLEM_EXPIRE")) {
-		command_type = CMD_ACKNOWLEDGE_SVC_PROBLEM_EXPIRE;
-		author_position = 7;
-	} else if (!strcmp(command_id, "REMOVE_SVC_ACKNOWLEDGEMENT"))
-		command_type = CMD_REMOVE_SVC_ACKNOWLEDGEMENT;
-
-	else if (!strcmp(command_id, "START_OBSESSING_OVER_SVC"))
-		command_type = CMD_START_OBSESSING_OVER_SVC;
-	else if (!strcmp(command_id, "STOP_OBSESSING_OVER_SVC"))
-		command_type = CMD_STOP_OBSESSING_OVER_SVC;
-
-	else if (!strcmp(command_id, "CHANGE_SVC_EVENT_HANDLER"))
-		command_type = CMD_CHANGE_SVC_EVENT_HANDLER;
-	else if (!strcmp(command_id, "CHANGE_SVC_CHECK_COMMAND"))
-		command_type = CMD_CHANGE_SVC_CHECK_COMMAND;
-
-	else if (!strcmp(command_id, "CHANGE_NORMAL_SVC_CHECK_INTERVAL"))
-		command_type = CMD_CHANGE_NORMAL_SVC_CHECK_INTERVAL;
-	else if (!strcmp(command_id, "CHANGE_RETRY_SVC_CHECK_INTERVAL"))
-		command_type = CMD_CHANGE_RETRY_SVC_CHECK_INTERVAL;
-
-	else if (!strcmp(command_id, "CHANGE_MAX_SVC_CHECK_ATTEMPTS"))
-		command_type = CMD_CHANGE_MAX_SVC_CHECK_ATTEMPTS;
-
-	else if (!strcmp(command_id, "SET_SVC_NOTIFICATION_NUMBER"))
-		command_type = CMD_SET_SVC_NOTIFICATION_NUMBER;
-
-	else if (!strcmp(command_id, "CHANGE_SVC_CHECK_TIMEPERIOD"))
-		command_type = CMD_CHANGE_SVC_CHECK_TIMEPERIOD;
-
-	else if (!strcmp(command_id, "CHANGE_CUSTOM_SVC_VAR"))
-		command_type = CMD_CHANGE_CUSTOM_SVC_VAR;
-
-	else if (!strcmp(command_id, "CHANGE_CUSTOM_CONTACT_VAR"))
-		command_type = CMD_CHANGE_CUSTOM_CONTACT_VAR;
-
-	else if (!strcmp(command_id, "SEND_CUSTOM_SVC_NOTIFICATION")) {
-		command_type = CMD_SEND_CUSTOM_SVC_NOTIFICATION;
-		author_position = 4;
-
-	} else if (!strcmp(command_id, "CHANGE_SVC_NOTIFICATION_TIMEPERIOD"))
-		command_type = CMD_CHANGE_SVC_NOTIFICATION_TIMEPERIOD;
-
-	else if (!strcmp(command_id, "CHANGE_SVC_MODATTR"))
-		command_type = CMD_CHANGE_SVC_MODATTR;
-
-
-	/***************************************/
-	/**** SERVICEGROUP-RELATED COMMANDS ****/
-	/***************************************/
-
-	else if (!strcmp(command_id, "ENABLE_SERVICEGROUP_HOST_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_SERVICEGROUP_HOST_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_SERVICEGROUP_HOST_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_SERVICEGROUP_HOST_NOTIFICATIONS;
-
-	else if (!strcmp(command_id, "ENABLE_SERVICEGROUP_SVC_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_SERVICEGROUP_SVC_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_SERVICEGROUP_SVC_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_SERVICEGROUP_SVC_NOTIFICATIONS;
-
-	else if (!strcmp(command_id, "ENABLE_SERVICEGROUP_HOST_CHECKS"))
-		command_type = CMD_ENABLE_SERVICEGROUP_HOST_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_SERVICEGROUP_HOST_CHECKS"))
-		command_type = CMD_DISABLE_SERVICEGROUP_HOST_CHECKS;
-
-	else if (!strcmp(command_id, "ENABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS"))
-		command_type = CMD_ENABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS"))
-		command_type = CMD_DISABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS;
-
-	else if (!strcmp(command_id, "ENABLE_SERVICEGROUP_SVC_CHECKS"))
-		command_type = CMD_ENABLE_SERVICEGROUP_SVC_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_SERVICEGROUP_SVC_CHECKS"))
-		command_type = CMD_DISABLE_SERVICEGROUP_SVC_CHECKS;
-
-	else if (!strcmp(command_id, "ENABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS"))
-		command_type = CMD_ENABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS;
-	else if (!strcmp(command_id, "DISABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS"))
-		command_type = CMD_DISABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS;
-
-	else if (!strcmp(command_id, "SCHEDULE_SERVICEGROUP_HOST_DOWNTIME")) {
-		command_type = CMD_SCHEDULE_SERVICEGROUP_HOST_DOWNTIME;
-		author_position = 7;
-	} else if (!strcmp(command_id, "SCHEDULE_SERVICEGROUP_SVC_DOWNTIME")) {
-		command_type = CMD_SCHEDULE_SERVICEGROUP_SVC_DOWNTIME;
-		author_position = 7;
+	if ((type = find_external_command_type(command_id)) != NULL) {
+		command_type = type->command_type;
+		author_position = type->author_position;
 	}
 
-
-	/**********************************/
-	/**** CONTACT-RELATED COMMANDS ****/
-	/**********************************/
-
-	else if (!strcmp(command_id, "ENABLE_CONTACT_HOST_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_CONTACT_HOST_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_CONTACT_HOST_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_CONTACT_HOST_NOTIFICATIONS;
-
-	else if (!strcmp(command_id, "ENABLE_CONTACT_SVC_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_CONTACT_SVC_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_CONTACT_SVC_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_CONTACT_SVC_NOTIFICATIONS;
-
-	else if (!strcmp(command_id, "CHANGE_CONTACT_HOST_NOTIFICATION_TIMEPERIOD"))
-		command_type = CMD_CHANGE_CONTACT_HOST_NOTIFICATION_TIMEPERIOD;
-
-	else if (!strcmp(command_id, "CHANGE_CONTACT_SVC_NOTIFICATION_TIMEPERIOD"))
-		command_type = CMD_CHANGE_CONTACT_SVC_NOTIFICATION_TIMEPERIOD;
-
-	else if (!strcmp(command_id, "CHANGE_CONTACT_MODATTR"))
-		command_type = CMD_CHANGE_CONTACT_MODATTR;
-	else if (!strcmp(command_id, "CHANGE_CONTACT_MODHATTR"))
-		command_type = CMD_CHANGE_CONTACT_MODHATTR;
-	else if (!strcmp(command_id, "CHANGE_CONTACT_MODSATTR"))
-		command_type = CMD_CHANGE_CONTACT_MODSATTR;
-
-	/***************************************/
-	/**** CONTACTGROUP-RELATED COMMANDS ****/
-	/***************************************/
-
-	else if (!strcmp(command_id, "ENABLE_CONTACTGROUP_HOST_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_CONTACTGROUP_HOST_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_CONTACTGROUP_HOST_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_CONTACTGROUP_HOST_NOTIFICATIONS;
-
-	else if (!strcmp(command_id, "ENABLE_CONTACTGROUP_SVC_NOTIFICATIONS"))
-		command_type = CMD_ENABLE_CONTACTGROUP_SVC_NOTIFICATIONS;
-	else if (!strcmp(command_id, "DISABLE_CONTACTGROUP_SVC_NOTIFICATIONS"))
-		command_type = CMD_DISABLE_CONTACTGROUP_SVC_NOTIFICATIONS;
-
-
-	/**************************/
-	/****** MISC COMMANDS *****/
-	/**************************/
-
-	else if (!strcmp(command_id, "PROCESS_FILE"))
-		command_type = CMD_PROCESS_FILE;
-
-
-
-	/****************************/
-	/****** CUSTOM COMMANDS *****/
-	/****************************/
-
+	/**** CUSTOM COMMANDS ****/
 	else if (command_id[0] == '_')
 		command_type = CMD_CUSTOM_COMMAND;
 
-
-
 	/**** UNKNOWN COMMAND ****/
 	else {
 		/* log the bad external command */
 		logit(NSLOG_EXTERNAL_COMMAND | NSLOG_RUNTIME_WARNING, TRUE, "Warning: Unrecognized external command -> %s;%s\n", command_id, args);
 
-		/* free memory */
-		my_free(command_id);
-		my_free(args);
-
 		return CMD_ERROR_UNKNOWN_COMMAND;
 	}
 
@@ -835,10 +718,6 @@ int process_external_command1(char *cmd) {
 	broker_external_command(NEBTYPE_EXTERNALCOMMAND_END, NEBFLAG_NONE, NEBATTR_NONE, command_type, entry_time, command_id, args, NULL);
 #endif
 
-	/* free memory */
-	my_free(command_id);
-	my_free(args);
-
 	return result;
 }
 
@@ -2232,17 +2111,8 @@ int process_passive_service_check(time_t check_time, char *host_name, char *svc_
 	/* find the host by its name or address */
 	if (find_host(host_name) != NULL)
 		real_host_name = host_name;
-	else {
-		for (temp_host = host_list; temp_host != NULL; temp_host = temp_host->next) {
-			if (!strcmp(host_name, temp_host->address)) {
-				real_host_name = temp_host->name;
-				break;
-			} else if (!strcmp(host_name, temp_host->address6)) {
-				real_host_name = temp_host->name;
-				break;
-			}
-		}
-	}
+	else if ((temp_host = find_host_by_address(host_name)) != NULL)
+		real_host_name = temp_host->name;
 
 	/* we couldn't find the host */
 	if (real_host_name == NULL) {
@@ -2376,17 +2246,8 @@ int process_passive_host_check(time_t check_time, char *host_name, int return_co
 	/* find the host by its name or address */
 	if ((temp_host = find_host(host_name)) != NULL)
 		real_host_name = host_name;
-	else {
-		for (temp_host = host_list; temp_host != NULL; temp_host = temp_host->next) {
-			if (!strcmp(host_name, temp_host->address)) {
-				real_host_name = temp_host->name;
-				break;
-			} else if (!strcmp(host_name, temp_host->address6)) {
-				real_host_name = temp_host->name;
-				break;
-			}
-		}
-	}
+	else if ((temp_host = find_host_by_address(host_name)) != NULL)
+		real_host_name = temp_host->name;
 
 	/* we couldn't find the host */
 	if (temp_host == NULL) {
@@ -3123,6 +2984,9 @@ int cmd_change_object_int_var(int cmd, char *args) {
 				schedule_host_check(temp_host, temp_host->next_check, CHECK_OPTION_NONE);
 		}
 
+		/* the freshness threshold may have changed */
+		update_host_freshness(temp_host);
+
 		break;
 
 	case CMD_CHANGE_RETRY_HOST_CHECK_INTERVAL:
@@ -3130,6 +2994,9 @@ int cmd_change_object_int_var(int cmd, char *args) {
 		temp_host->retry_interval = dval;
 		attr = MODATTR_RETRY_CHECK_INTERVAL;
 
+		/* the freshness threshold may have changed */
+		update_host_freshness(temp_host);
+
 		break;
 
 	case CMD_CHANGE_MAX_HOST_CHECK_ATTEMPTS:
@@ -3171,6 +3038,9 @@ int cmd_change_object_int_var(int cmd, char *args) {
 				schedule_service_check(temp_service, temp_service->next_check, CHECK_OPTION_NONE);
 		}
 
+		/* the freshness threshold may have changed */
+		update_service_freshness(temp_service);
+
 		break;
 
 	case CMD_CHANGE_RETRY_SVC_CHECK_INTERVAL:
@@ -3178,6 +3048,9 @@ int cmd_change_object_int_var(int cmd, char *args) {
 		temp_service->retry_interval = dval;
 		attr = MODATTR_RETRY_CHECK_INTERVAL;
 
+		/* the freshness threshold may have changed */
+		update_service_freshness(temp_service);
+
 		break;
 
 	case CMD_CHANGE_MAX_SVC_CHECK_ATTEMPTS:
@@ -3494,6 +3367,10 @@ int cmd_change_object_char_var(int cmd, char *args) {
 		temp_host->check_period = temp_ptr;
 		temp_host->check_period_ptr = temp_timeperiod;
 		attr = MODATTR_CHECK_TIMEPERIOD;
+
+		/* the freshness check may be waiting for the old check period to start */
+		update_host_freshness(temp_host);
+
 		break;
 
 	case CMD_CHANGE_HOST_NOTIFICATION_TIMEPERIOD:
@@ -3526,6 +3403,10 @@ int cmd_change_object_char_var(int cmd, char *args) {
 		temp_service->check_period = temp_ptr;
 		temp_service->check_period_ptr = temp_timeperiod;
 		attr = MODATTR_CHECK_TIMEPERIOD;
+
+		/* the freshness check may be waiting for the old check period to start */
+		update_service_freshness(temp_service);
+
 		break;
 
 	case CMD_CHANGE_SVC_NOTIFICATION_TIMEPERIOD:
@@ -3829,6 +3710,9 @@ void disable_service_checks(service *svc) {
 	svc->checks_enabled = FALSE;
 	svc->should_be_scheduled = FALSE;
 
+	/* this changes when the results expire */
+	update_service_freshness(svc);
+
 #ifdef USE_EVENT_BROKER
 	/* send data to event broker */
 	broker_adaptive_service_data(NEBTYPE_ADAPTIVESERVICE_UPDATE, NEBFLAG_NONE, NEBATTR_NONE, svc, CMD_NONE, attr, svc->modified_attributes, NULL);
@@ -3859,6 +3743,9 @@ void enable_service_checks(service *svc) {
 	svc->checks_enabled = TRUE;
 	svc->should_be_scheduled = TRUE;
 
+	/* this changes when the results expire */
+	update_service_freshness(svc);
+
 	/* services with no check intervals don't get checked */
 	if (svc->check_interval == 0)
 		svc->should_be_scheduled = FALSE;
@@ -4923,6 +4810,9 @@ void disable_host_checks(host *hst) {
 	hst->checks_enabled = FALSE;
 	hst->should_be_scheduled = FALSE;
 
+	/* this changes when the results expire */
+	update_host_freshness(hst);
+
 #ifdef USE_EVENT_BROKER
 	/* send data to event broker */
 	broker_adaptive_host_data(NEBTYPE_ADAPTIVEHOST_UPDATE, NEBFLAG_NONE, NEBATTR_NONE, hst, CMD_NONE, attr, hst->modified_attributes, NULL);
@@ -4952,6 +4842,9 @@ void enable_host_checks(host *hst) {
 	hst->checks_enabled = TRUE;
 	hst->should_be_scheduled = TRUE;
 
+	/* this changes when the results expire */
+	update_host_freshness(hst);
+
 	/* hosts with no check intervals don't get checked */
 	if (hst->check_interval == 0)
 		hst->should_be_scheduled = FALSE;
@@ -5121,6 +5014,7 @@ void enable_service_freshness_checks(service *svc) {
 		
 		/* set the freshness check flag */
 		svc->check_freshness = TRUE;
+		update_service_freshness(svc);
 
 #ifdef USE_EVENT_BROKER
 		/* send data to event broker */
@@ -5169,6 +5063,7 @@ void disable_service_freshness_checks(service *svc) {
 		
 		/* set the freshness check flag */
 		svc->check_freshness = FALSE;
+		update_service_freshness(svc);
 
 #ifdef USE_EVENT_BROKER
 		/* send data to event broker */
@@ -5215,6 +5110,7 @@ void enable_host_freshness_checks(host *hst) {
 
 		/* set the freshness check flag */
 		hst->check_freshness = TRUE;
+		update_host_freshness(hst);
 
 #ifdef USE_EVENT_BROKER
 		/* send data to event broker */
@@ -5261,6 +5157,7 @@ void disable_host_freshness_checks(host *hst) {
 		
 		/* set the freshness check flag */
 		hst->check_freshness = FALSE;
+		update_host_freshness(hst);
 
 #ifdef USE_EVENT_BROKER
 	/* send data to event broker */
@@ -5515,6 +5412,7 @@ void process_passive_checks(void) {
 	passive_check_result *temp_pcr = NULL;
 	passive_check_result *this_pcr = NULL;
 	passive_check_result *next_pcr = NULL;
+	check_result *new_cr = NULL;
 	char *checkresult_file = NULL;
 	int checkresult_file_fd = -1;
 	FILE *checkresult_file_fp = NULL;
@@ -5530,60 +5428,89 @@ void process_passive_checks(void) {
 
 	log_debug_info(DEBUGL_CHECKS, 1, "Submitting passive host/service check results obtained from external commands...\n");
 
-	/* open a temp file for storing check result(s) */
-	old_umask = umask(new_umask);
-	asprintf(&checkresult_file, "%s/checkXXXXXX", temp_path);
-	checkresult_file_fd = mkstemp(checkresult_file);
-	umask(old_umask);
+	/* we are the reaper, so there's no need to go through the check result queue directory */
+	if (use_check_result_channel == TRUE) {
 
-	if (checkresult_file_fd < 0) {
-		logit(NSLOG_RUNTIME_ERROR, TRUE, "Failed to open checkresult file '%s': %s\n", checkresult_file, strerror(errno));
-		free(checkresult_file);
-		return;
-	}
+		for (temp_pcr = passive_check_result_list; temp_pcr != NULL; temp_pcr = temp_pcr->next) {
+
+			if ((new_cr = (check_result *)malloc(sizeof(check_result))) == NULL)
+				continue;
+			init_check_result(new_cr);
 
-	checkresult_file_fp = fdopen(checkresult_file_fd, "w");
+			new_cr->object_check_type = temp_pcr->object_check_type;
+			new_cr->host_name = (char *)strdup((temp_pcr->host_name == NULL) ? "" : temp_pcr->host_name);
+			if (temp_pcr->object_check_type == SERVICE_CHECK)
+				new_cr->service_description = (char *)strdup((temp_pcr->service_description == NULL) ? "" : temp_pcr->service_description);
+			new_cr->check_type = (temp_pcr->object_check_type == HOST_CHECK) ? HOST_CHECK_PASSIVE : SERVICE_CHECK_PASSIVE;
+			new_cr->output_file = NULL;
+			new_cr->latency = temp_pcr->latency;
+			new_cr->start_time.tv_sec = temp_pcr->check_time;
+			new_cr->finish_time.tv_sec = temp_pcr->check_time;
+			new_cr->return_code = temp_pcr->return_code;
+			/* newlines in output are already escaped */
+			new_cr->output = (char *)strdup((temp_pcr->output == NULL) ? "" : temp_pcr->output);
 
-	time(&current_time);
-	fprintf(checkresult_file_fp, "### Passive Check Result File ###\n");
-	fprintf(checkresult_file_fp, "# Time: %s", ctime(&current_time));
-	fprintf(checkresult_file_fp, "file_time=%lu\n", (unsigned long)current_time);
-	fprintf(checkresult_file_fp, "\n");
+			add_check_result_to_list(new_cr);
+		}
+	}
 
-	log_debug_info(DEBUGL_CHECKS | DEBUGL_IPC, 1, "Passive check result(s) will be written to '%s' (fd=%d)\n", checkresult_file, checkresult_file_fd);
+	/* otherwise open a temp file for storing check result(s) */
+	else {
 
-	/* write all service checks to check result queue file for later processing */
-	for (temp_pcr = passive_check_result_list; temp_pcr != NULL; temp_pcr = temp_pcr->next) {
+		old_umask = umask(new_umask);
+		asprintf(&checkresult_file, "%s/checkXXXXXX", temp_path);
+		checkresult_file_fd = mkstemp(checkresult_file);
+		umask(old_umask);
 
-		/* write check results to file */
-		if (checkresult_file_fp) {
+		if (checkresult_file_fd < 0) {
+			logit(NSLOG_RUNTIME_ERROR, TRUE, "Failed to open checkresult file '%s': %s\n", checkresult_file, strerror(errno));
+			free(checkresult_file);
+			return;
+		}
 
-			fprintf(checkresult_file_fp, "### Icinga %s Check Result ###\n", (temp_pcr->object_check_type == SERVICE_CHECK) ? "Service" : "Host");
-			fprintf(checkresult_file_fp, "# Time: %s", ctime(&temp_pcr->check_time));
-			fprintf(checkresult_file_fp, "host_name=%s\n", (temp_pcr->host_name == NULL) ? "" : temp_pcr->host_name);
-			if (temp_pcr->object_check_type == SERVICE_CHECK)
-				fprintf(checkresult_file_fp, "service_description=%s\n", (temp_pcr->service_description == NULL) ? "" : temp_pcr->service_description);
-			fprintf(checkresult_file_fp, "check_type=%d\n", (temp_pcr->object_check_type == HOST_CHECK) ? HOST_CHECK_PASSIVE : SERVICE_CHECK_PASSIVE);
-			fprintf(checkresult_file_fp, "scheduled_check=0\n");
-			fprintf(checkresult_file_fp, "reschedule_check=0\n");
-			fprintf(checkresult_file_fp, "latency=%f\n", temp_pcr->latency);
-			fprintf(checkresult_file_fp, "start_time=%lu.%lu\n", temp_pcr->check_time, 0L);
-			fprintf(checkresult_file_fp, "finish_time=%lu.%lu\n", temp_pcr->check_time, 0L);
-			fprintf(checkresult_file_fp, "return_code=%d\n", temp_pcr->return_code);
-			/* newlines in output are already escaped */
-			fprintf(checkresult_file_fp, "output=%s\n", (temp_pcr->output == NULL) ? "" : temp_pcr->output);
-			fprintf(checkresult_file_fp, "\n");
+		checkresult_file_fp = fdopen(checkresult_file_fd, "w");
+
+		time(&current_time);
+		fprintf(checkresult_file_fp, "### Passive Check Result File ###\n");
+		fprintf(checkresult_file_fp, "# Time: %s", ctime(&current_time));
+		fprintf(checkresult_file_fp, "file_time=%lu\n", (unsigned long)current_time);
+		fprintf(checkresult_file_fp, "\n");
+
+		log_debug_info(DEBUGL_CHECKS | DEBUGL_IPC, 1, "Passive check result(s) will be written to '%s' (fd=%d)\n", checkresult_file, checkresult_file_fd);
+
+		/* write all service checks to check result queue file for later processing */
+		for (temp_pcr = passive_check_result_list; temp_pcr != NULL; temp_pcr = temp_pcr->next) {
+
+			/* write check results to file */
+			if (checkresult_file_fp) {
+
+				fprintf(checkresult_file_fp, "### Icinga %s Check Result ###\n", (temp_pcr->object_check_type == SERVICE_CHECK) ? "Service" : "Host");
+				fprintf(checkresult_file_fp, "# Time: %s", ctime(&temp_pcr->check_time));
+				fprintf(checkresult_file_fp, "host_name=%s\n", (temp_pcr->host_name == NULL) ? "" : temp_pcr->host_name);
+				if (temp_pcr->object_check_type == SERVICE_CHECK)
+					fprintf(checkresult_file_fp, "service_description=%s\n", (temp_pcr->service_description == NULL) ? "" : temp_pcr->service_description);
+				fprintf(checkresult_file_fp, "check_type=%d\n", (temp_pcr->object_check_type == HOST_CHECK) ? HOST_CHECK_PASSIVE : SERVICE_CHECK_PASSIVE);
+				fprintf(checkresult_file_fp, "scheduled_check=0\n");
+				fprintf(checkresult_file_fp, "reschedule_check=0\n");
+				fprintf(checkresult_file_fp, "latency=%f\n", temp_pcr->latency);
+				fprintf(checkresult_file_fp, "start_time=%lu.%lu\n", temp_pcr->check_time, 0L);
+				fprintf(checkresult_file_fp, "finish_time=%lu.%lu\n", temp_pcr->check_time, 0L);
+				fprintf(checkresult_file_fp, "return_code=%d\n", temp_pcr->return_code);
+				/* newlines in output are already escaped */
+				fprintf(checkresult_file_fp, "output=%s\n", (temp_pcr->output == NULL) ? "" : temp_pcr->output);
+				fprintf(checkresult_file_fp, "\n");
+			}
 		}
-	}
 
-	/* close the temp file */
-	fclose(checkresult_file_fp);
+		/* close the temp file */
+		fclose(checkresult_file_fp);
 
-	/* move check result to queue directory */
-	move_check_result_to_queue(checkresult_file);
+		/* move check result to queue directory */
+		move_check_result_to_queue(checkresult_file);
 
-	/* free memory */
-	my_free(checkresult_file);
+		/* free memory */
+		my_free(checkresult_file);
+	}
 
 	/* free memory for the passive check result list */
 	this_pcr = passive_check_result_list;
@@ -185,6 +185,7 @@ extern double   high_host_flap_threshold;
 
 extern int      use_large_installation_tweaks;
 extern int      enable_environment_macros;
+extern char     *environment_macros;
 extern int      free_child_process_memory;
 extern int      child_processes_fork_twice;
 
@@ -231,6 +232,12 @@ extern unsigned long    max_debug_file_size;
 extern int              allow_empty_hostgroup_assignment;
 
 extern unsigned long    max_check_result_list_items;
+
+extern int              check_worker_processes;
+extern int              check_worker_queue_depth;
+extern int              check_result_reaper_threads;
+
+extern int              use_check_result_channel;
 extern int		enable_state_based_escalation_ranges;
 
 /******************************************************************/
@@ -1382,6 +1389,11 @@ int read_main_config_file(char *main_config_file) {
 		else if (!strcmp(variable, "enable_environment_macros"))
 			enable_environment_macros = (atoi(value) > 0) ? TRUE : FALSE;
 
+		else if (!strcmp(variable, "environment_macros")) {
+			my_free(environment_macros);
+			environment_macros = (char *)strdup(value);
+		}
+
 		else if (!strcmp(variable, "free_child_process_memory"))
 			free_child_process_memory = (atoi(value) > 0) ? TRUE : FALSE;
 
@@ -1485,6 +1497,50 @@ int read_main_config_file(char *main_config_file) {
 		else if (!strcmp(variable, "max_check_result_list_items"))
 			max_check_result_list_items = strtoul(value, NULL, 0);
 
+		else if (!strcmp(variable, "check_worker_processes")) {
+
+			check_worker_processes = atoi(value);
+
+			if (check_worker_processes < 0) {
+				asprintf(&error_message, "Illegal value for check_worker_processes");
+				error = TRUE;
+				break;
+			}
+		}
+
+		else if (!strcmp(variable, "check_worker_queue_depth")) {
+
+			check_worker_queue_depth = atoi(value);
+
+			if (check_worker_queue_depth <= 0) {
+				asprintf(&error_message, "Illegal value for check_worker_queue_depth");
+				error = TRUE;
+				break;
+			}
+		}
+
+		else if (!strcmp(variable, "check_result_reaper_threads")) {
+
+			check_result_reaper_threads = atoi(value);
+
+			if (check_result_reaper_threads < 0) {
+				asprintf(&error_message, "Illegal value for check_result_reaper_threads");
+				error = TRUE;
+				break;
+			}
+		}
+
+		else if (!strcmp(variable, "use_check_result_channel")) {
+
+			if (strlen(value) != 1 || value[0] < '0' || value[0] > '1') {
+				asprintf(&error_message, "Illegal value for use_check_result_channel");
+				error = TRUE;
+				break;
+			}
+
+			use_check_result_channel = (atoi(value) > 0) ? TRUE : FALSE;
+		}
+
                 else if (!strcmp(variable, "enable_state_based_escalation_ranges")) {
 
                         if (strlen(value) != 1 || value[0] < '0' || value[0] > '1') {
@@ -31,6 +31,7 @@
 #include "../include/icinga.h"
 #include "../include/broker.h"
 #include "../include/sretention.h"
+#include "../include/skiplist.h"
 
 extern char	*config_file;
 
@@ -92,6 +93,19 @@ timed_event *event_list_low_tail = NULL;
 timed_event *event_list_high = NULL;
 timed_event *event_list_high_tail = NULL;
 
+/*
+ * run time index of the event lists: one slot per distinct run time,
+ * pointing to the last event queued for that second. add_event() uses
+ * it to find the insertion point without walking the list.
+ */
+typedef struct timed_event_slot_struct {
+	time_t run_time;
+	timed_event *last;
+} timed_event_slot;
+
+static skiplist *event_list_low_slots = NULL;
+static skiplist *event_list_high_slots = NULL;
+
 extern host     *host_list;
 extern service  *service_list;
 
@@ -1028,52 +1042,125 @@ void reschedule_event(timed_event *event, timed_event **event_list, timed_event
 }
 
 
+/* compares two event list slots by run time */
+static int compare_event_slots(void *a, void *b) {
+	timed_event_slot *sa = (timed_event_slot *)a;
+	timed_event_slot *sb = (timed_event_slot *)b;
+
+	if (sa->run_time < sb->run_time)
+		return -1;
+	if (sa->run_time > sb->run_time)
+		return 1;
+	return 0;
+}
+
+
+/* returns the run time index for one of our own event lists, NULL for any other list */
+static skiplist *get_event_list_slots(timed_event **event_list) {
+	skiplist **slots = NULL;
+
+	if (event_list == &event_list_low)
+		slots = &event_list_low_slots;
+	else if (event_list == &event_list_high)
+		slots = &event_list_high_slots;
+	else
+		return NULL;
+
+	if (*slots == NULL)
+		*slots = skiplist_new(15, 0.5, FALSE, FALSE, compare_event_slots);
+
+	return *slots;
+}
+
+
+/* drops all slots of an event list index */
+static void empty_event_list_slots(skiplist *slots) {
+	timed_event_slot *temp_slot = NULL;
+
+	if (slots == NULL)
+		return;
+
+	while ((temp_slot = (timed_event_slot *)skiplist_pop(slots)) != NULL)
+		my_free(temp_slot);
+
+	skiplist_empty(slots);
+}
+
+
+/* frees the run time indexes of the event lists */
+void free_event_list_slots(void) {
+
+	empty_event_list_slots(event_list_low_slots);
+	skiplist_free(&event_list_low_slots);
+
+	empty_event_list_slots(event_list_high_slots);
+	skiplist_free(&event_list_high_slots);
+
+	return;
+}
+
+
 /* add an event to list ordered by execution time */
 void add_event(timed_event *event, timed_event **event_list, timed_event **event_list_tail) {
+	skiplist *slots = NULL;
+	timed_event_slot *temp_slot = NULL;
+	timed_event_slot search_slot;
 	timed_event *temp_event = NULL;
-	timed_event *first_event = NULL;
 
 	log_debug_info(DEBUGL_FUNCTIONS, 0, "add_event()\n");
 
 	event->next = NULL;
 	event->prev = NULL;
 
-	first_event = *event_list;
+	slots = get_event_list_slots(event_list);
 
-	/* add the event to the head of the list if there are no other events */
+	/* find the last event that runs at or before this one (the slot index is stale if the list was reset) */
 	if (*event_list == NULL) {
-		*event_list = event;
-		*event_list_tail = event;
+		empty_event_list_slots(slots);
+	} else if (event->run_time >= (*event_list)->run_time) {
+		if (slots != NULL) {
+			search_slot.run_time = event->run_time;
+			if ((temp_slot = (timed_event_slot *)skiplist_find_floor(slots, &search_slot, NULL)) != NULL)
+				temp_event = temp_slot->last;
+		} else {
+			/* start from the end of the list, as new events are likely to be executed in the future, rather than now... */
+			for (temp_event = *event_list_tail; temp_event != NULL; temp_event = temp_event->prev) {
+				if (event->run_time >= temp_event->run_time)
+					break;
+			}
+		}
 	}
 
-	/* add event to head of the list if it should be executed first */
-	else if (event->run_time < first_event->run_time) {
-		event->prev = NULL;
-		(*event_list)->prev = event;
+	/* add the event to the head of the list if it should be executed first */
+	if (temp_event == NULL) {
 		event->next = *event_list;
+		if (*event_list == NULL)
+			*event_list_tail = event;
+		else
+			(*event_list)->prev = event;
 		*event_list = event;
 	}
 
-	/* else place the event according to next execution time */
+	/* else place the event behind its predecessor */
 	else {
+		event->next = temp_event->next;
+		event->prev = temp_event;
+		temp_event->next = event;
+		if (event->next == NULL)
+			*event_list_tail = event;
+		else
+			event->next->prev = event;
+	}
 
-		/* start from the end of the list, as new events are likely to be executed in the future, rather than now... */
-		for (temp_event = *event_list_tail; temp_event != NULL; temp_event = temp_event->prev) {
-			if (event->run_time >= temp_event->run_time) {
-				event->next = temp_event->next;
-				event->prev = temp_event;
-				temp_event->next = event;
-				if (event->next == NULL)
-					*event_list_tail = event;
-				else
-					event->next->prev = event;
-				break;
-			} else if (temp_event->prev == NULL) {
-				temp_event->prev = event;
-				event->next = temp_event;
-				*event_list = event;
-				break;
-			}
+	/* the new event is now the last one to run at this time */
+	if (slots != NULL) {
+		if (temp_slot != NULL && temp_slot->run_time == event->run_time)
+			temp_slot->last = event;
+		else if ((temp_slot = (timed_event_slot *)malloc(sizeof(timed_event_slot))) != NULL) {
+			temp_slot->run_time = event->run_time;
+			temp_slot->last = event;
+			if (skiplist_insert(slots, (void *)temp_slot) != SKIPLIST_OK)
+				my_free(temp_slot);
 		}
 	}
 
@@ -1087,20 +1174,14 @@ void add_event(timed_event *event, timed_event **event_list, timed_event **event
 
 
 
-/* remove an event from the queue */
-void remove_event(timed_event *event, timed_event **event_list, timed_event **event_list_tail) {
+/* unlinks an event from the queue without notifying the broker */
+static void unlink_event(timed_event *event, timed_event **event_list, timed_event **event_list_tail) {
+	skiplist *slots = NULL;
+	timed_event_slot *temp_slot = NULL;
+	timed_event_slot search_slot;
+	void *node_ptr = NULL;
 	timed_event *prev_event, *next_event;
 
-	log_debug_info(DEBUGL_FUNCTIONS, 0, "remove_event()\n");
-
-	if (!event)
-		return;
-
-#ifdef USE_EVENT_BROKER
-	/* send event data to broker */
-	broker_timed_event(NEBTYPE_TIMEDEVENT_REMOVE, NEBFLAG_NONE, NEBATTR_NONE, event, NULL);
-#endif
-
 	if (*event_list == NULL)
 		return;
 
@@ -1113,6 +1194,20 @@ void remove_event(timed_event *event, timed_event **event_list, timed_event **ev
 	prev_event = event->prev;
 	next_event = event->next;
 
+	/* hand the run time slot over to the previous event, or drop it if it's empty now */
+	if ((slots = get_event_list_slots(event_list)) != NULL) {
+		search_slot.run_time = event->run_time;
+		temp_slot = (timed_event_slot *)skiplist_find_first(slots, &search_slot, &node_ptr);
+		if (temp_slot != NULL && temp_slot->last == event) {
+			if (prev_event != NULL && prev_event->run_time == event->run_time)
+				temp_slot->last = prev_event;
+			else {
+				skiplist_delete_node(slots, node_ptr);
+				my_free(temp_slot);
+			}
+		}
+	}
+
 	if (prev_event) {
 		prev_event->next = next_event;
 	}
@@ -1136,6 +1231,30 @@ void remove_event(timed_event *event, timed_event **event_list, timed_event **ev
 	 * and after the deleted event.
 	 * head and tail pointers are now NULL in this case
 	 */
+	event->next = NULL;
+	event->prev = NULL;
+
+	return;
+}
+
+
+
+/* remove an event from the queue */
+void remove_event(timed_event *event, timed_event **event_list, timed_event **event_list_tail) {
+
+	log_debug_info(DEBUGL_FUNCTIONS, 0, "remove_event()\n");
+
+	if (!event)
+		return;
+
+#ifdef USE_EVENT_BROKER
+	/* send event data to broker */
+	broker_timed_event(NEBTYPE_TIMEDEVENT_REMOVE, NEBFLAG_NONE, NEBATTR_NONE, event, NULL);
+#endif
+
+	unlink_event(event, event_list, event_list_tail);
+
+	return;
 }
 
 
@@ -1222,16 +1341,18 @@ int event_execution_loop(void) {
 			while ((wait_result = waitpid(-1, NULL, WNOHANG)) > 0);
 		}
 
+		/* pick up results from the check workers right away, so they get new checks and don't block on a full socket */
+		read_check_worker_results();
+
+		/* drain the check result channel before it fills up and results spill over to the queue directory */
+		read_check_result_channel();
+
 		/* handle high priority events */
 		if (event_list_high != NULL && (current_time >= event_list_high->run_time)) {
 
 			/* remove the first event from the timing loop */
 			temp_event = event_list_high;
-			event_list_high = event_list_high->next;
-
-			/* we may have just removed the only item from the list */
-			if (event_list_high != NULL)
-				event_list_high->prev = NULL;
+			unlink_event(temp_event, &event_list_high, &event_list_high_tail);
 
 			/* handle the event */
 			handle_timed_event(temp_event);
@@ -1379,10 +1500,7 @@ int event_execution_loop(void) {
 
 				/* remove the first event from the timing loop */
 				temp_event = event_list_low;
-				event_list_low = event_list_low->next;
-				/* we may have just removed the only item from the list */
-				if (event_list_low != NULL)
-					event_list_low->prev = NULL;
+				unlink_event(temp_event, &event_list_low, &event_list_low_tail);
 
 				log_debug_info(DEBUGL_EVENTS, 1, "Running event...\n");
 
@@ -226,6 +226,7 @@ double          high_host_flap_threshold = DEFAULT_HIGH_HOST_FLAP_THRESHOLD;
 
 int             use_large_installation_tweaks = DEFAULT_USE_LARGE_INSTALLATION_TWEAKS;
 int             enable_environment_macros = TRUE;
+char            *environment_macros = NULL;
 int             free_child_process_memory = -1;
 int             child_processes_fork_twice = -1;
 
@@ -279,6 +280,13 @@ unsigned long   max_debug_file_size = DEFAULT_MAX_DEBUG_FILE_SIZE;
 
 unsigned long   max_check_result_list_items = DEFAULT_MAX_CHECK_RESULT_LIST_ITEMS;
 
+int             check_worker_processes = DEFAULT_CHECK_WORKER_PROCESSES;
+int             check_worker_queue_depth = DEFAULT_CHECK_WORKER_QUEUE_DEPTH;
+check_worker    *check_workers = NULL;
+int             check_result_reaper_threads = DEFAULT_CHECK_RESULT_REAPER_THREADS;
+
+int             use_check_result_channel = DEFAULT_USE_CHECK_RESULT_CHANNEL;
+
 int		enable_state_based_escalation_ranges = FALSE;
 
 
@@ -690,6 +698,12 @@ int main(int argc, char **argv, char **env) {
 				exit(ERROR);
 			}
 
+			/* open the check result channel before starting the check workers, so they can use it as well */
+			open_check_result_channel();
+
+			/* start the persistent check worker processes before modules and object data are loaded, so they don't carry a copy of them */
+			init_check_workers();
+
 #ifdef USE_EVENT_BROKER
 			/* initialize modules */
 			neb_init_modules();
@@ -773,6 +787,9 @@ int main(int argc, char **argv, char **env) {
 				exit(ERROR);
 			}
 
+			/* parse the command lines once, rather than every time a command is run */
+			compile_command_templates();
+
 
 
 			/* initialize embedded Perl interpreter */
@@ -837,6 +854,9 @@ int main(int argc, char **argv, char **env) {
 				exit(ERROR);
 			}
 
+			/* start the threads helping the check result reaper */
+			init_check_result_reaper_threads();
+
 			/* initialize status data unless we're starting */
 			if (sigrestart == FALSE)
 				initialize_status_data(config_file);
@@ -913,6 +933,10 @@ int main(int argc, char **argv, char **env) {
 				broker_program_state(NEBTYPE_PROCESS_RESTART, NEBFLAG_USER_INITIATED, NEBATTR_RESTART_NORMAL, NULL);
 #endif
 
+			/* let the check workers finish their running checks and exit */
+			shutdown_check_workers();
+			shutdown_check_result_reaper_threads();
+
 			/* save service and host state information */
 			save_state_information(FALSE);
 			cleanup_retention_data(config_file);
@@ -936,6 +960,10 @@ int main(int argc, char **argv, char **env) {
 				close_command_file();
 			}
 
+			/* move check results still in transit to the check result queue directory unless we're restarting */
+			if (sigrestart == FALSE)
+				close_check_result_channel();
+
 			/* cleanup embedded perl interpreter */
 			if (sigrestart == FALSE)
 				deinit_embedded_perl();
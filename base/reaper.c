@@ -0,0 +1,218 @@
+/*****************************************************************************
+ *
+ * REAPER.C - Check result reaper threads for Icinga
+ *
+ * Copyright (c) 2009-2015 Icinga Development Team (http://www.icinga.org)
+ *
+ * License:
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *****************************************************************************/
+
+/*
+ * The check result reaper hands each batch of queued check results to a
+ * small pool of threads, which look up the host/service and parse the
+ * plugin output (see decode_check_result()).  The main thread walks the
+ * batch in order and only does the state handling, which must not run
+ * concurrently.  Whenever the result it needs next hasn't been picked up
+ * by a thread yet, the main thread decodes it itself, so a batch never
+ * waits for idle threads - and without any threads everything simply
+ * runs on the main thread.
+ */
+
+#include "../include/config.h"
+#include "../include/common.h"
+#include "../include/objects.h"
+#include "../include/icinga.h"
+
+extern int      check_result_reaper_threads;
+
+static pthread_t *reaper_threads = NULL;
+static int reaper_thread_count = 0;
+
+/* the current batch - all protected by reaper_lock */
+static pthread_mutex_t reaper_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reaper_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t reaper_done_cond = PTHREAD_COND_INITIALIZER;
+static decoded_check_result *reaper_jobs = NULL;
+static int reaper_job_count = 0;
+static int reaper_next_job = 0;
+static int reaper_busy_threads = 0;
+static int reaper_shutdown = FALSE;
+
+static void *check_result_reaper_thread(void *);
+
+
+
+/* starts the check result reaper threads */
+int init_check_result_reaper_threads(void) {
+	sigset_t newmask;
+	register int x = 0;
+
+	if (check_result_reaper_threads <= 0 || reaper_threads != NULL)
+		return OK;
+
+	if ((reaper_threads = (pthread_t *)calloc(check_result_reaper_threads, sizeof(pthread_t))) == NULL)
+		return ERROR;
+
+	reaper_shutdown = FALSE;
+
+	/* new threads should block all signals */
+	sigfillset(&newmask);
+	pthread_sigmask(SIG_BLOCK, &newmask, NULL);
+
+	for (x = 0; x < check_result_reaper_threads; x++) {
+		if (pthread_create(&reaper_threads[x], NULL, check_result_reaper_thread, NULL)) {
+			logit(NSLOG_RUNTIME_ERROR, TRUE, "Error: Could not create check result reaper thread #%d: %s\n", x + 1, strerror(errno));
+			break;
+		}
+	}
+	reaper_thread_count = x;
+
+	/* main thread should unblock all signals */
+	pthread_sigmask(SIG_UNBLOCK, &newmask, NULL);
+
+	log_debug_info(DEBUGL_CHECKS, 0, "Started %d check result reaper threads\n", reaper_thread_count);
+
+	return OK;
+}
+
+
+
+/* stops the check result reaper threads */
+int shutdown_check_result_reaper_threads(void) {
+	register int x = 0;
+
+	if (reaper_threads == NULL)
+		return OK;
+
+	pthread_mutex_lock(&reaper_lock);
+	reaper_shutdown = TRUE;
+	pthread_cond_broadcast(&reaper_work_cond);
+	pthread_mutex_unlock(&reaper_lock);
+
+	for (x = 0; x < reaper_thread_count; x++)
+		pthread_join(reaper_threads[x], NULL);
+
+	my_free(reaper_threads);
+	reaper_thread_count = 0;
+
+	return OK;
+}
+
+
+
+/* decodes the next unclaimed result of the current batch - must be called with reaper_lock held */
+static void decode_next_check_result(void) {
+	decoded_check_result *decoded = NULL;
+
+	decoded = &reaper_jobs[reaper_next_job++];
+	reaper_busy_threads++;
+
+	pthread_mutex_unlock(&reaper_lock);
+	decode_check_result(decoded);
+	pthread_mutex_lock(&reaper_lock);
+
+	decoded->is_decoded = TRUE;
+	reaper_busy_threads--;
+
+	return;
+}
+
+
+
+/* reaper thread - decodes check results of the current batch */
+static void *check_result_reaper_thread(void *arg) {
+
+	pthread_mutex_lock(&reaper_lock);
+
+	while (reaper_shutdown == FALSE) {
+
+		if (reaper_next_job >= reaper_job_count) {
+			pthread_cond_wait(&reaper_work_cond, &reaper_lock);
+			continue;
+		}
+
+		decode_next_check_result();
+
+		pthread_cond_broadcast(&reaper_done_cond);
+	}
+
+	pthread_mutex_unlock(&reaper_lock);
+
+	return NULL;
+}
+
+
+
+/* publishes a batch of check results to the reaper threads */
+int queue_check_results_for_decoding(decoded_check_result *jobs, int count) {
+
+	pthread_mutex_lock(&reaper_lock);
+
+	reaper_jobs = jobs;
+	reaper_job_count = count;
+	reaper_next_job = 0;
+
+	if (reaper_thread_count > 0)
+		pthread_cond_broadcast(&reaper_work_cond);
+
+	pthread_mutex_unlock(&reaper_lock);
+
+	return OK;
+}
+
+
+
+/* returns a decoded check result of the current batch, waiting for (or doing) the work if necessary */
+decoded_check_result *get_decoded_check_result(int index) {
+
+	pthread_mutex_lock(&reaper_lock);
+
+	while (reaper_jobs[index].is_decoded == FALSE) {
+
+		/* nobody picked it up yet, so it's the next one in line */
+		if (reaper_next_job <= index)
+			decode_next_check_result();
+		else
+			pthread_cond_wait(&reaper_done_cond, &reaper_lock);
+	}
+
+	pthread_mutex_unlock(&reaper_lock);
+
+	return &reaper_jobs[index];
+}
+
+
+
+/* withdraws the current batch, waiting for the threads to finish the results they are working on */
+int finish_check_result_decoding(void) {
+
+	pthread_mutex_lock(&reaper_lock);
+
+	/* results not picked up yet stay undecoded */
+	reaper_job_count = reaper_next_job;
+
+	while (reaper_busy_threads > 0)
+		pthread_cond_wait(&reaper_done_cond, &reaper_lock);
+
+	reaper_jobs = NULL;
+	reaper_job_count = 0;
+	reaper_next_job = 0;
+
+	pthread_mutex_unlock(&reaper_lock);
+
+	return OK;
+}
@@ -33,6 +33,7 @@
 #include "../include/broker.h"
 #include "../include/nebmods.h"
 #include "../include/nebmodules.h"
+#include "../include/skiplist.h"
 
 
 #ifdef EMBEDDEDPERL
@@ -44,6 +45,20 @@ int use_embedded_perl = TRUE;
 /* mutex lock for operations on check_result_list */
 pthread_mutex_t check_result_list_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * finish time index of the check result list: one slot per distinct
+ * finish time, pointing to the last result queued for that time.
+ * add_check_result_to_list() uses it to find the insertion point
+ * without walking the list. both are protected by check_result_list_mutex.
+ */
+typedef struct check_result_slot_struct {
+	struct timeval finish_time;
+	check_result *last;
+} check_result_slot;
+
+static skiplist *check_result_list_slots = NULL;
+static unsigned long check_result_list_items = 0L;
+
 extern char	*config_file;
 extern char	*log_file;
 extern char     *command_file;
@@ -225,6 +240,7 @@ extern double   high_host_flap_threshold;
 
 extern int      use_large_installation_tweaks;
 extern int      enable_environment_macros;
+extern char     *environment_macros;
 extern int      free_child_process_memory;
 extern int      child_processes_fork_twice;
 
@@ -284,12 +300,46 @@ extern unsigned long   max_debug_file_size;
 
 extern unsigned long   max_check_result_list_items;
 
+extern int             check_worker_processes;
+extern int             check_worker_queue_depth;
+extern int             check_result_reaper_threads;
+
+extern int             use_check_result_channel;
+
 /* from GNU defines errno as a macro, since it's a per-thread variable */
 #ifndef errno
 extern int errno;
 #endif
 
 
+/* socket pair used by check processes to pass results to the reaper */
+static int check_result_channel[2] = { -1, -1 };
+static char *check_result_channel_buffer = NULL;
+
+/*
+ * lock-free single producer/single consumer ring between the command file
+ * worker thread and the main thread.  each slot holds a block of complete,
+ * NUL-terminated command lines (the block ends with an empty string).
+ * only the worker thread advances the head, only the main thread the tail.
+ */
+static char *command_file_ring[COMMAND_FILE_RING_SLOTS];
+static volatile unsigned long command_file_ring_head = 0;
+static volatile unsigned long command_file_ring_tail = 0;
+static volatile unsigned long command_file_ring_high = 0;
+static volatile int command_file_reader_waiting = FALSE;
+static int command_file_wakeup_pipe[2] = { -1, -1 };
+
+/* owned by the worker thread, freed by its cleanup handler */
+static char *command_file_read_buffer = NULL;
+static char *command_file_pending_block = NULL;
+
+#ifdef MSG_NOSIGNAL
+#define CHECK_RESULT_CHANNEL_SEND_FLAGS		MSG_NOSIGNAL
+#else
+#define CHECK_RESULT_CHANNEL_SEND_FLAGS		0
+#endif
+
+
 /******************************************************************/
 /****************** REGISTERED FILE DESCRIPTORS *******************/
 /******************************************************************/
@@ -755,8 +805,8 @@ int my_system(char *cmd, int timeout, int *early_timeout, double *exectime, char
 }
 
 
-/* given a "raw" command, return the "expanded" or "whole" command line */
-int get_raw_command_line_r(icinga_macros *mac, command *cmd_ptr, char *cmd, char **full_command, int macro_options) {
+/* sets the argv macros to the (processed) arguments of a "raw" command */
+static void grab_command_argv_macros_r(icinga_macros *mac, char *cmd, int macro_options) {
 	char temp_arg[MAX_COMMAND_BUFFER] = "";
 	char *arg_buffer = NULL;
 	register int x = 0;
@@ -764,20 +814,6 @@ int get_raw_command_line_r(icinga_macros *mac, command *cmd_ptr, char *cmd, char
 	register int arg_index = 0;
 	register int escaped = FALSE;
 
-	log_debug_info(DEBUGL_FUNCTIONS, 0, "get_raw_command_line_r()\n");
-
-	/* clear the argv macros */
-	clear_argv_macros_r(mac);
-
-	/* make sure we've got all the requirements */
-	if (cmd_ptr == NULL || full_command == NULL)
-		return ERROR;
-
-	log_debug_info(DEBUGL_COMMANDS | DEBUGL_CHECKS | DEBUGL_MACROS, 2, "Raw Command Input: %s\n", cmd_ptr->command_line);
-
-	/* get the full command line */
-	*full_command = (char *)strdup((cmd_ptr->command_line == NULL) ? "" : cmd_ptr->command_line);
-
 	/* XXX: Crazy indent */
 	/* get the command arguments */
 	if (cmd != NULL) {
@@ -826,6 +862,30 @@ int get_raw_command_line_r(icinga_macros *mac, command *cmd_ptr, char *cmd, char
 		}
 	}
 
+	return;
+}
+
+
+/* given a "raw" command, return the "expanded" or "whole" command line */
+int get_raw_command_line_r(icinga_macros *mac, command *cmd_ptr, char *cmd, char **full_command, int macro_options) {
+
+	log_debug_info(DEBUGL_FUNCTIONS, 0, "get_raw_command_line_r()\n");
+
+	/* clear the argv macros */
+	clear_argv_macros_r(mac);
+
+	/* make sure we've got all the requirements */
+	if (cmd_ptr == NULL || full_command == NULL)
+		return ERROR;
+
+	log_debug_info(DEBUGL_COMMANDS | DEBUGL_CHECKS | DEBUGL_MACROS, 2, "Raw Command Input: %s\n", cmd_ptr->command_line);
+
+	/* get the full command line */
+	*full_command = (char *)strdup((cmd_ptr->command_line == NULL) ? "" : cmd_ptr->command_line);
+
+	/* get the command arguments */
+	grab_command_argv_macros_r(mac, cmd, macro_options);
+
 	log_debug_info(DEBUGL_COMMANDS | DEBUGL_CHECKS | DEBUGL_MACROS, 2, "Expanded Command Output: %s\n", *full_command);
 
 	return OK;
@@ -843,6 +903,65 @@ int get_raw_command_line(command *cmd_ptr, char *cmd, char **full_command, int m
 }
 
 
+/* given a "raw" command, return the command line with all macros processed - same as get_raw_command_line_r() followed by process_macros_r() */
+int get_processed_command_line_r(icinga_macros *mac, command *cmd_ptr, char *cmd, char **full_command, int macro_options) {
+	char *raw_command = NULL;
+
+	log_debug_info(DEBUGL_FUNCTIONS, 0, "get_processed_command_line_r()\n");
+
+	if (full_command == NULL)
+		return ERROR;
+	*full_command = NULL;
+
+	/* commands without a compiled command line are processed the long way */
+	if (cmd_ptr == NULL || cmd_ptr->compiled_command_line == NULL) {
+		if (get_raw_command_line_r(mac, cmd_ptr, cmd, &raw_command, macro_options) == ERROR || raw_command == NULL)
+			return ERROR;
+		process_macros_r(mac, raw_command, full_command, macro_options);
+		my_free(raw_command);
+		return (*full_command == NULL) ? ERROR : OK;
+	}
+
+	/* clear the argv macros and get the new ones */
+	clear_argv_macros_r(mac);
+	grab_command_argv_macros_r(mac, cmd, macro_options);
+
+	log_debug_info(DEBUGL_COMMANDS | DEBUGL_CHECKS | DEBUGL_MACROS, 2, "Raw Command Input: %s\n", cmd_ptr->command_line);
+
+	process_macro_template_r(mac, cmd_ptr->compiled_command_line, full_command, macro_options);
+
+	log_debug_info(DEBUGL_COMMANDS | DEBUGL_CHECKS | DEBUGL_MACROS, 2, "Processed Command Output: %s\n", (*full_command == NULL) ? "" : *full_command);
+
+	return (*full_command == NULL) ? ERROR : OK;
+}
+
+
+/* parses the command lines of all commands once, so they don't need to be parsed again whenever they're run */
+void compile_command_templates(void) {
+	command *temp_command = NULL;
+
+	for (temp_command = command_list; temp_command != NULL; temp_command = temp_command->next) {
+		if (temp_command->compiled_command_line == NULL)
+			temp_command->compiled_command_line = compile_macro_template((temp_command->command_line == NULL) ? "" : temp_command->command_line);
+	}
+
+	return;
+}
+
+
+/* frees the compiled command lines of all commands */
+void free_command_templates(void) {
+	command *temp_command = NULL;
+
+	for (temp_command = command_list; temp_command != NULL; temp_command = temp_command->next) {
+		free_macro_template(temp_command->compiled_command_line);
+		temp_command->compiled_command_line = NULL;
+	}
+
+	return;
+}
+
+
 
 /******************************************************************/
 /******************** ENVIRONMENT FUNCTIONS ***********************/
@@ -910,12 +1029,9 @@ int get_dlst_shift(time_t *start, time_t *end) {
 
 /*#define TEST_TIMEPERIODS_A 1*/
 
-/* see if the specified time falls into a valid time range in the given time period */
-int check_time_against_period(time_t test_time, timeperiod *tperiod) {
-	timeperiodexclusion *temp_timeperiodexclusion = NULL;
-	timeperiodexclusion *first_timeperiodexclusion = NULL;
+/* determines the time ranges of a time period (not looking at its exclusions) that apply to the day the specified time falls on */
+static timerange *get_timeranges_for_day(time_t test_time, timeperiod *tperiod, time_t *day_midnight, int *is_exception) {
 	daterange *temp_daterange = NULL;
-	timerange *temp_timerange = NULL;
 	time_t midnight = 0L;
 	time_t start_time = (time_t)0L;
 	time_t end_time = (time_t)0L;
@@ -923,32 +1039,12 @@ int check_time_against_period(time_t test_time, timeperiod *tperiod) {
 	struct tm *t, tm_s;
 	int daterange_type = 0;
 	unsigned long days = 0L;
-	time_t day_range_start = (time_t)0L;
-	time_t day_range_end = (time_t)0L;
 	int test_time_year = 0;
 	int test_time_mon = 0;
 	int test_time_wday = 0;
 	int year = 0;
 	int shift;
 
-	log_debug_info(DEBUGL_FUNCTIONS, 0, "check_time_against_period()\n");
-
-	/* if no period was specified, assume the time is good */
-	if (tperiod == NULL)
-		return OK;
-
-	/* test exclusions first - if exclusions match current time, bail out with an error */
-	/* clear exclusions list before recursing (and restore afterwards) to prevent endless loops... */
-	first_timeperiodexclusion = tperiod->exclusions;
-	tperiod->exclusions = NULL;
-	for (temp_timeperiodexclusion = first_timeperiodexclusion; temp_timeperiodexclusion != NULL; temp_timeperiodexclusion = temp_timeperiodexclusion->next) {
-		if (check_time_against_period(test_time, temp_timeperiodexclusion->timeperiod_ptr) == OK) {
-			tperiod->exclusions = first_timeperiodexclusion;
-			return ERROR;
-		}
-	}
-	tperiod->exclusions = first_timeperiodexclusion;
-
 	/* save values for later */
 	t = localtime_r(&test_time, &tm_s);
 	test_time_year = t->tm_year;
@@ -1115,73 +1211,480 @@ int check_time_against_period(time_t test_time, timeperiod *tperiod) {
 				if ((days % temp_daterange->skip_interval) != 0)
 					continue;
 
-				/* use midnight of test date as start time */
-				else
-					start_time = (time_t)midnight;
+				/* use midnight of test date as start time */
+				else
+					start_time = (time_t)midnight;
+
+				/* if skipping range has no end, use test date as end */
+				if ((daterange_type == DATERANGE_CALENDAR_DATE) && (is_daterange_single_day(temp_daterange) == TRUE))
+					end_time = (time_t)midnight;
+			}
+
+#ifdef TEST_TIMEPERIODS_A
+			printf("NEW START:    %lu = %s", (unsigned long)start_time, ctime(&start_time));
+			printf("NEW END:      %lu = %s", (unsigned long)end_time, ctime(&end_time));
+			printf("%d DAYS PASSED\n", days);
+			printf("DLST SHIFT:   %d", shift);
+#endif
+
+			/* time falls into the range of days */
+			if (midnight >= start_time && midnight <= end_time)
+				found_match = TRUE;
+
+			/* found a day match, so use its time ranges */
+			if (found_match == TRUE) {
+				*day_midnight = midnight;
+				*is_exception = TRUE;
+				return temp_daterange->times;
+			}
+		}
+	}
+
+
+	/**** use normal, weekly rotating schedule last ****/
+	*day_midnight = midnight;
+	*is_exception = FALSE;
+
+	return tperiod->days[test_time_wday];
+}
+
+
+
+/* see if the specified time falls into a valid time range in the given time period (without using its cached valid intervals) */
+int check_time_against_period_uncached(time_t test_time, timeperiod *tperiod) {
+	timeperiodexclusion *temp_timeperiodexclusion = NULL;
+	timeperiodexclusion *first_timeperiodexclusion = NULL;
+	timerange *temp_timerange = NULL;
+	time_t midnight = 0L;
+	time_t day_range_start = (time_t)0L;
+	time_t day_range_end = (time_t)0L;
+	int is_exception = FALSE;
+
+	/* if no period was specified, assume the time is good */
+	if (tperiod == NULL)
+		return OK;
+
+	/* test exclusions first - if exclusions match current time, bail out with an error */
+	/* clear exclusions list before recursing (and restore afterwards) to prevent endless loops... */
+	first_timeperiodexclusion = tperiod->exclusions;
+	tperiod->exclusions = NULL;
+	for (temp_timeperiodexclusion = first_timeperiodexclusion; temp_timeperiodexclusion != NULL; temp_timeperiodexclusion = temp_timeperiodexclusion->next) {
+		if (check_time_against_period_uncached(test_time, temp_timeperiodexclusion->timeperiod_ptr) == OK) {
+			tperiod->exclusions = first_timeperiodexclusion;
+			return ERROR;
+		}
+	}
+	tperiod->exclusions = first_timeperiodexclusion;
+
+	for (temp_timerange = get_timeranges_for_day(test_time, tperiod, &midnight, &is_exception); temp_timerange != NULL; temp_timerange = temp_timerange->next) {
+
+		/* ranges with start/end of zero in date exceptions mean exlude this day */
+		if (is_exception == TRUE && temp_timerange->range_start == 0 && temp_timerange->range_end == 0) {
+#ifdef TEST_TIMEPERIODS_A
+			printf("0 MINUTE RANGE EXCLUSION\n");
+#endif
+			continue;
+		}
+
+		day_range_start = (time_t)(midnight + temp_timerange->range_start);
+		day_range_end = (time_t)(midnight + temp_timerange->range_end);
+
+#ifdef TEST_TIMEPERIODS_A
+		printf("  RANGE START: %lu (%lu) = %s", temp_timerange->range_start, (unsigned long)day_range_start, ctime(&day_range_start));
+		printf("  RANGE END:   %lu (%lu) = %s", temp_timerange->range_end, (unsigned long)day_range_end, ctime(&day_range_end));
+#endif
+
+		/* if the user-specified time falls in this range, return with a positive result */
+		if (test_time >= day_range_start && test_time <= day_range_end)
+			return OK;
+	}
+
+	return ERROR;
+}
+
+
+
+/*
+ * Valid times of a time period are cached as a sorted list of [start, end)
+ * intervals covering a few days at a time, so checking a time or finding the
+ * next valid time is a binary search instead of evaluating date ranges and
+ * exclusions all over again.  The intervals are compiled day by day from the
+ * same rules check_time_against_period_uncached() applies, so both always
+ * agree - including across daylight saving time changes, as the intervals are
+ * absolute times.  Caches are dropped along with the time periods when the
+ * configuration is (re)loaded.
+ */
+
+struct timeperiod_cache_struct {
+	time_t start;						/* intervals are valid for [start, end) */
+	time_t end;
+	timeperiod_interval *intervals;
+	int count;
+	int size;
+};
+
+/* time periods may be looked at by modules from other threads */
+static pthread_mutex_t timeperiod_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/*
+ * returns the first second after a time that falls on another day - searched
+ * for instead of using mktime(), whose result for a midnight that happens
+ * twice (or not at all) when daylight saving time changes depends on earlier calls
+ */
+static time_t get_next_day_start(time_t test_time) {
+	struct tm tm_s;
+	time_t low = test_time;
+	time_t high = test_time + (26 * 3600);
+	time_t middle = 0L;
+	int year = 0;
+	int yday = 0;
+
+	localtime_r(&test_time, &tm_s);
+	year = tm_s.tm_year;
+	yday = tm_s.tm_yday;
+
+	while (high - low > 1) {
+		middle = low + ((high - low) / 2);
+		localtime_r(&middle, &tm_s);
+		if (tm_s.tm_year == year && tm_s.tm_yday == yday)
+			low = middle;
+		else
+			high = middle;
+	}
+
+	return high;
+}
+
+
+
+/* returns the first second of the day a time falls on */
+static time_t get_day_start(time_t test_time) {
+	time_t day_start = 0L;
+	time_t next_day_start = 0L;
+
+	day_start = get_next_day_start(test_time - (26 * 3600));
+	while ((next_day_start = get_next_day_start(day_start)) <= test_time)
+		day_start = next_day_start;
+
+	return day_start;
+}
+
+
+
+/* adds an interval to a sorted interval list, merging it with the ones it overlaps or touches */
+static int add_timeperiod_interval(timeperiod_cache *cache, time_t start, time_t end) {
+	timeperiod_interval *new_intervals = NULL;
+	int x = 0;
+	int y = 0;
+
+	if (start >= end)
+		return OK;
+
+	/* intervals are mostly added in order, so look for the place from the end */
+	for (x = cache->count; x > 0 && cache->intervals[x - 1].start > start; x--)
+		;
+
+	/* extend the previous interval */
+	if (x > 0 && cache->intervals[x - 1].end >= start) {
+		x--;
+		if (end > cache->intervals[x].end)
+			cache->intervals[x].end = end;
+	}
+
+	/* or insert a new one */
+	else {
+		if (cache->count == cache->size) {
+			if ((new_intervals = (timeperiod_interval *)realloc(cache->intervals, sizeof(timeperiod_interval) * (cache->size + TIMEPERIOD_INTERVAL_GROWTH))) == NULL)
+				return ERROR;
+			cache->intervals = new_intervals;
+			cache->size += TIMEPERIOD_INTERVAL_GROWTH;
+		}
+		memmove(&cache->intervals[x + 1], &cache->intervals[x], sizeof(timeperiod_interval) * (cache->count - x));
+		cache->intervals[x].start = start;
+		cache->intervals[x].end = end;
+		cache->count++;
+	}
+
+	/* swallow following intervals that now overlap */
+	for (y = x + 1; y < cache->count && cache->intervals[y].start <= cache->intervals[x].end; y++) {
+		if (cache->intervals[y].end > cache->intervals[x].end)
+			cache->intervals[x].end = cache->intervals[y].end;
+	}
+	if (y > x + 1) {
+		memmove(&cache->intervals[x + 1], &cache->intervals[y], sizeof(timeperiod_interval) * (cache->count - y));
+		cache->count -= (y - x - 1);
+	}
+
+	return OK;
+}
+
+
+
+/* removes all times in the second interval list from the first one */
+static int subtract_timeperiod_intervals(timeperiod_cache *cache, timeperiod_cache *excluded) {
+	timeperiod_cache result = { 0L, 0L, NULL, 0, 0 };
+	time_t start = 0L;
+	int x = 0;
+	int y = 0;
+
+	for (x = 0; x < cache->count; x++) {
+		start = cache->intervals[x].start;
+		for (y = 0; y < excluded->count && start < cache->intervals[x].end; y++) {
+			if (excluded->intervals[y].end <= start)
+				continue;
+			if (excluded->intervals[y].start >= cache->intervals[x].end)
+				break;
+			if (add_timeperiod_interval(&result, start, excluded->intervals[y].start) == ERROR) {
+				my_free(result.intervals);
+				return ERROR;
+			}
+			start = excluded->intervals[y].end;
+		}
+		if (add_timeperiod_interval(&result, start, cache->intervals[x].end) == ERROR) {
+			my_free(result.intervals);
+			return ERROR;
+		}
+	}
+
+	my_free(cache->intervals);
+	cache->intervals = result.intervals;
+	cache->count = result.count;
+	cache->size = result.size;
+
+	return OK;
+}
+
+
+
+/* adds the valid times of a time period between two times of the same day to an interval list */
+static int add_timeperiod_day_intervals(timeperiod_cache *cache, timeperiod *tperiod, time_t start, time_t end) {
+	timeperiodexclusion *temp_timeperiodexclusion = NULL;
+	timeperiodexclusion *first_timeperiodexclusion = NULL;
+	timeperiod_cache day = { 0L, 0L, NULL, 0, 0 };
+	timeperiod_cache excluded = { 0L, 0L, NULL, 0, 0 };
+	timerange *temp_timerange = NULL;
+	time_t midnight = 0L;
+	time_t range_start = 0L;
+	time_t range_end = 0L;
+	int is_exception = FALSE;
+	int x = 0;
+	int result = OK;
+
+	for (temp_timerange = get_timeranges_for_day(start, tperiod, &midnight, &is_exception); temp_timerange != NULL && result == OK; temp_timerange = temp_timerange->next) {
+
+		/* ranges with start/end of zero in date exceptions mean exlude this day */
+		if (is_exception == TRUE && temp_timerange->range_start == 0 && temp_timerange->range_end == 0)
+			continue;
+
+		/* range ends are inclusive */
+		range_start = (time_t)(midnight + temp_timerange->range_start);
+		range_end = (time_t)(midnight + temp_timerange->range_end + 1);
+
+		result = add_timeperiod_interval(&day, (range_start < start) ? start : range_start, (range_end > end) ? end : range_end);
+	}
+
+	/* take out the exclusions - clear exclusions list before recursing (and restore afterwards) to prevent endless loops... */
+	first_timeperiodexclusion = tperiod->exclusions;
+	tperiod->exclusions = NULL;
+	for (temp_timeperiodexclusion = first_timeperiodexclusion; temp_timeperiodexclusion != NULL && day.count > 0 && result == OK; temp_timeperiodexclusion = temp_timeperiodexclusion->next) {
+
+		/* without a time period, exclusions match all the time */
+		if (temp_timeperiodexclusion->timeperiod_ptr == NULL)
+			day.count = 0;
+		else {
+			excluded.count = 0;
+			if ((result = add_timeperiod_day_intervals(&excluded, temp_timeperiodexclusion->timeperiod_ptr, start, end)) == OK)
+				result = subtract_timeperiod_intervals(&day, &excluded);
+		}
+	}
+	tperiod->exclusions = first_timeperiodexclusion;
+
+	for (x = 0; x < day.count && result == OK; x++)
+		result = add_timeperiod_interval(cache, day.intervals[x].start, day.intervals[x].end);
+
+	my_free(day.intervals);
+	my_free(excluded.intervals);
+
+	return result;
+}
+
+
+
+/* adds another day of valid times to the end of a time period's cache */
+static int extend_timeperiod_cache(timeperiod_cache *cache, timeperiod *tperiod) {
+	struct tm tm_s;
+	time_t day_end = 0L;
+	time_t segment_end = 0L;
+	time_t low = 0L;
+	time_t high = 0L;
+	time_t middle = 0L;
+	int isdst = 0;
+
+	day_end = get_next_day_start(cache->end);
+
+	/*
+	 * the rules work with midnight as computed in the daylight saving time of
+	 * the time looked at, so days on which that changes are split in two
+	 */
+	while (cache->end < day_end) {
+
+		isdst = localtime_r(&cache->end, &tm_s)->tm_isdst;
+		segment_end = day_end;
+
+		high = day_end - 1;
+		if (localtime_r(&high, &tm_s)->tm_isdst != isdst) {
+			for (low = cache->end; high - low > 1;) {
+				middle = low + ((high - low) / 2);
+				if (localtime_r(&middle, &tm_s)->tm_isdst == isdst)
+					low = middle;
+				else
+					high = middle;
+			}
+			segment_end = high;
+		}
+
+		if (add_timeperiod_day_intervals(cache, tperiod, cache->end, segment_end) == ERROR)
+			return ERROR;
+
+		cache->end = segment_end;
+	}
+
+	return OK;
+}
+
+
+
+/* makes sure a time period's cache covers the specified time - must be called with timeperiod_cache_lock held */
+static timeperiod_cache *get_timeperiod_cache(timeperiod *tperiod, time_t test_time) {
+	timeperiod_cache *cache = tperiod->cache;
+
+	if (cache == NULL) {
+		if ((cache = (timeperiod_cache *)calloc(1, sizeof(timeperiod_cache))) == NULL)
+			return NULL;
+		tperiod->cache = cache;
+	}
+
+	/* start over if nothing is cached yet or the time is before the cached days or too far beyond them */
+	if (cache->start == cache->end || test_time < cache->start || test_time >= cache->start + (TIMEPERIOD_CACHE_MAX_DAYS * 24 * 3600)) {
+		cache->count = 0;
+		cache->start = cache->end = get_day_start(test_time);
+	}
+
+	while (test_time >= cache->end) {
+		if (extend_timeperiod_cache(cache, tperiod) == ERROR) {
+			cache->count = 0;
+			cache->start = cache->end;
+			return NULL;
+		}
+	}
+
+	return cache;
+}
+
+
+
+/* returns the index of the first cached interval that ends after the specified time */
+static int find_timeperiod_interval(timeperiod_cache *cache, time_t test_time) {
+	int low = 0;
+	int high = cache->count;
+	int middle = 0;
+
+	while (low < high) {
+		middle = low + ((high - low) / 2);
+		if (cache->intervals[middle].end <= test_time)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return low;
+}
+
+
+
+/* frees the cached valid intervals of all time periods */
+void free_timeperiod_caches(void) {
+	timeperiod *temp_timeperiod = NULL;
+
+	pthread_mutex_lock(&timeperiod_cache_lock);
+
+	for (temp_timeperiod = timeperiod_list; temp_timeperiod != NULL; temp_timeperiod = temp_timeperiod->next) {
+		if (temp_timeperiod->cache == NULL)
+			continue;
+		my_free(temp_timeperiod->cache->intervals);
+		my_free(temp_timeperiod->cache);
+	}
+
+	pthread_mutex_unlock(&timeperiod_cache_lock);
+
+	return;
+}
+
+
 
-				/* if skipping range has no end, use test date as end */
-				if ((daterange_type == DATERANGE_CALENDAR_DATE) && (is_daterange_single_day(temp_daterange) == TRUE))
-					end_time = (time_t)midnight;
-			}
+/* see if the specified time falls into a valid time range in the given time period */
+int check_time_against_period(time_t test_time, timeperiod *tperiod) {
+	timeperiod_cache *cache = NULL;
+	int result = ERROR;
+	int x = 0;
 
-#ifdef TEST_TIMEPERIODS_A
-			printf("NEW START:    %lu = %s", (unsigned long)start_time, ctime(&start_time));
-			printf("NEW END:      %lu = %s", (unsigned long)end_time, ctime(&end_time));
-			printf("%d DAYS PASSED\n", days);
-			printf("DLST SHIFT:   %d", shift);
-#endif
+	log_debug_info(DEBUGL_FUNCTIONS, 0, "check_time_against_period()\n");
 
-			/* time falls into the range of days */
-			if (midnight >= start_time && midnight <= end_time)
-				found_match = TRUE;
+	/* if no period was specified, assume the time is good */
+	if (tperiod == NULL)
+		return OK;
 
-			/* found a day match, so see if time ranges are good */
-			if (found_match == TRUE) {
+	pthread_mutex_lock(&timeperiod_cache_lock);
 
-				for (temp_timerange = temp_daterange->times; temp_timerange != NULL; temp_timerange = temp_timerange->next) {
+	if ((cache = get_timeperiod_cache(tperiod, test_time)) == NULL) {
+		pthread_mutex_unlock(&timeperiod_cache_lock);
+		return check_time_against_period_uncached(test_time, tperiod);
+	}
 
-					/* ranges with start/end of zero mean exlude this day */
-					if (temp_timerange->range_start == 0 && temp_timerange->range_end == 0) {
-#ifdef TEST_TIMEPERIODS_A
-						printf("0 MINUTE RANGE EXCLUSION\n");
-#endif
-						continue;
-					}
+	x = find_timeperiod_interval(cache, test_time);
+	if (x < cache->count && cache->intervals[x].start <= test_time)
+		result = OK;
 
-					day_range_start = (time_t)(midnight + temp_timerange->range_start);
-					day_range_end = (time_t)(midnight + temp_timerange->range_end);
+	pthread_mutex_unlock(&timeperiod_cache_lock);
 
-#ifdef TEST_TIMEPERIODS_A
-					printf("  RANGE START: %lu (%lu) = %s", temp_timerange->range_start, (unsigned long)day_range_start, ctime(&day_range_start));
-					printf("  RANGE END:   %lu (%lu) = %s", temp_timerange->range_end, (unsigned long)day_range_end, ctime(&day_range_end));
-#endif
+	return result;
+}
 
-					/* if the user-specified time falls in this range, return with a positive result */
-					if (test_time >= day_range_start && test_time <= day_range_end)
-						return OK;
-				}
 
-				/* no match, so bail with error */
-				return ERROR;
-			}
-		}
-	}
 
+/* finds the next valid time in a time period at or after the specified time, looking ahead up to TIMEPERIOD_CACHE_MAX_DAYS */
+static int get_next_valid_time_from_cache(time_t pref_time, time_t *valid_time, timeperiod *tperiod) {
+	timeperiod_cache *cache = NULL;
+	int result = ERROR;
+	int x = 0;
 
-	/**** check normal, weekly rotating schedule last ****/
+	pthread_mutex_lock(&timeperiod_cache_lock);
 
-	/* check weekday time ranges */
-	for (temp_timerange = tperiod->days[test_time_wday]; temp_timerange != NULL; temp_timerange = temp_timerange->next) {
+	if ((cache = get_timeperiod_cache(tperiod, pref_time)) != NULL) {
 
-		day_range_start = (time_t)(midnight + temp_timerange->range_start);
-		day_range_end = (time_t)(midnight + temp_timerange->range_end);
+		x = find_timeperiod_interval(cache, pref_time);
 
-		/* if the user-specified time falls in this range, return with a positive result */
-		if (test_time >= day_range_start && test_time <= day_range_end)
-			return OK;
+		/* look further ahead until there's a valid time - a full cache isn't started over, periods without a valid time would rebuild it on every call */
+		while (x == cache->count && cache->end < cache->start + (TIMEPERIOD_CACHE_MAX_DAYS * 24 * 3600)) {
+			if (extend_timeperiod_cache(cache, tperiod) == ERROR) {
+				cache->count = 0;
+				cache->start = cache->end;
+				break;
+			}
+			x = find_timeperiod_interval(cache, pref_time);
+		}
+
+		if (x < cache->count) {
+			*valid_time = (cache->intervals[x].start > pref_time) ? cache->intervals[x].start : pref_time;
+			result = OK;
+		}
 	}
 
-	return ERROR;
+	pthread_mutex_unlock(&timeperiod_cache_lock);
+
+	return result;
 }
 
 
@@ -1229,6 +1732,12 @@ void _get_next_valid_time(time_t pref_time, time_t current_time, time_t *valid_t
 		return;
 	}
 
+	/*
+	 * the next valid interval is usually within the cached days of the timeperiod
+	 */
+	if (get_next_valid_time_from_cache(preferred_time, valid_time, tperiod) == OK)
+		return;
+
 	/*
 	 * first check for possible timeperiod excuslions before getting a valid_time
 	 */
@@ -2416,7 +2925,8 @@ void service_check_sighandler(int sig) {
 
 		/* move check result to queue directory */
 		move_check_result_to_queue(check_result_info.output_file);
-	}
+	} else
+		submit_check_result(&check_result_info, "(Service Check Timed Out)");
 
 	/* free check result memory */
 	free_check_result(&check_result_info);
@@ -2456,7 +2966,8 @@ void host_check_sighandler(int sig) {
 
 		/* move check result to queue directory */
 		move_check_result_to_queue(check_result_info.output_file);
-	}
+	} else
+		submit_check_result(&check_result_info, "(Host Check Timed Out)");
 
 	/* free check result memory */
 	free_check_result(&check_result_info);
@@ -2643,125 +3154,369 @@ int drop_privileges(char *user, char *group) {
 		else
 			gid = (gid_t)atoi(group);
 
-	}
+	}
+
+	/* set effective user ID */
+	if (user != NULL) {
+
+		/* see if this is a user name */
+		if (strspn(user, "0123456789") < strlen(user)) {
+			pw = (struct passwd *)getpwnam(user);
+			if (pw != NULL)
+				uid = (uid_t)(pw->pw_uid);
+			else
+				logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Could not get passwd entry for '%s'", user);
+		}
+
+		/* else we were passed the UID */
+		else
+			uid = (uid_t)atoi(user);
+	}
+
+	/* now that we know what to change to, we fix log file permissions */
+	fix_log_file_owner(uid, gid);
+
+	/* set effective group ID if other than current EGID */
+	if (gid != getegid()) {
+
+		if (setgid(gid) == -1) {
+			logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Could not set effective GID=%d", (int)gid);
+			result = ERROR;
+		}
+	}
+
+#ifdef HAVE_INITGROUPS
+
+	if (uid != geteuid()) {
+
+		/* initialize supplementary groups */
+		if (initgroups(user, gid) == -1) {
+			if (errno == EPERM)
+				logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Unable to change supplementary groups using initgroups() -- I hope you know what you're doing");
+			else {
+				logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Possibly root user failed dropping privileges with initgroups()");
+				return ERROR;
+			}
+		}
+	}
+#endif
+
+	if (setuid(uid) == -1) {
+		logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Could not set effective UID=%d", (int)uid);
+		result = ERROR;
+	}
+
+	log_debug_info(DEBUGL_PROCESS, 0, "New UID/GID: %d/%d\n", (int)getuid(), (int)getgid());
+
+	return result;
+}
+
+
+
+
+/******************************************************************/
+/************************* IPC FUNCTIONS **************************/
+/******************************************************************/
+
+/* move check result to queue directory */
+int move_check_result_to_queue(char *checkresult_file) {
+	char *output_file = NULL;
+	char *temp_buffer = NULL;
+	int output_file_fd = -1;
+	mode_t new_umask = 077;
+	mode_t old_umask;
+	int result = 0;
+
+	/* save the file creation mask */
+	old_umask = umask(new_umask);
+
+	/* create a safe temp file */
+	asprintf(&output_file, "%s/cXXXXXX", check_result_path);
+	output_file_fd = mkstemp(output_file);
+
+	/* file created okay */
+	if (output_file_fd >= 0) {
+
+		log_debug_info(DEBUGL_CHECKS, 2, "Moving temp check result file '%s' to queue file '%s'...\n", checkresult_file, output_file);
+
+#ifdef __CYGWIN__
+		/* Cygwin cannot rename open files - gives Permission Denied */
+		/* close the file */
+		close(output_file_fd);
+#endif
+
+		/* move the original file */
+		result = my_rename(checkresult_file, output_file);
+
+#ifndef __CYGWIN__
+		/* close the file */
+		close(output_file_fd);
+#endif
+
+		/* create an ok-to-go indicator file */
+		asprintf(&temp_buffer, "%s.ok", output_file);
+		if ((output_file_fd = open(temp_buffer, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR)) >= 0)
+			close(output_file_fd);
+		my_free(temp_buffer);
+
+		/* delete the original file if it couldn't be moved */
+		if (result != 0)
+			unlink(checkresult_file);
+	} else
+		result = -1;
+
+	/* reset the file creation mask */
+	umask(old_umask);
+
+	/* log a warning on errors */
+	if (result != 0)
+		logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Unable to move file '%s' to check results queue.\n", checkresult_file);
+
+	/* free memory */
+	my_free(output_file);
+
+	return OK;
+}
+
+
+
+/* reads all pending messages from the channel, either for the reaper or for the queue directory */
+static int read_check_result_channel_messages(int sd, int add_to_list) {
+	char *buffer = NULL;
+	check_result *new_cr = NULL;
+	ssize_t result = 0;
+	int messages = 0;
+
+	/* the channel is read on every pass of the event loop, so the buffer is kept until the channel is closed */
+	if (check_result_channel_buffer == NULL && (check_result_channel_buffer = (char *)malloc(CHECK_RESULT_CHANNEL_MAX_MESSAGE + 1)) == NULL)
+		return ERROR;
+	buffer = check_result_channel_buffer;
+
+	while (1) {
+
+		result = recv(sd, buffer, CHECK_RESULT_CHANNEL_MAX_MESSAGE, MSG_DONTWAIT);
+
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result <= 0)
+			break;
+
+		buffer[result] = '\x0';
+		messages++;
+
+		if (add_to_list == FALSE) {
+			submit_check_result_message(buffer);
+			continue;
+		}
+
+		if ((new_cr = parse_check_result_message(buffer)) != NULL)
+			add_check_result_to_list(new_cr);
+	}
+
+	if (messages > 0)
+		log_debug_info(DEBUGL_CHECKS | DEBUGL_IPC, 1, "Read %d check results from check result channel\n", messages);
+
+	return OK;
+}
+
+
+
+/* opens the in-memory channel check processes use to pass results to the reaper */
+int open_check_result_channel(void) {
+	int buffer_size = CHECK_RESULT_CHANNEL_MAX_MESSAGE * 4;
+
+	/* the channel is kept open across restarts, so checks that are still running can deliver their results */
+	if (use_check_result_channel == FALSE) {
+		close_check_result_channel();
+		return OK;
+	}
+	if (check_result_channel[0] >= 0)
+		return OK;
+
+	if (socketpair(AF_UNIX, SOCK_DGRAM, 0, check_result_channel) < 0) {
+		logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Could not create check result channel, using the check result queue directory instead: %s\n", strerror(errno));
+		check_result_channel[0] = -1;
+		check_result_channel[1] = -1;
+		return ERROR;
+	}
+
+	/* plugins don't need the channel, and check processes must never block on a busy reaper */
+	fcntl(check_result_channel[0], F_SETFD, FD_CLOEXEC);
+	fcntl(check_result_channel[1], F_SETFD, FD_CLOEXEC);
+	fcntl(check_result_channel[1], F_SETFL, fcntl(check_result_channel[1], F_GETFL) | O_NONBLOCK);
+
+	setsockopt(check_result_channel[0], SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+	setsockopt(check_result_channel[1], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+
+	log_debug_info(DEBUGL_CHECKS | DEBUGL_IPC, 1, "Opened check result channel (fd=%d/%d)\n", check_result_channel[0], check_result_channel[1]);
+
+	return OK;
+}
+
+
+
+/* closes the check result channel, results still in transit are moved to the check result queue directory */
+int close_check_result_channel(void) {
+	int read_sd = check_result_channel[0];
+	int write_sd = check_result_channel[1];
+
+	if (read_sd < 0)
+		return OK;
+
+	check_result_channel[0] = -1;
+	check_result_channel[1] = -1;
+
+	/* running check processes get EPIPE after the shutdown and fall back to the queue directory */
+	read_check_result_channel_messages(read_sd, FALSE);
+	shutdown(read_sd, SHUT_RD);
+	read_check_result_channel_messages(read_sd, FALSE);
+
+	close(read_sd);
+	close(write_sd);
+	my_free(check_result_channel_buffer);
+
+	return OK;
+}
+
+
+
+/* reads check results from the check result channel and adds them to the check result list - called on every pass of the event loop */
+int read_check_result_channel(void) {
+
+	if (check_result_channel[0] < 0)
+		return OK;
+
+	return read_check_result_channel_messages(check_result_channel[0], TRUE);
+}
+
+
+
+/* converts var=value lines into a new check result */
+check_result *parse_check_result_message(char *msg) {
+	check_result *new_cr = NULL;
+	char *var = NULL;
+	char *val = NULL;
+	char *eol = NULL;
+
+	if (msg == NULL)
+		return NULL;
+
+	if ((new_cr = (check_result *)malloc(sizeof(check_result))) == NULL)
+		return NULL;
+	init_check_result(new_cr);
+	new_cr->output_file = NULL;
+
+	for (var = msg; var != NULL && *var != '\x0'; var = eol) {
+
+		if ((eol = strchr(var, '\n')) != NULL)
+			*(eol++) = '\x0';
 
-	/* set effective user ID */
-	if (user != NULL) {
+		if ((val = strchr(var, '=')) == NULL)
+			continue;
+		*(val++) = '\x0';
 
-		/* see if this is a user name */
-		if (strspn(user, "0123456789") < strlen(user)) {
-			pw = (struct passwd *)getpwnam(user);
-			if (pw != NULL)
-				uid = (uid_t)(pw->pw_uid);
-			else
-				logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Could not get passwd entry for '%s'", user);
-		}
+		set_check_result_var(new_cr, var, val);
+	}
 
-		/* else we were passed the UID */
-		else
-			uid = (uid_t)atoi(user);
+	/* do we have the minimum amount of data? */
+	if (new_cr->host_name == NULL || new_cr->output == NULL) {
+		free_check_result(new_cr);
+		my_free(new_cr);
+		return NULL;
 	}
 
-	/* now that we know what to change to, we fix log file permissions */
-	fix_log_file_owner(uid, gid);
+	return new_cr;
+}
 
-	/* set effective group ID if other than current EGID */
-	if (gid != getegid()) {
 
-		if (setgid(gid) == -1) {
-			logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Could not set effective GID=%d", (int)gid);
-			result = ERROR;
-		}
-	}
 
-#ifdef HAVE_INITGROUPS
+/* passes a finished active check result to the reaper */
+int submit_check_result(check_result *cr, char *output) {
+	char *msg = NULL;
+	int result = OK;
 
-	if (uid != geteuid()) {
+	if (cr == NULL)
+		return ERROR;
 
-		/* initialize supplementary groups */
-		if (initgroups(user, gid) == -1) {
-			if (errno == EPERM)
-				logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Unable to change supplementary groups using initgroups() -- I hope you know what you're doing");
-			else {
-				logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Possibly root user failed dropping privileges with initgroups()");
-				return ERROR;
-			}
-		}
-	}
-#endif
+	if (asprintf(&msg, "host_name=%s\n%s%s%scheck_type=%d\ncheck_options=%d\nscheduled_check=%d\nreschedule_check=%d\nlatency=%f\nstart_time=%lu.%lu\nfinish_time=%lu.%lu\nearly_timeout=%d\nexited_ok=%d\nreturn_code=%d\noutput=%s\n",
+	             cr->host_name,
+	             (cr->service_description == NULL) ? "" : "service_description=",
+	             (cr->service_description == NULL) ? "" : cr->service_description,
+	             (cr->service_description == NULL) ? "" : "\n",
+	             cr->check_type,
+	             cr->check_options,
+	             cr->scheduled_check,
+	             cr->reschedule_check,
+	             cr->latency,
+	             cr->start_time.tv_sec,
+	             cr->start_time.tv_usec,
+	             cr->finish_time.tv_sec,
+	             cr->finish_time.tv_usec,
+	             cr->early_timeout,
+	             cr->exited_ok,
+	             cr->return_code,
+	             (output == NULL) ? "(null)" : output) < 0)
+		return ERROR;
 
-	if (setuid(uid) == -1) {
-		logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Could not set effective UID=%d", (int)uid);
-		result = ERROR;
-	}
+	result = submit_check_result_message(msg);
 
-	log_debug_info(DEBUGL_PROCESS, 0, "New UID/GID: %d/%d\n", (int)getuid(), (int)getgid());
+	my_free(msg);
 
 	return result;
 }
 
 
 
-
-/******************************************************************/
-/************************* IPC FUNCTIONS **************************/
-/******************************************************************/
-
-/* move check result to queue directory */
-int move_check_result_to_queue(char *checkresult_file) {
+/* sends a check result message over the check result channel, falling back to the check result queue directory */
+int submit_check_result_message(char *msg) {
 	char *output_file = NULL;
-	char *temp_buffer = NULL;
 	int output_file_fd = -1;
+	FILE *output_file_fp = NULL;
+	size_t msg_len = 0;
+	ssize_t result = 0;
 	mode_t new_umask = 077;
 	mode_t old_umask;
-	int result = 0;
-
-	/* save the file creation mask */
-	old_umask = umask(new_umask);
-
-	/* create a safe temp file */
-	asprintf(&output_file, "%s/cXXXXXX", check_result_path);
-	output_file_fd = mkstemp(output_file);
+	time_t current_time;
 
-	/* file created okay */
-	if (output_file_fd >= 0) {
+	if (msg == NULL)
+		return ERROR;
 
-		log_debug_info(DEBUGL_CHECKS, 2, "Moving temp check result file '%s' to queue file '%s'...\n", checkresult_file, output_file);
+	msg_len = strlen(msg);
 
-#ifdef __CYGWIN__
-		/* Cygwin cannot rename open files - gives Permission Denied */
-		/* close the file */
-		close(output_file_fd);
-#endif
+	/* the reaper is gone or busy if this fails */
+	if (check_result_channel[1] >= 0 && msg_len <= CHECK_RESULT_CHANNEL_MAX_MESSAGE) {
+		do {
+			result = send(check_result_channel[1], msg, msg_len, CHECK_RESULT_CHANNEL_SEND_FLAGS);
+		} while (result < 0 && errno == EINTR);
 
-		/* move the original file */
-		result = my_rename(checkresult_file, output_file);
+		if (result == (ssize_t)msg_len)
+			return OK;
+	}
 
-#ifndef __CYGWIN__
-		/* close the file */
-		close(output_file_fd);
-#endif
+	/* open a temp file for storing the check result */
+	old_umask = umask(new_umask);
+	asprintf(&output_file, "%s/checkXXXXXX", temp_path);
+	if (output_file != NULL && (output_file_fd = mkstemp(output_file)) >= 0)
+		output_file_fp = fdopen(output_file_fd, "w");
+	umask(old_umask);
 
-		/* create an ok-to-go indicator file */
-		asprintf(&temp_buffer, "%s.ok", output_file);
-		if ((output_file_fd = open(temp_buffer, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR)) >= 0)
+	if (output_file_fp == NULL) {
+		if (output_file_fd >= 0)
 			close(output_file_fd);
-		my_free(temp_buffer);
-
-		/* delete the original file if it couldn't be moved */
-		if (result != 0)
-			unlink(checkresult_file);
-	} else
-		result = -1;
+		my_free(output_file);
+		return ERROR;
+	}
 
-	/* reset the file creation mask */
-	umask(old_umask);
+	time(&current_time);
+	fprintf(output_file_fp, "### Active Check Result File ###\n");
+	fprintf(output_file_fp, "file_time=%lu\n", (unsigned long)current_time);
+	fprintf(output_file_fp, "\n");
+	fprintf(output_file_fp, "%s", msg);
+	fclose(output_file_fp);
 
-	/* log a warning on errors */
-	if (result != 0)
-		logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Unable to move file '%s' to check results queue.\n", checkresult_file);
+	/* move check result to queue directory */
+	move_check_result_to_queue(output_file);
 
-	/* free memory */
 	my_free(output_file);
 
 	return OK;
@@ -2781,16 +3536,12 @@ int process_check_result_queue(char *dirname) {
 	int result = OK;
 
 	unsigned long list_length = 0;
-	check_result *current = check_result_list;
 
 	if (max_check_result_list_items != 0) {
 		/* get the number of items currently to-be-processed
 		 * already on the checkresult list
 		 */
-		while (current != NULL) {
-			list_length++;
-			current = current->next;
-		}
+		list_length = get_check_result_list_items();
 
 		log_debug_info(DEBUGL_CHECKS, 1, "check_result_list has %lu items\n", list_length);
 
@@ -2884,7 +3635,6 @@ int process_check_result_file(char *fname) {
 	char *input = NULL;
 	char *var = NULL;
 	char *val = NULL;
-	char *v1 = NULL, *v2 = NULL;
 	time_t current_time;
 	check_result *new_cr = NULL;
 
@@ -2972,43 +3722,7 @@ int process_check_result_file(char *fname) {
 				new_cr->output_file = (char *)strdup(fname);
 			}
 
-			if (!strcmp(var, "host_name"))
-				new_cr->host_name = (char *)strdup(val);
-			else if (!strcmp(var, "service_description")) {
-				new_cr->service_description = (char *)strdup(val);
-				new_cr->object_check_type = SERVICE_CHECK;
-			} else if (!strcmp(var, "check_type"))
-				new_cr->check_type = atoi(val);
-			else if (!strcmp(var, "check_options"))
-				new_cr->check_options = atoi(val);
-			else if (!strcmp(var, "scheduled_check"))
-				new_cr->scheduled_check = atoi(val);
-			else if (!strcmp(var, "reschedule_check"))
-				new_cr->reschedule_check = atoi(val);
-			else if (!strcmp(var, "latency"))
-				new_cr->latency = strtod(val, NULL);
-			else if (!strcmp(var, "start_time")) {
-				if ((v1 = strtok(val, ".")) == NULL)
-					continue;
-				if ((v2 = strtok(NULL, "\n")) == NULL)
-					continue;
-				new_cr->start_time.tv_sec = strtoul(v1, NULL, 0);
-				new_cr->start_time.tv_usec = strtoul(v2, NULL, 0);
-			} else if (!strcmp(var, "finish_time")) {
-				if ((v1 = strtok(val, ".")) == NULL)
-					continue;
-				if ((v2 = strtok(NULL, "\n")) == NULL)
-					continue;
-				new_cr->finish_time.tv_sec = strtoul(v1, NULL, 0);
-				new_cr->finish_time.tv_usec = strtoul(v2, NULL, 0);
-			} else if (!strcmp(var, "early_timeout"))
-				new_cr->early_timeout = atoi(val);
-			else if (!strcmp(var, "exited_ok"))
-				new_cr->exited_ok = atoi(val);
-			else if (!strcmp(var, "return_code"))
-				new_cr->return_code = atoi(val);
-			else if (!strcmp(var, "output"))
-				new_cr->output = (char *)strdup(val);
+			set_check_result_var(new_cr, var, val);
 		}
 	}
 
@@ -3047,6 +3761,59 @@ int process_check_result_file(char *fname) {
 
 
 
+/* sets a check result attribute from a variable/value pair */
+int set_check_result_var(check_result *cr, char *var, char *val) {
+	char *v1 = NULL, *v2 = NULL;
+
+	if (cr == NULL || var == NULL || val == NULL)
+		return ERROR;
+
+	if (!strcmp(var, "host_name"))
+		cr->host_name = (char *)strdup(val);
+	else if (!strcmp(var, "service_description")) {
+		cr->service_description = (char *)strdup(val);
+		cr->object_check_type = SERVICE_CHECK;
+	} else if (!strcmp(var, "check_type"))
+		cr->check_type = atoi(val);
+	else if (!strcmp(var, "check_options"))
+		cr->check_options = atoi(val);
+	else if (!strcmp(var, "scheduled_check"))
+		cr->scheduled_check = atoi(val);
+	else if (!strcmp(var, "reschedule_check"))
+		cr->reschedule_check = atoi(val);
+	else if (!strcmp(var, "latency"))
+		cr->latency = strtod(val, NULL);
+	else if (!strcmp(var, "start_time")) {
+		if ((v1 = strtok(val, ".")) == NULL)
+			return ERROR;
+		if ((v2 = strtok(NULL, "\n")) == NULL)
+			return ERROR;
+		cr->start_time.tv_sec = strtoul(v1, NULL, 0);
+		cr->start_time.tv_usec = strtoul(v2, NULL, 0);
+	} else if (!strcmp(var, "finish_time")) {
+		if ((v1 = strtok(val, ".")) == NULL)
+			return ERROR;
+		if ((v2 = strtok(NULL, "\n")) == NULL)
+			return ERROR;
+		cr->finish_time.tv_sec = strtoul(v1, NULL, 0);
+		cr->finish_time.tv_usec = strtoul(v2, NULL, 0);
+	} else if (!strcmp(var, "early_timeout"))
+		cr->early_timeout = atoi(val);
+	else if (!strcmp(var, "exited_ok"))
+		cr->exited_ok = atoi(val);
+	else if (!strcmp(var, "return_code"))
+		cr->return_code = atoi(val);
+	else if (!strcmp(var, "output"))
+		cr->output = (char *)strdup(val);
+	else
+		return ERROR;
+
+	return OK;
+}
+
+
+
+
 /* deletes as check result file, as well as its ok-to-go file */
 int delete_check_result_file(char *fname) {
 	char *temp_buffer = NULL;
@@ -3065,9 +3832,51 @@ int delete_check_result_file(char *fname) {
 
 
 
+/* compares two check result list slots by finish time */
+static int compare_check_result_slots(void *a, void *b) {
+	check_result_slot *sa = (check_result_slot *)a;
+	check_result_slot *sb = (check_result_slot *)b;
+
+	if (sa->finish_time.tv_sec != sb->finish_time.tv_sec)
+		return (sa->finish_time.tv_sec < sb->finish_time.tv_sec) ? -1 : 1;
+	if (sa->finish_time.tv_usec != sb->finish_time.tv_usec)
+		return (sa->finish_time.tv_usec < sb->finish_time.tv_usec) ? -1 : 1;
+	return 0;
+}
+
+
+
+/* drops all slots of the check result list index */
+static void empty_check_result_list_slots(void) {
+	check_result_slot *temp_slot = NULL;
+
+	if (check_result_list_slots == NULL)
+		return;
+
+	while ((temp_slot = (check_result_slot *)skiplist_pop(check_result_list_slots)) != NULL)
+		my_free(temp_slot);
+
+	skiplist_empty(check_result_list_slots);
+}
+
+
+
+/* returns the number of check results waiting in the list in memory */
+unsigned long get_check_result_list_items(void) {
+
+	/* the list may have been reset behind our back */
+	if (check_result_list == NULL)
+		return 0L;
+
+	return check_result_list_items;
+}
+
+
+
 /* reads the first host/service check result from the list in memory */
 check_result *read_check_result(void) {
 	check_result *first_cr = NULL;
+	check_result_slot *temp_slot = NULL;
 
 	if (check_result_list == NULL)
 		return NULL;
@@ -3079,6 +3888,21 @@ check_result *read_check_result(void) {
 	first_cr = check_result_list;
 	check_result_list = check_result_list->next;
 
+	/* drop the finish time slot if this was the only result left in it */
+	if (check_result_list_slots != NULL) {
+		if (check_result_list == NULL)
+			empty_check_result_list_slots();
+		else if ((temp_slot = (check_result_slot *)skiplist_peek(check_result_list_slots)) != NULL && temp_slot->last == first_cr) {
+			skiplist_pop(check_result_list_slots);
+			my_free(temp_slot);
+		}
+	}
+
+	if (check_result_list == NULL)
+		check_result_list_items = 0L;
+	else if (check_result_list_items > 0L)
+		check_result_list_items--;
+
 	/* forcibly detach this check result from the list tail */
 	first_cr->next = NULL;
 
@@ -3125,7 +3949,8 @@ int init_check_result(check_result *info) {
 
 /* adds a new host/service check result to the list in memory */
 int add_check_result_to_list(check_result *new_cr) {
-	check_result *temp_cr = NULL;
+	check_result_slot *temp_slot = NULL;
+	check_result_slot search_slot;
 	check_result *last_cr = NULL;
 
 	if (new_cr == NULL)
@@ -3135,32 +3960,43 @@ int add_check_result_to_list(check_result *new_cr) {
 	   can inter-mix calls to add_check_result (i.e. from an event broker) */
 	pthread_mutex_lock(&check_result_list_mutex);
 
+	if (check_result_list_slots == NULL)
+		check_result_list_slots = skiplist_new(15, 0.5, FALSE, FALSE, compare_check_result_slots);
+
 	/* add to list, sorted by finish time (asc) */
 
-	/* find insertion point */
-	last_cr = check_result_list;
-	for (temp_cr = check_result_list; temp_cr != NULL; temp_cr = temp_cr->next) {
-		if (temp_cr->finish_time.tv_sec >= new_cr->finish_time.tv_sec) {
-			if (temp_cr->finish_time.tv_sec > new_cr->finish_time.tv_sec)
-				break;
-			else if (temp_cr->finish_time.tv_usec > new_cr->finish_time.tv_usec)
-				break;
-		}
-		last_cr = temp_cr;
-	}
+	/* find the last result that finished at or before this one (the slot index is stale if the list was reset) */
+	search_slot.finish_time = new_cr->finish_time;
+	if (check_result_list == NULL) {
+		empty_check_result_list_slots();
+		check_result_list_items = 0L;
+	} else if ((temp_slot = (check_result_slot *)skiplist_find_floor(check_result_list_slots, &search_slot, NULL)) != NULL)
+		last_cr = temp_slot->last;
 
 	/* item goes at head of list */
-	if (check_result_list == NULL || temp_cr == check_result_list) {
+	if (last_cr == NULL) {
 		new_cr->next = check_result_list;
 		check_result_list = new_cr;
 	}
 
-	/* item goes in middle or at end of list */
+	/* item goes behind its predecessor */
 	else {
-		new_cr->next = temp_cr;
+		new_cr->next = last_cr->next;
 		last_cr->next = new_cr;
 	}
 
+	/* the new result is now the last one finished at this time */
+	if (temp_slot != NULL && compare_check_result_slots(temp_slot, &search_slot) == 0)
+		temp_slot->last = new_cr;
+	else if ((temp_slot = (check_result_slot *)malloc(sizeof(check_result_slot))) != NULL) {
+		temp_slot->finish_time = new_cr->finish_time;
+		temp_slot->last = new_cr;
+		if (check_result_list_slots == NULL || skiplist_insert(check_result_list_slots, (void *)temp_slot) != SKIPLIST_OK)
+			my_free(temp_slot);
+	}
+
+	check_result_list_items++;
+
 	/* unlock the mutex; all the destructive operations are done */
 	pthread_mutex_unlock(&check_result_list_mutex);
 
@@ -3182,6 +4018,11 @@ int free_check_result_list(void) {
 	}
 
 	check_result_list = NULL;
+	check_result_list_items = 0L;
+
+	/* free the finish time index */
+	empty_check_result_list_slots();
+	skiplist_free(&check_result_list_slots);
 
 	return OK;
 }
@@ -3767,6 +4608,7 @@ int file_uses_embedded_perl(char *fname) {
 /* initializes command file worker thread */
 int init_command_file_worker_thread(void) {
 	int result = 0;
+	int x = 0;
 	sigset_t newmask;
 
 	/* initialize circular buffer */
@@ -3783,6 +4625,22 @@ int init_command_file_worker_thread(void) {
 	if (sigrestart == FALSE)
 		pthread_mutex_init(&external_command_buffer.buffer_lock, NULL);
 
+	/* initialize the ring the worker thread hands its blocks over with */
+	command_file_ring_head = 0;
+	command_file_ring_tail = 0;
+	command_file_ring_high = 0;
+	command_file_reader_waiting = FALSE;
+
+	/* the main thread wakes up a waiting worker thread through this pipe */
+	if (pipe(command_file_wakeup_pipe) == -1) {
+		my_free(external_command_buffer.buffer);
+		return ERROR;
+	}
+	for (x = 0; x < 2; x++) {
+		fcntl(command_file_wakeup_pipe[x], F_SETFL, fcntl(command_file_wakeup_pipe[x], F_GETFL) | O_NONBLOCK);
+		fcntl(command_file_wakeup_pipe[x], F_SETFD, FD_CLOEXEC);
+	}
+
 	/* new thread should block all signals */
 	sigfillset(&newmask);
 	pthread_sigmask(SIG_BLOCK, &newmask, NULL);
@@ -3842,6 +4700,93 @@ void cleanup_command_file_worker_thread(void *arg) {
 	}
 	my_free(external_command_buffer.buffer);
 
+	/* release blocks that didn't make it to the main thread */
+	for (; command_file_ring_tail != command_file_ring_head; command_file_ring_tail++) {
+		my_free(command_file_ring[command_file_ring_tail % COMMAND_FILE_RING_SLOTS]);
+	}
+	my_free(command_file_pending_block);
+	my_free(command_file_read_buffer);
+
+	for (x = 0; x < 2; x++) {
+		if (command_file_wakeup_pipe[x] >= 0)
+			close(command_file_wakeup_pipe[x]);
+		command_file_wakeup_pipe[x] = -1;
+	}
+
+	return;
+}
+
+
+
+/* copies the complete lines of the read buffer into a new block for the main thread, skipping empty lines */
+static char *make_command_file_block(char *buf, size_t len) {
+	char *block = NULL;
+	char *line = NULL;
+	char *eol = NULL;
+	size_t line_len = 0;
+	size_t used = 0;
+
+	if ((block = (char *)malloc(len + 2)) == NULL)
+		return NULL;
+
+	for (line = buf; line < buf + len; line = eol + 1) {
+
+		if ((eol = memchr(line, '\n', (buf + len) - line)) == NULL)
+			eol = buf + len;
+
+		if ((line_len = eol - line) == 0)
+			continue;
+
+		memcpy(block + used, line, line_len);
+		used += line_len;
+		block[used++] = '\x0';
+	}
+	block[used] = '\x0';
+
+	return block;
+}
+
+
+
+/* hands a block over to the main thread, waiting for a free slot if necessary */
+static void queue_command_file_block(char *block) {
+	struct pollfd pfd;
+	char drain[64];
+
+	command_file_pending_block = block;
+
+	while (command_file_ring_head - command_file_ring_tail >= COMMAND_FILE_RING_SLOTS) {
+
+		/* announce that we're waiting before we look again, so the main thread can't miss us */
+		command_file_reader_waiting = TRUE;
+		__sync_synchronize();
+		if (command_file_ring_head - command_file_ring_tail < COMMAND_FILE_RING_SLOTS)
+			break;
+
+		/* sleep until the main thread took a block (or a while has passed) */
+		pfd.fd = command_file_wakeup_pipe[0];
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 500) > 0) {
+			while (read(command_file_wakeup_pipe[0], drain, sizeof(drain)) > 0)
+				;
+		}
+
+		/* should we shutdown? */
+		pthread_testcancel();
+	}
+	command_file_reader_waiting = FALSE;
+
+	/* publish the block before the new head */
+	command_file_ring[command_file_ring_head % COMMAND_FILE_RING_SLOTS] = block;
+	__sync_synchronize();
+	command_file_ring_head++;
+
+	/* keep track of the most blocks waiting at once */
+	if (command_file_ring_head - command_file_ring_tail > command_file_ring_high)
+		command_file_ring_high = command_file_ring_head - command_file_ring_tail;
+
+	command_file_pending_block = NULL;
+
 	return;
 }
 
@@ -3849,12 +4794,13 @@ void cleanup_command_file_worker_thread(void *arg) {
 
 /* worker thread - artificially increases buffer of named pipe */
 void * command_file_worker_thread(void *arg) {
-	char input_buffer[MAX_EXTERNAL_COMMAND_LENGTH];
 	struct pollfd pfd;
 	int pollval;
 	struct timeval tv;
-	int buffer_items = 0;
-	int result = 0;
+	char *block = NULL;
+	ssize_t bytes = 0;
+	size_t used = 0;
+	size_t complete = 0;
 
 	/* specify cleanup routine */
 	pthread_cleanup_push(cleanup_command_file_worker_thread, NULL);
@@ -3870,8 +4816,6 @@ void * command_file_worker_thread(void *arg) {
 
 		/* wait for data to arrive */
 		/* select seems to not work, so we have to use poll instead */
-		/* 10-15-08 EG check into implementing William's patch @ http://blog.netways.de/2008/08/15/nagios-unter-mac-os-x-installieren/ */
-		/* 10-15-08 EG poll() seems broken on OSX - see Jonathan's patch a few lines down */
 		pfd.fd = command_file_fd;
 		pfd.events = POLLIN;
 		pollval = poll(&pfd, 1, 500);
@@ -3910,75 +4854,62 @@ void * command_file_worker_thread(void *arg) {
 		/* should we shutdown? */
 		pthread_testcancel();
 
-		/* get number of items in the buffer */
-		pthread_mutex_lock(&external_command_buffer.buffer_lock);
-		buffer_items = external_command_buffer.items;
-		pthread_mutex_unlock(&external_command_buffer.buffer_lock);
+		/* room for a full read plus an incomplete line left over from the previous one */
+		if (command_file_read_buffer == NULL) {
+			if ((command_file_read_buffer = (char *)malloc(COMMAND_FILE_READ_SIZE + MAX_EXTERNAL_COMMAND_LENGTH)) == NULL) {
+				/* wait a bit */
+				tv.tv_sec = 0;
+				tv.tv_usec = 250000;
+				select(0, NULL, NULL, NULL, &tv);
+				continue;
+			}
+		}
 
-#ifdef DEBUG_CFWT
-		printf("(CFWT) BUFFER ITEMS: %d/%d\n", buffer_items, external_command_buffer_slots);
-#endif
+		/* read as much as we can get in one go */
+		if ((bytes = read(command_file_fd, command_file_read_buffer + used, COMMAND_FILE_READ_SIZE)) <= 0) {
 
-		/* 10-15-08 Fix for OS X by Jonathan Saggau - see http://www.jonathansaggau.com/blog/2008/09/using_shark_and_custom_dtrace.html */
-		/* Not sure if this would have negative effects on other OSes... */
-		if (buffer_items == 0) {
-			/* pause a bit so OS X doesn't go nuts with CPU overload */
+			/* 10-15-08 Fix for OS X by Jonathan Saggau - see http://www.jonathansaggau.com/blog/2008/09/using_shark_and_custom_dtrace.html */
+			/* pause a bit so OS X doesn't go nuts with CPU overload if poll() lied to us */
 			tv.tv_sec = 0;
 			tv.tv_usec = 500;
 			select(0, NULL, NULL, NULL, &tv);
+			continue;
 		}
-
-		/* process all commands in the file (named pipe) if there's some space in the buffer */
-		if (buffer_items < external_command_buffer_slots) {
-
-			/* clear EOF condition from prior run (FreeBSD fix) */
-			/* FIXME: use_poll_on_cmd_pipe: Still needed? */
-			clearerr(command_file_fp);
-
-			/* read and process the next command in the file */
-			while (fgets(input_buffer, (int)(sizeof(input_buffer) - 1), command_file_fp) != NULL) {
+		used += bytes;
 
 #ifdef DEBUG_CFWT
-				printf("(CFWT) READ: %s", input_buffer);
+		printf("(CFWT) READ: %ld bytes, %lu buffered\n", (long)bytes, (unsigned long)used);
 #endif
 
-				/* submit the external command for processing (retry if buffer is full) */
-				while ((result = submit_external_command(input_buffer, &buffer_items)) == ERROR && buffer_items == external_command_buffer_slots) {
+		/* only pass on complete lines... */
+		for (complete = used; complete > 0 && command_file_read_buffer[complete - 1] != '\n'; complete--)
+			;
 
-					/* wait a bit */
-					tv.tv_sec = 0;
-					tv.tv_usec = 250000;
-					select(0, NULL, NULL, NULL, &tv);
-
-					/* should we shutdown? */
-					pthread_testcancel();
-				}
-
-#ifdef DEBUG_CFWT
-				printf("(CFWT) RES: %d, BUFFER_ITEMS: %d/%d\n", result, buffer_items, external_comand_buffer_slots);
-#endif
-
-				/* bail if the circular buffer is full */
-				if (buffer_items == external_command_buffer_slots)
-					break;
+		/* ...unless the incomplete one doesn't fit into a command - fgets() used to split those, so do we */
+		if (used - complete >= MAX_EXTERNAL_COMMAND_LENGTH - 2)
+			complete = used;
+		if (complete == 0)
+			continue;
 
-				/* should we shutdown? */
-				pthread_testcancel();
-			}
-		} else {
-			/* HB 06-07-2009:
-			 * We should wait for the event queuing to catch up some commands
-			 * from the buffer if for this atomic run the buffer is filled completely or
-			 * is overrun
-			  */
-			/* wait a bit */
+		/* wait for memory rather than losing commands */
+		while ((block = make_command_file_block(command_file_read_buffer, complete)) == NULL) {
 			tv.tv_sec = 0;
 			tv.tv_usec = 250000;
 			select(0, NULL, NULL, NULL, &tv);
-
-			/* should we shutdown? */
 			pthread_testcancel();
 		}
+
+		/* keep the incomplete line for the next read */
+		used -= complete;
+		memmove(command_file_read_buffer, command_file_read_buffer + complete, used);
+
+		/* blocks without any commands aren't worth a slot */
+		if (*block == '\x0') {
+			my_free(block);
+			continue;
+		}
+
+		queue_command_file_block(block);
 	}
 
 	/* removes cleanup handler - this should never be reached */
@@ -3989,6 +4920,46 @@ void * command_file_worker_thread(void *arg) {
 
 
 
+/* returns the next block of command lines read by the command file worker thread (to be freed by the caller), NULL if there is none */
+char *get_command_file_block(void) {
+	char *block = NULL;
+
+	if (command_file_ring_tail == command_file_ring_head)
+		return NULL;
+
+	/* don't look at the slot before we saw the head that published it */
+	__sync_synchronize();
+	block = command_file_ring[command_file_ring_tail % COMMAND_FILE_RING_SLOTS];
+	command_file_ring[command_file_ring_tail % COMMAND_FILE_RING_SLOTS] = NULL;
+	__sync_synchronize();
+	command_file_ring_tail++;
+
+	/* wake up the worker thread if it was waiting for a free slot */
+	__sync_synchronize();
+	if (command_file_reader_waiting == TRUE)
+		write(command_file_wakeup_pipe[1], "", 1);
+
+	return block;
+}
+
+
+
+/* gets the number of blocks waiting in the command file ring, and the most that ever did */
+void get_command_file_ring_usage(int *used, int *high) {
+	unsigned long tail = command_file_ring_tail;
+
+	__sync_synchronize();
+
+	if (used != NULL)
+		*used = (int)(command_file_ring_head - tail);
+	if (high != NULL)
+		*high = (int)command_file_ring_high;
+
+	return;
+}
+
+
+
 /* submits an external command for processing */
 int submit_external_command(char *cmd, int *buffer_items) {
 	int result = OK;
@@ -4363,6 +5334,12 @@ void free_memory(icinga_macros *mac) {
 	timed_event *this_event = NULL;
 	timed_event *next_event = NULL;
 
+	/* free the cached valid times of the timeperiods */
+	free_timeperiod_caches();
+
+	/* free the compiled command lines */
+	free_command_templates();
+
 	/* free all allocated memory for the object definitions */
 	free_object_data();
 
@@ -4372,6 +5349,9 @@ void free_memory(icinga_macros *mac) {
 	/* free check result list */
 	free_check_result_list();
 
+	/* free the freshness and running check queues, they point to the objects */
+	free_check_queues();
+
 	/* free memory for the high priority event list */
 	this_event = event_list_high;
 	while (this_event != NULL) {
@@ -4398,6 +5378,9 @@ void free_memory(icinga_macros *mac) {
 	/* reset the event pointer */
 	event_list_low = NULL;
 
+	/* free the run time index of both event lists */
+	free_event_list_slots();
+
 	/* free memory for global event handlers */
 	my_free(global_host_event_handler);
 	my_free(global_service_event_handler);
@@ -4425,6 +5408,9 @@ void free_memory(icinga_macros *mac) {
 	my_free(illegal_object_chars);
 	my_free(illegal_output_chars);
 
+	/* free the list of environment macros */
+	my_free(environment_macros);
+
 	/* free Icinga user and group */
 	my_free(nagios_user);
 	my_free(nagios_group);
@@ -4622,6 +5608,12 @@ int reset_variables(void) {
 
 	max_check_result_list_items = DEFAULT_MAX_CHECK_RESULT_LIST_ITEMS;
 
+	check_worker_processes = DEFAULT_CHECK_WORKER_PROCESSES;
+	check_worker_queue_depth = DEFAULT_CHECK_WORKER_QUEUE_DEPTH;
+	check_result_reaper_threads = DEFAULT_CHECK_RESULT_REAPER_THREADS;
+
+	use_check_result_channel = DEFAULT_USE_CHECK_RESULT_CHANNEL;
+
 	date_format = DATE_FORMAT_US;
 
 	/* initialize macros */
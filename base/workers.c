@@ -0,0 +1,924 @@
+/*****************************************************************************
+ *
+ * WORKERS.C - Persistent check worker processes for Icinga
+ *
+ * Copyright (c) 2009-2015 Icinga Development Team (http://www.icinga.org)
+ *
+ * License:
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *****************************************************************************/
+
+/*
+ * Active checks are normally run by fork()ing the (potentially huge) core
+ * process once or twice per check.  Check workers are small helper processes
+ * started once at program start which execute plugins on behalf of the core
+ * via posix_spawn() and hand the results back over a unix socket pair.  They
+ * are forked right after the main config file has been read, before any
+ * object data is loaded, and are restarted along with the core on SIGHUP.
+ *
+ * Both directions use NUL terminated messages made of the same var=value
+ * lines that are written to check result files.  The core sends the check
+ * attributes and environment macros followed by "timeout=" and
+ * "command_line=", the worker echoes the attributes back followed by the
+ * plugin result.
+ */
+
+#include "../include/config.h"
+#include "../include/common.h"
+#include "../include/objects.h"
+#include "../include/icinga.h"
+
+#include <spawn.h>
+
+extern int      service_check_timeout;
+extern int      service_check_timeout_state;
+
+extern int      use_large_installation_tweaks;
+extern int      enable_environment_macros;
+extern char     *environment_macros;
+
+extern int      check_worker_processes;
+extern int      check_worker_queue_depth;
+
+extern check_worker *check_workers;
+
+#ifdef EMBEDDEDPERL
+extern int      use_embedded_perl;
+#endif
+
+extern char     **environ;
+
+#define CHECK_WORKER_READ_SIZE          8192
+#define CHECK_WORKER_ENV_GROWTH         64
+
+/* a plugin running inside a check worker */
+typedef struct check_worker_job_struct {
+	pid_t pid;
+	int fd;                                         /* read end of the plugin output pipe, -1 once drained */
+	int is_service;
+	time_t deadline;
+	int early_timeout;
+	char *header;                                   /* check attributes to echo back to the core */
+	dbuf output;
+	struct check_worker_job_struct *next;
+} check_worker_job;
+
+/* state of the worker process itself - unused in the core */
+static check_worker_job *worker_job_list = NULL;
+static int worker_job_count = 0;
+static int worker_sd = -1;
+static int worker_core_gone = FALSE;
+static char *worker_outbuf = NULL;
+static unsigned long worker_outbuf_used = 0;
+static unsigned long worker_outbuf_size = 0;
+
+static int spawn_check_worker(check_worker *);
+static void run_check_worker(int);
+
+
+
+/******************************************************************/
+/************************ HELPER FUNCTIONS ************************/
+/******************************************************************/
+
+/* sets close-on-exec and optionally non-blocking mode on a file descriptor */
+static int set_worker_fd_flags(int fd, int nonblock) {
+	int flags;
+
+	if ((flags = fcntl(fd, F_GETFD, 0)) < 0 || fcntl(fd, F_SETFD, flags | FD_CLOEXEC) < 0)
+		return ERROR;
+
+	if (nonblock == FALSE)
+		return OK;
+
+	if ((flags = fcntl(fd, F_GETFL, 0)) < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+		return ERROR;
+
+	return OK;
+}
+
+
+/* makes sure a buffer has room for at least the given number of additional bytes */
+static int grow_worker_buffer(char **buf, unsigned long *size, unsigned long used, unsigned long needed) {
+	char *new_buf = NULL;
+	unsigned long new_size;
+
+	if (used + needed <= *size)
+		return OK;
+
+	new_size = (*size == 0) ? CHECK_WORKER_READ_SIZE : *size;
+	while (new_size < used + needed)
+		new_size *= 2;
+
+	if ((new_buf = (char *)realloc(*buf, new_size)) == NULL)
+		return ERROR;
+
+	*buf = new_buf;
+	*size = new_size;
+
+	return OK;
+}
+
+
+
+/******************************************************************/
+/********************* CORE SIDE FUNCTIONS ************************/
+/******************************************************************/
+
+/* starts the persistent check worker processes */
+int init_check_workers(void) {
+	register int x = 0;
+	int started = 0;
+
+	log_debug_info(DEBUGL_FUNCTIONS, 0, "init_check_workers()\n");
+
+	if (check_worker_processes <= 0)
+		return OK;
+
+	if ((check_workers = (check_worker *)calloc(check_worker_processes, sizeof(check_worker))) == NULL) {
+		logit(NSLOG_RUNTIME_ERROR, TRUE, "Error: Could not allocate memory for %d check workers - falling back to forking every check.\n", check_worker_processes);
+		return ERROR;
+	}
+
+	for (x = 0; x < check_worker_processes; x++) {
+		check_workers[x].id = x;
+		check_workers[x].pid = -1;
+		check_workers[x].sd = -1;
+	}
+
+	/* workers that fail to start are retried by the check reaper, until then their checks are forked */
+	for (x = 0; x < check_worker_processes; x++) {
+		if (spawn_check_worker(&check_workers[x]) == OK)
+			started++;
+	}
+
+	log_debug_info(DEBUGL_PROCESS | DEBUGL_CHECKS, 0, "Started %d of %d check worker processes\n", started, check_worker_processes);
+
+	return OK;
+}
+
+
+/* disconnects from the check workers, which finish their running checks and exit on their own */
+int shutdown_check_workers(void) {
+	register int x = 0;
+
+	log_debug_info(DEBUGL_FUNCTIONS, 0, "shutdown_check_workers()\n");
+
+	if (check_workers == NULL)
+		return OK;
+
+	for (x = 0; x < check_worker_processes; x++) {
+		if (check_workers[x].sd >= 0)
+			close(check_workers[x].sd);
+		my_free(check_workers[x].buf);
+	}
+
+	my_free(check_workers);
+
+	return OK;
+}
+
+
+/* forks a (double-forked) check worker process connected to us by a socket pair */
+static int spawn_check_worker(check_worker *worker) {
+	int sv[2];
+	pid_t pid;
+	pid_t worker_pid = -1;
+	register int x = 0;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+		logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Could not create socket pair for check worker #%d: %s\n", worker->id, strerror(errno));
+		return ERROR;
+	}
+	set_worker_fd_flags(sv[0], FALSE);
+	set_worker_fd_flags(sv[1], FALSE);
+
+	pid = fork();
+
+	if (pid < 0) {
+		logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Could not fork check worker #%d: %s\n", worker->id, strerror(errno));
+		close(sv[0]);
+		close(sv[1]);
+		return ERROR;
+	}
+
+	if (pid == 0) {
+
+		close(sv[0]);
+
+		/* don't keep the other workers' sockets open */
+		for (x = 0; x < check_worker_processes; x++) {
+			if (check_workers[x].sd >= 0)
+				close(check_workers[x].sd);
+		}
+
+		/* close external command file and any file descriptors on behalf of our event brokers */
+		close_command_file();
+		close_registered_fds();
+
+		reset_sighandler();
+		signal(SIGPIPE, SIG_IGN);
+
+		/* workers are started before the core daemonizes, keep them away from its controlling terminal */
+		setsid();
+
+		/* fork again, so the worker gets inherited by INIT and we never have to wait for it */
+		worker_pid = fork();
+		if (worker_pid < 0)
+			_exit(STATE_UNKNOWN);
+
+		if (worker_pid == 0)
+			run_check_worker(sv[1]);
+
+		/* let the core know the pid of the worker */
+		write(sv[1], &worker_pid, sizeof(worker_pid));
+		_exit(STATE_OK);
+	}
+
+	close(sv[1]);
+
+	waitpid(pid, NULL, 0);
+	if (read(sv[0], &worker_pid, sizeof(worker_pid)) != sizeof(worker_pid)) {
+		logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Check worker #%d failed to start.\n", worker->id);
+		close(sv[0]);
+		return ERROR;
+	}
+
+	worker->pid = worker_pid;
+	worker->sd = sv[0];
+	worker->buf_used = 0;
+	worker->running_checks = 0;
+	worker->start_time = time(NULL);
+
+	log_debug_info(DEBUGL_CHECKS | DEBUGL_IPC, 1, "Check worker #%d started (pid=%lu)\n", worker->id, (unsigned long)worker_pid);
+
+	return OK;
+}
+
+
+/* handles a worker that went away - its running checks will be caught by the orphan check logic */
+static void handle_check_worker_exit(check_worker *worker) {
+
+	logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Check worker #%d (pid=%lu) exited unexpectedly with %d checks running.  Restarting it...\n", worker->id, (unsigned long)worker->pid, worker->running_checks);
+
+	close(worker->sd);
+	worker->sd = -1;
+	worker->pid = -1;
+	worker->buf_used = 0;
+	worker->running_checks = 0;
+	worker->restarts++;
+
+	spawn_check_worker(worker);
+
+	return;
+}
+
+
+/* hands an active check over to a check worker */
+int run_check_via_worker(check_result *cr, int timeout, char *processed_command, icinga_macros *mac) {
+	check_worker *worker = NULL;
+	char **envp = NULL;
+	char *escaped_var = NULL;
+	char *msg = NULL;
+	char *ptr = NULL;
+	dbuf env_dbuf;
+	int msg_len = 0;
+	ssize_t result = 0;
+	register int x = 0;
+
+	if (check_workers == NULL || cr == NULL || processed_command == NULL)
+		return ERROR;
+
+	/* all environment macros include the summary macros, which are too expensive to build in the core for every check */
+	if (enable_environment_macros == TRUE && environment_macros == NULL && use_large_installation_tweaks == FALSE)
+		return ERROR;
+
+#ifdef EMBEDDEDPERL
+	/* perl plugins get run by the interpreter inside a forked copy of the core */
+	if (use_embedded_perl == TRUE)
+		return ERROR;
+#endif
+
+	/* use the least busy worker */
+	for (x = 0; x < check_worker_processes; x++) {
+		if (check_workers[x].sd < 0 || check_workers[x].running_checks >= check_worker_queue_depth)
+			continue;
+		if (worker == NULL || check_workers[x].running_checks < worker->running_checks)
+			worker = &check_workers[x];
+	}
+
+	if (worker == NULL) {
+		log_debug_info(DEBUGL_CHECKS, 1, "No check worker has capacity left, forking the check instead.\n");
+		return ERROR;
+	}
+
+	/* environment macros are passed along with the check, the worker hands them to the plugin */
+	dbuf_init(&env_dbuf, 1024);
+	if (enable_environment_macros == TRUE) {
+
+		if ((envp = get_macro_environment_r(mac)) == NULL) {
+			dbuf_free(&env_dbuf);
+			return ERROR;
+		}
+
+		for (x = 0; envp[x] != NULL; x++) {
+			dbuf_strcat(&env_dbuf, "environment=");
+			if (strpbrk(envp[x], "\\\n") == NULL)
+				dbuf_strcat(&env_dbuf, envp[x]);
+			else {
+				escaped_var = escape_newlines(envp[x]);
+				dbuf_strcat(&env_dbuf, escaped_var);
+				my_free(escaped_var);
+			}
+			dbuf_strcat(&env_dbuf, "\n");
+		}
+
+		my_free(envp);
+	}
+
+	msg_len = asprintf(&msg, "host_name=%s\n%s%s%scheck_type=%d\ncheck_options=%d\nscheduled_check=%d\nreschedule_check=%d\nlatency=%f\nstart_time=%lu.%lu\n%stimeout=%d\ncommand_line=%s",
+	                   cr->host_name,
+	                   (cr->service_description == NULL) ? "" : "service_description=",
+	                   (cr->service_description == NULL) ? "" : cr->service_description,
+	                   (cr->service_description == NULL) ? "" : "\n",
+	                   cr->check_type,
+	                   cr->check_options,
+	                   cr->scheduled_check,
+	                   cr->reschedule_check,
+	                   cr->latency,
+	                   cr->start_time.tv_sec,
+	                   cr->start_time.tv_usec,
+	                   (env_dbuf.buf == NULL) ? "" : env_dbuf.buf,
+	                   timeout,
+	                   processed_command);
+	dbuf_free(&env_dbuf);
+	if (msg_len < 0)
+		return ERROR;
+
+	/* send the message including its terminating NUL */
+	for (ptr = msg, msg_len++; msg_len > 0; ptr += result, msg_len -= result) {
+		result = write(worker->sd, ptr, msg_len);
+		if (result < 0 && errno == EINTR) {
+			result = 0;
+			continue;
+		}
+		if (result <= 0)
+			break;
+	}
+
+	my_free(msg);
+
+	if (msg_len > 0) {
+		handle_check_worker_exit(worker);
+		return ERROR;
+	}
+
+	worker->running_checks++;
+
+	log_debug_info(DEBUGL_CHECKS, 1, "Check is executing in check worker #%d (pid=%lu, %d running checks)\n", worker->id, (unsigned long)worker->pid, worker->running_checks);
+
+	return OK;
+}
+
+
+/* converts a result message from a worker into a check result */
+static int handle_check_worker_message(check_worker *worker, char *msg) {
+	check_result *new_cr = NULL;
+
+	if (worker->running_checks > 0)
+		worker->running_checks--;
+	worker->total_checks++;
+
+	if ((new_cr = parse_check_result_message(msg)) == NULL)
+		return ERROR;
+
+	if (new_cr->early_timeout == TRUE)
+		worker->timed_out_checks++;
+
+	add_check_result_to_list(new_cr);
+
+	return OK;
+}
+
+
+/* reads pending messages from a worker socket without blocking */
+static void read_check_worker_socket(check_worker *worker) {
+	char *msg = NULL;
+	char *end = NULL;
+	ssize_t result = 0;
+
+	while (1) {
+
+		if (grow_worker_buffer(&worker->buf, &worker->buf_size, worker->buf_used, CHECK_WORKER_READ_SIZE) == ERROR)
+			break;
+
+		result = recv(worker->sd, worker->buf + worker->buf_used, worker->buf_size - worker->buf_used, MSG_DONTWAIT);
+
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (result <= 0) {
+			handle_check_worker_exit(worker);
+			break;
+		}
+
+		worker->buf_used += result;
+
+		/* process all complete messages */
+		for (msg = worker->buf; (end = memchr(msg, '\x0', worker->buf_used - (msg - worker->buf))) != NULL; msg = end + 1)
+			handle_check_worker_message(worker, msg);
+
+		/* keep partial messages for the next round */
+		worker->buf_used -= (msg - worker->buf);
+		if (worker->buf_used > 0 && msg != worker->buf)
+			memmove(worker->buf, msg, worker->buf_used);
+	}
+
+	return;
+}
+
+
+/* moves check results the workers have sent so far to the check result list - called on every pass of the event loop */
+int read_check_worker_results(void) {
+	register int x = 0;
+
+	if (check_workers == NULL)
+		return OK;
+
+	for (x = 0; x < check_worker_processes; x++) {
+		if (check_workers[x].sd >= 0)
+			read_check_worker_socket(&check_workers[x]);
+	}
+
+	return OK;
+}
+
+
+/* restarts workers that failed to start and collects their results */
+int reap_check_worker_results(void) {
+	register int x = 0;
+
+	if (check_workers == NULL)
+		return OK;
+
+	/* retry workers that failed to start */
+	for (x = 0; x < check_worker_processes; x++) {
+		if (check_workers[x].sd < 0)
+			spawn_check_worker(&check_workers[x]);
+	}
+
+	return read_check_worker_results();
+}
+
+
+
+/******************************************************************/
+/******************** WORKER SIDE FUNCTIONS ***********************/
+/******************************************************************/
+
+/* queues a check result for the core */
+static void send_worker_result(char *header, int is_service, int early_timeout, int exited_ok, int return_code, char *output) {
+	struct timeval finish_time;
+	char *msg = NULL;
+	int msg_len = 0;
+
+	gettimeofday(&finish_time, NULL);
+
+	if (early_timeout == TRUE) {
+		return_code = (is_service == TRUE) ? service_check_timeout_state : STATE_CRITICAL;
+		output = (is_service == TRUE) ? "(Service Check Timed Out)" : "(Host Check Timed Out)";
+	}
+
+	msg_len = asprintf(&msg, "%sfinish_time=%lu.%lu\nearly_timeout=%d\nexited_ok=%d\nreturn_code=%d\noutput=%s\n", (header == NULL) ? "" : header, finish_time.tv_sec, finish_time.tv_usec, early_timeout, exited_ok, return_code, (output == NULL) ? "(null)" : output);
+	if (msg_len < 0)
+		return;
+
+	if (worker_core_gone == TRUE)
+		submit_check_result_message(msg);
+	else if (grow_worker_buffer(&worker_outbuf, &worker_outbuf_size, worker_outbuf_used, msg_len + 1) == OK) {
+		memcpy(worker_outbuf + worker_outbuf_used, msg, msg_len + 1);
+		worker_outbuf_used += msg_len + 1;
+	}
+
+	my_free(msg);
+
+	return;
+}
+
+
+/* undoes escape_newlines() in place */
+static void unescape_worker_line(char *line) {
+	char *src = NULL;
+	char *dst = NULL;
+
+	for (src = line, dst = line; *src != '\x0'; src++) {
+		if (*src == '\\' && (src[1] == 'n' || src[1] == '\\')) {
+			*(dst++) = (src[1] == 'n') ? '\n' : '\\';
+			src++;
+		} else
+			*(dst++) = *src;
+	}
+	*dst = '\x0';
+
+	return;
+}
+
+
+/* adds a variable to a plugin environment */
+static int add_worker_env_var(char ***envp, int *count, int *size, char *var) {
+	char **new_envp = NULL;
+
+	/* leave room for the terminating NULL */
+	if (*count + 1 >= *size) {
+		if ((new_envp = (char **)realloc(*envp, sizeof(char *) * (*size + CHECK_WORKER_ENV_GROWTH))) == NULL)
+			return ERROR;
+		*envp = new_envp;
+		*size += CHECK_WORKER_ENV_GROWTH;
+	}
+
+	(*envp)[(*count)++] = var;
+	(*envp)[*count] = NULL;
+
+	return OK;
+}
+
+
+/* starts a plugin for a check request received from the core */
+static void start_worker_job(char *msg) {
+	check_worker_job *new_job = NULL;
+	dbuf header;
+	char *line = NULL;
+	char *eol = NULL;
+	char *command_line = NULL;
+	char *argv[MAX_CMD_ARGS];
+	char **envp = NULL;
+	int env_count = 0;
+	int env_size = 0;
+	int env_error = FALSE;
+	register int x = 0;
+	int timeout = service_check_timeout;
+	int is_service = FALSE;
+	int pipefds[2];
+	pid_t pid;
+	int result = 0;
+	posix_spawn_file_actions_t file_actions;
+	posix_spawnattr_t attr;
+	sigset_t sigset;
+
+	dbuf_init(&header, 256);
+
+	for (line = msg; line != NULL && *line != '\x0'; line = eol) {
+
+		/* the command line is always last and may contain newlines */
+		if (!strncmp(line, "command_line=", 13)) {
+			command_line = line + 13;
+			break;
+		}
+
+		if ((eol = strchr(line, '\n')) != NULL)
+			*(eol++) = '\x0';
+
+		if (!strncmp(line, "timeout=", 8))
+			timeout = atoi(line + 8);
+		else if (!strncmp(line, "environment=", 12)) {
+			unescape_worker_line(line + 12);
+			if (add_worker_env_var(&envp, &env_count, &env_size, line + 12) == ERROR)
+				env_error = TRUE;
+		} else {
+			if (!strncmp(line, "service_description=", 20))
+				is_service = TRUE;
+			dbuf_strcat(&header, line);
+			dbuf_strcat(&header, "\n");
+		}
+	}
+
+	/* the environment macros of the check come first, anything left over from the core's environment after them */
+	if (envp != NULL) {
+		for (x = 0; environ[x] != NULL && env_error == FALSE; x++) {
+			if (strncmp(environ[x], MACRO_ENV_VAR_PREFIX, strlen(MACRO_ENV_VAR_PREFIX)) && add_worker_env_var(&envp, &env_count, &env_size, environ[x]) == ERROR)
+				env_error = TRUE;
+		}
+	}
+
+	if (command_line == NULL || env_error == TRUE || pipe(pipefds) < 0) {
+		send_worker_result(header.buf, is_service, FALSE, TRUE, STATE_UNKNOWN, NULL);
+		dbuf_free(&header);
+		my_free(envp);
+		return;
+	}
+	set_worker_fd_flags(pipefds[0], TRUE);
+	set_worker_fd_flags(pipefds[1], FALSE);
+
+	/* plugins get their own process group, so timeouts can kill everything they started */
+	posix_spawn_file_actions_init(&file_actions);
+	posix_spawn_file_actions_adddup2(&file_actions, pipefds[1], STDOUT_FILENO);
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+	posix_spawnattr_setpgroup(&attr, 0);
+	sigfillset(&sigset);
+	posix_spawnattr_setsigdefault(&attr, &sigset);
+	sigemptyset(&sigset);
+	posix_spawnattr_setsigmask(&attr, &sigset);
+
+	/* check for check execution method (shell or execvp) */
+	if (has_shell_metachars(command_line)) {
+		log_debug_info(DEBUGL_CHECKS, 0, "running command %s via shell\n", command_line);
+		argv[0] = "/bin/sh";
+		argv[1] = "-c";
+		argv[2] = command_line;
+		argv[3] = NULL;
+		result = posix_spawn(&pid, "/bin/sh", &file_actions, &attr, argv, (envp == NULL) ? environ : envp);
+	} else {
+		/* like run_check(), capture stderr as well when not using the shell */
+		posix_spawn_file_actions_adddup2(&file_actions, pipefds[1], STDERR_FILENO);
+		log_debug_info(DEBUGL_CHECKS, 0, "running command %s via execvp\n", command_line);
+		if (parse_command_line(command_line, argv) == ERROR)
+			result = E2BIG;
+		else if (argv[0] == NULL) {
+			logit(NSLOG_RUNTIME_WARNING, TRUE, "plugin command definition empty\n");
+			result = ENOENT;
+		} else if ((result = posix_spawnp(&pid, argv[0], &file_actions, &attr, argv, (envp == NULL) ? environ : envp)) != 0)
+			logit(NSLOG_RUNTIME_WARNING, TRUE, "error executing command '%s': %s. Make sure that the file actually exists (in PATH, if set) and is executable!\n", argv[0], strerror(result));
+	}
+
+	posix_spawn_file_actions_destroy(&file_actions);
+	posix_spawnattr_destroy(&attr);
+	close(pipefds[1]);
+	my_free(envp);
+
+	if (result != 0) {
+		close(pipefds[0]);
+		send_worker_result(header.buf, is_service, FALSE, TRUE, STATE_UNKNOWN, NULL);
+		dbuf_free(&header);
+		return;
+	}
+
+	if ((new_job = (check_worker_job *)calloc(1, sizeof(check_worker_job))) == NULL) {
+		/* the plugin still gets reaped, but nobody will wait for its output */
+		close(pipefds[0]);
+		send_worker_result(header.buf, is_service, FALSE, TRUE, STATE_UNKNOWN, NULL);
+		dbuf_free(&header);
+		return;
+	}
+
+	new_job->pid = pid;
+	new_job->fd = pipefds[0];
+	new_job->is_service = is_service;
+	new_job->deadline = time(NULL) + timeout;
+	new_job->early_timeout = FALSE;
+	new_job->header = header.buf;
+	dbuf_init(&new_job->output, CHECK_WORKER_READ_SIZE);
+
+	new_job->next = worker_job_list;
+	worker_job_list = new_job;
+	worker_job_count++;
+
+	return;
+}
+
+
+/* reads check requests from the core */
+static void read_worker_jobs(char **inbuf, unsigned long *inbuf_used, unsigned long *inbuf_size) {
+	char *msg = NULL;
+	char *end = NULL;
+	ssize_t result = 0;
+
+	while (1) {
+
+		if (grow_worker_buffer(inbuf, inbuf_size, *inbuf_used, CHECK_WORKER_READ_SIZE) == ERROR)
+			return;
+
+		result = read(worker_sd, *inbuf + *inbuf_used, *inbuf_size - *inbuf_used);
+
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+		if (result <= 0) {
+			/* the core is shutting down or restarting - finish what we have and pass the results on to the reaper */
+			worker_core_gone = TRUE;
+			break;
+		}
+
+		*inbuf_used += result;
+
+		for (msg = *inbuf; (end = memchr(msg, '\x0', *inbuf_used - (msg - *inbuf))) != NULL; msg = end + 1)
+			start_worker_job(msg);
+
+		*inbuf_used -= (msg - *inbuf);
+		if (*inbuf_used > 0 && msg != *inbuf)
+			memmove(*inbuf, msg, *inbuf_used);
+	}
+
+	/* hand pending results over to the check result channel or queue directory */
+	for (msg = worker_outbuf; worker_outbuf_used > 0 && (end = memchr(msg, '\x0', worker_outbuf_used - (msg - worker_outbuf))) != NULL; msg = end + 1)
+		submit_check_result_message(msg);
+	worker_outbuf_used = 0;
+
+	return;
+}
+
+
+/* sends queued results to the core */
+static void flush_worker_results(void) {
+	ssize_t result = 0;
+
+	while (worker_outbuf_used > 0) {
+
+		result = write(worker_sd, worker_outbuf, worker_outbuf_used);
+
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result <= 0)
+			return;
+
+		worker_outbuf_used -= result;
+		if (worker_outbuf_used > 0)
+			memmove(worker_outbuf, worker_outbuf + result, worker_outbuf_used);
+	}
+
+	return;
+}
+
+
+/* reads plugin output */
+static void read_worker_job_output(check_worker_job *job) {
+	char buffer[CHECK_WORKER_READ_SIZE];
+	ssize_t result = 0;
+
+	while (1) {
+
+		result = read(job->fd, buffer, sizeof(buffer) - 1);
+
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+		if (result <= 0)
+			break;
+
+		buffer[result] = '\x0';
+		dbuf_strcat(&job->output, buffer);
+	}
+
+	close(job->fd);
+	job->fd = -1;
+
+	return;
+}
+
+
+/* kills plugins that ran too long and reports the ones that have exited */
+static void reap_worker_jobs(void) {
+	check_worker_job *temp_job = NULL;
+	check_worker_job *next_job = NULL;
+	check_worker_job *last_job = NULL;
+	char *output = NULL;
+	pid_t result = 0;
+	int status = 0;
+	int return_code = 0;
+	time_t current_time;
+
+	time(&current_time);
+
+	for (temp_job = worker_job_list; temp_job != NULL; temp_job = next_job) {
+
+		next_job = temp_job->next;
+
+		if (temp_job->early_timeout == FALSE && current_time >= temp_job->deadline) {
+			kill(-temp_job->pid, SIGKILL);
+			kill(temp_job->pid, SIGKILL);
+			temp_job->early_timeout = TRUE;
+			if (temp_job->fd >= 0) {
+				close(temp_job->fd);
+				temp_job->fd = -1;
+			}
+		}
+
+		if (temp_job->fd >= 0 || ((result = waitpid(temp_job->pid, &status, WNOHANG)) == 0) || (result < 0 && errno == EINTR)) {
+			last_job = temp_job;
+			continue;
+		}
+
+		/* test for execution error */
+		if (result < 0)
+			return_code = STATE_UNKNOWN;
+		else if (WEXITSTATUS(status) == 0 && WIFSIGNALED(status))
+			return_code = 128 + WTERMSIG(status);
+		else
+			return_code = WEXITSTATUS(status);
+
+		output = escape_newlines(temp_job->output.buf);
+		send_worker_result(temp_job->header, temp_job->is_service, temp_job->early_timeout, TRUE, return_code, output);
+		my_free(output);
+
+		if (last_job == NULL)
+			worker_job_list = next_job;
+		else
+			last_job->next = next_job;
+		worker_job_count--;
+
+		dbuf_free(&temp_job->output);
+		my_free(temp_job->header);
+		my_free(temp_job);
+	}
+
+	return;
+}
+
+
+/* main loop of a check worker process */
+static void run_check_worker(int sd) {
+	check_worker_job *temp_job = NULL;
+	struct pollfd *pfds = NULL;
+	struct pollfd *new_pfds = NULL;
+	check_worker_job **pjobs = NULL;
+	check_worker_job **new_pjobs = NULL;
+	int pfds_size = 0;
+	int nfds = 0;
+	int poll_timeout = 0;
+	char *inbuf = NULL;
+	unsigned long inbuf_used = 0;
+	unsigned long inbuf_size = 0;
+	time_t current_time;
+	register int x = 0;
+
+	worker_sd = sd;
+	set_worker_fd_flags(worker_sd, TRUE);
+
+	while (worker_core_gone == FALSE || worker_job_list != NULL) {
+
+		if (pfds_size < worker_job_count + 1) {
+			pfds_size = (worker_job_count + 1) * 2;
+			new_pfds = (struct pollfd *)realloc(pfds, pfds_size * sizeof(struct pollfd));
+			new_pjobs = (check_worker_job **)realloc(pjobs, pfds_size * sizeof(check_worker_job *));
+			if (new_pfds != NULL)
+				pfds = new_pfds;
+			if (new_pjobs != NULL)
+				pjobs = new_pjobs;
+			if (new_pfds == NULL || new_pjobs == NULL)
+				break;
+		}
+
+		/* negative descriptors are ignored by poll() */
+		pfds[0].fd = (worker_core_gone == TRUE) ? -1 : worker_sd;
+		pfds[0].events = POLLIN | ((worker_outbuf_used > 0) ? POLLOUT : 0);
+		pfds[0].revents = 0;
+		nfds = 1;
+
+		time(&current_time);
+		poll_timeout = 1000;
+
+		for (temp_job = worker_job_list; temp_job != NULL; temp_job = temp_job->next) {
+
+			if (temp_job->fd >= 0) {
+				pfds[nfds].fd = temp_job->fd;
+				pfds[nfds].events = POLLIN;
+				pfds[nfds].revents = 0;
+				pjobs[nfds++] = temp_job;
+			}
+
+			/* poll for exited plugins which already closed their output */
+			else if (poll_timeout > 10)
+				poll_timeout = 10;
+
+			if (temp_job->early_timeout == FALSE && (temp_job->deadline - current_time) * 1000 < poll_timeout)
+				poll_timeout = (temp_job->deadline <= current_time) ? 0 : (temp_job->deadline - current_time) * 1000;
+		}
+
+		if (poll(pfds, nfds, poll_timeout) < 0 && errno != EINTR)
+			break;
+
+		if (pfds[0].revents & (POLLIN | POLLHUP | POLLERR))
+			read_worker_jobs(&inbuf, &inbuf_used, &inbuf_size);
+		if (worker_core_gone == FALSE && worker_outbuf_used > 0)
+			flush_worker_results();
+
+		for (x = 1; x < nfds; x++) {
+			if (pfds[x].revents != 0)
+				read_worker_job_output(pjobs[x]);
+		}
+
+		reap_worker_jobs();
+
+		/* results of checks that just finished */
+		if (worker_core_gone == FALSE && worker_outbuf_used > 0)
+			flush_worker_results();
+	}
+
+	_exit(STATE_OK);
+}
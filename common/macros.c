@@ -38,6 +38,7 @@
 #ifdef NSCORE
 extern int      use_large_installation_tweaks;
 extern int      enable_environment_macros;
+extern char     *environment_macros;
 extern int	keep_unknown_macros;
 #endif
 
@@ -120,24 +121,194 @@ const struct macro_key_code *find_macro_key(const char *name) {
 }
 
 
+/* a growing buffer macros are expanded into */
+typedef struct macro_buffer_struct {
+	char *buffer;
+	size_t length;
+	size_t size;
+} macro_buffer;
+
+
+/* allocates the output buffer, sized to hold the expected output in one go */
+static int init_macro_buffer(macro_buffer *mb, size_t size) {
+
+	mb->length = 0;
+	mb->size = (size < 64) ? 64 : size;
+
+	if ((mb->buffer = (char *)malloc(mb->size)) == NULL) {
+		mb->size = 0;
+		return ERROR;
+	}
+	mb->buffer[0] = '\x0';
+
+	return OK;
+}
+
+
+/* appends text to the output buffer, keeping it terminated */
+static int add_to_macro_buffer(macro_buffer *mb, const char *text, size_t length) {
+	char *new_buffer = NULL;
+	size_t new_size = 0;
+
+	if (mb->buffer == NULL || text == NULL)
+		return ERROR;
+
+	if (mb->length + length + 1 > mb->size) {
+		for (new_size = mb->size * 2; new_size < mb->length + length + 1; new_size *= 2)
+			;
+		if ((new_buffer = (char *)realloc(mb->buffer, new_size)) == NULL)
+			return ERROR;
+		mb->buffer = new_buffer;
+		mb->size = new_size;
+	}
+
+	memcpy(mb->buffer + mb->length, text, length);
+	mb->length += length;
+	mb->buffer[mb->length] = '\x0';
+
+	return OK;
+}
+
+
+/**
+ * adds the value grabbed for a macro to the output, or the macro itself if
+ * it is unknown - frees the value if told to do so
+ */
+static void add_macro_value(macro_buffer *mb, char *macro_name, int terminated, int result, char *selected_macro, int clean_options, int free_macro, int options) {
+	char *original_macro = NULL;
+	char *cleaned_macro = NULL;
+	int macro_options = 0;
+
+	/* an error occurred - we couldn't parse the macro, so continue on */
+	if (result == ERROR) {
+		/* empty string still could mean that we hit the escaped $, so log an error in all other cases */
+		/* the error tells the user that the macro is valid, but value fetching contained error*/
+		if (strcmp(macro_name, "")) {
+			log_debug_info(DEBUGL_MACROS, 2, " Warning: Error grabbing macro '%s' value '%s'! Maybe used in the wrong scope? Check the docs.\n", macro_name, selected_macro ? selected_macro : "");
+#ifdef NSCORE
+			if (keep_unknown_macros == FALSE) {
+				logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Error grabbing macro '%s' value '%s'! Maybe used in the wrong scope? Check the docs.\n", macro_name, selected_macro ? selected_macro : "");
+			}
+#endif
+		}
+
+		if (free_macro == TRUE)
+			my_free(selected_macro);
+	}
+
+	/* we already have a macro... */
+	if (result == OK)
+		; /* do nothing special if things worked out ok */
+
+	/* an escaped $ is done by specifying two $$ next to each other */
+	else if (!strcmp(macro_name, "")) {
+
+		log_debug_info(DEBUGL_MACROS, 2, "  Escaped $.  Running output (%lu): '%s'\n", (unsigned long)mb->length, mb->buffer);
+
+		add_to_macro_buffer(mb, "$", 1);
+	}
+
+	/* a non-macro, just some user-defined string between two $s */
+	else {
+
+		log_debug_info(DEBUGL_MACROS, 2, "  Non-macro.  Running output (%lu): '%s'\n", (unsigned long)mb->length, mb->buffer);
+
+#ifdef NSCORE
+		if (keep_unknown_macros == TRUE) {
+#endif
+			/* add the plain text to the end of the already processed buffer */
+			add_to_macro_buffer(mb, "$", 1);
+			add_to_macro_buffer(mb, macro_name, strlen(macro_name));
+			if (terminated == TRUE)
+				add_to_macro_buffer(mb, "$", 1);
+#ifdef NSCORE
+		} else {
+			/* do not process unknown macros */
+			logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Skipping unknown macro '$%s$', removing it from output! Fix your config, or set keep_unknown_macros accordingly...\n", macro_name);
+		}
+#endif
+	}
+
+	/* insert macro */
+	if (selected_macro != NULL) {
+
+		log_debug_info(DEBUGL_MACROS, 2, "  Processed '%s', Clean Options: %d, Free: %d\n", macro_name, clean_options, free_macro);
+
+		/* include any cleaning options passed back to us */
+		macro_options = (options | clean_options);
+
+		log_debug_info(DEBUGL_MACROS, 2, "  Cleaning options: global=%d, local=%d, effective=%d\n", options, clean_options, macro_options);
+
+		/* URL encode the macro if requested - this allocates new memory */
+		if (macro_options & URL_ENCODE_MACRO_CHARS) {
+			original_macro = selected_macro;
+			selected_macro = get_url_encoded_string(selected_macro);
+			if (free_macro == TRUE) {
+				my_free(original_macro);
+			}
+			free_macro = TRUE;
+		}
+
+		/* some macros are cleaned... */
+		if ((macro_options & STRIP_ILLEGAL_MACRO_CHARS) || (macro_options & ESCAPE_MACRO_CHARS)) {
+
+			/* add the (cleaned) processed macro to the end of the already processed buffer */
+			if (selected_macro != NULL && (cleaned_macro = clean_macro_chars(selected_macro, macro_options)) != NULL) {
+				add_to_macro_buffer(mb, cleaned_macro, strlen(cleaned_macro));
+
+				log_debug_info(DEBUGL_MACROS, 2, "  Cleaned macro.  Running output (%lu): '%s'\n", (unsigned long)mb->length, mb->buffer);
+			}
+		}
+
+		/* others are not cleaned */
+		else {
+			/* add the processed macro to the end of the already processed buffer */
+			if (selected_macro != NULL) {
+				add_to_macro_buffer(mb, selected_macro, strlen(selected_macro));
+
+				log_debug_info(DEBUGL_MACROS, 2, "  Uncleaned macro.  Running output (%lu): '%s'\n", (unsigned long)mb->length, mb->buffer);
+			}
+		}
+
+		/* free memory if necessary (if we URL encoded the macro or we were told to do so by grab_macro_value()) */
+		if (free_macro == TRUE)
+			my_free(selected_macro);
+
+		log_debug_info(DEBUGL_MACROS, 2, "  Just finished macro.  Running output (%lu): '%s'\n", (unsigned long)mb->length, mb->buffer);
+	}
+
+	return;
+}
+
+
+/* grabs the value of a macro by its name and adds it to the output */
+static void process_macro_r(icinga_macros *mac, macro_buffer *mb, char *macro_name, int terminated, int options) {
+	char *selected_macro = NULL;
+	int clean_options = 0;
+	int free_macro = FALSE;
+	int result = OK;
+
+	/* grab the macro value */
+	result = grab_macro_value_r(mac, macro_name, &selected_macro, &clean_options, &free_macro);
+	log_debug_info(DEBUGL_MACROS, 2, "  Processed '%s', Clean Options: %d, Free: %d\n, Value: '%s'", macro_name, clean_options, free_macro, selected_macro ? selected_macro : "");
+
+	add_macro_value(mb, macro_name, terminated, result, selected_macro, clean_options, free_macro, options);
+
+	return;
+}
+
+
 /**
  * replace macros in notification commands with their values,
  * the thread-safe version
  */
 int process_macros_r(icinga_macros *mac, char *input_buffer, char **output_buffer, int options) {
+	macro_buffer mb;
 	char *temp_buffer = NULL;
 	char *save_buffer = NULL;
 	char *buf_ptr = NULL;
 	char *delim_ptr = NULL;
 	int in_macro = FALSE;
-	char *selected_macro = NULL;
-	char *original_macro = NULL;
-	char *cleaned_macro = NULL;
-	int clean_macro = FALSE;
-	int result = OK;
-	int clean_options = 0;
-	int free_macro = FALSE;
-	int macro_options = 0;
 
 
 	log_debug_info(DEBUGL_FUNCTIONS, 0, "process_macros_r()\n");
@@ -145,10 +316,16 @@ int process_macros_r(icinga_macros *mac, char *input_buffer, char **output_buffe
 	if (output_buffer == NULL)
 		return ERROR;
 
-	*output_buffer = (char *)strdup("");
+	if (input_buffer == NULL) {
+		*output_buffer = (char *)strdup("");
+		return ERROR;
+	}
 
-	if (input_buffer == NULL)
+	/* macro values mostly take about as much space as their names */
+	if (init_macro_buffer(&mb, strlen(input_buffer) + 1) == ERROR) {
+		*output_buffer = NULL;
 		return ERROR;
+	}
 
 	in_macro = FALSE;
 
@@ -156,7 +333,7 @@ int process_macros_r(icinga_macros *mac, char *input_buffer, char **output_buffe
 	log_debug_info(DEBUGL_MACROS, 1, "Processing: '%s'\n", input_buffer);
 
 	/* save original input_buffer ptr for later free'ing */
-	save_buffer = buf_ptr = (input_buffer ? strdup(input_buffer) : NULL);
+	save_buffer = buf_ptr = strdup(input_buffer);
 
 	while (buf_ptr) {
 
@@ -174,17 +351,13 @@ int process_macros_r(icinga_macros *mac, char *input_buffer, char **output_buffe
 
 		log_debug_info(DEBUGL_MACROS, 2, "  Processing part: '%s'\n", temp_buffer);
 
-		selected_macro = NULL;
-		clean_macro = FALSE;
-
 		/* we're in plain text... */
 		if (in_macro == FALSE) {
 
 			/* add the plain text to the end of the already processed buffer */
-			*output_buffer = (char *)realloc(*output_buffer, strlen(*output_buffer) + strlen(temp_buffer) + 1);
-			strcat(*output_buffer, temp_buffer);
+			add_to_macro_buffer(&mb, temp_buffer, strlen(temp_buffer));
 
-			log_debug_info(DEBUGL_MACROS, 2, "  Not currently in macro.  Running output (%lu): '%s'\n", (unsigned long)strlen(*output_buffer), *output_buffer);
+			log_debug_info(DEBUGL_MACROS, 2, "  Not currently in macro.  Running output (%lu): '%s'\n", (unsigned long)mb.length, mb.buffer);
 
 			in_macro = TRUE;
 		}
@@ -192,130 +365,214 @@ int process_macros_r(icinga_macros *mac, char *input_buffer, char **output_buffe
 		/* looks like we're in a macro, so process it... */
 		else {
 
-			/* reset clean options */
-			clean_options = 0;
+			process_macro_r(mac, &mb, temp_buffer, (buf_ptr != NULL) ? TRUE : FALSE, options);
 
-			/* grab the macro value */
-			result = grab_macro_value_r(mac, temp_buffer, &selected_macro, &clean_options, &free_macro);
-			log_debug_info(DEBUGL_MACROS, 2, "  Processed '%s', Clean Options: %d, Free: %d\n, Value: '%s'", temp_buffer, clean_options, free_macro, selected_macro ? selected_macro : "");
+			in_macro = FALSE;
+		}
+	}
 
-			/* an error occurred - we couldn't parse the macro, so continue on */
-			if (result == ERROR) {
-				/* empty string still could mean that we hit the escaped $, so log an error in all other cases */
-				/* the error tells the user that the macro is valid, but value fetching contained error*/
-				if(strcmp(temp_buffer, "")) {
-					log_debug_info(DEBUGL_MACROS, 2, " Warning: Error grabbing macro '%s' value '%s'! Maybe used in the wrong scope? Check the docs.\n", temp_buffer, selected_macro ? selected_macro : "" );
-#ifdef NSCORE
-					if (keep_unknown_macros == FALSE) {
-						logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Error grabbing macro '%s' value '%s'! Maybe used in the wrong scope? Check the docs.\n", temp_buffer, selected_macro ? selected_macro : "" );
-					}
-#endif
-				}
+	/* free copy of input buffer */
+	my_free(save_buffer);
 
-				if (free_macro == TRUE)
-					my_free(selected_macro);
-			}
+	*output_buffer = mb.buffer;
 
-			/* we already have a macro... */
-			if (result == OK)
-				; /* do nothing special if things worked out ok */
+	log_debug_info(DEBUGL_MACROS, 1, "  Done.  Final output: '%s'\n", *output_buffer);
+	log_debug_info(DEBUGL_MACROS, 1, "**** END MACRO PROCESSING *************\n");
 
-			/* an escaped $ is done by specifying two $$ next to each other */
-			else if (!strcmp(temp_buffer, "")) {
+	return OK;
+}
 
-				log_debug_info(DEBUGL_MACROS, 2, "  Escaped $.  Running output (%lu): '%s'\n", (unsigned long)strlen(*output_buffer), *output_buffer);
+int process_macros(char *input_buffer, char **output_buffer, int options) {
+	return process_macros_r(&global_macros, input_buffer, output_buffer, options);
+}
 
-				*output_buffer = (char *)realloc(*output_buffer, strlen(*output_buffer) + 2);
-				strcat(*output_buffer, "$");
-			}
 
-			/* a non-macro, just some user-defined string between two $s */
-			else {
+/**
+ * splits a string into literal text and macros the way process_macros_r()
+ * does, resolving $ARGn$, $USERn$ and macro x names to their indexes so
+ * that expanding the string doesn't need to parse it again
+ */
+macro_template *compile_macro_template(char *input_buffer) {
+	macro_template *new_template = NULL;
+	macro_token *token = NULL;
+	const struct macro_key_code *mkey = NULL;
+	char *temp_buffer = NULL;
+	char *buf_ptr = NULL;
+	char *delim_ptr = NULL;
+	int in_macro = FALSE;
+	int x = 0;
 
-				log_debug_info(DEBUGL_MACROS, 2, "  Non-macro.  Running output (%lu): '%s'\n", (unsigned long)strlen(*output_buffer), *output_buffer);
+	if (input_buffer == NULL)
+		return NULL;
 
-#ifdef NSCORE
-				if (keep_unknown_macros == TRUE) {
-#endif
-					/* add the plain text to the end of the already processed buffer */
-					*output_buffer = (char *)realloc(*output_buffer, strlen(*output_buffer) + strlen(temp_buffer) + 3);
-					strcat(*output_buffer, "$");
-					strcat(*output_buffer, temp_buffer);
-					if (buf_ptr != NULL)
-						strcat(*output_buffer, "$");
-#ifdef NSCORE
-				} else {
-					/* do not process unknown macros */
-					logit(NSLOG_RUNTIME_WARNING, TRUE, "Warning: Skipping unknown macro '$%s$', removing it from output! Fix your config, or set keep_unknown_macros accordingly...\n", temp_buffer);
+	if ((new_template = (macro_template *)calloc(1, sizeof(macro_template))) == NULL)
+		return NULL;
+
+	if ((new_template->buffer = strdup(input_buffer)) == NULL) {
+		my_free(new_template);
+		return NULL;
+	}
+
+	/* there's at most one more token than there are delimiters */
+	for (buf_ptr = input_buffer, x = 1; (buf_ptr = strchr(buf_ptr, '$')); buf_ptr++, x++)
+		;
+	if ((new_template->tokens = (macro_token *)calloc(x, sizeof(macro_token))) == NULL) {
+		free_macro_template(new_template);
+		return NULL;
+	}
+
+	for (buf_ptr = new_template->buffer; buf_ptr;) {
+
+		temp_buffer = buf_ptr;
+
+		if ((delim_ptr = strchr(buf_ptr, '$'))) {
+			delim_ptr[0] = '\x0';
+			buf_ptr = (char *)delim_ptr + 1;
+		} else
+			buf_ptr = NULL;
+
+		token = &new_template->tokens[new_template->count];
+		token->text = temp_buffer;
+		token->terminated = (buf_ptr != NULL) ? TRUE : FALSE;
+
+		/* plain text */
+		if (in_macro == FALSE) {
+			in_macro = TRUE;
+			if (temp_buffer[0] == '\x0')
+				continue;
+			token->type = MACRO_TOKEN_TEXT;
+			token->length = strlen(temp_buffer);
+		}
+
+		/* an escaped $ */
+		else if (temp_buffer[0] == '\x0') {
+			in_macro = FALSE;
+			token->type = MACRO_TOKEN_TEXT;
+			token->text = "$";
+			token->length = 1;
+		}
+
+		/* a macro - anything grab_macro_value_r() doesn't take a shortcut for is looked up by name */
+		else {
+			in_macro = FALSE;
+			token->type = MACRO_TOKEN_OTHER;
+
+			if (strstr(temp_buffer, "ARG") == temp_buffer) {
+				x = atoi(temp_buffer + 3);
+				if (x > 0 && x <= MAX_COMMAND_ARGUMENTS) {
+					token->type = MACRO_TOKEN_ARGV;
+					token->index = x - 1;
 				}
-#endif
+			} else if (strstr(temp_buffer, "USER") == temp_buffer) {
+				x = atoi(temp_buffer + 4);
+				if (x > 0 && x <= MAX_USER_MACROS) {
+					token->type = MACRO_TOKEN_USER;
+					token->index = x - 1;
+				}
+			} else if (strchr(temp_buffer, ':') == NULL && (mkey = find_macro_key(temp_buffer))) {
+				token->type = MACRO_TOKEN_MACROX;
+				token->index = mkey->code;
+				token->clean_options = mkey->clean_options;
 			}
+		}
 
-			/* insert macro */
-			if (selected_macro != NULL) {
+		new_template->count++;
+	}
 
-				log_debug_info(DEBUGL_MACROS, 2, "  Processed '%s', Clean Options: %d, Free: %d\n", temp_buffer, clean_options, free_macro);
+	return new_template;
+}
 
-				/* include any cleaning options passed back to us */
-				macro_options = (options | clean_options);
 
-				log_debug_info(DEBUGL_MACROS, 2, "  Cleaning options: global=%d, local=%d, effective=%d\n", options, clean_options, macro_options);
+/**
+ * replace macros in a pre-compiled string with their values, the output
+ * is the same process_macros_r() returns for the original string
+ */
+int process_macro_template_r(icinga_macros *mac, macro_template *template, char **output_buffer, int options) {
+	macro_buffer mb;
+	macro_token *token = NULL;
+	char *selected_macro = NULL;
+	int free_macro = FALSE;
+	int result = OK;
+	int x = 0;
 
-				/* URL encode the macro if requested - this allocates new memory */
-				if (macro_options & URL_ENCODE_MACRO_CHARS) {
-					original_macro = selected_macro;
-					selected_macro = get_url_encoded_string(selected_macro);
-					if (free_macro == TRUE) {
-						my_free(original_macro);
-					}
-					free_macro = TRUE;
-				}
+	log_debug_info(DEBUGL_FUNCTIONS, 0, "process_macro_template_r()\n");
 
-				/* some macros are cleaned... */
-				if (clean_macro == TRUE || ((macro_options & STRIP_ILLEGAL_MACRO_CHARS) || (macro_options & ESCAPE_MACRO_CHARS))) {
+	if (output_buffer == NULL)
+		return ERROR;
+
+	if (template == NULL) {
+		*output_buffer = (char *)strdup("");
+		return ERROR;
+	}
 
-					/* add the (cleaned) processed macro to the end of the already processed buffer */
-					if (selected_macro != NULL && (cleaned_macro = clean_macro_chars(selected_macro, macro_options)) != NULL) {
-						*output_buffer = (char *)realloc(*output_buffer, strlen(*output_buffer) + strlen(cleaned_macro) + 1);
-						strcat(*output_buffer, cleaned_macro);
+	if (init_macro_buffer(&mb, (template->expanded_size > 0) ? template->expanded_size : strlen(template->buffer) + 1) == ERROR) {
+		*output_buffer = NULL;
+		return ERROR;
+	}
 
-						log_debug_info(DEBUGL_MACROS, 2, "  Cleaned macro.  Running output (%lu): '%s'\n", (unsigned long)strlen(*output_buffer), *output_buffer);
-					}
-				}
+	log_debug_info(DEBUGL_MACROS, 1, "**** BEGIN MACRO TEMPLATE PROCESSING ***********\n");
 
-				/* others are not cleaned */
-				else {
-					/* add the processed macro to the end of the already processed buffer */
-					if (selected_macro != NULL) {
-						*output_buffer = (char *)realloc(*output_buffer, strlen(*output_buffer) + strlen(selected_macro) + 1);
-						strcat(*output_buffer, selected_macro);
+	for (x = 0; x < template->count; x++) {
 
-						log_debug_info(DEBUGL_MACROS, 2, "  Uncleaned macro.  Running output (%lu): '%s'\n", (unsigned long)strlen(*output_buffer), *output_buffer);
-					}
-				}
+		token = &template->tokens[x];
+		selected_macro = NULL;
 
-				/* free memory if necessary (if we URL encoded the macro or we were told to do so by grab_macro_value()) */
-				if (free_macro == TRUE)
-					my_free(selected_macro);
+		switch (token->type) {
 
-				log_debug_info(DEBUGL_MACROS, 2, "  Just finished macro.  Running output (%lu): '%s'\n", (unsigned long)strlen(*output_buffer), *output_buffer);
+		case MACRO_TOKEN_TEXT:
+			add_to_macro_buffer(&mb, token->text, token->length);
+			break;
+
+		case MACRO_TOKEN_ARGV:
+			add_macro_value(&mb, token->text, token->terminated, OK, mac->argv[token->index], 0, FALSE, options);
+			break;
+
+		case MACRO_TOKEN_USER:
+			add_macro_value(&mb, token->text, token->terminated, OK, macro_user[token->index], 0, FALSE, options);
+			break;
+
+		case MACRO_TOKEN_MACROX:
+			/* same shortcut as in grab_macro_value_r() */
+			if (mac->host_ptr && token->index == MACRO_HOSTADDRESS)
+				add_macro_value(&mb, token->text, token->terminated, OK, mac->host_ptr->address, 0, FALSE, options);
+			else if (mac->host_ptr && token->index == MACRO_HOSTADDRESS6)
+				add_macro_value(&mb, token->text, token->terminated, OK, mac->host_ptr->address6, 0, FALSE, options);
+			else {
+				result = grab_macrox_value_r(mac, token->index, NULL, NULL, &selected_macro, &free_macro);
+				add_macro_value(&mb, token->text, token->terminated, result, selected_macro, token->clean_options, free_macro, options);
 			}
+			break;
 
-			in_macro = FALSE;
+		default:
+			process_macro_r(mac, &mb, token->text, token->terminated, options);
+			break;
 		}
 	}
 
-	/* free copy of input buffer */
-	my_free(save_buffer);
+	/* remember how large the output got, so the next one fits right away */
+	if (mb.length + 1 > template->expanded_size)
+		template->expanded_size = mb.length + 1;
+
+	*output_buffer = mb.buffer;
 
 	log_debug_info(DEBUGL_MACROS, 1, "  Done.  Final output: '%s'\n", *output_buffer);
-	log_debug_info(DEBUGL_MACROS, 1, "**** END MACRO PROCESSING *************\n");
+	log_debug_info(DEBUGL_MACROS, 1, "**** END MACRO TEMPLATE PROCESSING *************\n");
 
 	return OK;
 }
 
-int process_macros(char *input_buffer, char **output_buffer, int options) {
-	return process_macros_r(&global_macros, input_buffer, output_buffer, options);
+
+/* frees a pre-compiled string */
+void free_macro_template(macro_template *template) {
+
+	if (template == NULL)
+		return;
+
+	my_free(template->tokens);
+	my_free(template->buffer);
+	my_free(template);
+
+	return;
 }
 
 
@@ -3355,6 +3612,182 @@ int clear_summary_macros(void) {
 
 #ifdef NSCORE
 
+/* a block of environment macros being built - only the required space is counted while envp is NULL */
+typedef struct macro_environment_struct {
+	char **envp;
+	char *buf;
+	int count;
+	size_t size;
+} macro_environment;
+
+
+/**
+ * checks whether a macro may be exported to the environment (the name is split in two to save building it)
+ */
+static int is_environment_macro_allowed(char *prefix, char *name) {
+	char *ptr = NULL;
+	size_t prefix_len = 0;
+	size_t name_len = 0;
+	size_t len = 0;
+
+	/* all macros are exported unless they're limited to a list */
+	if (environment_macros == NULL)
+		return TRUE;
+
+	if (name == NULL)
+		return FALSE;
+
+	prefix_len = strlen(prefix);
+	name_len = strlen(name);
+
+	for (ptr = environment_macros; *ptr != '\x0'; ptr += len) {
+		ptr += strspn(ptr, ", \t");
+		len = strcspn(ptr, ", \t");
+		if (len == prefix_len + name_len && !strncmp(ptr, prefix, prefix_len) && !strncmp(ptr + prefix_len, name, name_len))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+
+/**
+ * checks whether a standard macro is exported to the environment
+ */
+static int is_environment_macrox_exported(int macro_type) {
+
+	if (use_large_installation_tweaks == TRUE) {
+
+		/* skip summary macro generation if large installation tweaks are enabled */
+		if (macro_type >= MACRO_TOTALHOSTSUP && macro_type <= MACRO_TOTALSERVICEPROBLEMSUNHANDLED)
+			return FALSE;
+
+		/* skip groupmembers macro generation, see set_macrox_environment_vars_r() */
+		if (macro_type == MACRO_HOSTGROUPMEMBERS || macro_type == MACRO_SERVICEGROUPMEMBERS)
+			return FALSE;
+	}
+
+	return is_environment_macro_allowed("", macro_x_names[macro_type]);
+}
+
+
+/**
+ * adds a variable to a block of environment macros
+ */
+static void add_macro_environment_var(macro_environment *env, char *prefix, char *name, char *value, int strip) {
+	char *ptr = NULL;
+
+	if (name == NULL)
+		return;
+
+	if (value == NULL)
+		value = "";
+
+	/* the first pass only counts the space needed */
+	if (env->envp == NULL) {
+		env->size += strlen(MACRO_ENV_VAR_PREFIX) + strlen(prefix) + strlen(name) + strlen(value) + 2;
+		env->count++;
+		return;
+	}
+
+	env->envp[env->count++] = env->buf;
+	env->buf += sprintf(env->buf, "%s%s%s=", MACRO_ENV_VAR_PREFIX, prefix, name);
+
+	/* custom variables haven't been cleaned yet */
+	for (ptr = value; *ptr != '\x0'; ptr++) {
+		if (strip == FALSE || !illegal_output_char_map[*ptr & 0xff])
+			*(env->buf++) = *ptr;
+	}
+	*(env->buf++) = '\x0';
+
+	return;
+}
+
+
+/**
+ * adds all macros that are exported to the environment to a block of environment macros
+ */
+static void add_macro_environment_vars(macro_environment *env, icinga_macros *mac) {
+	customvariablesmember *temp_customvariablesmember = NULL;
+	char name[32];
+	register int x = 0;
+
+	for (x = 0; x < MACRO_X_COUNT; x++) {
+		if (is_environment_macrox_exported(x) == TRUE)
+			add_macro_environment_var(env, "", macro_x_names[x], mac->x[x], FALSE);
+	}
+
+	for (x = 0; x < MAX_COMMAND_ARGUMENTS; x++) {
+		snprintf(name, sizeof(name), "ARG%d", x + 1);
+		if (is_environment_macro_allowed("", name) == TRUE)
+			add_macro_environment_var(env, "", name, mac->argv[x], FALSE);
+	}
+
+	if (mac->host_ptr != NULL) {
+		for (temp_customvariablesmember = mac->host_ptr->custom_variables; temp_customvariablesmember != NULL; temp_customvariablesmember = temp_customvariablesmember->next) {
+			if (is_environment_macro_allowed("_HOST", temp_customvariablesmember->variable_name) == TRUE)
+				add_macro_environment_var(env, "_HOST", temp_customvariablesmember->variable_name, temp_customvariablesmember->variable_value, TRUE);
+		}
+	}
+
+	if (mac->service_ptr != NULL) {
+		for (temp_customvariablesmember = mac->service_ptr->custom_variables; temp_customvariablesmember != NULL; temp_customvariablesmember = temp_customvariablesmember->next) {
+			if (is_environment_macro_allowed("_SERVICE", temp_customvariablesmember->variable_name) == TRUE)
+				add_macro_environment_var(env, "_SERVICE", temp_customvariablesmember->variable_name, temp_customvariablesmember->variable_value, TRUE);
+		}
+	}
+
+	if (mac->contact_ptr != NULL) {
+		for (temp_customvariablesmember = mac->contact_ptr->custom_variables; temp_customvariablesmember != NULL; temp_customvariablesmember = temp_customvariablesmember->next) {
+			if (is_environment_macro_allowed("_CONTACT", temp_customvariablesmember->variable_name) == TRUE)
+				add_macro_environment_var(env, "_CONTACT", temp_customvariablesmember->variable_name, temp_customvariablesmember->variable_value, TRUE);
+		}
+
+		for (x = 0; x < MAX_CONTACT_ADDRESSES; x++) {
+			snprintf(name, sizeof(name), "CONTACTADDRESS%d", x);
+			if (is_environment_macro_allowed("", name) == TRUE)
+				add_macro_environment_var(env, "", name, mac->contact_ptr->address[x], FALSE);
+		}
+	}
+
+	return;
+}
+
+
+/**
+ * returns the macros that are exported to the environment as a NULL terminated
+ * array of "ICINGA_<macro>=<value>" strings, which is freed with a single free()
+ */
+char **get_macro_environment_r(icinga_macros *mac) {
+	macro_environment env = { NULL, NULL, 0, 0 };
+	int free_macro = FALSE;
+	register int x = 0;
+
+	if (enable_environment_macros == FALSE)
+		return NULL;
+
+	/* generate the values of the standard macros first, so both passes see the same ones */
+	/* THIS IS EXPENSIVE - so only do it for the macros that are actually exported */
+	for (x = 0; x < MACRO_X_COUNT; x++) {
+		if (mac->x[x] == NULL && is_environment_macrox_exported(x) == TRUE)
+			grab_macrox_value_r(mac, x, NULL, NULL, &mac->x[x], &free_macro);
+	}
+
+	/* count the variables and their size, then copy them into one block */
+	add_macro_environment_vars(&env, mac);
+
+	if ((env.envp = (char **)malloc((sizeof(char *) * (env.count + 1)) + env.size)) == NULL)
+		return NULL;
+	env.buf = (char *)(env.envp + env.count + 1);
+	env.count = 0;
+
+	add_macro_environment_vars(&env, mac);
+	env.envp[env.count] = NULL;
+
+	return env.envp;
+}
+
+
 /**
  * sets or unsets all macro environment variables
  */
@@ -3404,6 +3837,10 @@ int set_macrox_environment_vars_r(icinga_macros *mac, int set) {
 				continue;
 		}
 
+		/* skip macros that aren't exported */
+		if (is_environment_macro_allowed("", macro_x_names[x]) == FALSE)
+			continue;
+
 		/* generate the macro value if it hasn't already been done */
 		/* THIS IS EXPENSIVE */
 		if (set == TRUE) {
@@ -3538,6 +3975,10 @@ int set_macro_environment_var(char *name, char *value, int set) {
 	if (name == NULL)
 		return ERROR;
 
+	/* skip macros that aren't exported */
+	if (is_environment_macro_allowed("", name) == FALSE)
+		return OK;
+
 	/* create environment var name */
 	asprintf(&env_macro_name, "%s%s", MACRO_ENV_VAR_PREFIX, name);
 
@@ -66,6 +66,36 @@ module		*module_list = NULL, *module_list_tail = NULL;
 skiplist *object_skiplists[NUM_OBJECT_SKIPLISTS];
 static int object_skiplists_valid = 0;
 
+/*
+ * open addressing hash index for objects with a unique name, used by
+ * the find_*() functions. slots are probed linearly, the skiplist compare
+ * functions confirm a match. the skiplists remain the authoritative
+ * (and sorted) store; lookups fall back to them if the index is unusable.
+ */
+typedef struct object_hash_slot_struct {
+	unsigned long hash;
+	void *data;
+} object_hash_slot;
+
+typedef struct object_hash_struct {
+	object_hash_slot *slots;
+	unsigned long size;                             /* always a power of two */
+	unsigned long items;
+	int disabled;
+} object_hash;
+
+static object_hash object_hashes[NUM_OBJECT_SKIPLISTS];
+
+/* host address index for passive results submitted by address instead of name */
+typedef struct host_address_struct {
+	char *address;
+	host *host_ptr;
+} host_address;
+
+static object_hash host_address_hash;
+
+static void free_host_address_index(void);
+
 
 #ifdef NSCORE
 /* keep this for compatibility */
@@ -107,6 +137,8 @@ int read_object_config_data(char *main_config_file, int options, int cache, int
 /******************************************************************/
 
 int init_object_skiplists(void) {
+	int x = 0;
+
 	if (object_skiplists_valid)
 		free_object_skiplists();
 
@@ -127,6 +159,15 @@ int init_object_skiplists(void) {
 
 	object_skiplists[MODULE_SKIPLIST] = skiplist_new(10, 0.5, FALSE, FALSE, skiplist_compare_module);
 
+	/* escalations and dependencies are looked up by iterating over duplicates, so they don't get a hash index */
+	for (x = 0; x < NUM_OBJECT_SKIPLISTS; x++) {
+		object_hashes[x].slots = NULL;
+		object_hashes[x].size = 0L;
+		object_hashes[x].items = 0L;
+		object_hashes[x].disabled = FALSE;
+	}
+	free_host_address_index();
+
 	object_skiplists_valid = 1;
 
 	return OK;
@@ -137,8 +178,13 @@ int init_object_skiplists(void) {
 int free_object_skiplists(void) {
 	int x = 0;
 
-	for (x = 0; x < NUM_OBJECT_SKIPLISTS; x++)
+	for (x = 0; x < NUM_OBJECT_SKIPLISTS; x++) {
 		skiplist_free(&object_skiplists[x]);
+		my_free(object_hashes[x].slots);
+		object_hashes[x].size = 0L;
+		object_hashes[x].items = 0L;
+	}
+	free_host_address_index();
 
 	object_skiplists_valid = 0;
 
@@ -146,6 +192,168 @@ int free_object_skiplists(void) {
 }
 
 
+
+/******************************************************************/
+/******************** HASH INDEX FUNCTIONS ************************/
+/******************************************************************/
+
+/* computes the hash index key of an object name (or host name/service description pair) */
+unsigned long object_hash_key(const char *name1, const char *name2) {
+	unsigned long hash = 0L;
+
+	if (name1)
+		hash = sdbm(name1);
+
+	if (name2)
+		hash = (hash * 65599) + sdbm(name2);
+
+	return hash;
+}
+
+
+/* puts an object into a hash index slot without growing it */
+static void object_hash_store(object_hash *index, unsigned long hash, void *data) {
+	unsigned long mask = index->size - 1;
+	unsigned long x = 0L;
+
+	for (x = hash & mask; index->slots[x].data != NULL; x = (x + 1) & mask)
+		;
+
+	index->slots[x].hash = hash;
+	index->slots[x].data = data;
+	index->items++;
+}
+
+
+/* adds an object to a hash index, keeping the load factor below 1/2 */
+static int add_object_to_hash(object_hash *index, unsigned long hash, void *data) {
+	object_hash_slot *old_slots = NULL;
+	unsigned long old_size = 0L;
+	unsigned long old_items = 0L;
+	unsigned long x = 0L;
+
+	if (index->disabled == TRUE)
+		return ERROR;
+
+	if ((index->items + 1) * 2 > index->size) {
+
+		old_slots = index->slots;
+		old_size = index->size;
+		old_items = index->items;
+
+		index->size = (old_size == 0L) ? 64L : old_size * 2;
+		index->items = 0L;
+		if ((index->slots = (object_hash_slot *)calloc(index->size, sizeof(object_hash_slot))) == NULL) {
+			/* the index is incomplete, so lookups must not use it anymore */
+			index->slots = old_slots;
+			index->size = old_size;
+			index->items = old_items;
+			index->disabled = TRUE;
+			return ERROR;
+		}
+
+		for (x = 0L; x < old_size; x++) {
+			if (old_slots[x].data != NULL)
+				object_hash_store(index, old_slots[x].hash, old_slots[x].data);
+		}
+		my_free(old_slots);
+	}
+
+	object_hash_store(index, hash, data);
+
+	return OK;
+}
+
+
+/* adds a new object to its skiplist and, if that worked, to its hash index */
+static int insert_named_object(int type, unsigned long hash, void *data) {
+	int result = SKIPLIST_OK;
+
+	result = skiplist_insert(object_skiplists[type], data);
+
+	if (result == SKIPLIST_OK)
+		add_object_to_hash(&object_hashes[type], hash, data);
+
+	return result;
+}
+
+
+/* looks up an object in a hash index - does not modify anything, so it's safe to call from multiple threads */
+static void *find_in_object_hash(object_hash *index, unsigned long hash, void *key, int (*compare_function)(void *, void *)) {
+	unsigned long mask = index->size - 1;
+	unsigned long x = 0L;
+
+	for (x = hash & mask; index->slots[x].data != NULL; x = (x + 1) & mask) {
+		if (index->slots[x].hash == hash && compare_function(index->slots[x].data, key) == 0)
+			return index->slots[x].data;
+	}
+
+	return NULL;
+}
+
+
+/* finds an object with a unique name */
+static void *find_named_object(int type, unsigned long hash, void *key) {
+	object_hash *index = &object_hashes[type];
+
+	if (index->disabled == TRUE || index->slots == NULL)
+		return skiplist_find_first(object_skiplists[type], key, NULL);
+
+	return find_in_object_hash(index, hash, key, object_skiplists[type]->compare_function);
+}
+
+
+/* compares two host address index entries */
+static int compare_host_addresses(void *a, void *b) {
+
+	return strcmp(((host_address *)a)->address, ((host_address *)b)->address);
+}
+
+
+/* frees the host address index */
+static void free_host_address_index(void) {
+	unsigned long x = 0L;
+
+	for (x = 0L; x < host_address_hash.size; x++)
+		my_free(host_address_hash.slots[x].data);
+	my_free(host_address_hash.slots);
+
+	host_address_hash.size = 0L;
+	host_address_hash.items = 0L;
+	host_address_hash.disabled = FALSE;
+}
+
+
+/* adds a host address to the address index, unless an earlier host already uses it */
+static int add_host_address_to_index(char *address, host *hst) {
+	host_address *new_address = NULL;
+	host_address search_address;
+	unsigned long hash = 0L;
+
+	if (address == NULL || host_address_hash.disabled == TRUE)
+		return ERROR;
+
+	hash = object_hash_key(address, NULL);
+	search_address.address = address;
+	if (host_address_hash.slots != NULL && find_in_object_hash(&host_address_hash, hash, &search_address, compare_host_addresses) != NULL)
+		return OK;
+
+	if ((new_address = (host_address *)malloc(sizeof(host_address))) == NULL) {
+		host_address_hash.disabled = TRUE;
+		return ERROR;
+	}
+	new_address->address = address;
+	new_address->host_ptr = hst;
+
+	if (add_object_to_hash(&host_address_hash, hash, new_address) == ERROR) {
+		my_free(new_address);
+		return ERROR;
+	}
+
+	return OK;
+}
+
+
 int skiplist_compare_text(const char *val1a, const char *val1b, const char *val2a, const char *val2b) {
 	int result = 0;
 
@@ -457,7 +665,7 @@ timeperiod *add_timeperiod(char *name, char *alias) {
 
 	/* add new timeperiod to skiplist */
 	if (result == OK) {
-		result = skiplist_insert(object_skiplists[TIMEPERIOD_SKIPLIST], (void *)new_timeperiod);
+		result = insert_named_object(TIMEPERIOD_SKIPLIST, object_hash_key(new_timeperiod->name, NULL), (void *)new_timeperiod);
 		switch (result) {
 		case SKIPLIST_ERROR_DUPLICATE:
 			logit(NSLOG_CONFIG_ERROR, TRUE, "Error: Timeperiod '%s' has already been defined\n", name);
@@ -792,6 +1000,8 @@ host *add_host(char *name, char *display_name, char *alias, char *address, char
 	new_host->last_time_unreachable = (time_t)0;
 	new_host->has_been_checked = FALSE;
 	new_host->is_being_freshened = FALSE;
+	new_host->freshness_queue_index = -1;
+	new_host->running_queue_index = -1;
 	new_host->problem_has_been_acknowledged = FALSE;
 	new_host->acknowledgement_type = ACKNOWLEDGEMENT_NONE;
 	new_host->acknowledgement_end_time = (time_t)0;
@@ -826,7 +1036,7 @@ host *add_host(char *name, char *display_name, char *alias, char *address, char
 
 	/* add new host to skiplist */
 	if (result == OK) {
-		result = skiplist_insert(object_skiplists[HOST_SKIPLIST], (void *)new_host);
+		result = insert_named_object(HOST_SKIPLIST, new_host->name_hash, (void *)new_host);
 		switch (result) {
 		case SKIPLIST_ERROR_DUPLICATE:
 			logit(NSLOG_CONFIG_ERROR, TRUE, "Error: Host '%s' has already been defined\n", name);
@@ -879,6 +1089,10 @@ host *add_host(char *name, char *display_name, char *alias, char *address, char
 		host_list_tail = new_host;
 	}
 
+	/* the first host in the list wins if several share an address */
+	add_host_address_to_index(new_host->address, new_host);
+	add_host_address_to_index(new_host->address6, new_host);
+
 	return new_host;
 }
 
@@ -1058,7 +1272,7 @@ hostgroup *add_hostgroup(char *name, char *alias, char *notes, char *notes_url,
 
 	/* add new host group to skiplist */
 	if (result == OK) {
-		result = skiplist_insert(object_skiplists[HOSTGROUP_SKIPLIST], (void *)new_hostgroup);
+		result = insert_named_object(HOSTGROUP_SKIPLIST, object_hash_key(new_hostgroup->group_name, NULL), (void *)new_hostgroup);
 		switch (result) {
 		case SKIPLIST_ERROR_DUPLICATE:
 			logit(NSLOG_CONFIG_ERROR, TRUE, "Error: Hostgroup '%s' has already been defined\n", name);
@@ -1180,7 +1394,7 @@ servicegroup *add_servicegroup(char *name, char *alias, char *notes, char *notes
 
 	/* add new service group to skiplist */
 	if (result == OK) {
-		result = skiplist_insert(object_skiplists[SERVICEGROUP_SKIPLIST], (void *)new_servicegroup);
+		result = insert_named_object(SERVICEGROUP_SKIPLIST, object_hash_key(new_servicegroup->group_name, NULL), (void *)new_servicegroup);
 		switch (result) {
 		case SKIPLIST_ERROR_DUPLICATE:
 			logit(NSLOG_CONFIG_ERROR, TRUE, "Error: Servicegroup '%s' has already been defined\n", name);
@@ -1366,7 +1580,7 @@ contact *add_contact(char *name, char *alias, char *email, char *pager, char **a
 
 	/* add new contact to skiplist */
 	if (result == OK) {
-		result = skiplist_insert(object_skiplists[CONTACT_SKIPLIST], (void *)new_contact);
+		result = insert_named_object(CONTACT_SKIPLIST, object_hash_key(new_contact->name, NULL), (void *)new_contact);
 		switch (result) {
 		case SKIPLIST_ERROR_DUPLICATE:
 			logit(NSLOG_CONFIG_ERROR, TRUE, "Error: Contact '%s' has already been defined\n", name);
@@ -1501,7 +1715,7 @@ contactgroup *add_contactgroup(char *name, char *alias) {
 
 	/* add new contact group to skiplist */
 	if (result == OK) {
-		result = skiplist_insert(object_skiplists[CONTACTGROUP_SKIPLIST], (void *)new_contactgroup);
+		result = insert_named_object(CONTACTGROUP_SKIPLIST, object_hash_key(new_contactgroup->group_name, NULL), (void *)new_contactgroup);
 		switch (result) {
 		case SKIPLIST_ERROR_DUPLICATE:
 			logit(NSLOG_CONFIG_ERROR, TRUE, "Error: Contactgroup '%s' has already been defined\n", name);
@@ -1715,6 +1929,8 @@ service *add_service(char *host_name, char *description, char *display_name, cha
 	new_service->last_time_critical = (time_t)0;
 	new_service->has_been_checked = FALSE;
 	new_service->is_being_freshened = FALSE;
+	new_service->freshness_queue_index = -1;
+	new_service->running_queue_index = -1;
 	new_service->notified_on_unknown = FALSE;
 	new_service->notified_on_warning = FALSE;
 	new_service->notified_on_critical = FALSE;
@@ -1743,7 +1959,7 @@ service *add_service(char *host_name, char *description, char *display_name, cha
 
 	/* add new service to skiplist */
 	if (result == OK) {
-		result = skiplist_insert(object_skiplists[SERVICE_SKIPLIST], (void *)new_service);
+		result = insert_named_object(SERVICE_SKIPLIST, object_hash_key(new_service->host_name, new_service->description), (void *)new_service);
 		switch (result) {
 		case SKIPLIST_ERROR_DUPLICATE:
 			logit(NSLOG_CONFIG_ERROR, TRUE, "Error: Service '%s' on host '%s' has already been defined\n", description, host_name);
@@ -1860,7 +2076,7 @@ command *add_command(char *name, char *value) {
 
 	/* add new command to skiplist */
 	if (result == OK) {
-		result = skiplist_insert(object_skiplists[COMMAND_SKIPLIST], (void *)new_command);
+		result = insert_named_object(COMMAND_SKIPLIST, object_hash_key(new_command->name, NULL), (void *)new_command);
 		switch (result) {
 		case SKIPLIST_ERROR_DUPLICATE:
 			logit(NSLOG_CONFIG_ERROR, TRUE, "Error: Command '%s' has already been defined\n", name);
@@ -2489,7 +2705,7 @@ module *add_module(char *name, char *type, char *path, char *args) {
 
 	/* add new command to skiplist */
 	if (result == OK) {
-		result = skiplist_insert(object_skiplists[MODULE_SKIPLIST], (void *)new_module);
+		result = insert_named_object(MODULE_SKIPLIST, object_hash_key(new_module->name, NULL), (void *)new_module);
 		switch (result) {
 		case SKIPLIST_ERROR_DUPLICATE:
 			logit(NSLOG_CONFIG_ERROR, TRUE, "Error: Module '%s' has already been defined\n", name);
@@ -2560,7 +2776,7 @@ timeperiod * find_timeperiod(char *name) {
 
 	temp_timeperiod.name = name;
 
-	return skiplist_find_first(object_skiplists[TIMEPERIOD_SKIPLIST], &temp_timeperiod, NULL);
+	return find_named_object(TIMEPERIOD_SKIPLIST, object_hash_key(name, NULL), &temp_timeperiod);
 }
 
 
@@ -2573,7 +2789,33 @@ host * find_host(char *name) {
 
 	temp_host.name = name;
 
-	return skiplist_find_first(object_skiplists[HOST_SKIPLIST], &temp_host, NULL);
+	return find_named_object(HOST_SKIPLIST, object_hash_key(name, NULL), &temp_host);
+}
+
+
+/* given an IPv4 or IPv6 address, find the first host using it */
+host * find_host_by_address(char *address) {
+	host_address search_address;
+	host_address *temp_address = NULL;
+	host *temp_host = NULL;
+
+	if (address == NULL)
+		return NULL;
+
+	/* fall back to a linear search if we couldn't build the index */
+	if (host_address_hash.disabled == TRUE || host_address_hash.slots == NULL) {
+		for (temp_host = host_list; temp_host != NULL; temp_host = temp_host->next) {
+			if (!strcmp(address, temp_host->address) || !strcmp(address, temp_host->address6))
+				return temp_host;
+		}
+		return NULL;
+	}
+
+	search_address.address = address;
+	if ((temp_address = (host_address *)find_in_object_hash(&host_address_hash, object_hash_key(address, NULL), &search_address, compare_host_addresses)) == NULL)
+		return NULL;
+
+	return temp_address->host_ptr;
 }
 
 
@@ -2586,7 +2828,7 @@ hostgroup * find_hostgroup(char *name) {
 
 	temp_hostgroup.group_name = name;
 
-	return skiplist_find_first(object_skiplists[HOSTGROUP_SKIPLIST], &temp_hostgroup, NULL);
+	return find_named_object(HOSTGROUP_SKIPLIST, object_hash_key(name, NULL), &temp_hostgroup);
 }
 
 
@@ -2599,7 +2841,7 @@ servicegroup * find_servicegroup(char *name) {
 
 	temp_servicegroup.group_name = name;
 
-	return skiplist_find_first(object_skiplists[SERVICEGROUP_SKIPLIST], &temp_servicegroup, NULL);
+	return find_named_object(SERVICEGROUP_SKIPLIST, object_hash_key(name, NULL), &temp_servicegroup);
 }
 
 
@@ -2612,7 +2854,7 @@ contact * find_contact(char *name) {
 
 	temp_contact.name = name;
 
-	return skiplist_find_first(object_skiplists[CONTACT_SKIPLIST], &temp_contact, NULL);
+	return find_named_object(CONTACT_SKIPLIST, object_hash_key(name, NULL), &temp_contact);
 }
 
 
@@ -2625,7 +2867,7 @@ contactgroup * find_contactgroup(char *name) {
 
 	temp_contactgroup.group_name = name;
 
-	return skiplist_find_first(object_skiplists[CONTACTGROUP_SKIPLIST], &temp_contactgroup, NULL);
+	return find_named_object(CONTACTGROUP_SKIPLIST, object_hash_key(name, NULL), &temp_contactgroup);
 }
 
 
@@ -2638,7 +2880,7 @@ command * find_command(char *name) {
 
 	temp_command.name = name;
 
-	return skiplist_find_first(object_skiplists[COMMAND_SKIPLIST], &temp_command, NULL);
+	return find_named_object(COMMAND_SKIPLIST, object_hash_key(name, NULL), &temp_command);
 }
 
 
@@ -2652,7 +2894,7 @@ service * find_service(char *host_name, char *svc_desc) {
 	temp_service.host_name = host_name;
 	temp_service.description = svc_desc;
 
-	return skiplist_find_first(object_skiplists[SERVICE_SKIPLIST], &temp_service, NULL);
+	return find_named_object(SERVICE_SKIPLIST, object_hash_key(host_name, svc_desc), &temp_service);
 }
 
 
@@ -2665,7 +2907,7 @@ module * find_module(char *name) {
 
 	temp_module.name = name;
 
-	return skiplist_find_first(object_skiplists[MODULE_SKIPLIST], &temp_module, NULL);
+	return find_named_object(MODULE_SKIPLIST, object_hash_key(name, NULL), &temp_module);
 }
 
 
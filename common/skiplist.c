@@ -360,6 +360,39 @@ void *skiplist_find_first(skiplist *list, void *data, void **node_ptr) {
 
 
 
+/* find last item in list that is less than or equal to data */
+void *skiplist_find_floor(skiplist *list, void *data, void **node_ptr) {
+	skiplistnode *thisnode = NULL;
+	skiplistnode *nextnode = NULL;
+	int level = 0;
+
+	if (list == NULL || data == NULL)
+		return NULL;
+
+	thisnode = list->head;
+	for (level = list->current_level; level >= 0; level--) {
+		while ((nextnode = thisnode->forward[level])) {
+			if (list->compare_function(nextnode->data, data) > 0)
+				break;
+			thisnode = nextnode;
+		}
+	}
+
+	/* every item in the list is greater than data */
+	if (thisnode == list->head) {
+		if (node_ptr)
+			*node_ptr = NULL;
+		return NULL;
+	}
+
+	if (node_ptr)
+		*node_ptr = (void *)thisnode;
+
+	return thisnode->data;
+}
+
+
+
 /* find next match */
 void *skiplist_find_next(skiplist *list, void *data, void **node_ptr) {
 	skiplistnode *thisnode = NULL;
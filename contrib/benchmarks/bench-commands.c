@@ -0,0 +1,465 @@
+/*****************************************************************************
+ *
+ * BENCH-COMMANDS.C - Benchmark of external command name lookups
+ *
+ * Copyright (c) 2009-2015 Icinga Development Team (http://www.icinga.org)
+ *
+ * License:
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *****************************************************************************/
+
+/*
+ * Looks up the names of external commands (10M by default) in a mix like
+ * the one a busy command pipe sees: mostly passive service check results,
+ * some host check results and a few acknowledgements, comments, downtimes,
+ * rescheduled checks and custom commands.  process_external_command1() used
+ * to compare the name against every command in turn, which is done here on
+ * a copy of the command list in the order of the old comparisons.  That is
+ * timed against get_external_command_type(), which searches the sorted
+ * command table.  Every command must map to the same type and author
+ * argument both ways.
+ *
+ * usage: bench-commands [<lookups>]
+ */
+
+#include "../../include/config.h"
+#include "../../include/common.h"
+#include "../../include/icinga.h"
+
+#include <sys/time.h>
+
+struct bench_command {
+	char *name;
+	int command_type;
+	int author_position;
+};
+
+/* the commands in the order process_external_command1() used to compare them */
+static struct bench_command bench_commands[] = {
+	{ "ENTER_STANDBY_MODE", CMD_DISABLE_NOTIFICATIONS, 0 },
+	{ "DISABLE_NOTIFICATIONS", CMD_DISABLE_NOTIFICATIONS, 0 },
+	{ "ENTER_ACTIVE_MODE", CMD_ENABLE_NOTIFICATIONS, 0 },
+	{ "ENABLE_NOTIFICATIONS", CMD_ENABLE_NOTIFICATIONS, 0 },
+	{ "DISABLE_NOTIFICATIONS_EXPIRE_TIME", CMD_DISABLE_NOTIFICATIONS_EXPIRE_TIME, 0 },
+
+	{ "SHUTDOWN_PROGRAM", CMD_SHUTDOWN_PROCESS, 0 },
+	{ "SHUTDOWN_PROCESS", CMD_SHUTDOWN_PROCESS, 0 },
+	{ "RESTART_PROGRAM", CMD_RESTART_PROCESS, 0 },
+	{ "RESTART_PROCESS", CMD_RESTART_PROCESS, 0 },
+
+	{ "SAVE_STATE_INFORMATION", CMD_SAVE_STATE_INFORMATION, 0 },
+	{ "READ_STATE_INFORMATION", CMD_READ_STATE_INFORMATION, 0 },
+	{ "SYNC_STATE_INFORMATION", CMD_SYNC_STATE_INFORMATION, 0 },
+
+	{ "ENABLE_EVENT_HANDLERS", CMD_ENABLE_EVENT_HANDLERS, 0 },
+	{ "DISABLE_EVENT_HANDLERS", CMD_DISABLE_EVENT_HANDLERS, 0 },
+
+	{ "FLUSH_PENDING_COMMANDS", CMD_FLUSH_PENDING_COMMANDS, 0 },
+
+	{ "ENABLE_FAILURE_PREDICTION", CMD_ENABLE_FAILURE_PREDICTION, 0 },
+	{ "DISABLE_FAILURE_PREDICTION", CMD_DISABLE_FAILURE_PREDICTION, 0 },
+
+	{ "ENABLE_PERFORMANCE_DATA", CMD_ENABLE_PERFORMANCE_DATA, 0 },
+	{ "DISABLE_PERFORMANCE_DATA", CMD_DISABLE_PERFORMANCE_DATA, 0 },
+
+	{ "START_EXECUTING_HOST_CHECKS", CMD_START_EXECUTING_HOST_CHECKS, 0 },
+	{ "STOP_EXECUTING_HOST_CHECKS", CMD_STOP_EXECUTING_HOST_CHECKS, 0 },
+
+	{ "START_EXECUTING_SVC_CHECKS", CMD_START_EXECUTING_SVC_CHECKS, 0 },
+	{ "STOP_EXECUTING_SVC_CHECKS", CMD_STOP_EXECUTING_SVC_CHECKS, 0 },
+
+	{ "START_ACCEPTING_PASSIVE_HOST_CHECKS", CMD_START_ACCEPTING_PASSIVE_HOST_CHECKS, 0 },
+	{ "STOP_ACCEPTING_PASSIVE_HOST_CHECKS", CMD_STOP_ACCEPTING_PASSIVE_HOST_CHECKS, 0 },
+
+	{ "START_ACCEPTING_PASSIVE_SVC_CHECKS", CMD_START_ACCEPTING_PASSIVE_SVC_CHECKS, 0 },
+	{ "STOP_ACCEPTING_PASSIVE_SVC_CHECKS", CMD_STOP_ACCEPTING_PASSIVE_SVC_CHECKS, 0 },
+
+	{ "START_OBSESSING_OVER_HOST_CHECKS", CMD_START_OBSESSING_OVER_HOST_CHECKS, 0 },
+	{ "STOP_OBSESSING_OVER_HOST_CHECKS", CMD_STOP_OBSESSING_OVER_HOST_CHECKS, 0 },
+
+	{ "START_OBSESSING_OVER_SVC_CHECKS", CMD_START_OBSESSING_OVER_SVC_CHECKS, 0 },
+	{ "STOP_OBSESSING_OVER_SVC_CHECKS", CMD_STOP_OBSESSING_OVER_SVC_CHECKS, 0 },
+
+	{ "ENABLE_FLAP_DETECTION", CMD_ENABLE_FLAP_DETECTION, 0 },
+	{ "DISABLE_FLAP_DETECTION", CMD_DISABLE_FLAP_DETECTION, 0 },
+
+	{ "CHANGE_GLOBAL_HOST_EVENT_HANDLER", CMD_CHANGE_GLOBAL_HOST_EVENT_HANDLER, 0 },
+	{ "CHANGE_GLOBAL_SVC_EVENT_HANDLER", CMD_CHANGE_GLOBAL_SVC_EVENT_HANDLER, 0 },
+
+	{ "ENABLE_SERVICE_FRESHNESS_CHECKS", CMD_ENABLE_SERVICE_FRESHNESS_CHECKS, 0 },
+	{ "DISABLE_SERVICE_FRESHNESS_CHECKS", CMD_DISABLE_SERVICE_FRESHNESS_CHECKS, 0 },
+
+	{ "ENABLE_HOST_FRESHNESS_CHECKS", CMD_ENABLE_HOST_FRESHNESS_CHECKS, 0 },
+	{ "DISABLE_HOST_FRESHNESS_CHECKS", CMD_DISABLE_HOST_FRESHNESS_CHECKS, 0 },
+
+	/*******************************/
+	/**** HOST-RELATED COMMANDS ****/
+	/*******************************/
+
+	{ "ADD_HOST_COMMENT", CMD_ADD_HOST_COMMENT, 3 },
+	{ "DEL_HOST_COMMENT", CMD_DEL_HOST_COMMENT, 0 },
+	{ "DEL_ALL_HOST_COMMENTS", CMD_DEL_ALL_HOST_COMMENTS, 0 },
+
+	{ "DELAY_HOST_NOTIFICATION", CMD_DELAY_HOST_NOTIFICATION, 0 },
+
+	{ "ENABLE_HOST_NOTIFICATIONS", CMD_ENABLE_HOST_NOTIFICATIONS, 0 },
+	{ "DISABLE_HOST_NOTIFICATIONS", CMD_DISABLE_HOST_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_ALL_NOTIFICATIONS_BEYOND_HOST", CMD_ENABLE_ALL_NOTIFICATIONS_BEYOND_HOST, 0 },
+	{ "DISABLE_ALL_NOTIFICATIONS_BEYOND_HOST", CMD_DISABLE_ALL_NOTIFICATIONS_BEYOND_HOST, 0 },
+
+	{ "ENABLE_HOST_AND_CHILD_NOTIFICATIONS", CMD_ENABLE_HOST_AND_CHILD_NOTIFICATIONS, 0 },
+	{ "DISABLE_HOST_AND_CHILD_NOTIFICATIONS", CMD_DISABLE_HOST_AND_CHILD_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_HOST_SVC_NOTIFICATIONS", CMD_ENABLE_HOST_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_HOST_SVC_NOTIFICATIONS", CMD_DISABLE_HOST_SVC_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_HOST_SVC_CHECKS", CMD_ENABLE_HOST_SVC_CHECKS, 0 },
+	{ "DISABLE_HOST_SVC_CHECKS", CMD_DISABLE_HOST_SVC_CHECKS, 0 },
+
+	{ "ENABLE_PASSIVE_HOST_CHECKS", CMD_ENABLE_PASSIVE_HOST_CHECKS, 0 },
+	{ "DISABLE_PASSIVE_HOST_CHECKS", CMD_DISABLE_PASSIVE_HOST_CHECKS, 0 },
+
+	{ "SCHEDULE_HOST_SVC_CHECKS", CMD_SCHEDULE_HOST_SVC_CHECKS, 0 },
+	{ "SCHEDULE_FORCED_HOST_SVC_CHECKS", CMD_SCHEDULE_FORCED_HOST_SVC_CHECKS, 0 },
+
+	{ "ACKNOWLEDGE_HOST_PROBLEM", CMD_ACKNOWLEDGE_HOST_PROBLEM, 5 },
+	{ "ACKNOWLEDGE_HOST_PROBLEM_EXPIRE", CMD_ACKNOWLEDGE_HOST_PROBLEM_EXPIRE, 6 },
+	{ "REMOVE_HOST_ACKNOWLEDGEMENT", CMD_REMOVE_HOST_ACKNOWLEDGEMENT, 0 },
+
+	{ "ACKNOWLEDGE_HOST_SVC_PROBLEM", CMD_ACKNOWLEDGE_HOST_SVC_PROBLEM, 0 },
+
+	{ "ENABLE_HOST_EVENT_HANDLER", CMD_ENABLE_HOST_EVENT_HANDLER, 0 },
+	{ "DISABLE_HOST_EVENT_HANDLER", CMD_DISABLE_HOST_EVENT_HANDLER, 0 },
+
+	{ "ENABLE_HOST_CHECK", CMD_ENABLE_HOST_CHECK, 0 },
+	{ "DISABLE_HOST_CHECK", CMD_DISABLE_HOST_CHECK, 0 },
+
+	{ "SCHEDULE_HOST_CHECK", CMD_SCHEDULE_HOST_CHECK, 0 },
+	{ "SCHEDULE_FORCED_HOST_CHECK", CMD_SCHEDULE_FORCED_HOST_CHECK, 0 },
+
+	{ "SCHEDULE_HOST_DOWNTIME", CMD_SCHEDULE_HOST_DOWNTIME, 7 },
+	{ "SCHEDULE_HOST_SVC_DOWNTIME", CMD_SCHEDULE_HOST_SVC_DOWNTIME, 7 },
+	{ "DEL_HOST_DOWNTIME", CMD_DEL_HOST_DOWNTIME, 0 },
+	{ "DEL_DOWNTIME_BY_HOST_NAME", CMD_DEL_DOWNTIME_BY_HOST_NAME, 0 },
+	{ "DEL_DOWNTIME_BY_HOSTGROUP_NAME", CMD_DEL_DOWNTIME_BY_HOSTGROUP_NAME, 0 },
+
+	{ "DEL_DOWNTIME_BY_START_TIME_COMMENT", CMD_DEL_DOWNTIME_BY_START_TIME_COMMENT, 0 },
+
+	{ "ENABLE_HOST_FLAP_DETECTION", CMD_ENABLE_HOST_FLAP_DETECTION, 0 },
+	{ "DISABLE_HOST_FLAP_DETECTION", CMD_DISABLE_HOST_FLAP_DETECTION, 0 },
+
+	{ "START_OBSESSING_OVER_HOST", CMD_START_OBSESSING_OVER_HOST, 0 },
+	{ "STOP_OBSESSING_OVER_HOST", CMD_STOP_OBSESSING_OVER_HOST, 0 },
+
+	{ "CHANGE_HOST_EVENT_HANDLER", CMD_CHANGE_HOST_EVENT_HANDLER, 0 },
+	{ "CHANGE_HOST_CHECK_COMMAND", CMD_CHANGE_HOST_CHECK_COMMAND, 0 },
+
+	{ "CHANGE_NORMAL_HOST_CHECK_INTERVAL", CMD_CHANGE_NORMAL_HOST_CHECK_INTERVAL, 0 },
+	{ "CHANGE_RETRY_HOST_CHECK_INTERVAL", CMD_CHANGE_RETRY_HOST_CHECK_INTERVAL, 0 },
+
+	{ "CHANGE_MAX_HOST_CHECK_ATTEMPTS", CMD_CHANGE_MAX_HOST_CHECK_ATTEMPTS, 0 },
+
+	{ "SCHEDULE_AND_PROPAGATE_TRIGGERED_HOST_DOWNTIME", CMD_SCHEDULE_AND_PROPAGATE_TRIGGERED_HOST_DOWNTIME, 7 },
+
+	{ "SCHEDULE_AND_PROPAGATE_HOST_DOWNTIME", CMD_SCHEDULE_AND_PROPAGATE_HOST_DOWNTIME, 7 },
+
+	{ "SET_HOST_NOTIFICATION_NUMBER", CMD_SET_HOST_NOTIFICATION_NUMBER, 0 },
+
+	{ "CHANGE_HOST_CHECK_TIMEPERIOD", CMD_CHANGE_HOST_CHECK_TIMEPERIOD, 0 },
+
+	{ "CHANGE_CUSTOM_HOST_VAR", CMD_CHANGE_CUSTOM_HOST_VAR, 0 },
+
+	{ "SEND_CUSTOM_HOST_NOTIFICATION", CMD_SEND_CUSTOM_HOST_NOTIFICATION, 3 },
+
+	{ "CHANGE_HOST_NOTIFICATION_TIMEPERIOD", CMD_CHANGE_HOST_NOTIFICATION_TIMEPERIOD, 0 },
+
+	{ "CHANGE_HOST_MODATTR", CMD_CHANGE_HOST_MODATTR, 0 },
+
+	/************************************/
+	/**** HOSTGROUP-RELATED COMMANDS ****/
+	/************************************/
+
+	{ "ENABLE_HOSTGROUP_HOST_NOTIFICATIONS", CMD_ENABLE_HOSTGROUP_HOST_NOTIFICATIONS, 0 },
+	{ "DISABLE_HOSTGROUP_HOST_NOTIFICATIONS", CMD_DISABLE_HOSTGROUP_HOST_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_HOSTGROUP_SVC_NOTIFICATIONS", CMD_ENABLE_HOSTGROUP_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_HOSTGROUP_SVC_NOTIFICATIONS", CMD_DISABLE_HOSTGROUP_SVC_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_HOSTGROUP_HOST_CHECKS", CMD_ENABLE_HOSTGROUP_HOST_CHECKS, 0 },
+	{ "DISABLE_HOSTGROUP_HOST_CHECKS", CMD_DISABLE_HOSTGROUP_HOST_CHECKS, 0 },
+
+	{ "ENABLE_HOSTGROUP_PASSIVE_HOST_CHECKS", CMD_ENABLE_HOSTGROUP_PASSIVE_HOST_CHECKS, 0 },
+	{ "DISABLE_HOSTGROUP_PASSIVE_HOST_CHECKS", CMD_DISABLE_HOSTGROUP_PASSIVE_HOST_CHECKS, 0 },
+
+	{ "ENABLE_HOSTGROUP_SVC_CHECKS", CMD_ENABLE_HOSTGROUP_SVC_CHECKS, 0 },
+	{ "DISABLE_HOSTGROUP_SVC_CHECKS", CMD_DISABLE_HOSTGROUP_SVC_CHECKS, 0 },
+
+	{ "ENABLE_HOSTGROUP_PASSIVE_SVC_CHECKS", CMD_ENABLE_HOSTGROUP_PASSIVE_SVC_CHECKS, 0 },
+	{ "DISABLE_HOSTGROUP_PASSIVE_SVC_CHECKS", CMD_DISABLE_HOSTGROUP_PASSIVE_SVC_CHECKS, 0 },
+
+	{ "SCHEDULE_HOSTGROUP_HOST_DOWNTIME", CMD_SCHEDULE_HOSTGROUP_HOST_DOWNTIME, 7 },
+	{ "SCHEDULE_HOSTGROUP_SVC_DOWNTIME", CMD_SCHEDULE_HOSTGROUP_SVC_DOWNTIME, 7 },
+
+	/**********************************/
+	/**** SERVICE-RELATED COMMANDS ****/
+	/**********************************/
+
+	{ "ADD_SVC_COMMENT", CMD_ADD_SVC_COMMENT, 4 },
+	{ "DEL_SVC_COMMENT", CMD_DEL_SVC_COMMENT, 0 },
+	{ "DEL_ALL_SVC_COMMENTS", CMD_DEL_ALL_SVC_COMMENTS, 0 },
+
+	{ "SCHEDULE_SVC_CHECK", CMD_SCHEDULE_SVC_CHECK, 0 },
+	{ "SCHEDULE_FORCED_SVC_CHECK", CMD_SCHEDULE_FORCED_SVC_CHECK, 0 },
+
+	{ "ENABLE_SVC_CHECK", CMD_ENABLE_SVC_CHECK, 0 },
+	{ "DISABLE_SVC_CHECK", CMD_DISABLE_SVC_CHECK, 0 },
+
+	{ "ENABLE_PASSIVE_SVC_CHECKS", CMD_ENABLE_PASSIVE_SVC_CHECKS, 0 },
+	{ "DISABLE_PASSIVE_SVC_CHECKS", CMD_DISABLE_PASSIVE_SVC_CHECKS, 0 },
+
+	{ "DELAY_SVC_NOTIFICATION", CMD_DELAY_SVC_NOTIFICATION, 0 },
+	{ "ENABLE_SVC_NOTIFICATIONS", CMD_ENABLE_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_SVC_NOTIFICATIONS", CMD_DISABLE_SVC_NOTIFICATIONS, 0 },
+
+	{ "PROCESS_SERVICE_CHECK_RESULT", CMD_PROCESS_SERVICE_CHECK_RESULT, 0 },
+	{ "PROCESS_HOST_CHECK_RESULT", CMD_PROCESS_HOST_CHECK_RESULT, 0 },
+
+	{ "ENABLE_SVC_EVENT_HANDLER", CMD_ENABLE_SVC_EVENT_HANDLER, 0 },
+	{ "DISABLE_SVC_EVENT_HANDLER", CMD_DISABLE_SVC_EVENT_HANDLER, 0 },
+
+	{ "ENABLE_SVC_FLAP_DETECTION", CMD_ENABLE_SVC_FLAP_DETECTION, 0 },
+	{ "DISABLE_SVC_FLAP_DETECTION", CMD_DISABLE_SVC_FLAP_DETECTION, 0 },
+
+	{ "SCHEDULE_SVC_DOWNTIME", CMD_SCHEDULE_SVC_DOWNTIME, 8 },
+	{ "DEL_SVC_DOWNTIME", CMD_DEL_SVC_DOWNTIME, 0 },
+	{ "ACKNOWLEDGE_SVC_PROBLEM", CMD_ACKNOWLEDGE_SVC_PROBLEM, 6 },
+	{ "ACKNOWLEDGE_SVC_PROBLEM_EXPIRE", CMD_ACKNOWLEDGE_SVC_PROBLEM_EXPIRE, 7 },
+	{ "REMOVE_SVC_ACKNOWLEDGEMENT", CMD_REMOVE_SVC_ACKNOWLEDGEMENT, 0 },
+
+	{ "START_OBSESSING_OVER_SVC", CMD_START_OBSESSING_OVER_SVC, 0 },
+	{ "STOP_OBSESSING_OVER_SVC", CMD_STOP_OBSESSING_OVER_SVC, 0 },
+
+	{ "CHANGE_SVC_EVENT_HANDLER", CMD_CHANGE_SVC_EVENT_HANDLER, 0 },
+	{ "CHANGE_SVC_CHECK_COMMAND", CMD_CHANGE_SVC_CHECK_COMMAND, 0 },
+
+	{ "CHANGE_NORMAL_SVC_CHECK_INTERVAL", CMD_CHANGE_NORMAL_SVC_CHECK_INTERVAL, 0 },
+	{ "CHANGE_RETRY_SVC_CHECK_INTERVAL", CMD_CHANGE_RETRY_SVC_CHECK_INTERVAL, 0 },
+
+	{ "CHANGE_MAX_SVC_CHECK_ATTEMPTS", CMD_CHANGE_MAX_SVC_CHECK_ATTEMPTS, 0 },
+
+	{ "SET_SVC_NOTIFICATION_NUMBER", CMD_SET_SVC_NOTIFICATION_NUMBER, 0 },
+
+	{ "CHANGE_SVC_CHECK_TIMEPERIOD", CMD_CHANGE_SVC_CHECK_TIMEPERIOD, 0 },
+
+	{ "CHANGE_CUSTOM_SVC_VAR", CMD_CHANGE_CUSTOM_SVC_VAR, 0 },
+
+	{ "CHANGE_CUSTOM_CONTACT_VAR", CMD_CHANGE_CUSTOM_CONTACT_VAR, 0 },
+
+	{ "SEND_CUSTOM_SVC_NOTIFICATION", CMD_SEND_CUSTOM_SVC_NOTIFICATION, 4 },
+
+	{ "CHANGE_SVC_NOTIFICATION_TIMEPERIOD", CMD_CHANGE_SVC_NOTIFICATION_TIMEPERIOD, 0 },
+
+	{ "CHANGE_SVC_MODATTR", CMD_CHANGE_SVC_MODATTR, 0 },
+
+	/***************************************/
+	/**** SERVICEGROUP-RELATED COMMANDS ****/
+	/***************************************/
+
+	{ "ENABLE_SERVICEGROUP_HOST_NOTIFICATIONS", CMD_ENABLE_SERVICEGROUP_HOST_NOTIFICATIONS, 0 },
+	{ "DISABLE_SERVICEGROUP_HOST_NOTIFICATIONS", CMD_DISABLE_SERVICEGROUP_HOST_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_SERVICEGROUP_SVC_NOTIFICATIONS", CMD_ENABLE_SERVICEGROUP_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_SERVICEGROUP_SVC_NOTIFICATIONS", CMD_DISABLE_SERVICEGROUP_SVC_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_SERVICEGROUP_HOST_CHECKS", CMD_ENABLE_SERVICEGROUP_HOST_CHECKS, 0 },
+	{ "DISABLE_SERVICEGROUP_HOST_CHECKS", CMD_DISABLE_SERVICEGROUP_HOST_CHECKS, 0 },
+
+	{ "ENABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS", CMD_ENABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS, 0 },
+	{ "DISABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS", CMD_DISABLE_SERVICEGROUP_PASSIVE_HOST_CHECKS, 0 },
+
+	{ "ENABLE_SERVICEGROUP_SVC_CHECKS", CMD_ENABLE_SERVICEGROUP_SVC_CHECKS, 0 },
+	{ "DISABLE_SERVICEGROUP_SVC_CHECKS", CMD_DISABLE_SERVICEGROUP_SVC_CHECKS, 0 },
+
+	{ "ENABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS", CMD_ENABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS, 0 },
+	{ "DISABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS", CMD_DISABLE_SERVICEGROUP_PASSIVE_SVC_CHECKS, 0 },
+
+	{ "SCHEDULE_SERVICEGROUP_HOST_DOWNTIME", CMD_SCHEDULE_SERVICEGROUP_HOST_DOWNTIME, 7 },
+	{ "SCHEDULE_SERVICEGROUP_SVC_DOWNTIME", CMD_SCHEDULE_SERVICEGROUP_SVC_DOWNTIME, 7 },
+
+	/**********************************/
+	/**** CONTACT-RELATED COMMANDS ****/
+	/**********************************/
+
+	{ "ENABLE_CONTACT_HOST_NOTIFICATIONS", CMD_ENABLE_CONTACT_HOST_NOTIFICATIONS, 0 },
+	{ "DISABLE_CONTACT_HOST_NOTIFICATIONS", CMD_DISABLE_CONTACT_HOST_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_CONTACT_SVC_NOTIFICATIONS", CMD_ENABLE_CONTACT_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_CONTACT_SVC_NOTIFICATIONS", CMD_DISABLE_CONTACT_SVC_NOTIFICATIONS, 0 },
+
+	{ "CHANGE_CONTACT_HOST_NOTIFICATION_TIMEPERIOD", CMD_CHANGE_CONTACT_HOST_NOTIFICATION_TIMEPERIOD, 0 },
+
+	{ "CHANGE_CONTACT_SVC_NOTIFICATION_TIMEPERIOD", CMD_CHANGE_CONTACT_SVC_NOTIFICATION_TIMEPERIOD, 0 },
+
+	{ "CHANGE_CONTACT_MODATTR", CMD_CHANGE_CONTACT_MODATTR, 0 },
+	{ "CHANGE_CONTACT_MODHATTR", CMD_CHANGE_CONTACT_MODHATTR, 0 },
+	{ "CHANGE_CONTACT_MODSATTR", CMD_CHANGE_CONTACT_MODSATTR, 0 },
+
+	/***************************************/
+	/**** CONTACTGROUP-RELATED COMMANDS ****/
+	/***************************************/
+
+	{ "ENABLE_CONTACTGROUP_HOST_NOTIFICATIONS", CMD_ENABLE_CONTACTGROUP_HOST_NOTIFICATIONS, 0 },
+	{ "DISABLE_CONTACTGROUP_HOST_NOTIFICATIONS", CMD_DISABLE_CONTACTGROUP_HOST_NOTIFICATIONS, 0 },
+
+	{ "ENABLE_CONTACTGROUP_SVC_NOTIFICATIONS", CMD_ENABLE_CONTACTGROUP_SVC_NOTIFICATIONS, 0 },
+	{ "DISABLE_CONTACTGROUP_SVC_NOTIFICATIONS", CMD_DISABLE_CONTACTGROUP_SVC_NOTIFICATIONS, 0 },
+
+	/**************************/
+	/****** MISC COMMANDS *****/
+	/**************************/
+
+	{ "PROCESS_FILE", CMD_PROCESS_FILE, 0 },
+};
+
+#define BENCH_COMMANDS		(sizeof(bench_commands) / sizeof(bench_commands[0]))
+
+/* command mix of the lookups, in percent */
+static struct bench_command_share {
+	char *name;
+	int share;
+} bench_command_mix[] = {
+	{ "PROCESS_SERVICE_CHECK_RESULT", 85 },
+	{ "PROCESS_HOST_CHECK_RESULT", 8 },
+	{ "ACKNOWLEDGE_SVC_PROBLEM", 1 },
+	{ "ADD_SVC_COMMENT", 1 },
+	{ "SCHEDULE_FORCED_SVC_CHECK", 1 },
+	{ "SCHEDULE_SVC_CHECK", 1 },
+	{ "SCHEDULE_SVC_DOWNTIME", 1 },
+	{ "ACKNOWLEDGE_HOST_PROBLEM", 1 },
+	{ "_CUSTOM_COMMAND", 1 },
+	{ NULL, 0 }
+};
+
+
+static double get_seconds(void) {
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (double)tv.tv_sec + ((double)tv.tv_usec / 1000000.0);
+}
+
+
+/* compares a command name against every command, like the old chain of comparisons */
+static int find_command_linear(const char *name, int *author_position) {
+	unsigned int x = 0;
+
+	for (x = 0; x < BENCH_COMMANDS; x++) {
+		if (!strcmp(name, bench_commands[x].name)) {
+			*author_position = bench_commands[x].author_position;
+			return bench_commands[x].command_type;
+		}
+	}
+
+	return CMD_NONE;
+}
+
+
+/* checks that every command and a few unknown ones map to the same type both ways */
+static int verify_commands(void) {
+	char *unknown_commands[] = { "", "_CUSTOM_COMMAND", "PROCESS_SERVICE_CHECK_RESULTS", "process_service_check_result", "ZZZ", "AAA", NULL };
+	unsigned int x = 0;
+	int author_position = 0;
+	int command_type = CMD_NONE;
+	int mismatches = 0;
+
+	for (x = 0; x < BENCH_COMMANDS; x++) {
+		author_position = -1;
+		command_type = get_external_command_type(bench_commands[x].name, &author_position);
+		if (command_type != bench_commands[x].command_type || author_position != bench_commands[x].author_position) {
+			printf("%s: type %d, author argument %d, expected type %d, author argument %d\n", bench_commands[x].name, command_type, author_position, bench_commands[x].command_type, bench_commands[x].author_position);
+			mismatches++;
+		}
+	}
+
+	for (x = 0; unknown_commands[x] != NULL; x++) {
+		if (get_external_command_type(unknown_commands[x], NULL) != CMD_NONE) {
+			printf("unknown command '%s' found\n", unknown_commands[x]);
+			mismatches++;
+		}
+	}
+
+	printf("%u commands: %d mismatches\n", (unsigned int)BENCH_COMMANDS, mismatches);
+
+	return (mismatches == 0) ? OK : ERROR;
+}
+
+
+int main(int argc, char **argv) {
+	char **lookup_names = NULL;
+	double t0, t1, t2;
+	int lookups = 10000000;
+	int author_position = 0;
+	int found = 0;
+	int share = 0;
+	int x = 0;
+	int y = 0;
+
+	if (argc > 1)
+		lookups = atoi(argv[1]);
+	if (lookups <= 0) {
+		printf("usage: %s [<lookups>]\n", argv[0]);
+		return ERROR;
+	}
+
+	/* names are copied, so the lookups don't compare identical pointers */
+	if ((lookup_names = (char **)calloc(lookups, sizeof(char *))) == NULL)
+		return ERROR;
+	for (y = 0; bench_command_mix[y].name != NULL; y++)
+		bench_command_mix[y].name = strdup(bench_command_mix[y].name);
+	srandom(42);
+	for (x = 0; x < lookups; x++) {
+		share = random() % 100;
+		for (y = 0; bench_command_mix[y + 1].name != NULL && share >= bench_command_mix[y].share; y++)
+			share -= bench_command_mix[y].share;
+		lookup_names[x] = bench_command_mix[y].name;
+	}
+
+	if (verify_commands() == ERROR)
+		return 1;
+
+	t0 = get_seconds();
+
+	for (x = 0, found = 0; x < lookups; x++)
+		found += (find_command_linear(lookup_names[x], &author_position) != CMD_NONE);
+
+	t1 = get_seconds();
+
+	for (x = 0; x < lookups; x++)
+		found -= (get_external_command_type(lookup_names[x], &author_position) != CMD_NONE);
+
+	t2 = get_seconds();
+
+	printf("%-32s %9d lookups: %6.2f s (%6.0f ns/lookup)\n", "comparing every command", lookups, t1 - t0, (t1 - t0) * 1000000000.0 / lookups);
+	printf("%-32s %9d lookups: %6.2f s (%6.0f ns/lookup)\n", "sorted command table", lookups, t2 - t1, (t2 - t1) * 1000000000.0 / lookups);
+
+	for (y = 0; bench_command_mix[y].name != NULL; y++)
+		my_free(bench_command_mix[y].name);
+	my_free(lookup_names);
+
+	return (found == 0) ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+/*****************************************************************************
+ *
+ * BENCH-EVENTS.C - Benchmark of timed event queue inserts
+ *
+ * Copyright (c) 2009-2015 Icinga Development Team (http://www.icinga.org)
+ *
+ * License:
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *****************************************************************************/
+
+/*
+ * Queues a number of events (1M by default) in run time order, the way
+ * init_timing_loop() does, then reschedules events the way the event loop
+ * does: the next event is taken off the queue and queued again somewhere
+ * within the next hour.  This is done on a private event list first, which
+ * add_event() handles by walking back from the tail of the list, and then on
+ * the core's low priority event list, which is indexed by run time.  The
+ * tail walk takes milliseconds per insert into a queue of 1M events, so it
+ * only reschedules a sample of the events.
+ *
+ * usage: bench-events [<events> [<tail walk reschedules>]]
+ */
+
+#include "../../include/config.h"
+#include "../../include/common.h"
+#include "../../include/objects.h"
+#include "../../include/icinga.h"
+
+#include <sys/time.h>
+
+#define BENCH_EVENT_SPREAD		3600	/* events are rescheduled within the next hour */
+
+extern timed_event *event_list_low;
+extern timed_event *event_list_low_tail;
+
+static timed_event *bench_event_list = NULL;
+static timed_event *bench_event_list_tail = NULL;
+
+
+static double get_seconds(void) {
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (double)tv.tv_sec + ((double)tv.tv_usec / 1000000.0);
+}
+
+
+/* fills an event list, reschedules events and checks the result is in order */
+static int run_benchmark(const char *name, timed_event **event_list, timed_event **event_list_tail, timed_event *events, int count, int reschedules) {
+	timed_event *temp_event = NULL;
+	time_t start_time = 0L;
+	time_t last_time = 0L;
+	double t0, t1, t2;
+	int x = 0;
+
+	time(&start_time);
+	srandom(42);
+
+	t0 = get_seconds();
+
+	/* checks are spread out over the first check interval */
+	for (x = 0; x < count; x++) {
+		events[x].run_time = start_time + ((time_t)x * BENCH_EVENT_SPREAD / count);
+		add_event(&events[x], event_list, event_list_tail);
+	}
+
+	t1 = get_seconds();
+
+	for (x = 0; x < reschedules; x++) {
+		temp_event = *event_list;
+		remove_event(temp_event, event_list, event_list_tail);
+		temp_event->run_time += 1 + (random() % BENCH_EVENT_SPREAD);
+		add_event(temp_event, event_list, event_list_tail);
+	}
+
+	t2 = get_seconds();
+
+	for (x = 0, temp_event = *event_list; temp_event != NULL; temp_event = temp_event->next, x++) {
+		if (temp_event->run_time < last_time) {
+			printf("%s: event list out of order!\n", name);
+			return ERROR;
+		}
+		last_time = temp_event->run_time;
+	}
+	if (x != count) {
+		printf("%s: %d events in the list, expected %d!\n", name, x, count);
+		return ERROR;
+	}
+
+	printf("%-16s %8d ordered inserts: %7.2f s (%9.0f/s)   %8d reschedules: %7.2f s (%9.0f/s)\n", name, count, t1 - t0, count / (t1 - t0), reschedules, t2 - t1, reschedules / (t2 - t1));
+
+	/* empty the list again */
+	while (*event_list != NULL)
+		remove_event(*event_list, event_list, event_list_tail);
+
+	return OK;
+}
+
+
+int main(int argc, char **argv) {
+	timed_event *events = NULL;
+	int count = 1000000;
+	int tail_walk_reschedules = 2000;
+	int result = OK;
+
+	if (argc > 1)
+		count = atoi(argv[1]);
+	if (argc > 2)
+		tail_walk_reschedules = atoi(argv[2]);
+	if (count <= 0 || tail_walk_reschedules < 0) {
+		printf("usage: %s [<events> [<tail walk reschedules>]]\n", argv[0]);
+		return ERROR;
+	}
+
+	if ((events = (timed_event *)calloc(count, sizeof(timed_event))) == NULL)
+		return ERROR;
+
+	if (run_benchmark("tail walk", &bench_event_list, &bench_event_list_tail, events, count, tail_walk_reschedules) == ERROR)
+		result = ERROR;
+	if (run_benchmark("run time index", &event_list_low, &event_list_low_tail, events, count, count) == ERROR)
+		result = ERROR;
+
+	free_event_list_slots();
+	my_free(events);
+
+	return (result == OK) ? 0 : 1;
+}
@@ -0,0 +1,272 @@
+/*****************************************************************************
+ *
+ * BENCH-IDO2DB-INPUT.C - Benchmark of splitting ido2db client input into lines
+ *
+ * Copyright (c) 2009-2015 Icinga Development Team (http://www.icinga.org)
+ *
+ * License:
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *****************************************************************************/
+
+/*
+ * Replays an idomod data stream (300MB of service status updates by
+ * default, or the output idomod wrote to a file sink) through the input
+ * handling of ido2db in reads of 16k, the size ido2db reads from a client.
+ * ido2db_append_client_data() and ido2db_check_for_client_input() are timed
+ * against a copy of the way they used to work: strcat() onto the buffer,
+ * then strdup() every line and move the rest of the buffer to the front.
+ * The client data is ignored after splitting, so no database is needed and
+ * only the splitting is timed.  Both must see the same lines and bytes.
+ *
+ * usage: bench-ido2db-input [<megabytes> | <idomod output file>]
+ */
+
+#include "../../include/config.h"
+#include "../../include/broker.h"
+#include "../../module/idoutils/include/common.h"
+#include "../../module/idoutils/include/io.h"
+#include "../../module/idoutils/include/utils.h"
+#include "../../module/idoutils/include/protoapi.h"
+#include "../../module/idoutils/include/ido2db.h"
+
+#include <sys/time.h>
+
+#define BENCH_READ_SIZE		(16 * 1024)	/* ido2db reads up to this much from a client at once */
+
+/* the numeric service status fields idomod sends */
+static int bench_status_fields[] = {
+	IDO_DATA_CURRENTSTATE, IDO_DATA_HASBEENCHECKED, IDO_DATA_SHOULDBESCHEDULED, IDO_DATA_CURRENTCHECKATTEMPT,
+	IDO_DATA_MAXCHECKATTEMPTS, IDO_DATA_LASTSERVICECHECK, IDO_DATA_NEXTSERVICECHECK, IDO_DATA_CHECKTYPE,
+	IDO_DATA_LASTSTATECHANGE, IDO_DATA_LASTHARDSTATECHANGE, IDO_DATA_LASTHARDSTATE, IDO_DATA_LASTTIMEOK,
+	IDO_DATA_LASTTIMEWARNING, IDO_DATA_LASTTIMEUNKNOWN, IDO_DATA_LASTTIMECRITICAL, IDO_DATA_STATETYPE,
+	IDO_DATA_LASTSERVICENOTIFICATION, IDO_DATA_NEXTSERVICENOTIFICATION, IDO_DATA_NOMORENOTIFICATIONS,
+	IDO_DATA_NOTIFICATIONSENABLED, IDO_DATA_PROBLEMHASBEENACKNOWLEDGED, IDO_DATA_ACKNOWLEDGEMENTTYPE,
+	IDO_DATA_CURRENTNOTIFICATIONNUMBER, IDO_DATA_PASSIVESERVICECHECKSENABLED, IDO_DATA_EVENTHANDLERENABLED,
+	IDO_DATA_ACTIVESERVICECHECKSENABLED, IDO_DATA_FLAPDETECTIONENABLED, IDO_DATA_ISFLAPPING,
+	IDO_DATA_SCHEDULEDDOWNTIMEDEPTH, IDO_DATA_FAILUREPREDICTIONENABLED, IDO_DATA_PROCESSPERFORMANCEDATA,
+	IDO_DATA_OBSESSOVERSERVICE, IDO_DATA_MODIFIEDSERVICEATTRIBUTES, -1
+};
+
+
+static double get_seconds(void) {
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (double)tv.tv_sec + ((double)tv.tv_usec / 1000000.0);
+}
+
+
+/* writes service status updates the way idomod formats them until the stream has the given size */
+static char *make_stream(unsigned long size, unsigned long *stream_size) {
+	char *stream = NULL;
+	unsigned long used = 0L;
+	int service = 0;
+	int x = 0;
+
+	if ((stream = (char *)malloc(size + 4096)) == NULL)
+		return NULL;
+
+	srandom(42);
+
+	for (service = 0; used < size; service++) {
+
+		used += sprintf(stream + used, "\n%d:\n%d=%d\n%d=%d\n%d=%d\n%d=%ld.%06ld\n%d=host%05d.example.org\n%d=Disk /var/lib/%d\n%d=DISK OK - free space: /var/lib/%d %d MB (%d%% inode=%d%%):\n%d=\n%d=/var/lib/%d=%dMB;%d;%d;0;%d\n"
+		                , IDO_API_SERVICESTATUSDATA
+		                , IDO_DATA_TYPE, NEBTYPE_SERVICESTATUS_UPDATE
+		                , IDO_DATA_FLAGS, 0
+		                , IDO_DATA_ATTRIBUTES, 0
+		                , IDO_DATA_TIMESTAMP, 1400000000L + service, random() % 1000000L
+		                , IDO_DATA_HOST, service / 20
+		                , IDO_DATA_SERVICE, service % 20
+		                , IDO_DATA_OUTPUT, service % 20, (int)(random() % 100000), (int)(random() % 100), (int)(random() % 100)
+		                , IDO_DATA_LONGOUTPUT
+		                , IDO_DATA_PERFDATA, service % 20, (int)(random() % 100000), 80000, 90000, 100000);
+
+		for (x = 0; bench_status_fields[x] >= 0; x++)
+			used += sprintf(stream + used, "%d=%ld\n", bench_status_fields[x], (x % 4 == 0) ? 1400000000L + random() % 86400 : random() % 4);
+
+		used += sprintf(stream + used, "%d=%.5lf\n%d=%.5lf\n%d=%.5lf\n%d=\n%d=check_disk!10%%!5%%!/var/lib/%d\n%d=%lf\n%d=%lf\n%d=24x7\n%d\n\n"
+		                , IDO_DATA_PERCENTSTATECHANGE, 0.0
+		                , IDO_DATA_LATENCY, (double)(random() % 1000) / 1000.0
+		                , IDO_DATA_EXECUTIONTIME, (double)(random() % 1000) / 100.0
+		                , IDO_DATA_EVENTHANDLER
+		                , IDO_DATA_CHECKCOMMAND, service % 20
+		                , IDO_DATA_NORMALCHECKINTERVAL, 5.0
+		                , IDO_DATA_RETRYCHECKINTERVAL, 1.0
+		                , IDO_DATA_SERVICECHECKPERIOD
+		                , IDO_API_ENDDATA);
+	}
+
+	*stream_size = used;
+
+	return stream;
+}
+
+
+/* reads a stream idomod wrote to a file */
+static char *read_stream(char *filename, unsigned long *stream_size) {
+	FILE *fp = NULL;
+	char *stream = NULL;
+	long size = 0L;
+
+	if ((fp = fopen(filename, "r")) == NULL)
+		return NULL;
+
+	if (fseek(fp, 0L, SEEK_END) == 0 && (size = ftell(fp)) > 0 && fseek(fp, 0L, SEEK_SET) == 0 && (stream = (char *)malloc(size)) != NULL) {
+		if (fread(stream, 1, size, fp) != (size_t)size)
+			my_free(stream);
+	}
+
+	fclose(fp);
+
+	*stream_size = (unsigned long)size;
+
+	return stream;
+}
+
+
+/* appends a read the way ido_dbuf_strcat() used to, looking for the end of the buffer first */
+static void old_dbuf_strcat(ido_dbuf *db, char *buf) {
+	unsigned long buflen = strlen(buf);
+
+	if (db->allocated_size < db->used_size + buflen + 1) {
+		db->allocated_size = ((db->used_size + buflen + 1) / db->chunk_size + 2) * db->chunk_size;
+		db->buf = (char *)realloc(db->buf, db->allocated_size);
+		db->buf[db->used_size] = '\x0';
+	}
+
+	strcat(db->buf, buf);
+	db->used_size += buflen;
+
+	return;
+}
+
+
+/* handles complete lines the way ido2db_check_for_client_input() used to, moving the rest of the buffer after every line */
+static void old_check_for_client_input(ido2db_idi *idi, ido_dbuf *dbuf) {
+	char *buf = NULL;
+	register int x;
+
+	for (x = 0; dbuf->buf[x] != '\x0'; x++) {
+
+		if (dbuf->buf[x] == '\n') {
+
+			dbuf->buf[x] = '\x0';
+
+			if ((buf = strdup(dbuf->buf))) {
+				ido2db_handle_client_input(idi, buf);
+
+				free(buf);
+				buf = NULL;
+				idi->lines_processed++;
+				idi->bytes_processed += (x + 1);
+			}
+
+			memmove((void *)&dbuf->buf[0], (void *)&dbuf->buf[x+1], (size_t)((int)dbuf->used_size - x - 1));
+			dbuf->used_size -= (x + 1);
+			dbuf->buf[dbuf->used_size] = '\x0';
+			x = -1;
+		}
+	}
+
+	return;
+}
+
+
+/* feeds the stream to ido2db in reads of BENCH_READ_SIZE */
+static void replay_stream(char *stream, unsigned long stream_size, ido2db_idi *idi, int old) {
+	char buf[BENCH_READ_SIZE];
+	ido_dbuf dbuf;
+	unsigned long offset = 0L;
+	unsigned long len = 0L;
+	double t0, t1;
+
+	ido2db_idi_init(idi);
+	idi->ignore_client_data = IDO_TRUE;
+	ido_dbuf_init(&dbuf, 2048);
+
+	t0 = get_seconds();
+
+	for (offset = 0L; offset < stream_size; offset += len) {
+
+		len = (stream_size - offset < sizeof(buf) - 1) ? stream_size - offset : sizeof(buf) - 1;
+		memcpy(buf, stream + offset, len);
+		buf[len] = '\x0';
+
+		if (old == IDO_TRUE) {
+			old_dbuf_strcat(&dbuf, buf);
+			old_check_for_client_input(idi, &dbuf);
+		} else {
+			ido2db_append_client_data(idi, &dbuf, buf, len);
+			ido2db_check_for_client_input(idi, &dbuf);
+		}
+	}
+
+	t1 = get_seconds();
+
+	printf("%-24s %6.0f MB %10lu lines: %6.2f s (%5.1f M lines/s, %6.1f MB/s)\n", (old == IDO_TRUE) ? "strdup and move per line" : "split in place", stream_size / 1048576.0, idi->lines_processed, t1 - t0, idi->lines_processed / (t1 - t0) / 1000000.0, stream_size / (t1 - t0) / 1048576.0);
+
+	ido_dbuf_free(&dbuf);
+
+	return;
+}
+
+
+int main(int argc, char **argv) {
+	ido2db_idi old_idi;
+	ido2db_idi idi;
+	char *stream = NULL;
+	unsigned long stream_size = 0L;
+	unsigned long lines = 0L;
+	unsigned long x = 0L;
+	int megabytes = 300;
+
+	if (argc > 1 && strspn(argv[1], "0123456789") == strlen(argv[1]))
+		megabytes = atoi(argv[1]);
+	if (argc > 2 || megabytes <= 0) {
+		printf("usage: %s [<megabytes> | <idomod output file>]\n", argv[0]);
+		return IDO_ERROR;
+	}
+
+	if (argc > 1 && strspn(argv[1], "0123456789") != strlen(argv[1]))
+		stream = read_stream(argv[1], &stream_size);
+	else
+		stream = make_stream((unsigned long)megabytes * 1048576L, &stream_size);
+	if (stream == NULL) {
+		printf("Could not set up the data stream\n");
+		return IDO_ERROR;
+	}
+
+	/* the old way can't deal with zero bytes, so the stream ends at the first one */
+	for (x = 0L; x < stream_size && stream[x] != '\x0'; x++) {
+		if (stream[x] == '\n')
+			lines++;
+	}
+	stream_size = x;
+
+	replay_stream(stream, stream_size, &old_idi, IDO_TRUE);
+	replay_stream(stream, stream_size, &idi, IDO_FALSE);
+
+	my_free(stream);
+
+	if (idi.lines_processed != lines || idi.lines_processed != old_idi.lines_processed || idi.bytes_processed != old_idi.bytes_processed) {
+		printf("%lu lines in the stream, %lu lines (%lu bytes) handled the old way, %lu lines (%lu bytes) in place\n", lines, old_idi.lines_processed, old_idi.bytes_processed, idi.lines_processed, idi.bytes_processed);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,366 @@
+/*****************************************************************************
+ *
+ * BENCH-MACROS.C - Benchmark of macro expansion
+ *
+ * Copyright (c) 2009-2015 Icinga Development Team (http://www.icinga.org)
+ *
+ * License:
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *****************************************************************************/
+
+/*
+ * Writes a configuration with a number of hosts (1000 by default) running
+ * ping, http, nrpe and one odd check command each, reads it the way the core
+ * does and expands the check commands and the default service perfdata file
+ * template.  Every expansion is done twice: by process_macros_r() on the raw
+ * command line, which parses the string every time, and by the macro
+ * templates the commands are compiled into at startup.  Both must give the
+ * same results, which is also checked for random strings made up of macro
+ * pieces.
+ *
+ * usage: bench-macros [<hosts> [<rounds>]]
+ */
+
+#include "../../include/config.h"
+#include "../../include/common.h"
+#include "../../include/objects.h"
+#include "../../include/macros.h"
+#include "../../include/icinga.h"
+#include "../../xdata/xpddefault.h"
+
+#include <sys/time.h>
+
+#define BENCH_FUZZ_STRINGS		200000
+
+extern int      keep_unknown_macros;
+extern int      daemon_mode;
+extern char     *config_file;
+extern service  *service_list;
+
+static char bench_dir[] = "/tmp/bench-macros.XXXXXX";
+
+static char *bench_pieces[] = { "$", "$$", "ARG", "1", "2", "0", "99", "USER", "HOSTNAME", "HOSTADDRESS", "HOSTADDRESS6", "SERVICEDESC", ":", "h1", "_HOSTNRPE_TIMEOUT", "_SERVICEPORT", "FOO", " ", "x", "CONTACTADDRESS", "SERVICEOUTPUT", "TIMET", "HOSTSTATE", "LONGDATETIME", "'", "&", "\\", NULL };
+
+static int bench_options[] = { 0, STRIP_ILLEGAL_MACRO_CHARS | ESCAPE_MACRO_CHARS, URL_ENCODE_MACRO_CHARS };
+
+
+static double get_seconds(void) {
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (double)tv.tv_sec + ((double)tv.tv_usec / 1000000.0);
+}
+
+
+static FILE *open_config_file(char *name) {
+	char path[MAX_FILENAME_LENGTH];
+
+	snprintf(path, sizeof(path), "%s/%s", bench_dir, name);
+
+	return fopen(path, "w");
+}
+
+
+static void remove_config_files(void) {
+	char path[MAX_FILENAME_LENGTH];
+
+	snprintf(path, sizeof(path), "%s/icinga.cfg", bench_dir);
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/objects.cfg", bench_dir);
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/resource.cfg", bench_dir);
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/objects.cache", bench_dir);
+	unlink(path);
+	rmdir(bench_dir);
+
+	return;
+}
+
+
+/* writes the main, resource and object config files */
+static int write_config(int hosts) {
+	FILE *fp = NULL;
+	char *services[4][2] = {
+		{ "ping", "check_ping!100.0,20%!500.0,60%" },
+		{ "http", "check_http!/index.html?a=1&b=$HOSTNAME$!10" },
+		{ "disk", "check_nrpe!check_disk!-w 20%!-c 10%" },
+		{ "misc", "check_misc!x$HOSTNAME$y" }
+	};
+	int x = 0;
+	int y = 0;
+
+	if ((fp = open_config_file("icinga.cfg")) == NULL)
+		return ERROR;
+	fprintf(fp, "log_file=/dev/null\nuse_syslog=0\ncfg_file=%s/objects.cfg\nresource_file=%s/resource.cfg\nobject_cache_file=%s/objects.cache\n", bench_dir, bench_dir, bench_dir);
+	fprintf(fp, "temp_path=%s\ncheck_result_path=%s\nillegal_macro_output_chars=`~$&|'\"<>\n", bench_dir, bench_dir);
+	fclose(fp);
+
+	if ((fp = open_config_file("resource.cfg")) == NULL)
+		return ERROR;
+	fprintf(fp, "$USER1$=/usr/lib/nagios/plugins\n$USER2$=s3cr3t\n");
+	fclose(fp);
+
+	if ((fp = open_config_file("objects.cfg")) == NULL)
+		return ERROR;
+
+	fprintf(fp, "define timeperiod{\n\ttimeperiod_name\t24x7\n\talias\t24x7\n");
+	fprintf(fp, "\tsunday\t00:00-24:00\n\tmonday\t00:00-24:00\n\ttuesday\t00:00-24:00\n\twednesday\t00:00-24:00\n\tthursday\t00:00-24:00\n\tfriday\t00:00-24:00\n\tsaturday\t00:00-24:00\n}\n");
+	fprintf(fp, "define contact{\n\tcontact_name\tadmin\n\thost_notifications_enabled\t0\n\tservice_notifications_enabled\t0\n\thost_notification_period\t24x7\n\tservice_notification_period\t24x7\n\thost_notification_commands\tdummy\n\tservice_notification_commands\tdummy\n\temail\troot@localhost\n}\n");
+	fprintf(fp, "define command{\n\tcommand_name\tdummy\n\tcommand_line\t/bin/true\n}\n");
+	fprintf(fp, "define command{\n\tcommand_name\tcheck_ping\n\tcommand_line\t$USER1$/check_ping -H $HOSTADDRESS$ -w $ARG1$ -c $ARG2$ -p 5\n}\n");
+	fprintf(fp, "define command{\n\tcommand_name\tcheck_http\n\tcommand_line\t$USER1$/check_http -H $HOSTNAME$ -I $HOSTADDRESS$ -u '$ARG1$' -t $ARG2$ --sni\n}\n");
+	fprintf(fp, "define command{\n\tcommand_name\tcheck_nrpe\n\tcommand_line\t$USER1$/check_nrpe -H $HOSTADDRESS$ -c $ARG1$ -a '$ARG2$' '$ARG3$' -t $_HOSTNRPE_TIMEOUT$ -p $_SERVICEPORT$\n}\n");
+	fprintf(fp, "define command{\n\tcommand_name\tcheck_misc\n\tcommand_line\t/bin/printf \"%%s\\n\" \"$HOSTNAME$ $SERVICEDESC$ $SERVICESTATE$ $SERVICEOUTPUT$ $$5 $NOSUCHMACRO$ $HOSTSTATE:h1$ $SERVICESTATEID:h2:misc$ $HOSTADDRESS6$ $USER2$ $ARG1$ $ARG0$ $ARG99$ $HOSTGROUPNAME$ $CONTACTADDRESS1$ unterminated $HOSTNAME\n}\n");
+	fprintf(fp, "define hostgroup{\n\thostgroup_name\tall\n\talias\tall\n}\n");
+
+	for (x = 0; x < hosts; x++) {
+		fprintf(fp, "define host{\n\thost_name\th%d\n\talias\thost %d\n\taddress\t10.%d.%d.%d\n\taddress6\t::%x\n\thostgroups\tall\n", x, x, (x >> 16) & 255, (x >> 8) & 255, x & 255, x + 1);
+		fprintf(fp, "\tmax_check_attempts\t3\n\tcheck_period\t24x7\n\tcontacts\tadmin\n\tnotification_period\t24x7\n\t_NRPE_TIMEOUT\t30\n}\n");
+		for (y = 0; y < 4; y++) {
+			fprintf(fp, "define service{\n\thost_name\th%d\n\tservice_description\t%s\n\tcheck_command\t%s\n", x, services[y][0], services[y][1]);
+			fprintf(fp, "\tmax_check_attempts\t3\n\tcheck_interval\t5\n\tretry_interval\t1\n\tcheck_period\t24x7\n\tnotification_period\t24x7\n\tcontacts\tadmin\n\t_PORT\t5666\n}\n");
+		}
+	}
+
+	fclose(fp);
+
+	return OK;
+}
+
+
+/* expands a check command the way it was done before commands were compiled */
+static int get_uncompiled_command_line(icinga_macros *mac, service *svc, char **result, int options) {
+	char *raw_command = NULL;
+
+	get_raw_command_line_r(mac, svc->check_command_ptr, svc->service_check_command, &raw_command, options);
+	process_macros_r(mac, raw_command, result, options);
+	my_free(raw_command);
+
+	return OK;
+}
+
+
+/* compares both ways of expanding the check commands and random strings */
+static int check_results(void) {
+	icinga_macros mac;
+	macro_template *template = NULL;
+	service *temp_service = NULL;
+	char buffer[MAX_INPUT_BUFFER];
+	char *result1 = NULL;
+	char *result2 = NULL;
+	int mismatches = 0;
+	int commands = 0;
+	int pieces = 0;
+	int options = 0;
+	int x = 0;
+	int y = 0;
+	int n = 0;
+
+	for (x = 0; x < 2; x++) {
+		keep_unknown_macros = x;
+		for (y = 0; y < 3; y++) {
+			for (temp_service = service_list; temp_service != NULL; temp_service = temp_service->next) {
+				memset(&mac, 0, sizeof(mac));
+				grab_host_macros_r(&mac, temp_service->host_ptr);
+				grab_service_macros_r(&mac, temp_service);
+				get_uncompiled_command_line(&mac, temp_service, &result1, bench_options[y]);
+				get_processed_command_line_r(&mac, temp_service->check_command_ptr, temp_service->service_check_command, &result2, bench_options[y]);
+				if (strcmp(result1, result2) && mismatches++ < 5)
+					printf("mismatch: '%s' expands to\n  '%s'\n  '%s'\n", temp_service->service_check_command, result1, result2);
+				my_free(result1);
+				my_free(result2);
+				clear_argv_macros_r(&mac);
+				clear_volatile_macros_r(&mac);
+				commands++;
+			}
+		}
+	}
+
+	for (pieces = 0; bench_pieces[pieces] != NULL; pieces++)
+		;
+
+	srandom(42);
+	temp_service = service_list;
+
+	for (x = 0; x < BENCH_FUZZ_STRINGS; x++) {
+
+		buffer[0] = '\x0';
+		for (y = 0, n = random() % 12; y < n; y++)
+			strcat(buffer, bench_pieces[random() % pieces]);
+
+		keep_unknown_macros = random() % 2;
+		options = bench_options[random() % 3];
+
+		memset(&mac, 0, sizeof(mac));
+		if (random() % 4) {
+			grab_host_macros_r(&mac, temp_service->host_ptr);
+			grab_service_macros_r(&mac, temp_service);
+		}
+		/* argument values get modified in place when illegal characters are stripped */
+		mac.argv[0] = (random() % 2) ? strdup("arg o'ne") : NULL;
+
+		template = compile_macro_template(buffer);
+		process_macros_r(&mac, buffer, &result1, options);
+		process_macro_template_r(&mac, template, &result2, options);
+		if (strcmp(result1, result2) && mismatches++ < 5)
+			printf("mismatch: '%s' expands to\n  '%s'\n  '%s'\n", buffer, result1, result2);
+		my_free(result1);
+		my_free(result2);
+		free_macro_template(template);
+
+		clear_argv_macros_r(&mac);
+		clear_volatile_macros_r(&mac);
+
+		temp_service = (temp_service->next != NULL) ? temp_service->next : service_list;
+	}
+
+	printf("%d mismatches in %d check commands and %d random strings\n", mismatches, commands, BENCH_FUZZ_STRINGS);
+
+	return (mismatches == 0) ? OK : ERROR;
+}
+
+
+/* times the expansion of the check commands, macros are looked up on demand like the core does */
+static void time_check_commands(int rounds, int compiled) {
+	icinga_macros mac;
+	service *temp_service = NULL;
+	char *result = NULL;
+	unsigned long count = 0L;
+	double t0, t1;
+	int x = 0;
+
+	keep_unknown_macros = TRUE;
+
+	t0 = get_seconds();
+
+	for (x = 0; x < rounds; x++) {
+		for (temp_service = service_list; temp_service != NULL; temp_service = temp_service->next) {
+
+			/* the odd command asks for summary macros, which take longer than the rest together */
+			if (!strcmp(temp_service->description, "misc"))
+				continue;
+
+			memset(&mac, 0, sizeof(mac));
+			mac.host_ptr = temp_service->host_ptr;
+			mac.service_ptr = temp_service;
+			mac.custom_host_vars = temp_service->host_ptr->custom_variables;
+			mac.custom_service_vars = temp_service->custom_variables;
+
+			if (compiled == TRUE)
+				get_processed_command_line_r(&mac, temp_service->check_command_ptr, temp_service->service_check_command, &result, 0);
+			else
+				get_uncompiled_command_line(&mac, temp_service, &result, 0);
+
+			my_free(result);
+			clear_argv_macros_r(&mac);
+			count++;
+		}
+	}
+
+	t1 = get_seconds();
+
+	printf("%-36s %9lu expansions: %7.2f s (%9.0f/s)\n", (compiled == TRUE) ? "check commands, compiled" : "check commands, process_macros_r", count, t1 - t0, count / (t1 - t0));
+
+	return;
+}
+
+
+/* times the expansion of the default service perfdata file template */
+static void time_perfdata_template(int count, int compiled) {
+	icinga_macros mac;
+	macro_template *template = NULL;
+	char *result = NULL;
+	double t0, t1;
+	int x = 0;
+
+	memset(&mac, 0, sizeof(mac));
+	grab_host_macros_r(&mac, service_list->host_ptr);
+	grab_service_macros_r(&mac, service_list);
+
+	template = compile_macro_template(DEFAULT_SERVICE_PERFDATA_FILE_TEMPLATE);
+
+	t0 = get_seconds();
+
+	for (x = 0; x < count; x++) {
+		if (compiled == TRUE)
+			process_macro_template_r(&mac, template, &result, 0);
+		else
+			process_macros_r(&mac, DEFAULT_SERVICE_PERFDATA_FILE_TEMPLATE, &result, 0);
+		my_free(result);
+	}
+
+	t1 = get_seconds();
+
+	free_macro_template(template);
+	clear_volatile_macros_r(&mac);
+
+	printf("%-36s %9d expansions: %7.2f s (%9.0f/s)\n", (compiled == TRUE) ? "perfdata template, compiled" : "perfdata template, process_macros_r", count, t1 - t0, count / (t1 - t0));
+
+	return;
+}
+
+
+int main(int argc, char **argv) {
+	char main_config_file[MAX_FILENAME_LENGTH];
+	int hosts = 1000;
+	int rounds = 100;
+	int result = OK;
+
+	if (argc > 1)
+		hosts = atoi(argv[1]);
+	if (argc > 2)
+		rounds = atoi(argv[2]);
+	if (hosts <= 0 || rounds <= 0) {
+		printf("usage: %s [<hosts> [<rounds>]]\n", argv[0]);
+		return ERROR;
+	}
+
+	if (mkdtemp(bench_dir) == NULL || write_config(hosts) == ERROR) {
+		printf("Could not write the configuration to %s\n", bench_dir);
+		return ERROR;
+	}
+
+	snprintf(main_config_file, sizeof(main_config_file), "%s/icinga.cfg", bench_dir);
+	config_file = main_config_file;
+
+	reset_variables();
+
+	/* keep the warnings about the unknown macros of the odd command off the console */
+	daemon_mode = TRUE;
+
+	if (read_main_config_file(main_config_file) != OK || read_all_object_data(main_config_file) != OK || pre_flight_check() != OK) {
+		printf("Could not read the configuration in %s\n", bench_dir);
+		remove_config_files();
+		return ERROR;
+	}
+	remove_config_files();
+
+	compile_command_templates();
+
+	if (check_results() == ERROR)
+		result = ERROR;
+
+	time_check_commands(rounds, FALSE);
+	time_check_commands(rounds, TRUE);
+	time_perfdata_template(rounds * hosts * 3, FALSE);
+	time_perfdata_template(rounds * hosts * 3, TRUE);
+
+	free_command_templates();
+
+	return (result == OK) ? 0 : 1;
+}
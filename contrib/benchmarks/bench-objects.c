@@ -0,0 +1,211 @@
+/*****************************************************************************
+ *
+ * BENCH-OBJECTS.C - Benchmark of host and service lookups by name
+ *
+ * Copyright (c) 2009-2015 Icinga Development Team (http://www.icinga.org)
+ *
+ * License:
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *****************************************************************************/
+
+/*
+ * Sets up 10k, 100k and 1M hosts and as many services (ten on every tenth
+ * host) and looks up random hosts and services by name (2M of each by
+ * default), the way external commands and passive check results do.  The
+ * lookups are done by walking the object skiplists, like the find_*()
+ * functions used to, and with find_host() and find_service(), which use the
+ * hash index.  Both must find the same objects.
+ *
+ * usage: bench-objects [<lookups> [<max objects>]]
+ */
+
+#include "../../include/config.h"
+#include "../../include/common.h"
+#include "../../include/objects.h"
+#include "../../include/icinga.h"
+#include "../../include/skiplist.h"
+
+#include <sys/time.h>
+
+#define BENCH_NAME_LENGTH		32
+#define BENCH_SERVICES_PER_HOST		10
+
+extern int      daemon_mode;
+extern skiplist *object_skiplists[NUM_OBJECT_SKIPLISTS];
+
+static char *bench_service_descriptions[BENCH_SERVICES_PER_HOST] = {
+	"PING", "HTTP", "HTTPS", "SSH", "Disk /", "Disk /var", "Load", "Memory", "Swap", "NTP Time"
+};
+
+
+static double get_seconds(void) {
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (double)tv.tv_sec + ((double)tv.tv_usec / 1000000.0);
+}
+
+
+/* adds hosts and services with the minimum settings add_host() and add_service() accept */
+static int make_objects(char *host_names, int count) {
+	char address[BENCH_NAME_LENGTH];
+	char address6[BENCH_NAME_LENGTH];
+	int x = 0;
+	int y = 0;
+
+	init_object_skiplists();
+
+	for (x = 0; x < count; x++) {
+		snprintf(host_names + (x * BENCH_NAME_LENGTH), BENCH_NAME_LENGTH, "host%08d.example.org", x);
+		snprintf(address, sizeof(address), "10.%d.%d.%d", (x >> 16) & 255, (x >> 8) & 255, x & 255);
+		snprintf(address6, sizeof(address6), "fd00::%x", x);
+		if (add_host(host_names + (x * BENCH_NAME_LENGTH), NULL, NULL, address, address6, NULL, 0, 5.0, 1.0, 3, TRUE, TRUE, TRUE, TRUE, TRUE, 30.0, 0.0, NULL, TRUE, "check-host-alive", TRUE, TRUE, NULL, TRUE, TRUE, 0.0, 0.0, TRUE, TRUE, TRUE, FALSE, FALSE, FALSE, TRUE, FALSE, NULL, FALSE, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, -1, -1, FALSE, 0.0, 0.0, 0.0, FALSE, TRUE, TRUE, TRUE, TRUE) == NULL)
+			return ERROR;
+	}
+
+	for (x = 0; x < count; x += BENCH_SERVICES_PER_HOST) {
+		for (y = 0; y < BENCH_SERVICES_PER_HOST; y++) {
+			if (add_service(host_names + (x * BENCH_NAME_LENGTH), bench_service_descriptions[y], NULL, NULL, STATE_OK, 3, TRUE, TRUE, 5.0, 1.0, 30.0, 0.0, NULL, TRUE, TRUE, TRUE, TRUE, TRUE, TRUE, TRUE, FALSE, NULL, TRUE, "check_dummy", TRUE, TRUE, 0.0, 0.0, TRUE, TRUE, TRUE, TRUE, FALSE, FALSE, FALSE, FALSE, TRUE, FALSE, NULL, FALSE, 0, NULL, NULL, NULL, NULL, NULL, TRUE, TRUE, TRUE) == NULL)
+				return ERROR;
+		}
+	}
+
+	return OK;
+}
+
+
+/* looks up random hosts and services in the skiplists and the hash index */
+static int run_benchmark(char *host_names, int count, int lookups) {
+	host temp_host;
+	service temp_service;
+	int *lookup_hosts = NULL;
+	int *lookup_services = NULL;
+	void *found = NULL;
+	double t0, t1, t2, t3, t4;
+	int mismatches = 0;
+	int x = 0;
+
+	if ((lookup_hosts = (int *)malloc(lookups * sizeof(int))) == NULL || (lookup_services = (int *)malloc(lookups * sizeof(int))) == NULL) {
+		my_free(lookup_hosts);
+		return ERROR;
+	}
+
+	/* services only exist on every tenth host */
+	srandom(42);
+	for (x = 0; x < lookups; x++) {
+		lookup_hosts[x] = random() % count;
+		lookup_services[x] = random() % count;
+	}
+
+	t0 = get_seconds();
+
+	for (x = 0; x < lookups; x++) {
+		temp_host.name = host_names + (lookup_hosts[x] * BENCH_NAME_LENGTH);
+		found = skiplist_find_first(object_skiplists[HOST_SKIPLIST], &temp_host, NULL);
+	}
+
+	t1 = get_seconds();
+
+	for (x = 0; x < lookups; x++)
+		found = find_host(host_names + (lookup_hosts[x] * BENCH_NAME_LENGTH));
+
+	t2 = get_seconds();
+
+	for (x = 0; x < lookups; x++) {
+		temp_service.host_name = host_names + ((lookup_services[x] - (lookup_services[x] % BENCH_SERVICES_PER_HOST)) * BENCH_NAME_LENGTH);
+		temp_service.description = bench_service_descriptions[lookup_services[x] % BENCH_SERVICES_PER_HOST];
+		found = skiplist_find_first(object_skiplists[SERVICE_SKIPLIST], &temp_service, NULL);
+	}
+
+	t3 = get_seconds();
+
+	for (x = 0; x < lookups; x++)
+		found = find_service(host_names + ((lookup_services[x] - (lookup_services[x] % BENCH_SERVICES_PER_HOST)) * BENCH_NAME_LENGTH), bench_service_descriptions[lookup_services[x] % BENCH_SERVICES_PER_HOST]);
+
+	t4 = get_seconds();
+
+	/* both ways must find the same objects */
+	for (x = 0; x < lookups && x < 100000; x++) {
+		temp_host.name = host_names + (lookup_hosts[x] * BENCH_NAME_LENGTH);
+		found = find_host(temp_host.name);
+		if (found == NULL || found != skiplist_find_first(object_skiplists[HOST_SKIPLIST], &temp_host, NULL)) {
+			if (mismatches++ < 10)
+				printf("host '%s' not found in the hash index\n", temp_host.name);
+		}
+
+		temp_service.host_name = host_names + ((lookup_services[x] - (lookup_services[x] % BENCH_SERVICES_PER_HOST)) * BENCH_NAME_LENGTH);
+		temp_service.description = bench_service_descriptions[lookup_services[x] % BENCH_SERVICES_PER_HOST];
+		found = find_service(temp_service.host_name, temp_service.description);
+		if (found == NULL || found != skiplist_find_first(object_skiplists[SERVICE_SKIPLIST], &temp_service, NULL)) {
+			if (mismatches++ < 10)
+				printf("service '%s' on host '%s' not found in the hash index\n", temp_service.description, temp_service.host_name);
+		}
+	}
+	if (find_host("no-such-host.example.org") != NULL || find_service(host_names, "no such service") != NULL) {
+		printf("missing objects found in the hash index\n");
+		mismatches++;
+	}
+
+	printf("%8d hosts    skiplist: %6.0f ns/lookup   hash index: %6.0f ns/lookup\n", count, (t1 - t0) * 1000000000.0 / lookups, (t2 - t1) * 1000000000.0 / lookups);
+	printf("%8d services skiplist: %6.0f ns/lookup   hash index: %6.0f ns/lookup\n", count, (t3 - t2) * 1000000000.0 / lookups, (t4 - t3) * 1000000000.0 / lookups);
+
+	my_free(lookup_hosts);
+	my_free(lookup_services);
+
+	return (mismatches == 0) ? OK : ERROR;
+}
+
+
+int main(int argc, char **argv) {
+	char *host_names = NULL;
+	int lookups = 2000000;
+	int max_objects = 1000000;
+	int count = 0;
+	int result = OK;
+
+	if (argc > 1)
+		lookups = atoi(argv[1]);
+	if (argc > 2)
+		max_objects = atoi(argv[2]);
+	if (lookups <= 0 || max_objects < 10000) {
+		printf("usage: %s [<lookups> [<max objects>]]\n", argv[0]);
+		return ERROR;
+	}
+
+	/* keep logit() off the console */
+	daemon_mode = TRUE;
+
+	for (count = 10000; count <= max_objects; count *= 10) {
+
+		if ((host_names = (char *)malloc(count * BENCH_NAME_LENGTH)) == NULL)
+			return ERROR;
+
+		if (make_objects(host_names, count) == ERROR) {
+			printf("Could not create %d hosts and services\n", count);
+			result = ERROR;
+		} else if (run_benchmark(host_names, count, lookups) == ERROR)
+			result = ERROR;
+
+		free_object_data();
+		my_free(host_names);
+
+		if (result == ERROR)
+			break;
+	}
+
+	return (result == OK) ? 0 : 1;
+}
@@ -0,0 +1,363 @@
+/*****************************************************************************
+ *
+ * BENCH-TIMEPERIODS.C - Benchmark of time period checks
+ *
+ * Copyright (c) 2009-2015 Icinga Development Team (http://www.icinga.org)
+ *
+ * License:
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *****************************************************************************/
+
+/*
+ * Builds a number of random time periods (60 by default) with weekday time
+ * ranges, all kinds of date range exceptions and up to three exclusions of
+ * other time periods each, now and then forming a cycle.  The cached valid
+ * intervals are checked against the time period rules in a few time zones,
+ * including the next valid time against a minute by minute search.  Then
+ * checking times and looking for the next valid time is timed with and
+ * without the cache.
+ *
+ * usage: bench-timeperiods [<timeperiods> [<checks>]]
+ */
+
+#include "../../include/config.h"
+#include "../../include/common.h"
+#include "../../include/objects.h"
+#include "../../include/icinga.h"
+
+#include <sys/time.h>
+
+#define BENCH_VERIFY_CHECKS		2000		/* times checked per time period and zone */
+#define BENCH_VERIFY_NEXT_VALID		4		/* next valid times looked up per time period and zone */
+#define BENCH_SEARCH_DAYS		2		/* how far the minute by minute search looks ahead */
+
+extern timeperiod *timeperiod_list;
+
+static char *bench_zones[] = { "UTC", "Europe/Berlin", "America/New_York", "Australia/Lord_Howe", NULL };
+
+static timeperiod **bench_periods = NULL;
+static int bench_period_count = 0;
+
+
+static double get_seconds(void) {
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (double)tv.tv_sec + ((double)tv.tv_usec / 1000000.0);
+}
+
+
+static int random_number(int n) {
+
+	return (int)(random() % n);
+}
+
+
+/* adds a few time ranges to a weekday or a date range, some of them empty or whole days */
+static void add_random_timeranges(timeperiod *tperiod, int day, daterange *drange) {
+	unsigned long start = 0L;
+	unsigned long end = 0L;
+	int n = 0;
+	int x = 0;
+
+	for (x = 0, n = random_number(4); x < n; x++) {
+
+		if (random_number(10) == 0)
+			start = end = 0L;
+		else if (random_number(6) == 0) {
+			start = 0L;
+			end = 86400L;
+		} else {
+			start = random_number(24 * 60) * 60;
+			end = start + random_number(24 * 60 - (start / 60) + 1) * 60;
+		}
+
+		if (drange != NULL)
+			add_timerange_to_daterange(drange, start, end);
+		else
+			add_timerange_to_timeperiod(tperiod, day, start, end);
+	}
+
+	return;
+}
+
+
+/* builds the time periods - exclusions refer to earlier ones, some of the later ones get excluded by the first */
+static int make_timeperiods(int count, int year) {
+	timeperiodexclusion *temp_exclusion = NULL;
+	timeperiod *tperiod = NULL;
+	daterange *drange = NULL;
+	char name[32];
+	int skip = 0;
+	int type = 0;
+	int n = 0;
+	int x = 0;
+	int y = 0;
+
+	if ((bench_periods = (timeperiod **)calloc(count, sizeof(timeperiod *))) == NULL)
+		return ERROR;
+
+	for (x = 0; x < count; x++) {
+
+		snprintf(name, sizeof(name), "tp%d", x);
+		if ((tperiod = add_timeperiod(name, name)) == NULL)
+			return ERROR;
+		bench_periods[bench_period_count++] = tperiod;
+
+		for (y = 0; y < 7; y++) {
+			if (random_number(3))
+				add_random_timeranges(tperiod, y, NULL);
+		}
+
+		for (y = 0, n = random_number(5); y < n; y++) {
+
+			type = random_number(DATERANGE_TYPES);
+			skip = random_number(3) ? 0 : 1 + random_number(5);
+
+			switch (type) {
+			case DATERANGE_CALENDAR_DATE:
+				drange = add_exception_to_timeperiod(tperiod, type, year + random_number(2), random_number(12), 1 + random_number(28), 0, 0, year + random_number(2), random_number(12), 1 + random_number(31), 0, 0, skip);
+				break;
+			case DATERANGE_MONTH_DATE:
+				drange = add_exception_to_timeperiod(tperiod, type, 0, random_number(12), 1 + random_number(28), 0, 0, 0, random_number(12), random_number(4) ? 1 + random_number(31) : -1 - random_number(3), 0, 0, skip);
+				break;
+			case DATERANGE_MONTH_DAY:
+				drange = add_exception_to_timeperiod(tperiod, type, 0, 0, 1 + random_number(28), 0, 0, 0, 0, random_number(4) ? 1 + random_number(31) : -1 - random_number(3), 0, 0, skip);
+				break;
+			case DATERANGE_MONTH_WEEK_DAY:
+				drange = add_exception_to_timeperiod(tperiod, type, 0, random_number(12), 0, random_number(7), 1 + random_number(4), 0, random_number(12), 0, random_number(7), random_number(4) ? 1 + random_number(5) : -1, skip);
+				break;
+			default:
+				drange = add_exception_to_timeperiod(tperiod, type, 0, 0, 0, random_number(7), 1 + random_number(4), 0, 0, 0, random_number(7), random_number(4) ? 1 + random_number(5) : -1, skip);
+				break;
+			}
+
+			if (drange != NULL)
+				add_random_timeranges(tperiod, 0, drange);
+		}
+
+		for (y = 0, n = (x == 0) ? 0 : random_number(4); y < n; y++) {
+			snprintf(name, sizeof(name), "tp%d", random_number(x));
+			add_exclusion_to_timeperiod(tperiod, name);
+		}
+
+		if (x > 2 && random_number(20) == 0) {
+			snprintf(name, sizeof(name), "tp%d", x);
+			add_exclusion_to_timeperiod(bench_periods[0], name);
+		}
+	}
+
+	/* what pre_flight_check() does for the core */
+	for (tperiod = timeperiod_list; tperiod != NULL; tperiod = tperiod->next) {
+		for (temp_exclusion = tperiod->exclusions; temp_exclusion != NULL; temp_exclusion = temp_exclusion->next)
+			temp_exclusion->timeperiod_ptr = find_timeperiod(temp_exclusion->timeperiod_name);
+	}
+
+	return OK;
+}
+
+
+static void set_time_zone(char *zone) {
+
+	setenv("TZ", zone, 1);
+	tzset();
+
+	/* cached intervals are absolute times computed in the old zone */
+	free_timeperiod_caches();
+
+	return;
+}
+
+
+/* checks the cached valid times against the time period rules */
+static int verify_timeperiods(time_t base_time) {
+	timeperiod *tperiod = NULL;
+	time_t test_time = 0L;
+	time_t valid_time = 0L;
+	time_t search_time = 0L;
+	time_t old_valid_time = 0L;
+	unsigned long checks = 0L;
+	int mismatches = 0;
+	int next_valid_times = 0;
+	int next_valid_mismatches = 0;
+	int old_differences = 0;
+	int x = 0;
+	int y = 0;
+	int z = 0;
+
+	srandom(42);
+
+	for (z = 0; bench_zones[z] != NULL; z++) {
+
+		set_time_zone(bench_zones[z]);
+
+		for (x = 0; x < bench_period_count; x++) {
+
+			tperiod = bench_periods[x];
+
+			/* times on and next to minute boundaries over 400 days */
+			for (y = 0; y < BENCH_VERIFY_CHECKS; y++) {
+				test_time = base_time + (time_t)random_number(400) * 86400 + (time_t)random_number(26 * 60) * 60 + random_number(3) - 1 - 3600;
+				checks++;
+				if (check_time_against_period(test_time, tperiod) != check_time_against_period_uncached(test_time, tperiod) && mismatches++ < 10)
+					printf("%s: %s at %lu is %s in the cache\n", bench_zones[z], tperiod->name, (unsigned long)test_time, (check_time_against_period(test_time, tperiod) == OK) ? "valid" : "invalid");
+			}
+
+			/* valid times start on a minute or a second after (when an exclusion ends) */
+			for (y = 0; y < BENCH_VERIFY_NEXT_VALID; y++) {
+
+				test_time = base_time + (time_t)random_number(370 * 86400);
+				valid_time = 0L;
+				get_next_valid_time(test_time, &valid_time, tperiod);
+
+				search_time = test_time;
+				if (check_time_against_period_uncached(search_time, tperiod) == ERROR) {
+					for (search_time = test_time - (test_time % 60) + 60; search_time < test_time + BENCH_SEARCH_DAYS * 86400; search_time += 60) {
+						if (check_time_against_period_uncached(search_time, tperiod) == OK)
+							break;
+						if (check_time_against_period_uncached(search_time + 1, tperiod) == OK) {
+							search_time++;
+							break;
+						}
+					}
+				}
+
+				if (search_time >= test_time + BENCH_SEARCH_DAYS * 86400)
+					continue;
+
+				next_valid_times++;
+				if (valid_time != search_time && next_valid_mismatches++ < 10)
+					printf("%s: next valid time of %s after %lu is %lu, searching finds %lu\n", bench_zones[z], tperiod->name, (unsigned long)test_time, (unsigned long)valid_time, (unsigned long)search_time);
+
+				if (check_time_against_period_uncached(test_time, tperiod) == ERROR) {
+					old_valid_time = 0L;
+					get_earliest_time(test_time, &old_valid_time, test_time, tperiod, 0);
+					if (old_valid_time != search_time)
+						old_differences++;
+				}
+			}
+		}
+	}
+
+	printf("%lu checked times: %d mismatches, %d next valid times: %d mismatches (%d without the cache)\n", checks, mismatches, next_valid_times, next_valid_mismatches, old_differences);
+
+	return (mismatches == 0 && next_valid_mismatches == 0) ? OK : ERROR;
+}
+
+
+/* times checks of random times within three days against random time periods */
+static void time_checks(time_t base_time, int count, int cached) {
+	timeperiod *tperiod = NULL;
+	time_t test_time = 0L;
+	double t0, t1;
+	int valid = 0;
+	int x = 0;
+
+	srandom(7);
+
+	t0 = get_seconds();
+
+	for (x = 0; x < count; x++) {
+		tperiod = bench_periods[random_number(bench_period_count)];
+		test_time = base_time + random_number(3 * 86400);
+		if (cached == TRUE)
+			valid += (check_time_against_period(test_time, tperiod) == OK);
+		else
+			valid += (check_time_against_period_uncached(test_time, tperiod) == OK);
+	}
+
+	t1 = get_seconds();
+
+	printf("%-38s %9d calls: %7.2f s (%8.0f ns/call, %d valid)\n", (cached == TRUE) ? "check_time_against_period, cached" : "check_time_against_period, uncached", count, t1 - t0, (t1 - t0) * 1000000000.0 / count, valid);
+
+	return;
+}
+
+
+/* times looking up the next valid time, the way it was done before the cache and with it */
+static void time_next_valid_times(time_t base_time, int count, int cached) {
+	timeperiod *tperiod = NULL;
+	time_t test_time = 0L;
+	time_t valid_time = 0L;
+	double t0, t1;
+	int x = 0;
+
+	srandom(9);
+
+	t0 = get_seconds();
+
+	for (x = 0; x < count; x++) {
+		tperiod = bench_periods[random_number(bench_period_count)];
+		test_time = base_time + random_number(3 * 86400);
+		valid_time = 0L;
+		if (cached == TRUE)
+			get_next_valid_time(test_time, &valid_time, tperiod);
+		else if (check_time_against_period_uncached(test_time, tperiod) == ERROR)
+			get_earliest_time(test_time, &valid_time, test_time, tperiod, 0);
+	}
+
+	t1 = get_seconds();
+
+	printf("%-38s %9d calls: %7.2f s (%8.0f ns/call)\n", (cached == TRUE) ? "next valid time, cached" : "next valid time, uncached", count, t1 - t0, (t1 - t0) * 1000000000.0 / count);
+
+	return;
+}
+
+
+int main(int argc, char **argv) {
+	struct tm tm_s;
+	time_t base_time = 0L;
+	int periods = 60;
+	int checks = 2000000;
+	int result = OK;
+
+	if (argc > 1)
+		periods = atoi(argv[1]);
+	if (argc > 2)
+		checks = atoi(argv[2]);
+	if (periods <= 0 || checks <= 0) {
+		printf("usage: %s [<timeperiods> [<checks>]]\n", argv[0]);
+		return ERROR;
+	}
+
+	/* start tomorrow, the next valid time is never looked for in the past */
+	time(&base_time);
+	base_time += 86400 - (base_time % 86400);
+	gmtime_r(&base_time, &tm_s);
+
+	init_object_skiplists();
+	srandom(42);
+	if (make_timeperiods(periods, tm_s.tm_year + 1900) == ERROR) {
+		printf("Could not create the time periods\n");
+		return ERROR;
+	}
+
+	if (verify_timeperiods(base_time) == ERROR)
+		result = ERROR;
+
+	set_time_zone("Europe/Berlin");
+
+	time_checks(base_time, checks, FALSE);
+	time_checks(base_time, checks, TRUE);
+	time_next_valid_times(base_time, checks / 10, FALSE);
+	time_next_valid_times(base_time, checks / 10, TRUE);
+
+	free_timeperiod_caches();
+	my_free(bench_periods);
+
+	return (result == OK) ? 0 : 1;
+}
@@ -52,6 +52,7 @@ extern "C" {
 */
 #define MAX_PLUGIN_OUTPUT_LENGTH                8192    /* max length of plugin output (including perf data) */
 #define MAX_CMD_ARGS 				4096	/* max number of arguments for command call on plugin */
+#define CHECK_RESULT_CHANNEL_MAX_MESSAGE	65536	/* larger check results go through the check result queue directory */
 
 
 /******************* DEFAULT VALUES *******************/
@@ -151,6 +152,17 @@ extern "C" {
 
 #define DEFAULT_MAX_CHECK_RESULT_LIST_ITEMS              	0	/* max items in checkresult lists, where reaper will not process anymore files into the lists. 0 means *all* */
 
+#define DEFAULT_CHECK_WORKER_PROCESSES				0	/* don't use persistent check workers by default, fork() for every check */
+#define DEFAULT_CHECK_WORKER_QUEUE_DEPTH			256	/* max number of checks a single check worker runs concurrently */
+
+#define DEFAULT_USE_CHECK_RESULT_CHANNEL			0	/* pass check results through the check result queue directory by default */
+
+#define DEFAULT_CHECK_RESULT_REAPER_THREADS			0	/* process check results on the main thread only by default */
+#define CHECK_RESULT_REAPER_BATCH_SIZE				1024	/* max number of check results handed to the reaper threads at once */
+
+#define TIMEPERIOD_CACHE_MAX_DAYS				366	/* max number of days of valid times cached per timeperiod (and looked ahead for the next valid time) */
+#define TIMEPERIOD_INTERVAL_GROWTH				16	/* number of valid intervals a timeperiod cache grows by */
+
 /******************** HOST STATUS *********************/
 
 #define HOST_UP				0
@@ -396,6 +408,41 @@ typedef struct dbuf_struct{
 	unsigned long chunk_size;
         }dbuf;
 
+/* CHECK_WORKER structure - persistent process executing active checks on behalf of the core */
+typedef struct check_worker_struct{
+	int id;
+	pid_t pid;
+	int sd;                                         /* our end of the socket pair connected to the worker */
+	char *buf;                                      /* partial check result messages read from the worker */
+	unsigned long buf_used;
+	unsigned long buf_size;
+	int running_checks;
+	unsigned long total_checks;
+	unsigned long timed_out_checks;
+	unsigned long restarts;
+	time_t start_time;
+        }check_worker;
+
+/* DECODED_CHECK_RESULT structure - check result with its object looked up and output parsed by a reaper thread */
+typedef struct decoded_check_result_struct{
+	check_result *cr;
+	host *hst;
+	service *svc;
+	int output_parsed;
+	char *short_output;
+	char *long_output;
+	char *perf_data;
+	int is_decoded;
+        }decoded_check_result;
+
+/* TIMEPERIOD_INTERVAL structure - a range of valid times [start, end) of a timeperiod */
+typedef struct timeperiod_interval_struct{
+	time_t start;
+	time_t end;
+        }timeperiod_interval;
+
+typedef struct timeperiod_cache_struct timeperiod_cache;	/* cached valid intervals of a timeperiod, see base/utils.c */
+
 int init_registered_fds(void);
 int register_fd(int fd);
 int deregister_fd(int fd);
@@ -417,6 +464,10 @@ typedef struct check_stats_struct{
 /* slots in circular buffers */
 #define DEFAULT_EXTERNAL_COMMAND_BUFFER_SLOTS     4096
 
+/* blocks of lines handed from the command file worker thread to the main thread */
+#define COMMAND_FILE_RING_SLOTS                   256
+#define COMMAND_FILE_READ_SIZE                    65536
+
 /* worker threads */
 #define TOTAL_WORKER_THREADS              1
 
@@ -456,16 +507,25 @@ void adjust_check_scheduling(void);		        	/* auto-adjusts scheduling of host
 void compensate_for_system_time_change(unsigned long,unsigned long);	/* attempts to compensate for a change in the system time */
 void adjust_timestamp_for_time_change(time_t,time_t,unsigned long,time_t *); /* adjusts a timestamp variable for a system time change */
 void resort_event_list(timed_event **,timed_event **);                 	/* resorts event list by event run time for system time changes */
+void free_event_list_slots(void);					/* frees the run time index of the event lists */
 
 
 /**** IPC Functions ****/
 int move_check_result_to_queue(char *);
 int process_check_result_queue(char *);
 int process_check_result_file(char *);
+int set_check_result_var(check_result *,char *,char *);		/* sets a check result attribute from a var=value pair */
+int open_check_result_channel(void);				/* opens the in-memory channel check processes pass their results through */
+int close_check_result_channel(void);				/* closes the check result channel, pending results are moved to the queue directory */
+int read_check_result_channel(void);				/* adds check results received over the channel to the check result list */
+check_result *parse_check_result_message(char *);		/* converts var=value lines into a new check result */
+int submit_check_result(check_result *,char *);			/* passes a finished check result to the reaper */
+int submit_check_result_message(char *);			/* passes check result var=value lines to the reaper */
 int add_check_result_to_list(check_result *);
 check_result *read_check_result(void);                  	/* reads a host/service check result from the list in memory */
 int delete_check_result_file(char *);
 int free_check_result_list(void);
+unsigned long get_check_result_list_items(void);				/* returns the number of check results waiting in memory */
 int init_check_result(check_result *);
 int free_check_result(check_result *);                  	/* frees memory associated with a host/service check result */
 int parse_check_output(char *,char **,char **,char **,int,int);
@@ -482,6 +542,9 @@ void check_service_result_freshness(void);              	/* checks the "freshnes
 int is_service_result_fresh(service *,time_t,int);              /* determines if a service's check results are fresh */
 void check_host_result_freshness(void);                 	/* checks the "freshness" of host check results */
 int is_host_result_fresh(host *,time_t,int);                    /* determines if a host's check results are fresh */
+void update_service_freshness(service *);			/* requeues a service for freshness checking after its results or settings changed */
+void update_host_freshness(host *);				/* requeues a host for freshness checking after its results or settings changed */
+void free_check_queues(void);					/* frees the freshness and running check queues */
 int my_system(char *,int,int *,double *,char **,int);         	/* executes a command via popen(), but also protects against timeouts */
 int my_system_r(icinga_macros *mac, char *,int,int *,double *,char **,int); /* thread-safe version of the above */
 
@@ -515,6 +578,7 @@ int execute_sync_host_check_3x(host *);
 int run_scheduled_host_check_3x(host *,int,double);
 int run_async_host_check_3x(host *,int,double,int,int,int *,time_t *);
 int handle_async_host_check_result_3x(host *,check_result *);
+int handle_decoded_host_check_result_3x(host *,check_result *,decoded_check_result *);
 
 
 /**** Service Check Functions ****/
@@ -522,6 +586,7 @@ int check_service_check_viability(service *,int,int *,time_t *);
 int run_scheduled_service_check(service *,int,double);
 int run_async_service_check(service *,int,double,int,int,int *,time_t *);
 int handle_async_service_check_result(service *,check_result *);
+int handle_decoded_service_check_result(service *,check_result *,decoded_check_result *);
 
 
 /**** Event Handler Functions ****/
@@ -531,6 +596,27 @@ int handle_host_state(host *);               			/* top level host state handler
 
 /**** Common Check Fucntions *****/
 int reap_check_results(void);
+int parse_command_line(char *,char *[MAX_CMD_ARGS]);				/* converts a command line to an argument array suitable for exec*() */
+void init_decoded_check_result(decoded_check_result *,check_result *);
+int decode_check_result(decoded_check_result *);		/* looks up the object and parses the output of a check result (thread-safe) */
+void take_decoded_check_output(decoded_check_result *,char **,char **,char **);
+void free_decoded_check_result(decoded_check_result *);
+
+
+/**** Check Result Reaper Thread Functions ****/
+int init_check_result_reaper_threads(void);			/* starts the check result reaper threads */
+int shutdown_check_result_reaper_threads(void);			/* stops the check result reaper threads */
+int queue_check_results_for_decoding(decoded_check_result *,int);	/* hands a batch of check results to the reaper threads */
+decoded_check_result *get_decoded_check_result(int);		/* returns a decoded check result of the current batch */
+int finish_check_result_decoding(void);				/* waits for the reaper threads to finish the current batch */
+
+
+/**** Check Worker Functions ****/
+int init_check_workers(void);					/* starts the persistent check worker processes */
+int shutdown_check_workers(void);				/* disconnects from the check workers, which exit once their running checks are done */
+int run_check_via_worker(check_result *,int,char *,icinga_macros *);	/* hands an active check over to a check worker */
+int read_check_worker_results(void);				/* moves check results received from the workers to the check result list */
+int reap_check_worker_results(void);				/* restarts failed check workers and reads their results */
 
 
 /**** Check Statistics Functions ****/
@@ -603,7 +689,13 @@ extern int get_raw_command_line_r(icinga_macros *mac, command *,char *,char **,i
  */
 extern int get_raw_command_line(command *,char *,char **,int);
 
+int get_processed_command_line_r(icinga_macros *mac, command *,char *,char **,int);	/* given a raw command line, returns the command line with all macros processed */
+void compile_command_templates(void);			/* parses the command lines of all commands into macro templates */
+void free_command_templates(void);			/* frees the macro templates of all commands */
+
 int check_time_against_period(time_t,timeperiod *);	/* check to see if a specific time is covered by a time period */
+int check_time_against_period_uncached(time_t,timeperiod *);	/* same, evaluating the time period's rules instead of its cached valid times */
+void free_timeperiod_caches(void);			/* frees the cached valid times of all time periods */
 int is_daterange_single_day(daterange *);
 time_t calculate_time_from_weekday_of_month(int,int,int,int);	/* calculates midnight time of specific (3rd, last, etc.) weekday of a particular month */
 time_t calculate_time_from_day_of_month(int,int,int);	/* calculates midnight time of specific (1st, last, etc.) day of a particular month */
@@ -624,6 +716,7 @@ int set_environment_var(char *,char *,int);             /* sets/clears and envir
 /**** External Command Functions ****/
 int check_for_external_commands(void);			/* checks for any external commands */
 int process_external_command1(char *);                  /* top-level external command processor */
+int get_external_command_type(const char *,int *);	/* looks up the type of an external command by name */
 int process_external_command2(int,time_t,char *);	/* process an external command */
 int process_external_commands_from_file(char *,int);    /* process external commands in a file */
 int process_host_command(int,time_t,char *);            /* process an external host command */
@@ -734,6 +827,8 @@ int init_command_file_worker_thread(void);
 int shutdown_command_file_worker_thread(void);
 void * command_file_worker_thread(void *);
 void cleanup_command_file_worker_thread(void *);
+char *get_command_file_block(void);
+void get_command_file_ring_usage(int *,int *);
 
 int submit_external_command(char *,int *);
 int submit_raw_external_command(char *,time_t *,int *);
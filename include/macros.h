@@ -242,6 +242,33 @@ typedef struct nagios_macros nagios_macros;
 #define URL_ENCODE_MACRO_CHARS		4
 
 
+/************** MACRO TEMPLATE TOKENS ****************/
+
+#define MACRO_TOKEN_TEXT		0	/* literal text */
+#define MACRO_TOKEN_ARGV		1	/* $ARGn$ */
+#define MACRO_TOKEN_USER		2	/* $USERn$ */
+#define MACRO_TOKEN_MACROX		3	/* a macro x without arguments */
+#define MACRO_TOKEN_OTHER		4	/* anything else, looked up by name when expanded */
+
+/* MACRO TEMPLATE structures - a string split into literal text and macros once, so it can be expanded over and over */
+typedef struct macro_token_struct {
+	int type;
+	int index;				/* argv or user macro index, or macro x code */
+	int clean_options;			/* clean options of macro x tokens */
+	int terminated;				/* FALSE if the string ended within the macro */
+	char *text;				/* literal text or macro name */
+	size_t length;				/* length of literal text */
+} macro_token;
+
+struct macro_template_struct {
+	char *buffer;				/* copy of the string the tokens point into */
+	macro_token *tokens;
+	int count;
+	size_t expanded_size;			/* size of the largest expansion so far, to allocate the output buffer once */
+};
+typedef struct macro_template_struct macro_template;
+
+
 
 /****************** MACRO FUNCTIONS ******************/
 
@@ -257,6 +284,11 @@ int process_macros(char *, char **, int);
 /* thread-safe version of the above */
 int process_macros_r(icinga_macros *mac, char *,char **,int);
 
+/* same as process_macros_r(), with the string parsed beforehand */
+macro_template *compile_macro_template(char *);
+int process_macro_template_r(icinga_macros *mac, macro_template *,char **,int);
+void free_macro_template(macro_template *);
+
 /* cleans macros characters before insertion into output string */
 char *clean_macro_chars(char *,int);
 
@@ -353,6 +385,8 @@ int set_custom_macro_environment_vars_r(icinga_macros *mac, int);
 int set_contact_address_environment_vars_r(icinga_macros *mac, int);
 
 int set_macro_environment_var(char *,char *,int);
+
+char **get_macro_environment_r(icinga_macros *mac);             /* returns the environment macros as one block of "ICINGA_<macro>=<value>" strings */
 #endif
 
 #endif
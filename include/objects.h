@@ -145,6 +145,9 @@ typedef struct timeperiod_struct{
 	timeperiodexclusion *exclusions;
 	struct 	timeperiod_struct *next;
 	struct 	timeperiod_struct *nexthash;
+#ifdef NSCORE
+	struct	timeperiod_cache_struct *cache;			/* valid times compiled by the core */
+#endif
 	}timeperiod;
 
 
@@ -193,6 +196,9 @@ typedef struct command_struct{
 	char    *command_line;
 	struct command_struct *next;
 	struct command_struct *nexthash;
+#ifdef NSCORE
+	struct	macro_template_struct *compiled_command_line;	/* command line parsed by the core */
+#endif
         }command;
 
 
@@ -424,6 +430,8 @@ struct host_struct{
 #ifdef NSCORE
 	int     current_down_notification_number;
 	int     current_unreachable_notification_number;
+	int     freshness_queue_index;		/* position in the freshness queue, -1 if not queued */
+	int     running_queue_index;		/* position in the running checks queue, -1 if no check is running */
 #endif
 	DECLARE_HASH(name);
         };
@@ -569,6 +577,8 @@ struct service_struct{
 	int     current_warning_notification_number;
 	int     current_critical_notification_number;
 	int     current_unknown_notification_number;
+	int     freshness_queue_index;		/* position in the freshness queue, -1 if not queued */
+	int     running_queue_index;		/* position in the running checks queue, -1 if no check is running */
 #endif
 	DECLARE_HASH(host_name);
 	DECLARE_HASH(description);
@@ -798,6 +808,7 @@ int add_module_objects_to_neb(void);									/* add modules to neb, backwards co
 /*** Object Skiplist Functions ****/
 int init_object_skiplists(void);
 int free_object_skiplists(void);
+unsigned long object_hash_key(const char *,const char *);		/* computes the hash index key of an object name */
 int skiplist_compare_text(const char *val1a, const char *val1b, const char *val2a, const char *val2b);
 int skiplist_compare_host(void *a, void *b);
 int skiplist_compare_service(void *a, void *b);
@@ -821,6 +832,7 @@ int get_service_count(void);
 /**** Object Search Functions ****/
 timeperiod * find_timeperiod(char *);						                /* finds a timeperiod object */
 host * find_host(char *);									/* finds a host object */
+host * find_host_by_address(char *);								/* finds the first host object using an IPv4/IPv6 address */
 hostgroup * find_hostgroup(char *);						                /* finds a hostgroup object */
 servicegroup * find_servicegroup(char *);					                /* finds a servicegroup object */
 contact * find_contact(char *);							                /* finds a contact object */
@@ -60,6 +60,7 @@ void *skiplist_get_first(skiplist *list, void **node_ptr);
 void *skiplist_get_next(void **node_ptr);
 void *skiplist_find_first(skiplist *list, void *data, void **node_ptr);
 void *skiplist_find_next(skiplist *list, void *data, void **node_ptr);
+void *skiplist_find_floor(skiplist *list, void *data, void **node_ptr);
 int skiplist_delete(skiplist *list, void *data);
 int skiplist_delete_first(skiplist *list, void *data);
 int skiplist_delete_all(skiplist *list, void *data);
@@ -35,6 +35,11 @@ typedef struct ido2db_dbconfig_struct{
 	unsigned long max_downtimehistory_age;
 	unsigned long trim_db_interval;
 	unsigned long housekeeping_thread_startup_delay;
+	unsigned long housekeeping_chunk_size;
+	unsigned long housekeeping_rows_per_second;
+	int housekeeping_drop_partitions;
+	int insert_batch_size;
+	unsigned long status_flush_interval;
         unsigned long clean_realtime_tables_on_core_startup;
         unsigned long clean_config_tables_on_core_startup;
 	unsigned long oci_errors_to_syslog;
@@ -155,6 +160,7 @@ char *ido2db_db_escape_string(ido2db_idi *,char *);
 char *ido2db_db_timet_to_sql(ido2db_idi *,time_t);
 char *ido2db_db_sql_to_timet(ido2db_idi *,char *);
 int ido2db_db_query(ido2db_idi *,char *);
+int ido2db_db_query_prepared(ido2db_idi *,int,int,char *,char *,char *);
 int ido2db_db_free_query(ido2db_idi *);
 int ido2db_handle_db_error(ido2db_idi *);
 
@@ -162,9 +168,15 @@ int ido2db_db_clear_table(ido2db_idi *,char *);
 int ido2db_db_get_latest_data_time(ido2db_idi *,char *,char *,unsigned long *);
 int ido2db_db_perform_maintenance(ido2db_idi *);
 int ido2db_db_trim_data_table(ido2db_idi *,char *,char *,unsigned long);
+int ido2db_db_trim_data_table_chunk(ido2db_idi *,char *,char *,char *,unsigned long,unsigned long,unsigned long *);
+int ido2db_db_drop_data_partitions(ido2db_idi *,char *,char *,unsigned long,unsigned long *);
 
 void ido2db_db_txbuf_init(ido2db_txbuf *txbuf);
 void ido2db_db_txbuf_add_id_to_activate(ido2db_txbuf *txbuf, unsigned long);
+void ido2db_db_txbuf_free(ido2db_txbuf *txbuf);
+int ido2db_db_txbuf_flush_inserts(ido2db_idi *idi, ido2db_txbuf *txbuf, int batch);
+int ido2db_db_txbuf_add_insert(ido2db_idi *idi, int batch, int table, char *columns, char *values);
+int ido2db_db_txbuf_has_insert(ido2db_txbuf *txbuf, int batch, char *values);
 void ido2db_db_txbuf_flush(ido2db_idi *idi, ido2db_txbuf *txbuf);
 
 int ido2db_db_tx_begin(ido2db_idi *idi);
@@ -21,6 +21,11 @@ int ido2db_get_cached_object_id(ido2db_idi *,int,char *,char *,unsigned long *);
 int ido2db_add_cached_object_id(ido2db_idi *,int,char *,char *,unsigned long);
 int ido2db_free_cached_object_ids(ido2db_idi *);
 
+int ido2db_status_cache_add(ido2db_idi *,int,unsigned long);
+int ido2db_status_cache_flush(ido2db_idi *,int);
+int ido2db_status_cache_free(ido2db_idi *);
+time_t ido2db_status_cache_next_flush(ido2db_idi *);
+
 int ido2db_object_hashfunc(const char *,const char *,int);
 int ido2db_compare_object_hashdata(const char *,const char *,const char *,const char *);
 
@@ -79,6 +79,31 @@ typedef struct ido2db_dbobject_struct{
 	struct ido2db_dbobject_struct *nexthash;
         }ido2db_dbobject;
 
+/* object ids of one instance, shared by all its connections */
+typedef struct ido2db_object_cache_struct{
+	unsigned long instance_id;
+	int refs;
+	int loaded;
+	pthread_mutex_t load_lock;	/* held while the ids are loaded, so others wait for them */
+	pthread_rwlock_t lock;
+	ido2db_dbobject **hashlist;
+	struct ido2db_object_cache_struct *next;
+        }ido2db_object_cache;
+
+
+/* history tables written with multi-row inserts */
+#define IDO2DB_INSERT_BATCH_SERVICECHECKS	0
+#define IDO2DB_INSERT_BATCH_HOSTCHECKS		1
+#define IDO2DB_INSERT_BATCH_STATEHISTORY	2
+#define IDO2DB_INSERT_BATCH_LOGENTRIES		3
+#define IDO2DB_MAX_INSERT_BATCHES		4
+
+/* statements prepared once per connection (PostgreSQL), single row inserts use the batch numbers */
+#define IDO2DB_PREPARED_HOSTSTATUS_UPDATE	(IDO2DB_MAX_INSERT_BATCHES + 0)
+#define IDO2DB_PREPARED_HOSTSTATUS_INSERT	(IDO2DB_MAX_INSERT_BATCHES + 1)
+#define IDO2DB_PREPARED_SERVICESTATUS_UPDATE	(IDO2DB_MAX_INSERT_BATCHES + 2)
+#define IDO2DB_PREPARED_SERVICESTATUS_INSERT	(IDO2DB_MAX_INSERT_BATCHES + 3)
+#define IDO2DB_MAX_PREPARED_STATEMENTS		(IDO2DB_MAX_INSERT_BATCHES + 4)
 
 typedef struct ido2db_dbconninfo_struct{
 	int server_type;
@@ -218,23 +243,69 @@ typedef struct ido2db_dbconninfo_struct{
 	unsigned long max_downtimehistory_age;
 	unsigned long trim_db_interval;
 	unsigned long housekeeping_thread_startup_delay;
+	unsigned long housekeeping_chunk_size;
+	unsigned long housekeeping_rows_per_second;
+	int housekeeping_drop_partitions;
+	int insert_batch_size;
+	unsigned long status_flush_interval;
 	unsigned long clean_realtime_tables_on_core_startup;
 	unsigned long clean_config_tables_on_core_startup;
 	unsigned long oci_errors_to_syslog;
 	time_t last_table_trim_time;
+	int trim_table;				/* table of the trimming pass in progress, -1 if none */
+	unsigned long trim_table_chunks;
+	time_t trim_pass_time;			/* the ages count from the start of the pass */
+	struct timeval trim_next_chunk;		/* when the rows per second budget allows the next delete */
+	unsigned long trim_rows;		/* progress of the pass */
+	unsigned long trim_chunks;
+	unsigned long trim_partitions;
 	time_t last_logentry_time;
 	char *last_logentry_data;
 	char *dbversion;
-	ido2db_dbobject **object_hashlist;
+	ido2db_object_cache *object_cache;
+	int prepared[IDO2DB_MAX_PREPARED_STATEMENTS];
         }ido2db_dbconninfo;
 
 typedef struct ido2db_txbuf_struct{
 	unsigned long *ids_to_activate;
 	int ids_to_activate_count;
+	ido_dbuf inserts[IDO2DB_MAX_INSERT_BATCHES];	/* pending multi-row inserts */
+	int insert_rows[IDO2DB_MAX_INSERT_BATCHES];
+	unsigned long *insert_row_offsets[IDO2DB_MAX_INSERT_BATCHES];	/* where each row starts, to insert them one by one if the batch fails */
+	int insert_row_offsets_size[IDO2DB_MAX_INSERT_BATCHES];
 	}ido2db_txbuf;
 
+/* newest status update of an object, waiting to be written */
+typedef struct ido2db_status_entry_struct{
+	int object_type;
+	unsigned long object_id;
+	int data_count;
+	int *data_types;			/* buffered_input slots of the update */
+	char **data;
+	struct ido2db_status_entry_struct *nexthash;
+	struct ido2db_status_entry_struct *next;
+	}ido2db_status_entry;
+
+typedef struct ido2db_status_cache_struct{
+	ido2db_status_entry **hashlist;
+	ido2db_status_entry *head;		/* write order */
+	ido2db_status_entry *tail;
+	time_t last_flush_time;
+	int flushing;
+	unsigned long updates;			/* status updates cached */
+	unsigned long coalesced;		/* replaced before they were written */
+	}ido2db_status_cache;
+
 typedef struct ido2db_input_data_info_struct{
 	int protocol_version;
+	int client_sd;				/* to answer the hello options, -1 if there's no way back */
+	int binary_encoding;
+	int compressed_input;			/* everything after the hello is a zlib stream */
+	unsigned long compressed_bytes;
+	unsigned long uncompressed_bytes;
+#ifdef HAVE_ZLIB_H
+	z_stream *zstream;
+#endif
 	int disconnect_client;
 	int ignore_client_data;
 	char *instance_name;
@@ -257,9 +328,27 @@ typedef struct ido2db_input_data_info_struct{
 	ido2db_mbuf mbuf[IDO2DB_MAX_MBUF_ITEMS];
 	ido2db_dbconninfo dbinfo;
 	ido2db_txbuf txbuf;
+	ido2db_status_cache status_cache;
 	int in_transaction;
         }ido2db_idi;
 
+/* a client connection served by the db writer threads */
+typedef struct ido2db_client_struct{
+	int sd;
+	int state;
+	int initialized;
+	time_t connect_time;
+	ido_dbuf dbuf;
+	ido2db_idi idi;
+	struct ido2db_client_struct *next;
+	struct ido2db_client_struct *next_queued;
+	}ido2db_client;
+
+#define IDO2DB_CLIENT_IDLE				0	/* waiting in epoll */
+#define IDO2DB_CLIENT_QUEUED				1	/* waiting for a writer thread */
+#define IDO2DB_CLIENT_BUSY				2	/* owned by a writer thread */
+#define IDO2DB_CLIENT_CLOSED				3	/* waiting to be freed */
+
 typedef struct ido2db_proxy_struct {
 	pthread_mutex_t mutex;
 	size_t size_left;
@@ -302,6 +391,7 @@ typedef struct ido2db_proxy_args_struct{
 #define IDO2DB_INPUT_BUFFER                             1024
 /* #define IDO2DB_OBJECT_HASHSLOTS                         1024 */
 #define IDO2DB_OBJECT_HASHSLOTS                         50240	/* Altinity patch: Spread the list of linked lists thinner */
+#define IDO2DB_STATUS_HASHSLOTS                         16384
 
 
 /*********** types of input sections ***********/
@@ -394,6 +484,28 @@ typedef struct ido2db_proxy_args_struct{
 
 #define DEFAULT_HOUSEKEEPING_THREAD_STARTUP_DELAY 300
 
+/* chunked housekeeping deletes **************/
+
+#define DEFAULT_HOUSEKEEPING_CHUNK_SIZE		10000		/* rows per delete, 0 = one delete per table */
+#define IDO2DB_HOUSEKEEPING_SLICE		1000000		/* usecs of trimming per call before others get a turn */
+
+/********* batched history inserts ************/
+
+#define DEFAULT_INSERT_BATCH_SIZE		100		/* rows per insert, 1 = disabled */
+#define IDO2DB_INSERT_BATCH_MAX_BYTES		(256 * 1024)	/* keep below max_allowed_packet */
+#define IDO2DB_INSERT_BATCH_CHUNK_SIZE		16384
+#define IDO2DB_INSERT_BATCH_ROWS_GROWTH		128
+
+/********* status write-behind cache **********/
+
+#define DEFAULT_STATUS_FLUSH_INTERVAL		0		/* seconds, 0 = write right away */
+
+/********* db writer threads (0 = fork) ********/
+
+#define DEFAULT_DB_WRITER_THREADS		0
+#define IDO2DB_CLIENT_READ_BUDGET		(1024 * 1024)	/* bytes per dispatch */
+#define IDO2DB_CLIENT_MAX_EVENTS		64
+
 /************* oci errors to syslog ************/
 
 #define DEFAULT_OCI_ERRORS_TO_SYSLOG 		1
@@ -439,13 +551,17 @@ int ido2db_free_connection_memory(ido2db_idi *);
 int ido2db_wait_for_connections(void);
 int ido2db_handle_client_connection(int, ido2db_proxy *);
 int ido2db_idi_init(ido2db_idi *);
-int ido2db_check_for_client_input(ido2db_idi *);
+int ido2db_check_for_client_input(ido2db_idi *, ido_dbuf *);
+int ido2db_append_client_data(ido2db_idi *,ido_dbuf *,char *,unsigned long);
 int ido2db_handle_client_input(ido2db_idi *,char *);
+int ido2db_handle_client_binary_input(ido2db_idi *,char *,unsigned long);
+int ido2db_get_input_data_type(int);
 
 /* data handling */
 int ido2db_start_input_data(ido2db_idi *);
 int ido2db_end_input_data(ido2db_idi *);
 int ido2db_add_input_data_item(ido2db_idi *,int,char *);
+int ido2db_store_input_data_item(ido2db_idi *,int,char *);
 int ido2db_add_input_data_mbuf(ido2db_idi *,int,int,char *);
 
 /* conversion */
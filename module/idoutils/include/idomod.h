@@ -17,16 +17,35 @@
 #define IDOMOD_MAX_BUFLEN   				49152
 #define IDOMOD_MAX_TEXT_LEN				32768
 
+#define IDOMOD_SINK_BUFFER_ITEM_SIZE			2048	/* bytes per output_buffer_items slot, if output_buffer_size isn't set */
+#define IDOMOD_SINK_BUFFER_IOVECS			256	/* buffers per writev() when flushing */
+#define IDOMOD_WRITER_LOG_MESSAGES			16	/* log messages the writer thread may leave for the main thread */
+#define IDOMOD_WRITER_STATS_INTERVAL			60	/* seconds between writer statistics in the debug log */
+#define IDOMOD_HELLO_TIMEOUT				5	/* seconds ido2db has to answer the hello options, data is queued meanwhile */
+
 /************** structures *******************/
 
+/* header of a buffered item */
+typedef struct idomod_sink_item_struct{
+	unsigned int len;
+	int binary;				/* binary record, see protoapi.h */
+	struct timeval queued;
+        }idomod_sink_item;
+
+/* byte ring of buffered items */
 typedef struct idomod_sink_buffer_struct{
-	char **buffer;
+	char *buffer;
 	unsigned long size;
-	unsigned long head;
-	unsigned long tail;
-	unsigned long items;
-	unsigned long maxitems;
+	volatile unsigned long head;
+	volatile unsigned long tail;
+	volatile unsigned long items_in;
+	volatile unsigned long items_out;
 	unsigned long overflow;
+	char *mmap_file;			/* backing file, if mapped */
+	unsigned long written;			/* writer statistics */
+	unsigned long max_queued;
+	double total_latency;
+	double max_latency;
         }idomod_sink_buffer;
 
 
@@ -101,16 +120,19 @@ int idomod_process_config_file(char *);
 int idomod_open_sink(void);
 int idomod_close_sink(void);
 int idomod_write_to_sink(char *,int,int);
+int idomod_write_data_to_sink(char *,unsigned long,int,int,int);
+int idomod_start_writer_thread(void);
+int idomod_stop_writer_thread(void);
 int idomod_rotate_sink_file(void *);
 int idomod_hello_sink(int,int);
 int idomod_goodbye_sink(void);
 
-int idomod_sink_buffer_init(idomod_sink_buffer *sbuf,unsigned long);
+int idomod_sink_buffer_init(idomod_sink_buffer *sbuf,unsigned long,char *);
 int idomod_sink_buffer_deinit(idomod_sink_buffer *sbuf);
-int idomod_sink_buffer_push(idomod_sink_buffer *sbuf,char *);
-char *idomod_sink_buffer_peek(idomod_sink_buffer *sbuf);
-char *idomod_sink_buffer_pop(idomod_sink_buffer *sbuf);
-int idomod_sink_buffer_items(idomod_sink_buffer *sbuf);
+int idomod_sink_buffer_push(idomod_sink_buffer *sbuf,char *,unsigned long,int);
+char *idomod_sink_buffer_pop(idomod_sink_buffer *sbuf,int *);
+int idomod_sink_buffer_write(idomod_sink_buffer *sbuf,int,int);
+unsigned long idomod_sink_buffer_items(idomod_sink_buffer *sbuf);
 unsigned long idomod_sink_buffer_get_overflow(idomod_sink_buffer *sbuf);
 int idomod_sink_buffer_set_overflow(idomod_sink_buffer *sbuf,unsigned long);
 
@@ -42,9 +42,12 @@ char *ido_mmap_fgets(ido_mmapfile *);
 
 int ido_sink_open(char *,int,int,int,int,int *);
 int ido_sink_write(int,char *,int);
+int ido_sink_writev(int,struct iovec *,int,int *);
 int ido_sink_write_newline(int);
 int ido_sink_flush(int);
 int ido_sink_close(int);
+int ido_sink_start_compression(int);
+int ido_sink_end_compression(void);
 int ido_inet_aton(register const char *,struct in_addr *);
 
 void ido_strip_buffer(char *);
@@ -46,6 +46,13 @@
 
 #define IDO_API_INSTANCENAME                         "INSTANCENAME"
 
+#define IDO_API_ENCODING                             "ENCODING"     /* asked for by the client, answered by the server */
+#define IDO_API_ENCODING_BINARY                      "BINARY"
+#define IDO_API_ENCODING_TEXT                        "TEXT"
+#define IDO_API_COMPRESSION                          "COMPRESSION"  /* asked for by the client, answered by the server */
+#define IDO_API_COMPRESSION_ZLIB                     "ZLIB"         /* everything after this line is a zlib stream */
+#define IDO_API_COMPRESSION_NONE                     "NONE"
+
 #define IDO_API_STARTCONFIGDUMP                      900
 #define IDO_API_ENDCONFIGDUMP                        901
 #define IDO_API_ENDDATA                              999
@@ -53,6 +60,32 @@
 
 
 
+/***************** BINARY ENCODING *****************/
+
+/*
+ * With ENCODING: BINARY answered, data items may be sent as binary records
+ * instead of text lines.  A record starts at the beginning of a line with
+ * IDO_API_BINARY_RECORD, followed by the length of the whole record (4 bytes)
+ * and its data type (2 bytes), both in network byte order.  Each field starts
+ * with its data attribute and field type as a varint (attribute << 3 | type),
+ * followed by the value.  Varints hold 7 bits per byte, least significant
+ * first, the high bit set on all but the last byte.  Strings are not escaped.
+ * The record replaces the whole "type:" ... IDO_API_ENDDATA block of the text
+ * protocol.
+ */
+
+#define IDO_API_BINARY_RECORD                        0x1e
+#define IDO_API_BINARY_HEADER_SIZE                   7
+#define IDO_API_BINARY_MAX_RECORD_SIZE               (4 * 1024 * 1024)
+
+#define IDO_API_BINARY_INT                           1      /* varint, zigzag encoded */
+#define IDO_API_BINARY_ULONG                         2      /* varint */
+#define IDO_API_BINARY_DOUBLE                        3      /* 8 bytes IEEE 754, network byte order */
+#define IDO_API_BINARY_TIMEVAL                       4      /* varint seconds, varint microseconds */
+#define IDO_API_BINARY_STRING                        5      /* varint length, data */
+
+
+
 /******************** DATA TYPES *******************/
 
 #define IDO_API_LOGENTRY                             100
@@ -23,6 +23,12 @@ typedef struct ido_dbuf_struct{
 int ido_dbuf_init(ido_dbuf *,int);
 int ido_dbuf_free(ido_dbuf *);
 int ido_dbuf_strcat(ido_dbuf *,char *);
+int ido_dbuf_append(ido_dbuf *,char *,unsigned long);
+
+void ido_binary_put(char *,unsigned long long,int);
+unsigned long long ido_binary_get(char *,int);
+int ido_binary_put_varint(char *,unsigned long long);
+int ido_binary_get_varint(char *,char *,unsigned long long *);
 
 int my_rename(char *,char *);
 
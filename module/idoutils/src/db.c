@@ -196,6 +196,11 @@ int use_transactions = IDO_TRUE;
 
 char *ido2db_db_tablenames[IDO2DB_MAX_DBTABLES];
 
+static pthread_mutex_t ido2db_db_init_lock = PTHREAD_MUTEX_INITIALIZER;
+#ifdef USE_LIBDBI
+static int ido2db_dbi_initialized = IDO_FALSE;
+#endif
+
 /*
  #define DEBUG_IDO2DB_QUERIES 1
  */
@@ -206,23 +211,14 @@ char *ido2db_db_tablenames[IDO2DB_MAX_DBTABLES];
 
 
 /************************************/
-/* initialize database structures   */
+/* initialize table names           */
 /************************************/
-int ido2db_db_init(ido2db_idi *idi) {
+static int ido2db_db_init_tablenames(int server_type) {
 	register int x;
 
-	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_init() start\n");
-
-	if (idi == NULL)
-		return IDO_ERROR;
-
-	/* initialize db server type */
-	idi->dbinfo.server_type = ido2db_db_settings.server_type;
-
-	/* initialize table names */
 	for (x = 0; x < IDO2DB_MAX_DBTABLES; x++) {
 
-		switch (idi->dbinfo.server_type) {
+		switch (server_type) {
 		case IDO2DB_DBSERVER_MYSQL:
 		case IDO2DB_DBSERVER_PGSQL:
 		case IDO2DB_DBSERVER_DB2:
@@ -255,6 +251,43 @@ int ido2db_db_init(ido2db_idi *idi) {
 		}
 	}
 
+	return IDO_OK;
+}
+
+
+/************************************/
+/* initialize database structures   */
+/************************************/
+int ido2db_db_init(ido2db_idi *idi) {
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_init() start\n");
+
+	if (idi == NULL)
+		return IDO_ERROR;
+
+	/* initialize db server type */
+	idi->dbinfo.server_type = ido2db_db_settings.server_type;
+
+	/* table names and the libdbi driver list are process wide, so set them up only once */
+	pthread_mutex_lock(&ido2db_db_init_lock);
+
+	if (ido2db_db_tablenames[0] == NULL && ido2db_db_init_tablenames(idi->dbinfo.server_type) == IDO_ERROR) {
+		pthread_mutex_unlock(&ido2db_db_init_lock);
+		return IDO_ERROR;
+	}
+
+#ifdef USE_LIBDBI
+	if (ido2db_dbi_initialized == IDO_FALSE) {
+		if (dbi_initialize(libdbi_driver_dir) == -1) {
+			pthread_mutex_unlock(&ido2db_db_init_lock);
+			syslog(LOG_USER | LOG_INFO, "Error: dbi_initialize() failed\n");
+			return IDO_ERROR;
+		}
+		ido2db_dbi_initialized = IDO_TRUE;
+	}
+#endif
+
+	pthread_mutex_unlock(&ido2db_db_init_lock);
+
 	/* initialize other variables */
 	idi->dbinfo.connected = IDO_FALSE;
 	idi->dbinfo.error = IDO_FALSE;
@@ -282,20 +315,20 @@ int ido2db_db_init(ido2db_idi *idi) {
 	idi->dbinfo.max_downtimehistory_age = ido2db_db_settings.max_downtimehistory_age;
 	idi->dbinfo.trim_db_interval = ido2db_db_settings.trim_db_interval;
 	idi->dbinfo.housekeeping_thread_startup_delay = ido2db_db_settings.housekeeping_thread_startup_delay;
+	idi->dbinfo.housekeeping_chunk_size = ido2db_db_settings.housekeeping_chunk_size;
+	idi->dbinfo.housekeeping_rows_per_second = ido2db_db_settings.housekeeping_rows_per_second;
+	idi->dbinfo.housekeeping_drop_partitions = ido2db_db_settings.housekeeping_drop_partitions;
+	idi->dbinfo.insert_batch_size = ido2db_db_settings.insert_batch_size;
+	idi->dbinfo.status_flush_interval = ido2db_db_settings.status_flush_interval;
 	idi->dbinfo.last_table_trim_time = (time_t) 0L;
+	idi->dbinfo.trim_table = -1;
+	idi->dbinfo.trim_next_chunk.tv_sec = 0L;
+	idi->dbinfo.trim_next_chunk.tv_usec = 0L;
 	idi->dbinfo.last_logentry_time = (time_t) 0L;
 	idi->dbinfo.last_logentry_data = NULL;
-	idi->dbinfo.object_hashlist = NULL;
+	idi->dbinfo.object_cache = NULL;
 
 	/* initialize db structures, etc. */
-#ifdef USE_LIBDBI /* everything else will be libdbi */
-
-	if (dbi_initialize(libdbi_driver_dir) == -1) {
-		syslog(LOG_USER | LOG_INFO, "Error: dbi_initialize() failed\n");
-		return IDO_ERROR;
-	}
-#endif
-
 #ifdef USE_PGSQL /* pgsql */
 
 	/* check if config matches */
@@ -336,23 +369,20 @@ int ido2db_db_init(ido2db_idi *idi) {
 /* clean up database structures     */
 /************************************/
 int ido2db_db_deinit(ido2db_idi *idi) {
-	register int x;
-
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_deinit() start\n");
 
 	if (idi == NULL)
 		return IDO_ERROR;
 
-	/* free table names */
-	for (x = 0; x < IDO2DB_MAX_DBTABLES; x++) {
-		if (ido2db_db_tablenames[x])
-			free(ido2db_db_tablenames[x]);
-		ido2db_db_tablenames[x] = NULL;
-	}
-
 	/* free cached object ids */
 	ido2db_free_cached_object_ids(idi);
 
+	/* drop status updates that never got written */
+	ido2db_status_cache_free(idi);
+
+	/* free queued rows and ids */
+	ido2db_db_txbuf_free(&(idi->txbuf));
+
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_deinit() end\n");
 	return IDO_OK;
 }
@@ -417,6 +447,7 @@ int ido2db_db_connect(ido2db_idi *idi) {
 #endif
 #ifdef USE_LIBDBI
 	const char *dbi_error;
+	register int x = 0;
 #endif
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_connect() start\n");
 
@@ -540,6 +571,10 @@ int ido2db_db_connect(ido2db_idi *idi) {
 		idi->dbinfo.connected = IDO_TRUE;
 		syslog(LOG_USER | LOG_INFO, "Successfully connected to %s database", ido2db_db_settings.dbserver);
 	}
+
+	/* a new session has no prepared statements */
+	for (x = 0; x < IDO2DB_MAX_PREPARED_STATEMENTS; x++)
+		idi->dbinfo.prepared[x] = IDO_FALSE;
 #endif
 
 #ifdef USE_PGSQL /* pgsql */
@@ -1111,8 +1146,8 @@ int ido2db_db_disconnect(ido2db_idi *idi) {
 
 
 #ifdef USE_LIBDBI /* everything else will be libdbi */
+	/* drivers stay loaded for other and later connections */
 	dbi_conn_close(idi->dbinfo.dbi_conn);
-	dbi_shutdown();
 
 	syslog(LOG_USER | LOG_INFO, "Successfully disconnected from %s database", ido2db_db_settings.dbserver);
 #endif
@@ -2093,7 +2128,16 @@ int ido2db_db_goodbye(ido2db_idi *idi) {
 #endif
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_goodbye() start\n");
 
+	/* write the status updates still held back */
+	if (idi->dbinfo.status_flush_interval > 0L) {
+		ido2db_status_cache_flush(idi, IDO_TRUE);
+		syslog(LOG_USER | LOG_INFO, "Status cache coalesced %lu of %lu host/service status updates\n", idi->status_cache.coalesced, idi->status_cache.updates);
+	}
+
 #ifdef USE_LIBDBI /* everything else will be libdbi */
+	/* send the rows still queued for insert */
+	ido2db_db_txbuf_flush(idi, &(idi->txbuf));
+
 	ts = ido2db_db_timet_to_sql(idi, idi->data_end_time);
 
 	/* record last connection information */
@@ -2496,6 +2540,112 @@ int ido2db_db_query(ido2db_idi *idi, char *buf) {
 	return result;
 }
 
+/*
+ * builds the definition of a prepared statement, $1..$n are the values of
+ * the columns in order: an insert, or an update of the row with the same key
+ */
+static char *ido2db_db_prepared_definition(int table, char *columns, char *key) {
+	ido_dbuf definition;
+	char *temp_columns = NULL;
+	char *column = NULL;
+	char *saveptr = NULL;
+	char param[32];
+	int key_param = 0;
+	int x = 0;
+
+	if ((temp_columns = strdup(columns)) == NULL)
+		return NULL;
+
+	ido_dbuf_init(&definition, 1024);
+
+	ido_dbuf_strcat(&definition, (key == NULL) ? "INSERT INTO " : "UPDATE ");
+	ido_dbuf_strcat(&definition, ido2db_db_tablenames[table]);
+	if (key == NULL) {
+		ido_dbuf_strcat(&definition, " (");
+		ido_dbuf_strcat(&definition, columns);
+		ido_dbuf_strcat(&definition, ") VALUES (");
+	} else
+		ido_dbuf_strcat(&definition, " SET ");
+
+	for (column = strtok_r(temp_columns, ", ", &saveptr); column != NULL; column = strtok_r(NULL, ", ", &saveptr)) {
+		if (++x > 1)
+			ido_dbuf_strcat(&definition, ", ");
+		if (key != NULL) {
+			if (!strcmp(column, key))
+				key_param = x;
+			ido_dbuf_strcat(&definition, column);
+			ido_dbuf_strcat(&definition, "=");
+		}
+		snprintf(param, sizeof(param), "$%d", x);
+		ido_dbuf_strcat(&definition, param);
+	}
+	free(temp_columns);
+
+	if (key == NULL)
+		ido_dbuf_strcat(&definition, ")");
+	else {
+		snprintf(param, sizeof(param), "=$%d", key_param);
+		ido_dbuf_strcat(&definition, " WHERE ");
+		ido_dbuf_strcat(&definition, key);
+		ido_dbuf_strcat(&definition, param);
+	}
+
+	if (definition.buf == NULL || (key != NULL && key_param == 0)) {
+		ido_dbuf_free(&definition);
+		return NULL;
+	}
+
+	return definition.buf;
+}
+
+/*
+ * executes a statement that is prepared on the server the first time it is
+ * used on a connection, so it doesn't get parsed and planned again for each
+ * row (PostgreSQL only). values is the parenthesized list of the column
+ * values, as for an insert. the caller frees the result.
+ */
+int ido2db_db_query_prepared(ido2db_idi *idi, int statement, int table, char *columns, char *key, char *values) {
+	int result = IDO_OK;
+#ifdef USE_LIBDBI
+	char *definition = NULL;
+	char *buf = NULL;
+
+	if (idi == NULL || columns == NULL || values == NULL)
+		return IDO_ERROR;
+
+	/* statements are gone after a reconnect, so reconnect before checking */
+	if (ido2db_db_reconnect(idi, IDO_FALSE) == IDO_ERROR)
+		return IDO_ERROR;
+
+	if (idi->dbinfo.prepared[statement] == IDO_FALSE) {
+
+		if ((definition = ido2db_db_prepared_definition(table, columns, key)) == NULL)
+			return IDO_ERROR;
+		if (asprintf(&buf, "PREPARE ido2db_statement_%d AS %s", statement, definition) == -1)
+			buf = NULL;
+		free(definition);
+
+		result = ido2db_db_query(idi, buf);
+		dbi_result_free(idi->dbinfo.dbi_result);
+		idi->dbinfo.dbi_result = NULL;
+		free(buf);
+
+		if (result != IDO_OK)
+			return result;
+
+		idi->dbinfo.prepared[statement] = IDO_TRUE;
+	}
+
+	if (asprintf(&buf, "EXECUTE ido2db_statement_%d %s", statement, values) == -1)
+		return IDO_ERROR;
+
+	result = ido2db_db_query(idi, buf);
+	free(buf);
+#endif
+
+	return result;
+}
+
 /****************************************/
 /* frees memory associated with a query */
 /****************************************/
@@ -2772,45 +2922,355 @@ int ido2db_db_trim_data_table(ido2db_idi *idi, char *table_name, char *field_nam
 	return result;
 }
 
+/*****************************************************/
+/* deletes up to limit old rows from a given table   */
+/*****************************************************/
+int ido2db_db_trim_data_table_chunk(ido2db_idi *idi, char *table_name, char *field_name, char *id_field, unsigned long t, unsigned long limit, unsigned long *deleted) {
+	char *buf = NULL;
+	char *ts = NULL;
+	int result = IDO_OK;
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_trim_data_table_chunk() start, time=%lu\n", t);
+
+	*deleted = 0L;
+
+	if (idi == NULL || table_name == NULL || field_name == NULL || id_field == NULL)
+		return IDO_ERROR;
+
+#ifdef USE_LIBDBI /* everything else will be libdbi */
+
+	ts = ido2db_db_timet_to_sql(idi, (time_t) t);
+
+	/* oldest rows first, so every chunk starts at the front of the primary key */
+	if (idi->dbinfo.server_type == IDO2DB_DBSERVER_MYSQL) {
+		if (asprintf(&buf, "DELETE FROM %s WHERE instance_id=%lu AND %s<%s ORDER BY %s LIMIT %lu",
+		             table_name, idi->dbinfo.instance_id, field_name, ts, id_field, limit) == -1)
+			buf = NULL;
+	} else {
+		if (asprintf(&buf, "DELETE FROM %s WHERE %s IN (SELECT %s FROM %s WHERE instance_id=%lu AND %s<%s ORDER BY %s LIMIT %lu)",
+		             table_name, id_field, id_field, table_name, idi->dbinfo.instance_id, field_name, ts, id_field, limit) == -1)
+			buf = NULL;
+	}
+
+	if ((result = ido2db_db_query(idi, buf)) == IDO_OK && idi->dbinfo.dbi_result != NULL)
+		*deleted = (unsigned long)dbi_result_get_numrows_affected(idi->dbinfo.dbi_result);
+
+	dbi_result_free(idi->dbinfo.dbi_result);
+	idi->dbinfo.dbi_result = NULL;
+
+	free(buf);
+	free(ts);
+#else
+	/* no chunks here, trim the whole table */
+	result = ido2db_db_trim_data_table(idi, table_name, field_name, t);
+#endif
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_trim_data_table_chunk(%s => %s: %lu) end, %lu rows\n", table_name, field_name, t, *deleted);
+	return result;
+}
+
+/*****************************************************/
+/* drops range partitions which only hold old rows   */
+/*****************************************************/
+#ifdef USE_LIBDBI
+/* tells if other instances write to the db, or left rows older than ts in the table - when in doubt, they did */
+static int ido2db_db_other_instance_data(ido2db_idi *idi, char *table_name, char *field_name, char *ts) {
+	char *buf = NULL;
+	int found = IDO_TRUE;
+
+	if (asprintf(&buf, "SELECT instance_id FROM %s WHERE instance_id<>%lu LIMIT 1", ido2db_db_tablenames[IDO2DB_DBTABLE_INSTANCES], idi->dbinfo.instance_id) == -1)
+		buf = NULL;
+
+	if (ido2db_db_query(idi, buf) == IDO_OK && idi->dbinfo.dbi_result != NULL)
+		found = (dbi_result_next_row(idi->dbinfo.dbi_result)) ? IDO_TRUE : IDO_FALSE;
+
+	dbi_result_free(idi->dbinfo.dbi_result);
+	idi->dbinfo.dbi_result = NULL;
+	free(buf);
+	buf = NULL;
+
+	if (found == IDO_TRUE)
+		return IDO_TRUE;
+
+	/* rows of an instance that is gone */
+	found = IDO_TRUE;
+
+	if (asprintf(&buf, "SELECT instance_id FROM %s WHERE instance_id<>%lu AND %s<%s LIMIT 1", table_name, idi->dbinfo.instance_id, field_name, ts) == -1)
+		buf = NULL;
+
+	if (ido2db_db_query(idi, buf) == IDO_OK && idi->dbinfo.dbi_result != NULL)
+		found = (dbi_result_next_row(idi->dbinfo.dbi_result)) ? IDO_TRUE : IDO_FALSE;
+
+	dbi_result_free(idi->dbinfo.dbi_result);
+	idi->dbinfo.dbi_result = NULL;
+	free(buf);
+
+	return found;
+}
+#endif
+
+int ido2db_db_drop_data_partitions(ido2db_idi *idi, char *table_name, char *field_name, unsigned long t, unsigned long *dropped) {
+#ifdef USE_LIBDBI
+	char *buf = NULL;
+	char *ts = NULL;
+	const char *partition = NULL;
+	ido_dbuf partitions;
+#endif
+	int result = IDO_OK;
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_drop_data_partitions() start, time=%lu\n", t);
+
+	*dropped = 0L;
+
+	if (idi == NULL || table_name == NULL || field_name == NULL)
+		return IDO_ERROR;
+
+#ifdef USE_LIBDBI /* everything else will be libdbi */
+
+	if (idi->dbinfo.server_type != IDO2DB_DBSERVER_MYSQL && idi->dbinfo.server_type != IDO2DB_DBSERVER_PGSQL)
+		return IDO_OK;
+
+	ts = ido2db_db_timet_to_sql(idi, (time_t) t);
+
+	/* only partitions by range of the time field whose upper bound is old enough */
+	if (idi->dbinfo.server_type == IDO2DB_DBSERVER_MYSQL) {
+		if (asprintf(&buf, "SELECT PARTITION_NAME AS partition_name FROM information_schema.PARTITIONS WHERE TABLE_SCHEMA=DATABASE() AND TABLE_NAME='%s' AND PARTITION_METHOD='RANGE COLUMNS' AND PARTITION_EXPRESSION IN ('%s','`%s`') AND PARTITION_DESCRIPTION<>'MAXVALUE' AND CAST(TRIM(BOTH '''' FROM PARTITION_DESCRIPTION) AS DATETIME)<=%s",
+		             table_name, field_name, field_name, ts) == -1)
+			buf = NULL;
+	} else {
+		if (asprintf(&buf, "SELECT c.relname AS partition_name FROM pg_inherits i JOIN pg_class c ON c.oid=i.inhrelid JOIN pg_class p ON p.oid=i.inhparent WHERE p.relname='%s' AND pg_get_partkeydef(p.oid)='RANGE (%s)' AND substring(pg_get_expr(c.relpartbound, c.oid) from 'TO \\(''([^'']+)''\\)')::timestamp with time zone<=%s",
+		             table_name, field_name, ts) == -1)
+			buf = NULL;
+	}
+
+	ido_dbuf_init(&partitions, 256);
+
+	if ((result = ido2db_db_query(idi, buf)) == IDO_OK && idi->dbinfo.dbi_result != NULL) {
+		while (dbi_result_next_row(idi->dbinfo.dbi_result)) {
+			if ((partition = dbi_result_get_string(idi->dbinfo.dbi_result, "partition_name")) == NULL)
+				continue;
+			if (*dropped > 0)
+				ido_dbuf_strcat(&partitions, ",");
+			ido_dbuf_strcat(&partitions, (char *)partition);
+			(*dropped)++;
+		}
+	}
+
+	dbi_result_free(idi->dbinfo.dbi_result);
+	idi->dbinfo.dbi_result = NULL;
+	free(buf);
+	buf = NULL;
+
+	/* partitions hold the rows of all instances, and the others may keep theirs longer */
+	if (*dropped > 0 && ido2db_db_other_instance_data(idi, table_name, field_name, ts) == IDO_TRUE) {
+		syslog(LOG_USER | LOG_INFO, "Warning: Not dropping %lu partitions of %s, as other instances than %lu have data in the db.  Set housekeeping_drop_partitions=0 for a db shared by several instances.", *dropped, table_name, idi->dbinfo.instance_id);
+		*dropped = 0L;
+	}
+
+	if (*dropped > 0) {
+
+		if (idi->dbinfo.server_type == IDO2DB_DBSERVER_MYSQL) {
+			if (asprintf(&buf, "ALTER TABLE %s DROP PARTITION %s", table_name, partitions.buf) == -1)
+				buf = NULL;
+		} else {
+			if (asprintf(&buf, "DROP TABLE %s", partitions.buf) == -1)
+				buf = NULL;
+		}
+
+		if ((result = ido2db_db_query(idi, buf)) != IDO_OK)
+			*dropped = 0L;
+
+		dbi_result_free(idi->dbinfo.dbi_result);
+		idi->dbinfo.dbi_result = NULL;
+		free(buf);
+	}
+
+	ido_dbuf_free(&partitions);
+	free(ts);
+#endif
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_drop_data_partitions(%s => %s: %lu) end, %lu partitions\n", table_name, field_name, t, *dropped);
+	return result;
+}
+
+/* the tables housekeeping trims, in the order of a pass */
+static struct {
+	int table;
+	char *time_field;
+	char *id_field;
+} ido2db_db_trim_tables[] = {
+	{ IDO2DB_DBTABLE_SYSTEMCOMMANDS, "start_time", "systemcommand_id" },
+	{ IDO2DB_DBTABLE_SERVICECHECKS, "start_time", "servicecheck_id" },
+	{ IDO2DB_DBTABLE_HOSTCHECKS, "start_time", "hostcheck_id" },
+	{ IDO2DB_DBTABLE_EVENTHANDLERS, "start_time", "eventhandler_id" },
+	{ IDO2DB_DBTABLE_EXTERNALCOMMANDS, "entry_time", "externalcommand_id" },
+	{ IDO2DB_DBTABLE_LOGENTRIES, "logentry_time", "logentry_id" },
+	{ IDO2DB_DBTABLE_ACKNOWLEDGEMENTS, "entry_time", "acknowledgement_id" },
+	{ IDO2DB_DBTABLE_NOTIFICATIONS, "start_time", "notification_id" },
+	{ IDO2DB_DBTABLE_CONTACTNOTIFICATIONS, "start_time", "contactnotification_id" },
+	{ IDO2DB_DBTABLE_CONTACTNOTIFICATIONMETHODS, "start_time", "contactnotificationmethod_id" },
+	{ IDO2DB_DBTABLE_DOWNTIMEHISTORY, "entry_time", "downtimehistory_id" }
+};
+
+#define IDO2DB_TRIM_TABLES	((int)(sizeof(ido2db_db_trim_tables) / sizeof(ido2db_db_trim_tables[0])))
+
+/* returns the max age configured for a table, 0 if it isn't trimmed */
+static unsigned long ido2db_db_trim_age(ido2db_idi *idi, int table) {
+
+	switch (table) {
+	case IDO2DB_DBTABLE_SYSTEMCOMMANDS:
+		return idi->dbinfo.max_systemcommands_age;
+	case IDO2DB_DBTABLE_SERVICECHECKS:
+		return idi->dbinfo.max_servicechecks_age;
+	case IDO2DB_DBTABLE_HOSTCHECKS:
+		return idi->dbinfo.max_hostchecks_age;
+	case IDO2DB_DBTABLE_EVENTHANDLERS:
+		return idi->dbinfo.max_eventhandlers_age;
+	case IDO2DB_DBTABLE_EXTERNALCOMMANDS:
+		return idi->dbinfo.max_externalcommands_age;
+	case IDO2DB_DBTABLE_LOGENTRIES:
+		return idi->dbinfo.max_logentries_age;
+	case IDO2DB_DBTABLE_ACKNOWLEDGEMENTS:
+		return idi->dbinfo.max_acknowledgements_age;
+	case IDO2DB_DBTABLE_NOTIFICATIONS:
+		return idi->dbinfo.max_notifications_age;
+	case IDO2DB_DBTABLE_CONTACTNOTIFICATIONS:
+		return idi->dbinfo.max_contactnotifications_age;
+	case IDO2DB_DBTABLE_CONTACTNOTIFICATIONMETHODS:
+		return idi->dbinfo.max_contactnotificationmethods_age;
+	case IDO2DB_DBTABLE_DOWNTIMEHISTORY:
+		return idi->dbinfo.max_downtimehistory_age;
+	default:
+		break;
+	}
+
+	return 0L;
+}
+
 /***********************************************/
 /* performs some periodic table maintenance... */
 /***********************************************/
+/*
+ * Tables are trimmed in chunks of housekeeping_chunk_size rows, so no single
+ * delete holds its locks for long.  A pass may take many calls: each call
+ * works for at most IDO2DB_HOUSEKEEPING_SLICE and returns early whenever the
+ * rows per second budget says the next chunk isn't due yet (trim_next_chunk),
+ * so the caller decides how to wait.
+ */
 int ido2db_db_perform_maintenance(ido2db_idi *idi) {
 	time_t current_time;
+	struct timeval slice_start;
+	struct timeval chunk_start;
+	struct timeval now;
+	unsigned long age = 0L;
+	unsigned long cutoff = 0L;
+	unsigned long deleted = 0L;
+	unsigned long dropped = 0L;
+	unsigned long long pause = 0L;
+	char *table_name = NULL;
+	int chunked = IDO_FALSE;
+	int result = IDO_OK;
 
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_perform_maintenance() start\n");
 
-	//ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_perform_maintenance() max_logentries_age=%lu, max_ack_age=%lu\n", idi->dbinfo.max_logentries_age, idi->dbinfo.max_logentries_age);
-
 	/* get the current time */
 	time(&current_time);
 
-	/* trim tables */
-	if (((unsigned long) current_time - idi->dbinfo.trim_db_interval) > (unsigned long) idi->dbinfo.last_table_trim_time) {
-		if (idi->dbinfo.max_systemcommands_age > 0L)
-			ido2db_db_trim_data_table(idi, ido2db_db_tablenames[IDO2DB_DBTABLE_SYSTEMCOMMANDS], "start_time", (time_t)((unsigned long) current_time - idi->dbinfo.max_systemcommands_age));
-		if (idi->dbinfo.max_servicechecks_age > 0L)
-			ido2db_db_trim_data_table(idi, ido2db_db_tablenames[IDO2DB_DBTABLE_SERVICECHECKS], "start_time", (time_t)((unsigned long) current_time - idi->dbinfo.max_servicechecks_age));
-		if (idi->dbinfo.max_hostchecks_age > 0L)
-			ido2db_db_trim_data_table(idi, ido2db_db_tablenames[IDO2DB_DBTABLE_HOSTCHECKS], "start_time", (time_t)((unsigned long) current_time - idi->dbinfo.max_hostchecks_age));
-		if (idi->dbinfo.max_eventhandlers_age > 0L)
-			ido2db_db_trim_data_table(idi, ido2db_db_tablenames[IDO2DB_DBTABLE_EVENTHANDLERS], "start_time", (time_t)((unsigned long) current_time - idi->dbinfo.max_eventhandlers_age));
-		if (idi->dbinfo.max_externalcommands_age > 0L)
-			ido2db_db_trim_data_table(idi, ido2db_db_tablenames[IDO2DB_DBTABLE_EXTERNALCOMMANDS], "entry_time", (time_t)((unsigned long)current_time - idi->dbinfo.max_externalcommands_age));
-		if (idi->dbinfo.max_logentries_age > 0L)
-			ido2db_db_trim_data_table(idi, ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES], "logentry_time", (time_t)((unsigned long)current_time - idi->dbinfo.max_logentries_age));
-		if (idi->dbinfo.max_acknowledgements_age > 0L)
-			ido2db_db_trim_data_table(idi, ido2db_db_tablenames[IDO2DB_DBTABLE_ACKNOWLEDGEMENTS], "entry_time", (time_t)((unsigned long)current_time - idi->dbinfo.max_acknowledgements_age));
-		if (idi->dbinfo.max_notifications_age > 0L)
-			ido2db_db_trim_data_table(idi, ido2db_db_tablenames[IDO2DB_DBTABLE_NOTIFICATIONS], "start_time", (time_t)((unsigned long) current_time - idi->dbinfo.max_notifications_age));
-		if (idi->dbinfo.max_contactnotifications_age > 0L)
-			ido2db_db_trim_data_table(idi, ido2db_db_tablenames[IDO2DB_DBTABLE_CONTACTNOTIFICATIONS], "start_time", (time_t)((unsigned long) current_time - idi->dbinfo.max_contactnotifications_age));
-		if (idi->dbinfo.max_contactnotificationmethods_age > 0L)
-			ido2db_db_trim_data_table(idi, ido2db_db_tablenames[IDO2DB_DBTABLE_CONTACTNOTIFICATIONMETHODS], "start_time", (time_t)((unsigned long) current_time - idi->dbinfo.max_contactnotificationmethods_age));
-		if (idi->dbinfo.max_downtimehistory_age > 0L)
-			ido2db_db_trim_data_table(idi, ido2db_db_tablenames[IDO2DB_DBTABLE_DOWNTIMEHISTORY], "entry_time", (time_t)((unsigned long) current_time - idi->dbinfo.max_downtimehistory_age));
-
-		idi->dbinfo.last_table_trim_time = current_time;
+	/* start a new pass */
+	if (idi->dbinfo.trim_table < 0) {
+
+		if (((unsigned long) current_time - idi->dbinfo.trim_db_interval) <= (unsigned long) idi->dbinfo.last_table_trim_time) {
+			ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_perform_maintenance() end\n");
+			return IDO_OK;
+		}
+
+		idi->dbinfo.trim_table = 0;
+		idi->dbinfo.trim_table_chunks = 0L;
+		idi->dbinfo.trim_pass_time = current_time;
+		idi->dbinfo.trim_rows = 0L;
+		idi->dbinfo.trim_chunks = 0L;
+		idi->dbinfo.trim_partitions = 0L;
+	}
+
+	gettimeofday(&slice_start, NULL);
+
+	/* the budget doesn't allow another chunk yet */
+	if (timercmp(&slice_start, &idi->dbinfo.trim_next_chunk, <)) {
+		ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_perform_maintenance() end\n");
+		return IDO_OK;
+	}
+
+	/* chunks need a LIMIT in the delete, ocilib trims with a stored procedure */
+	if (idi->dbinfo.housekeeping_chunk_size > 0 && (idi->dbinfo.server_type == IDO2DB_DBSERVER_MYSQL || idi->dbinfo.server_type == IDO2DB_DBSERVER_PGSQL))
+		chunked = IDO_TRUE;
+
+	while (idi->dbinfo.trim_table < IDO2DB_TRIM_TABLES) {
+
+		table_name = ido2db_db_tablenames[ido2db_db_trim_tables[idi->dbinfo.trim_table].table];
+
+		if ((age = ido2db_db_trim_age(idi, ido2db_db_trim_tables[idi->dbinfo.trim_table].table)) == 0L) {
+			idi->dbinfo.trim_table++;
+			continue;
+		}
+
+		/* the ages count from the start of the pass, so the chunks of a table agree on what's old */
+		cutoff = (unsigned long)idi->dbinfo.trim_pass_time - age;
+
+		/* whole partitions go first, the deletes take care of the rest */
+		if (idi->dbinfo.trim_table_chunks == 0L && idi->dbinfo.housekeeping_drop_partitions == IDO_TRUE) {
+			ido2db_db_drop_data_partitions(idi, table_name, ido2db_db_trim_tables[idi->dbinfo.trim_table].time_field, cutoff, &dropped);
+			idi->dbinfo.trim_partitions += dropped;
+		}
+
+		gettimeofday(&chunk_start, NULL);
+
+		deleted = 0L;
+		if (chunked == IDO_TRUE)
+			result = ido2db_db_trim_data_table_chunk(idi, table_name, ido2db_db_trim_tables[idi->dbinfo.trim_table].time_field, ido2db_db_trim_tables[idi->dbinfo.trim_table].id_field, cutoff, idi->dbinfo.housekeeping_chunk_size, &deleted);
+		else
+			result = ido2db_db_trim_data_table(idi, table_name, ido2db_db_trim_tables[idi->dbinfo.trim_table].time_field, cutoff);
+
+		idi->dbinfo.trim_table_chunks++;
+		idi->dbinfo.trim_chunks++;
+		idi->dbinfo.trim_rows += deleted;
+
+		/* a short chunk means the table is done - after errors we try again next pass */
+		if (chunked == IDO_FALSE || result == IDO_ERROR || deleted < idi->dbinfo.housekeeping_chunk_size) {
+			ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 1, "ido2db_db_perform_maintenance() trimmed %s in %lu chunks, %lu rows deleted in this pass\n", table_name, idi->dbinfo.trim_table_chunks, idi->dbinfo.trim_rows);
+			idi->dbinfo.trim_table++;
+			idi->dbinfo.trim_table_chunks = 0L;
+		}
+
+		gettimeofday(&now, NULL);
+
+		/* the next chunk is due once the budget covers the rows just deleted */
+		if (idi->dbinfo.housekeeping_rows_per_second > 0L && deleted > 0L) {
+			pause = (unsigned long long)deleted * 1000000L / idi->dbinfo.housekeeping_rows_per_second;
+			idi->dbinfo.trim_next_chunk.tv_sec = chunk_start.tv_sec + (time_t)(pause / 1000000L);
+			idi->dbinfo.trim_next_chunk.tv_usec = chunk_start.tv_usec + (suseconds_t)(pause % 1000000L);
+			if (idi->dbinfo.trim_next_chunk.tv_usec >= 1000000L) {
+				idi->dbinfo.trim_next_chunk.tv_sec++;
+				idi->dbinfo.trim_next_chunk.tv_usec -= 1000000L;
+			}
+			if (timercmp(&now, &idi->dbinfo.trim_next_chunk, <))
+				break;
+		}
+
+		/* give the caller a turn */
+		if ((now.tv_sec - slice_start.tv_sec) * 1000000L + (now.tv_usec - slice_start.tv_usec) >= IDO2DB_HOUSEKEEPING_SLICE)
+			break;
+	}
+
+	/* the pass is done */
+	if (idi->dbinfo.trim_table >= IDO2DB_TRIM_TABLES) {
+
+		time(&current_time);
+
+		if (idi->dbinfo.trim_rows > 0L || idi->dbinfo.trim_partitions > 0L)
+			syslog(LOG_USER | LOG_INFO, "Housekeeping deleted %lu rows in %lu chunks and dropped %lu partitions in %lu seconds\n", idi->dbinfo.trim_rows, idi->dbinfo.trim_chunks, idi->dbinfo.trim_partitions, (unsigned long)(current_time - idi->dbinfo.trim_pass_time));
+
+		idi->dbinfo.last_table_trim_time = idi->dbinfo.trim_pass_time;
+		idi->dbinfo.trim_table = -1;
 	}
 
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_perform_maintenance() end\n");
@@ -2818,8 +3278,227 @@ int ido2db_db_perform_maintenance(ido2db_idi *idi) {
 }
 
 void ido2db_db_txbuf_init(ido2db_txbuf *txbuf) {
+	register int x = 0;
+
 	txbuf->ids_to_activate = NULL;
 	txbuf->ids_to_activate_count = 0;
+
+	for (x = 0; x < IDO2DB_MAX_INSERT_BATCHES; x++) {
+		ido_dbuf_init(&txbuf->inserts[x], IDO2DB_INSERT_BATCH_CHUNK_SIZE);
+		txbuf->insert_rows[x] = 0;
+		txbuf->insert_row_offsets[x] = NULL;
+		txbuf->insert_row_offsets_size[x] = 0;
+	}
+}
+
+void ido2db_db_txbuf_free(ido2db_txbuf *txbuf) {
+	register int x = 0;
+
+	free(txbuf->ids_to_activate);
+	txbuf->ids_to_activate = NULL;
+	txbuf->ids_to_activate_count = 0;
+
+	for (x = 0; x < IDO2DB_MAX_INSERT_BATCHES; x++) {
+		ido_dbuf_free(&txbuf->inserts[x]);
+		txbuf->insert_rows[x] = 0;
+		free(txbuf->insert_row_offsets[x]);
+		txbuf->insert_row_offsets[x] = NULL;
+		txbuf->insert_row_offsets_size[x] = 0;
+	}
+}
+
+/*
+ * inserts the rows of a failed batch one by one, so a single bad row
+ * doesn't take the whole batch with it. a failed statement aborts the
+ * transaction on PostgreSQL, so every row gets its own savepoint there.
+ */
+static int ido2db_db_txbuf_insert_rows(ido2db_idi *idi, ido2db_txbuf *txbuf, int batch) {
+	char *buf = NULL;
+	char *header = txbuf->inserts[batch].buf;
+	unsigned long *offsets = txbuf->insert_row_offsets[batch];
+	unsigned long end = 0L;
+	int use_savepoints = IDO_FALSE;
+	int failed_rows = 0;
+	int result = IDO_OK;
+	register int x = 0;
+
+#ifdef USE_LIBDBI
+	use_savepoints = (use_transactions && idi->dbinfo.server_type == IDO2DB_DBSERVER_PGSQL) ? IDO_TRUE : IDO_FALSE;
+
+	if (use_savepoints == IDO_TRUE) {
+		ido2db_db_query(idi, "ROLLBACK TO SAVEPOINT ido2db_insert_batch");
+		dbi_result_free(idi->dbinfo.dbi_result);
+		idi->dbinfo.dbi_result = NULL;
+	}
+
+	for (x = 0; x < txbuf->insert_rows[batch]; x++) {
+
+		/* we lost the connection, no point in trying the other rows */
+		if (idi->dbinfo.connected == IDO_FALSE || idi->disconnect_client == IDO_TRUE)
+			return IDO_ERROR;
+
+		/* rows after the first one start with a comma */
+		end = (x + 1 < txbuf->insert_rows[batch]) ? offsets[x + 1] - 1 : txbuf->inserts[batch].used_size;
+
+		if (asprintf(&buf, "%s%.*s%.*s%s",
+		             (use_savepoints == IDO_TRUE) ? "SAVEPOINT ido2db_insert_row;" : "",
+		             (int)offsets[0], header,
+		             (int)(end - offsets[x]), header + offsets[x],
+		             (use_savepoints == IDO_TRUE) ? ";RELEASE SAVEPOINT ido2db_insert_row" : "") == -1)
+			return IDO_ERROR;
+
+		result = ido2db_db_query(idi, buf);
+		free(buf);
+		dbi_result_free(idi->dbinfo.dbi_result);
+		idi->dbinfo.dbi_result = NULL;
+
+		if (result == IDO_OK)
+			continue;
+
+		failed_rows++;
+
+		if (use_savepoints == IDO_TRUE) {
+			ido2db_db_query(idi, "ROLLBACK TO SAVEPOINT ido2db_insert_row");
+			dbi_result_free(idi->dbinfo.dbi_result);
+			idi->dbinfo.dbi_result = NULL;
+		}
+	}
+#endif
+
+	if (failed_rows == 0)
+		return IDO_OK;
+
+	syslog(LOG_USER | LOG_INFO, "Warning: %d of %d rows of a batched insert could not be written\n", failed_rows, txbuf->insert_rows[batch]);
+
+	return IDO_ERROR;
+}
+
+/* sends the rows queued for one history table as a single insert */
+int ido2db_db_txbuf_flush_inserts(ido2db_idi *idi, ido2db_txbuf *txbuf, int batch) {
+	char *buf = NULL;
+	int result = IDO_OK;
+
+	if (txbuf->insert_rows[batch] == 0)
+		return IDO_OK;
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_db_txbuf_flush_inserts(%d) rows=%d\n", batch, txbuf->insert_rows[batch]);
+
+#ifdef USE_LIBDBI
+	/* a failed statement aborts the transaction on PostgreSQL, keep the rows before the batch */
+	if (use_transactions && idi->dbinfo.server_type == IDO2DB_DBSERVER_PGSQL && txbuf->insert_rows[batch] > 1) {
+		if (asprintf(&buf, "SAVEPOINT ido2db_insert_batch;%s;RELEASE SAVEPOINT ido2db_insert_batch", txbuf->inserts[batch].buf) == -1)
+			buf = NULL;
+	}
+
+	result = ido2db_db_query(idi, (buf != NULL) ? buf : txbuf->inserts[batch].buf);
+	free(buf);
+	dbi_result_free(idi->dbinfo.dbi_result);
+	idi->dbinfo.dbi_result = NULL;
+
+	if (result != IDO_OK && txbuf->insert_rows[batch] > 1 && idi->dbinfo.connected == IDO_TRUE && idi->disconnect_client == IDO_FALSE)
+		result = ido2db_db_txbuf_insert_rows(idi, txbuf, batch);
+#endif
+
+	/* keep the memory for the next batch */
+	txbuf->inserts[batch].used_size = 0L;
+	txbuf->inserts[batch].buf[0] = '\x0';
+	txbuf->insert_rows[batch] = 0;
+
+	return result;
+}
+
+/*
+ * inserts a row into a history table. within a transaction the row is
+ * queued and sent together with the following ones as a multi-row insert
+ * once insert_batch_size rows are collected or the transaction commits.
+ * all rows of a table must use the same column list.
+ */
+int ido2db_db_txbuf_add_insert(ido2db_idi *idi, int batch, int table, char *columns, char *values) {
+	ido2db_txbuf *txbuf = NULL;
+	unsigned long *new_offsets = NULL;
+	unsigned long used_size = 0L;
+	char *buf = NULL;
+	int result = IDO_OK;
+
+	if (idi == NULL || columns == NULL || values == NULL)
+		return IDO_ERROR;
+
+	txbuf = &(idi->txbuf);
+
+	/* outside of a transaction, or if the database can't do multi-row inserts, insert right away */
+	if (idi->in_transaction == IDO_FALSE || idi->dbinfo.insert_batch_size <= 1 || (idi->dbinfo.server_type != IDO2DB_DBSERVER_MYSQL && idi->dbinfo.server_type != IDO2DB_DBSERVER_PGSQL)) {
+		if (idi->dbinfo.server_type == IDO2DB_DBSERVER_PGSQL)
+			result = ido2db_db_query_prepared(idi, batch, table, columns, NULL, values);
+		else {
+			if (asprintf(&buf, "INSERT INTO %s (%s) VALUES %s", ido2db_db_tablenames[table], columns, values) == -1)
+				return IDO_ERROR;
+			result = ido2db_db_query(idi, buf);
+			free(buf);
+		}
+#ifdef USE_LIBDBI
+		dbi_result_free(idi->dbinfo.dbi_result);
+		idi->dbinfo.dbi_result = NULL;
+#endif
+		return result;
+	}
+
+	if (txbuf->insert_rows[batch] >= txbuf->insert_row_offsets_size[batch]) {
+		if ((new_offsets = (unsigned long *)realloc(txbuf->insert_row_offsets[batch], (txbuf->insert_row_offsets_size[batch] + IDO2DB_INSERT_BATCH_ROWS_GROWTH) * sizeof(unsigned long))) == NULL)
+			return IDO_ERROR;
+		txbuf->insert_row_offsets[batch] = new_offsets;
+		txbuf->insert_row_offsets_size[batch] += IDO2DB_INSERT_BATCH_ROWS_GROWTH;
+	}
+
+	if (txbuf->insert_rows[batch] == 0) {
+		if (asprintf(&buf, "INSERT INTO %s (%s) VALUES ", ido2db_db_tablenames[table], columns) == -1)
+			return IDO_ERROR;
+	} else {
+		if ((buf = strdup(",")) == NULL)
+			return IDO_ERROR;
+	}
+
+	/* a row is added completely or not at all */
+	used_size = txbuf->inserts[batch].used_size;
+
+	result = ido_dbuf_strcat(&txbuf->inserts[batch], buf);
+	free(buf);
+
+	if (result == IDO_OK) {
+		txbuf->insert_row_offsets[batch][txbuf->insert_rows[batch]] = txbuf->inserts[batch].used_size;
+		result = ido_dbuf_strcat(&txbuf->inserts[batch], values);
+	}
+
+	if (result != IDO_OK) {
+		txbuf->inserts[batch].used_size = used_size;
+		if (txbuf->inserts[batch].buf != NULL)
+			txbuf->inserts[batch].buf[used_size] = '\x0';
+		return IDO_ERROR;
+	}
+
+	txbuf->insert_rows[batch]++;
+
+	if (txbuf->insert_rows[batch] >= idi->dbinfo.insert_batch_size || txbuf->inserts[batch].used_size >= IDO2DB_INSERT_BATCH_MAX_BYTES)
+		return ido2db_db_txbuf_flush_inserts(idi, txbuf, batch);
+
+	return IDO_OK;
+}
+
+/* tells if a row starting with the given values is still queued for insert */
+int ido2db_db_txbuf_has_insert(ido2db_txbuf *txbuf, int batch, char *values) {
+	unsigned long len = 0L;
+	int x = 0;
+
+	if (txbuf == NULL || values == NULL || txbuf->inserts[batch].buf == NULL)
+		return IDO_FALSE;
+
+	len = strlen(values);
+
+	for (x = 0; x < txbuf->insert_rows[batch]; x++) {
+		if (!strncmp(txbuf->inserts[batch].buf + txbuf->insert_row_offsets[batch][x], values, len))
+			return IDO_TRUE;
+	}
+
+	return IDO_FALSE;
 }
 
 void ido2db_db_txbuf_add_id_to_activate(ido2db_txbuf *txbuf, unsigned long object_id) {
@@ -2831,6 +3510,11 @@ void ido2db_db_txbuf_add_id_to_activate(ido2db_txbuf *txbuf, unsigned long objec
 void ido2db_db_txbuf_flush(ido2db_idi *idi, ido2db_txbuf *txbuf)
 {
 #ifdef USE_LIBDBI
+	register int x = 0;
+
+	for (x = 0; x < IDO2DB_MAX_INSERT_BATCHES; x++)
+		ido2db_db_txbuf_flush_inserts(idi, txbuf, x);
+
 	if (txbuf->ids_to_activate_count > 0) {
 		ido2db_set_objects_as_active(idi, txbuf->ids_to_activate, txbuf->ids_to_activate_count);
 	}
@@ -27,8 +27,16 @@ extern int errno;
 
 extern char *ido2db_db_tablenames[IDO2DB_MAX_DBTABLES];
 
+/* column lists of the history tables whose rows are queued for multi-row inserts */
+static char ido2db_logentries_columns[] = "instance_id, logentry_time, entry_time, entry_time_usec, logentry_type, logentry_data, realtime_data, inferred_data_extracted, object_id";
+static char ido2db_statehistory_columns[] = "instance_id, state_time, state_time_usec, object_id, state_change, state, state_type, current_check_attempt, max_check_attempts, last_state, last_hard_state, output, long_output";
+
 extern ido2db_dbconfig ido2db_db_settings; /* for tables cleanup settings */
 
+/* object id caches, one per instance and shared by all its connections */
+static ido2db_object_cache *ido2db_object_caches = NULL;
+static pthread_mutex_t ido2db_object_caches_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /****************************************************************************/
 /* OBJECT ROUTINES                                                          */
 /****************************************************************************/
@@ -464,6 +472,53 @@ int ido2db_get_object_id_with_insert(ido2db_idi *idi, int object_type, char *n1,
 	return result;
 }
 
+/* attaches the connection to the object id cache of its instance */
+static ido2db_object_cache *ido2db_attach_object_cache(ido2db_idi *idi) {
+	ido2db_object_cache *cache = NULL;
+
+	if (idi->dbinfo.object_cache != NULL) {
+		if (idi->dbinfo.object_cache->instance_id == idi->dbinfo.instance_id)
+			return idi->dbinfo.object_cache;
+
+		/* the instance changed */
+		ido2db_free_cached_object_ids(idi);
+	}
+
+	pthread_mutex_lock(&ido2db_object_caches_lock);
+
+	for (cache = ido2db_object_caches; cache != NULL; cache = cache->next) {
+		if (cache->instance_id == idi->dbinfo.instance_id)
+			break;
+	}
+
+	if (cache == NULL) {
+		if ((cache = (ido2db_object_cache *) calloc(1, sizeof(ido2db_object_cache))) == NULL) {
+			pthread_mutex_unlock(&ido2db_object_caches_lock);
+			return NULL;
+		}
+		if ((cache->hashlist = (ido2db_dbobject **) calloc(IDO2DB_OBJECT_HASHSLOTS, sizeof(ido2db_dbobject *))) == NULL) {
+			free(cache);
+			pthread_mutex_unlock(&ido2db_object_caches_lock);
+			return NULL;
+		}
+		cache->instance_id = idi->dbinfo.instance_id;
+		cache->loaded = IDO_FALSE;
+		pthread_mutex_init(&cache->load_lock, NULL);
+		pthread_rwlock_init(&cache->lock, NULL);
+
+		cache->next = ido2db_object_caches;
+		ido2db_object_caches = cache;
+	}
+
+	cache->refs++;
+
+	pthread_mutex_unlock(&ido2db_object_caches_lock);
+
+	idi->dbinfo.object_cache = cache;
+
+	return cache;
+}
+
 int ido2db_get_cached_object_ids(ido2db_idi *idi) {
 	int result = IDO_OK;
 	unsigned long object_id = 0L;
@@ -475,12 +530,25 @@ int ido2db_get_cached_object_ids(ido2db_idi *idi) {
 	char *buf = NULL;
 	char *name2 = NULL;
 #endif
+	ido2db_object_cache *cache = NULL;
 
 #ifdef USE_ORACLE
 	void *data[1];
 #endif
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_get_cached_object_ids() start\n");
 
+	if ((cache = ido2db_attach_object_cache(idi)) == NULL)
+		return IDO_ERROR;
+
+	/* another connection of this instance may have loaded it already - or be loading it right now */
+	pthread_mutex_lock(&cache->load_lock);
+
+	if (cache->loaded == IDO_TRUE) {
+		pthread_mutex_unlock(&cache->load_lock);
+		ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_get_cached_object_ids() already loaded\n");
+		return IDO_OK;
+	}
+
 	/* find all the object definitions we already have */
 #ifdef USE_LIBDBI /* everything else will be libdbi */
 	switch (idi->dbinfo.server_type) {
@@ -565,6 +633,10 @@ int ido2db_get_cached_object_ids(ido2db_idi *idi) {
 
 			free(buf);
 
+			/* don't ask again for what failed */
+			if (result != IDO_OK)
+				break;
+
 			offset += stride;
 		}
 		break;
@@ -578,19 +650,22 @@ int ido2db_get_cached_object_ids(ido2db_idi *idi) {
 #ifdef USE_ORACLE /* Oracle ocilib specific */
 
 	/* check if we lost connection, and reconnect */
-	if (ido2db_db_reconnect(idi, IDO_TRUE) == IDO_ERROR)
+	if (ido2db_db_reconnect(idi, IDO_TRUE) == IDO_ERROR) {
+		pthread_mutex_unlock(&cache->load_lock);
 		return IDO_ERROR;
-
+	}
 
 	data[0] = (void *) &idi->dbinfo.instance_id;
 
 	if (!OCI_BindUnsignedInt(idi->dbinfo.oci_statement_objects_select_cached, MT(":X1"), (uint *) data[0])) {
+		pthread_mutex_unlock(&cache->load_lock);
 		return IDO_ERROR;
 	}
 
 	/* execute statement */
 	if (!OCI_Execute(idi->dbinfo.oci_statement_objects_select_cached)) {
 		ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_query_objects_select_cached() execute error\n");
+		pthread_mutex_unlock(&cache->load_lock);
 		return IDO_ERROR;
 	}
 
@@ -625,6 +700,12 @@ int ido2db_get_cached_object_ids(ido2db_idi *idi) {
 
 #endif /* Oracle ocilib specific */
 
+	/* only a complete load counts, the next hello tries again otherwise */
+	if (result == IDO_OK)
+		cache->loaded = IDO_TRUE;
+
+	pthread_mutex_unlock(&cache->load_lock);
+
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_get_cached_object_ids(%lu) end\n", object_id);
 
 	return result;
@@ -635,6 +716,7 @@ int ido2db_get_cached_object_id(ido2db_idi *idi, int object_type, char *name1,
 	int result = IDO_ERROR;
 	int hashslot = 0;
 	int compare = 0;
+	ido2db_object_cache *cache = NULL;
 	ido2db_dbobject *temp_object = NULL;
 	int y = 0;
 
@@ -645,10 +727,12 @@ int ido2db_get_cached_object_id(ido2db_idi *idi, int object_type, char *name1,
 	printf("OBJECT LOOKUP: type=%d, name1=%s, name2=%s\n", object_type, (name1 == NULL) ? "NULL" : name1, (name2 == NULL) ? "NULL" : name2);
 #endif
 
-	if (idi->dbinfo.object_hashlist == NULL)
+	if ((cache = idi->dbinfo.object_cache) == NULL)
 		return IDO_ERROR;
 
-	for (temp_object = idi->dbinfo.object_hashlist[hashslot], y = 0; temp_object
+	pthread_rwlock_rdlock(&cache->lock);
+
+	for (temp_object = cache->hashlist[hashslot], y = 0; temp_object
 	        != NULL; temp_object = temp_object->nexthash, y++) {
 #ifdef IDO2DB_DEBUG_CACHING
 		printf("OBJECT LOOKUP LOOPING [%d][%d]: type=%d, id=%lu, name1=%s, name2=%s\n", hashslot, y, temp_object->object_type, temp_object->object_id, (temp_object->name1 == NULL) ? "NULL" : temp_object->name1, (temp_object->name2 == NULL) ? "NULL" : temp_object->name2);
@@ -675,6 +759,8 @@ int ido2db_get_cached_object_id(ido2db_idi *idi, int object_type, char *name1,
 	}
 #endif
 
+	pthread_rwlock_unlock(&cache->lock);
+
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_get_cached_object_id(%lu) end\n", *object_id);
 
 	return result;
@@ -685,7 +771,7 @@ int ido2db_add_cached_object_id(ido2db_idi *idi, int object_type, char *n1, char
 	ido2db_dbobject *temp_object = NULL;
 	ido2db_dbobject *lastpointer = NULL;
 	ido2db_dbobject *new_object = NULL;
-	int x = 0;
+	ido2db_object_cache *cache = NULL;
 	int y = 0;
 	int hashslot = 0;
 	int compare = 0;
@@ -711,17 +797,9 @@ int ido2db_add_cached_object_id(ido2db_idi *idi, int object_type, char *n1, char
 	printf("OBJECT CACHE ADD: type=%d, id=%lu, name1=%s, name2=%s\n", object_type, object_id, (name1 == NULL) ? "NULL" : name1, (name2 == NULL) ? "NULL" : name2);
 #endif
 
-	/* initialize hash list if necessary */
-	if (idi->dbinfo.object_hashlist == NULL) {
-
-		idi->dbinfo.object_hashlist = (ido2db_dbobject **) malloc(
-		                                  sizeof(ido2db_dbobject *) * IDO2DB_OBJECT_HASHSLOTS);
-		if (idi->dbinfo.object_hashlist == NULL)
-			return IDO_ERROR;
-
-		for (x = 0; x < IDO2DB_OBJECT_HASHSLOTS; x++)
-			idi->dbinfo.object_hashlist[x] = NULL;
-	}
+	/* attach to the instance's cache if necessary */
+	if ((cache = ido2db_attach_object_cache(idi)) == NULL)
+		return IDO_ERROR;
 
 	/* allocate and populate new object */
 	if ((new_object = (ido2db_dbobject *) malloc(sizeof(ido2db_dbobject)))
@@ -739,8 +817,10 @@ int ido2db_add_cached_object_id(ido2db_idi *idi, int object_type, char *n1, char
 	hashslot = ido2db_object_hashfunc(new_object->name1, new_object->name2,
 	                                  IDO2DB_OBJECT_HASHSLOTS);
 
+	pthread_rwlock_wrlock(&cache->lock);
+
 	lastpointer = NULL;
-	for (temp_object = idi->dbinfo.object_hashlist[hashslot], y = 0; temp_object
+	for (temp_object = cache->hashlist[hashslot], y = 0; temp_object
 	        != NULL; temp_object = temp_object->nexthash, y++) {
 		compare = ido2db_compare_object_hashdata(temp_object->name1,
 		          temp_object->name2, new_object->name1, new_object->name2);
@@ -752,9 +832,11 @@ int ido2db_add_cached_object_id(ido2db_idi *idi, int object_type, char *n1, char
 	if (lastpointer)
 		lastpointer->nexthash = new_object;
 	else
-		idi->dbinfo.object_hashlist[hashslot] = new_object;
+		cache->hashlist[hashslot] = new_object;
 	new_object->nexthash = temp_object;
 
+	pthread_rwlock_unlock(&cache->lock);
+
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_add_cached_object_id() end\n");
 
 	return result;
@@ -825,40 +907,272 @@ int ido2db_compare_object_hashdata(const char *val1a, const char *val1b,
 }
 
 /*
- * free cached object ids
+ * detach from the cached object ids, freeing them with the last connection
  */
 int ido2db_free_cached_object_ids(ido2db_idi *idi) {
 	int x = 0;
+	ido2db_object_cache *cache = NULL;
+	ido2db_object_cache **prev = NULL;
 	ido2db_dbobject *temp_object = NULL;
 	ido2db_dbobject *next_object = NULL;
 
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_free_cached_object_ids() start\n");
 
-	if (idi == NULL)
+	if (idi == NULL || (cache = idi->dbinfo.object_cache) == NULL)
 		return IDO_OK;
 
-	if (idi->dbinfo.object_hashlist) {
+	idi->dbinfo.object_cache = NULL;
 
-		for (x = 0; x < IDO2DB_OBJECT_HASHSLOTS; x++) {
-			for (temp_object = idi->dbinfo.object_hashlist[x]; temp_object
-			        != NULL; temp_object = next_object) {
-				next_object = temp_object->nexthash;
-				free(temp_object->name1);
-				free(temp_object->name2);
-				free(temp_object);
-			}
+	pthread_mutex_lock(&ido2db_object_caches_lock);
+
+	if (--cache->refs > 0) {
+		pthread_mutex_unlock(&ido2db_object_caches_lock);
+		return IDO_OK;
+	}
+
+	for (prev = &ido2db_object_caches; *prev != NULL; prev = &(*prev)->next) {
+		if (*prev == cache) {
+			*prev = cache->next;
+			break;
 		}
+	}
+
+	pthread_mutex_unlock(&ido2db_object_caches_lock);
 
-		free(idi->dbinfo.object_hashlist);
-		idi->dbinfo.object_hashlist = NULL;
+	for (x = 0; x < IDO2DB_OBJECT_HASHSLOTS; x++) {
+		for (temp_object = cache->hashlist[x]; temp_object
+		        != NULL; temp_object = next_object) {
+			next_object = temp_object->nexthash;
+			free(temp_object->name1);
+			free(temp_object->name2);
+			free(temp_object);
+		}
 	}
 
+	free(cache->hashlist);
+	pthread_mutex_destroy(&cache->load_lock);
+	pthread_rwlock_destroy(&cache->lock);
+	free(cache);
+
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_free_cached_object_ids() end\n");
 
 	return IDO_OK;
 }
 
 
+/*
+ * with status_flush_interval set, host and service status updates are held
+ * back and only the newest update of each object is written on the next
+ * flush - the updates replaced in between never hit the database
+ */
+static void ido2db_free_status_entry_data(ido2db_status_entry *entry) {
+	int x = 0;
+
+	for (x = 0; x < entry->data_count; x++)
+		free(entry->data[x]);
+	free(entry->data);
+	free(entry->data_types);
+
+	entry->data = NULL;
+	entry->data_types = NULL;
+	entry->data_count = 0;
+
+	return;
+}
+
+/* takes over the status update currently in buffered_input, returns IDO_FALSE if it must be written right away */
+int ido2db_status_cache_add(ido2db_idi *idi, int object_type, unsigned long object_id) {
+	ido2db_status_cache *cache = NULL;
+	ido2db_status_entry *entry = NULL;
+	int *data_types = NULL;
+	char **data = NULL;
+	int hashslot = 0;
+	int count = 0;
+	int x = 0;
+
+	if (idi == NULL || idi->dbinfo.status_flush_interval == 0L || object_id == 0L)
+		return IDO_FALSE;
+
+	cache = &idi->status_cache;
+
+	/* updates replayed by a flush go to the database */
+	if (cache->flushing == IDO_TRUE)
+		return IDO_FALSE;
+
+	if (cache->hashlist == NULL) {
+		if ((cache->hashlist = (ido2db_status_entry **)calloc(IDO2DB_STATUS_HASHSLOTS, sizeof(ido2db_status_entry *))) == NULL)
+			return IDO_FALSE;
+		cache->last_flush_time = time(NULL);
+	}
+
+	hashslot = (object_id + object_type) % IDO2DB_STATUS_HASHSLOTS;
+	for (entry = cache->hashlist[hashslot]; entry != NULL; entry = entry->nexthash) {
+		if (entry->object_id == object_id && entry->object_type == object_type)
+			break;
+	}
+
+	for (x = 0; x < IDO_MAX_DATA_TYPES; x++) {
+		if (idi->buffered_input[x] != NULL)
+			count++;
+	}
+
+	data_types = (int *)malloc(sizeof(int) * (count + 1));
+	data = (char **)malloc(sizeof(char *) * (count + 1));
+
+	if (data_types == NULL || data == NULL) {
+		free(data_types);
+		free(data);
+		/* an older update must not be written over this one later */
+		if (entry != NULL)
+			ido2db_free_status_entry_data(entry);
+		return IDO_FALSE;
+	}
+
+	if (entry == NULL) {
+		if ((entry = (ido2db_status_entry *)calloc(1, sizeof(ido2db_status_entry))) == NULL) {
+			free(data_types);
+			free(data);
+			return IDO_FALSE;
+		}
+
+		entry->object_type = object_type;
+		entry->object_id = object_id;
+
+		entry->nexthash = cache->hashlist[hashslot];
+		cache->hashlist[hashslot] = entry;
+
+		if (cache->tail == NULL)
+			cache->head = entry;
+		else
+			cache->tail->next = entry;
+		cache->tail = entry;
+	} else {
+		/* the previous update of this object is never written */
+		ido2db_free_status_entry_data(entry);
+		cache->coalesced++;
+	}
+
+	/* steal the input, so it isn't freed with the rest of the message */
+	for (x = 0; x < IDO_MAX_DATA_TYPES; x++) {
+		if (idi->buffered_input[x] == NULL)
+			continue;
+		data_types[entry->data_count] = x;
+		data[entry->data_count] = idi->buffered_input[x];
+		entry->data_count++;
+		idi->buffered_input[x] = NULL;
+	}
+
+	entry->data_types = data_types;
+	entry->data = data;
+
+	cache->updates++;
+
+	return IDO_TRUE;
+}
+
+/* writes the cached status updates once the flush interval has passed, or right away if forced */
+int ido2db_status_cache_flush(ido2db_idi *idi, int force) {
+	ido2db_status_cache *cache = NULL;
+	ido2db_status_entry *entry = NULL;
+	ido2db_status_entry *next_entry = NULL;
+	char **saved_input = NULL;
+	char **input = NULL;
+	unsigned long written = 0L;
+	time_t current_time;
+	int x = 0;
+
+	if (idi == NULL)
+		return IDO_OK;
+
+	cache = &idi->status_cache;
+
+	if (cache->head == NULL)
+		return IDO_OK;
+
+	time(&current_time);
+	if (force == IDO_FALSE && (unsigned long)(current_time - cache->last_flush_time) < idi->dbinfo.status_flush_interval)
+		return IDO_OK;
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_status_cache_flush() start\n");
+
+	if ((input = (char **)calloc(IDO_MAX_DATA_TYPES, sizeof(char *))) == NULL)
+		return IDO_ERROR;
+
+	/* replay the updates through the regular handlers */
+	saved_input = idi->buffered_input;
+	idi->buffered_input = input;
+	cache->flushing = IDO_TRUE;
+
+	for (entry = cache->head; entry != NULL; entry = next_entry) {
+		next_entry = entry->next;
+
+		cache->hashlist[(entry->object_id + entry->object_type) % IDO2DB_STATUS_HASHSLOTS] = NULL;
+
+		if (entry->data_count > 0) {
+			for (x = 0; x < entry->data_count; x++)
+				input[entry->data_types[x]] = entry->data[x];
+
+			if (entry->object_type == IDO2DB_OBJECTTYPE_HOST)
+				ido2db_handle_hoststatusdata(idi);
+			else
+				ido2db_handle_servicestatusdata(idi);
+
+			for (x = 0; x < entry->data_count; x++)
+				input[entry->data_types[x]] = NULL;
+
+			written++;
+		}
+
+		ido2db_free_status_entry_data(entry);
+		free(entry);
+	}
+
+	cache->flushing = IDO_FALSE;
+	idi->buffered_input = saved_input;
+	free(input);
+
+	cache->head = NULL;
+	cache->tail = NULL;
+	cache->last_flush_time = current_time;
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_status_cache_flush() end - %lu written, %lu of %lu updates coalesced so far\n", written, cache->coalesced, cache->updates);
+
+	return IDO_OK;
+}
+
+/* returns when the cached status updates are due, 0 if there are none */
+time_t ido2db_status_cache_next_flush(ido2db_idi *idi) {
+
+	if (idi == NULL || idi->status_cache.head == NULL)
+		return (time_t)0;
+
+	return idi->status_cache.last_flush_time + (time_t)idi->dbinfo.status_flush_interval;
+}
+
+/* drops the cached status updates without writing them */
+int ido2db_status_cache_free(ido2db_idi *idi) {
+	ido2db_status_entry *entry = NULL;
+	ido2db_status_entry *next_entry = NULL;
+
+	if (idi == NULL)
+		return IDO_OK;
+
+	for (entry = idi->status_cache.head; entry != NULL; entry = next_entry) {
+		next_entry = entry->next;
+		ido2db_free_status_entry_data(entry);
+		free(entry);
+	}
+
+	free(idi->status_cache.hashlist);
+
+	idi->status_cache.hashlist = NULL;
+	idi->status_cache.head = NULL;
+	idi->status_cache.tail = NULL;
+
+	return IDO_OK;
+}
+
+
 int ido2db_set_all_objects_as_inactive(ido2db_idi *idi) {
 	int result = IDO_OK;
 #ifdef USE_LIBDBI
@@ -1162,8 +1476,10 @@ int ido2db_handle_object_enable_disable(ido2db_idi *idi, int enable) {
 /****************************************************************************/
 
 int ido2db_handle_logentry(ido2db_idi *idi) {
+	char *saveptr = NULL;
 	char *ptr = NULL;
 	char *buf = NULL;
+	char *row_start = NULL;
 	char *es[1];
 	time_t etime = 0L;
 	char *ts[1];
@@ -1192,13 +1508,13 @@ int ido2db_handle_logentry(ido2db_idi *idi) {
 		object_id = 0L;
 
 	/* break log entry in pieces */
-	if ((ptr = strtok(idi->buffered_input[IDO_DATA_LOGENTRY], "]")) == NULL)
+	if ((ptr = strtok_r(idi->buffered_input[IDO_DATA_LOGENTRY], "]", &saveptr)) == NULL)
 		return IDO_ERROR;
 	if ((ido2db_convert_string_to_unsignedlong(ptr + 1,
 	        (unsigned long *) &etime)) == IDO_ERROR)
 		return IDO_ERROR;
 	ts[0] = ido2db_db_timet_to_sql(idi, etime);
-	if ((ptr = strtok(NULL, "\x0")) == NULL)
+	if ((ptr = strtok_r(NULL, "\x0", &saveptr)) == NULL)
 		return IDO_ERROR;
 	es[0] = ido2db_db_escape_string(idi, (ptr + 1));
 
@@ -1216,27 +1532,46 @@ int ido2db_handle_logentry(ido2db_idi *idi) {
 
 	/* make sure we aren't importing a duplicate log entry... */
 #ifdef USE_LIBDBI /* everything else will be libdbi */
+	/* the row values up to the object id, which a duplicate has the same */
 	switch (idi->dbinfo.server_type) {
 	case IDO2DB_DBSERVER_PGSQL:
-		if (asprintf(&buf, "SELECT logentry_id FROM %s WHERE instance_id=%lu AND logentry_time=%s AND logentry_data=E'%s'", ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES], idi->dbinfo.instance_id, ts[0], es[0]) == -1)
-			buf = NULL;
+		if (asprintf(&row_start, "(%lu, %s, %s, '0', %d, E'%s', '0', '0', ", idi->dbinfo.instance_id, ts[0], ts[0], type, (es[0] == NULL) ? "" : es[0]) == -1)
+			row_start = NULL;
 		break;
 	default:
-		if (asprintf(&buf, "SELECT logentry_id FROM %s WHERE instance_id=%lu AND logentry_time=%s AND logentry_data='%s'", ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES], idi->dbinfo.instance_id, ts[0], es[0]) == -1)
-			buf = NULL;
+		if (asprintf(&row_start, "(%lu, %s, %s, '0', %d, '%s', '0', '0', ", idi->dbinfo.instance_id, ts[0], ts[0], type, (es[0] == NULL) ? "" : es[0]) == -1)
+			row_start = NULL;
 		break;
 	}
 
-	if ((result = ido2db_db_query(idi, buf)) == IDO_OK) {
-		if (idi->dbinfo.dbi_result != NULL) {
-			if (dbi_result_next_row(idi->dbinfo.dbi_result) != 0)
-				duplicate_record = IDO_TRUE;
+	/* entries still queued for insert aren't in the database yet */
+	if (row_start != NULL && ido2db_db_txbuf_has_insert(&(idi->txbuf), IDO2DB_INSERT_BATCH_LOGENTRIES, row_start) == IDO_TRUE)
+		duplicate_record = IDO_TRUE;
+
+	else {
+		switch (idi->dbinfo.server_type) {
+		case IDO2DB_DBSERVER_PGSQL:
+			if (asprintf(&buf, "SELECT logentry_id FROM %s WHERE instance_id=%lu AND logentry_time=%s AND logentry_data=E'%s'", ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES], idi->dbinfo.instance_id, ts[0], es[0]) == -1)
+				buf = NULL;
+			break;
+		default:
+			if (asprintf(&buf, "SELECT logentry_id FROM %s WHERE instance_id=%lu AND logentry_time=%s AND logentry_data='%s'", ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES], idi->dbinfo.instance_id, ts[0], es[0]) == -1)
+				buf = NULL;
+			break;
 		}
-	}
 
-	dbi_result_free(idi->dbinfo.dbi_result);
-	idi->dbinfo.dbi_result = NULL;
-	free(buf);
+		if ((result = ido2db_db_query(idi, buf)) == IDO_OK) {
+			if (idi->dbinfo.dbi_result != NULL) {
+				if (dbi_result_next_row(idi->dbinfo.dbi_result) != 0)
+					duplicate_record = IDO_TRUE;
+			}
+		}
+
+		dbi_result_free(idi->dbinfo.dbi_result);
+		idi->dbinfo.dbi_result = NULL;
+		free(buf);
+		buf = NULL;
+	}
 
 #endif
 
@@ -1293,6 +1628,7 @@ int ido2db_handle_logentry(ido2db_idi *idi) {
 #ifdef IDO2DB_DEBUG
 		printf("IGNORING DUPLICATE LOG RECORD!\n");
 #endif
+		free(row_start);
 		return IDO_OK;
 	}
 
@@ -1300,51 +1636,19 @@ int ido2db_handle_logentry(ido2db_idi *idi) {
 
 #ifdef USE_LIBDBI /* everything else will be libdbi */
 	/* save entry to db */
-	switch (idi->dbinfo.server_type) {
-	case IDO2DB_DBSERVER_PGSQL:
-		if (object_id != 0) {
-		        if (asprintf(
-		                    &buf,
-	        	            "INSERT INTO %s (instance_id, logentry_time, entry_time, entry_time_usec, logentry_type, logentry_data, realtime_data, inferred_data_extracted, object_id) VALUES (%lu, %s, %s, '0', %d, E'%s', '0', '0', %lu)",
-	                	    ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES],
-		                    idi->dbinfo.instance_id, ts[0], ts[0], type, (es[0] == NULL) ? ""
-		                    : es[0], object_id) == -1)
-	        	        buf = NULL;
-		} else {
-		        if (asprintf(
-		                    &buf,
-	        	            "INSERT INTO %s (instance_id, logentry_time, entry_time, entry_time_usec, logentry_type, logentry_data, realtime_data, inferred_data_extracted) VALUES (%lu, %s, %s, '0', %d, E'%s', '0', '0')",
-	                	    ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES],
-		                    idi->dbinfo.instance_id, ts[0], ts[0], type, (es[0] == NULL) ? ""
-		                    : es[0]) == -1)
-	        	        buf = NULL;
-		}
-		break;
-	default:
-		if (object_id != 0) {
-		        if (asprintf(
-		                    &buf,
-        		            "INSERT INTO %s (instance_id, logentry_time, entry_time, entry_time_usec, logentry_type, logentry_data, realtime_data, inferred_data_extracted, object_id) VALUES (%lu, %s, %s, '0', %d, '%s', '0', '0', %lu)",
-	                	    ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES],
-		                    idi->dbinfo.instance_id, ts[0], ts[0], type, (es[0] == NULL) ? ""
-		                    : es[0], object_id) == -1)
-	        	        buf = NULL;
-		} else {
-		        if (asprintf(
-		                    &buf,
-        		            "INSERT INTO %s (instance_id, logentry_time, entry_time, entry_time_usec, logentry_type, logentry_data, realtime_data, inferred_data_extracted) VALUES (%lu, %s, %s, '0', %d, '%s', '0', '0')",
-	                	    ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES],
-		                    idi->dbinfo.instance_id, ts[0], ts[0], type, (es[0] == NULL) ? ""
-		                    : es[0]) == -1)
-	        	        buf = NULL;
-		}
-		break;
+	if (row_start == NULL)
+		buf = NULL;
+	else if (object_id != 0) {
+		if (asprintf(&buf, "%s%lu)", row_start, object_id) == -1)
+			buf = NULL;
+	} else {
+		if (asprintf(&buf, "%sNULL)", row_start) == -1)
+			buf = NULL;
 	}
+	free(row_start);
 
-	result = ido2db_db_query(idi, buf);
-
-	dbi_result_free(idi->dbinfo.dbi_result);
-	idi->dbinfo.dbi_result = NULL;
+	/* queue the row for a multi-row insert */
+	result = ido2db_db_txbuf_add_insert(idi, IDO2DB_INSERT_BATCH_LOGENTRIES, IDO2DB_DBTABLE_LOGENTRIES, ido2db_logentries_columns, buf);
 #endif
 
 #ifdef USE_PGSQL /* pgsql */
@@ -1790,16 +2094,14 @@ int ido2db_handle_logdata(ido2db_idi *idi) {
                 if (object_id != 0) {
                         if (asprintf(
                                     &buf,
-                                    "INSERT INTO %s (instance_id, logentry_time, entry_time, entry_time_usec, logentry_type, logentry_data, realtime_data, inferred_data_extracted, object_id) VALUES (%lu, %s, %s, '0', %d, E'%s', '1', '1', %lu)",
-                                    ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES],
+                                    "(%lu, %s, %s, '0', %d, E'%s', '1', '1', %lu)",
                                     idi->dbinfo.instance_id, ts[0], ts[0], type, (es[0] == NULL) ? ""
                                     : es[0], object_id) == -1)
                                 buf = NULL;
                 } else {
                         if (asprintf(
                                     &buf,
-                                    "INSERT INTO %s (instance_id, logentry_time, entry_time, entry_time_usec, logentry_type, logentry_data, realtime_data, inferred_data_extracted) VALUES (%lu, %s, %s, '0', %d, E'%s', '1', '1')",
-                                    ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES],
+                                    "(%lu, %s, %s, '0', %d, E'%s', '1', '1', NULL)",
                                     idi->dbinfo.instance_id, ts[0], ts[0], type, (es[0] == NULL) ? ""
                                     : es[0]) == -1)
                                 buf = NULL;
@@ -1809,16 +2111,14 @@ int ido2db_handle_logdata(ido2db_idi *idi) {
                 if (object_id != 0) {
                         if (asprintf(
                                     &buf,
-                                    "INSERT INTO %s (instance_id, logentry_time, entry_time, entry_time_usec, logentry_type, logentry_data, realtime_data, inferred_data_extracted, object_id) VALUES (%lu, %s, %s, '0', %d, '%s', '1', '1', %lu)",
-                                    ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES],
+                                    "(%lu, %s, %s, '0', %d, '%s', '1', '1', %lu)",
                                     idi->dbinfo.instance_id, ts[0], ts[0], type, (es[0] == NULL) ? ""
                                     : es[0], object_id) == -1)
                                 buf = NULL;
                 } else {
                         if (asprintf(
                                     &buf,
-                                    "INSERT INTO %s (instance_id, logentry_time, entry_time, entry_time_usec, logentry_type, logentry_data, realtime_data, inferred_data_extracted) VALUES (%lu, %s, %s, '0', %d, '%s', '1', '1')",
-                                    ido2db_db_tablenames[IDO2DB_DBTABLE_LOGENTRIES],
+                                    "(%lu, %s, %s, '0', %d, '%s', '1', '1', NULL)",
                                     idi->dbinfo.instance_id, ts[0], ts[0], type, (es[0] == NULL) ? ""
                                     : es[0]) == -1)
                                 buf = NULL;
@@ -1827,10 +2127,8 @@ int ido2db_handle_logdata(ido2db_idi *idi) {
         }
 
 
-	result = ido2db_db_query(idi, buf);
-	dbi_result_free(idi->dbinfo.dbi_result);
-	idi->dbinfo.dbi_result = NULL;
-
+	/* queue the row for a multi-row insert */
+	result = ido2db_db_txbuf_add_insert(idi, IDO2DB_INSERT_BATCH_LOGENTRIES, IDO2DB_DBTABLE_LOGENTRIES, ido2db_logentries_columns, buf);
 #endif
 
 #ifdef USE_PGSQL /* pgsql */
@@ -3738,10 +4036,13 @@ int ido2db_handle_hoststatusdata(ido2db_idi *idi) {
 
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_handle_hoststatusdata() LongLen:%d\n", strlen(es[1]));
 
-	ido2db_query_insert_or_update_hoststatusdata_add(idi, data);
+	/* held back and coalesced with later updates, if enabled */
+	if (ido2db_status_cache_add(idi, IDO2DB_OBJECTTYPE_HOST, object_id) == IDO_FALSE)
+		ido2db_query_insert_or_update_hoststatusdata_add(idi, data);
 
-	/* save custom variables to db */
-	ido2db_save_custom_variables(idi, IDO2DB_DBTABLE_CUSTOMVARIABLESTATUS, object_id, ts[0], tstamp.tv_sec);
+	/* save custom variables to db - a status cache flush has no custom variables of its own */
+	if (idi->status_cache.flushing == IDO_FALSE)
+		ido2db_save_custom_variables(idi, IDO2DB_DBTABLE_CUSTOMVARIABLESTATUS, object_id, ts[0], tstamp.tv_sec);
 
 	/* free memory */
 	for (x = 0; x < ICINGA_SIZEOF_ARRAY(ts); x++)
@@ -3942,14 +4243,17 @@ int ido2db_handle_servicestatusdata(ido2db_idi *idi) {
 	data[56] = (void *) &last_notification;
 	data[57] = (void *) &next_notification;
 
-	ido2db_query_insert_or_update_servicestatusdata_add(idi, data);
+	/* held back and coalesced with later updates, if enabled */
+	if (ido2db_status_cache_add(idi, IDO2DB_OBJECTTYPE_SERVICE, object_id) == IDO_FALSE)
+		ido2db_query_insert_or_update_servicestatusdata_add(idi, data);
 
 	/* free memory */
 	for (x = 0; x < ICINGA_SIZEOF_ARRAY(es); x++)
 		free(es[x]);
 
-	/* save custom variables to db */
-	ido2db_save_custom_variables(idi, IDO2DB_DBTABLE_CUSTOMVARIABLESTATUS, object_id, ts[0], tstamp.tv_sec);
+	/* save custom variables to db - a status cache flush has no custom variables of its own */
+	if (idi->status_cache.flushing == IDO_FALSE)
+		ido2db_save_custom_variables(idi, IDO2DB_DBTABLE_CUSTOMVARIABLESTATUS, object_id, ts[0], tstamp.tv_sec);
 
 	/* free memory */
 	for (x = 0; x < ICINGA_SIZEOF_ARRAY(ts); x++)
@@ -4518,8 +4822,7 @@ int ido2db_handle_statechangedata(ido2db_idi *idi) {
         case IDO2DB_DBSERVER_PGSQL:
 	        if (asprintf(
         	            &buf,
-	                    "INSERT INTO %s (instance_id, state_time, state_time_usec, object_id, state_change, state, state_type, current_check_attempt, max_check_attempts, last_state, last_hard_state, output, long_output) VALUES (%lu, %s, %lu, %lu, %d, %d, %d, %d, %d, %d, %d, E'%s', E'%s')",
-	                    ido2db_db_tablenames[IDO2DB_DBTABLE_STATEHISTORY],
+	                    "(%lu, %s, %lu, %lu, %d, %d, %d, %d, %d, %d, %d, E'%s', E'%s')",
 	                    idi->dbinfo.instance_id, ts[0], tstamp.tv_usec, object_id,
 	                    state_change_occurred, state, state_type, current_attempt,
 	                    max_attempts, last_state, last_hard_state, es[0], es[1]) == -1)
@@ -4528,8 +4831,7 @@ int ido2db_handle_statechangedata(ido2db_idi *idi) {
         default:
 	        if (asprintf(
 	                    &buf,
-	                    "INSERT INTO %s (instance_id, state_time, state_time_usec, object_id, state_change, state, state_type, current_check_attempt, max_check_attempts, last_state, last_hard_state, output, long_output) VALUES (%lu, %s, %lu, %lu, %d, %d, %d, %d, %d, %d, %d, '%s', '%s')",
-	                    ido2db_db_tablenames[IDO2DB_DBTABLE_STATEHISTORY],
+	                    "(%lu, %s, %lu, %lu, %d, %d, %d, %d, %d, %d, %d, '%s', '%s')",
 	                    idi->dbinfo.instance_id, ts[0], tstamp.tv_usec, object_id,
 	                    state_change_occurred, state, state_type, current_attempt,
 	                    max_attempts, last_state, last_hard_state, es[0], es[1]) == -1)
@@ -4537,10 +4839,8 @@ int ido2db_handle_statechangedata(ido2db_idi *idi) {
                 break;
         }
 
-	result = ido2db_db_query(idi, buf);
-
-	dbi_result_free(idi->dbinfo.dbi_result);
-	idi->dbinfo.dbi_result = NULL;
+	/* queue the row for a multi-row insert */
+	result = ido2db_db_txbuf_add_insert(idi, IDO2DB_INSERT_BATCH_STATEHISTORY, IDO2DB_DBTABLE_STATEHISTORY, ido2db_statehistory_columns, buf);
 #endif
 
 #ifdef USE_PGSQL /* pgsql */
@@ -4648,6 +4948,7 @@ int ido2db_handle_statechangedata(ido2db_idi *idi) {
 /****************************************************************************/
 
 int ido2db_handle_configfilevariables(ido2db_idi *idi, int configfile_type) {
+	char *saveptr = NULL;
 	int type, flags, attr;
 	struct timeval tstamp;
 	unsigned long configfile_id = 0L;
@@ -4753,8 +5054,8 @@ int ido2db_handle_configfilevariables(ido2db_idi *idi, int configfile_type) {
 			continue;
 
 		/* get var name/val pair */
-		varname = strtok(mbuf.buffer[x], "=");
-		varvalue = strtok(NULL, "\x0");
+		varname = strtok_r(mbuf.buffer[x], "=", &saveptr);
+		varvalue = strtok_r(NULL, "\x0", &saveptr);
 
 		es[1] = ido2db_db_escape_string(idi, varname);
 		es[2] = ido2db_db_escape_string(idi, varvalue);
@@ -4897,6 +5198,7 @@ int ido2db_handle_configvariables(ido2db_idi *idi) {
 }
 
 int ido2db_handle_runtimevariables(ido2db_idi *idi) {
+	char *saveptr = NULL;
 	int type, flags, attr;
 	struct timeval tstamp;
 	char *es[2];
@@ -4977,8 +5279,8 @@ int ido2db_handle_runtimevariables(ido2db_idi *idi) {
 			continue;
 
 		/* get var name/val pair */
-		varname = strtok(mbuf.buffer[x], "=");
-		varvalue = strtok(NULL, "\x0");
+		varname = strtok_r(mbuf.buffer[x], "=", &saveptr);
+		varvalue = strtok_r(NULL, "\x0", &saveptr);
 
 		es[0] = ido2db_db_escape_string(idi, varname);
 		es[1] = ido2db_db_escape_string(idi, varvalue);
@@ -5138,6 +5440,7 @@ int ido2db_handle_configdumpend(ido2db_idi *idi) {
 }
 
 int ido2db_handle_hostdefinition(ido2db_idi *idi) {
+	char *saveptr = NULL;
 	int type, flags, attr;
 	struct timeval tstamp;
 	unsigned long object_id = 0L;
@@ -5261,14 +5564,14 @@ int ido2db_handle_hostdefinition(ido2db_idi *idi) {
 	es[1] = ido2db_db_escape_string(idi, idi->buffered_input[IDO_DATA_HOSTFAILUREPREDICTIONOPTIONS]);
 
 	/* get the check command */
-	cmdptr = strtok(idi->buffered_input[IDO_DATA_HOSTCHECKCOMMAND], "!");
-	argptr = strtok(NULL, "\x0");
+	cmdptr = strtok_r(idi->buffered_input[IDO_DATA_HOSTCHECKCOMMAND], "!", &saveptr);
+	argptr = strtok_r(NULL, "\x0", &saveptr);
 	result = ido2db_get_object_id_with_insert(idi, IDO2DB_OBJECTTYPE_COMMAND, cmdptr, NULL, &check_command_id);
 	es[2] = ido2db_db_escape_string(idi, argptr);
 
 	/* get the event handler command */
-	cmdptr = strtok(idi->buffered_input[IDO_DATA_HOSTEVENTHANDLER], "!");
-	argptr = strtok(NULL, "\x0");
+	cmdptr = strtok_r(idi->buffered_input[IDO_DATA_HOSTEVENTHANDLER], "!", &saveptr);
+	argptr = strtok_r(NULL, "\x0", &saveptr);
 	result = ido2db_get_object_id_with_insert(idi, IDO2DB_OBJECTTYPE_COMMAND, cmdptr, NULL, &eventhandler_command_id);
 	es[3] = ido2db_db_escape_string(idi, argptr);
 
@@ -5986,6 +6289,7 @@ int ido2db_handle_hostgroupdefinition(ido2db_idi *idi) {
 }
 
 int ido2db_handle_servicedefinition(ido2db_idi *idi) {
+	char *saveptr = NULL;
 	int type, flags, attr;
 	struct timeval tstamp;
 	unsigned long object_id = 0L;
@@ -6103,16 +6407,16 @@ int ido2db_handle_servicedefinition(ido2db_idi *idi) {
 	es[0] = ido2db_db_escape_string(idi, idi->buffered_input[IDO_DATA_SERVICEFAILUREPREDICTIONOPTIONS]);
 
 	/* get the check command */
-	cmdptr = strtok(idi->buffered_input[IDO_DATA_SERVICECHECKCOMMAND], "!");
-	argptr = strtok(NULL, "\x0");
+	cmdptr = strtok_r(idi->buffered_input[IDO_DATA_SERVICECHECKCOMMAND], "!", &saveptr);
+	argptr = strtok_r(NULL, "\x0", &saveptr);
 
 	result = ido2db_get_object_id_with_insert(idi, IDO2DB_OBJECTTYPE_COMMAND, cmdptr, NULL, &check_command_id);
 
 	es[1] = ido2db_db_escape_string(idi, argptr);
 
 	/* get the event handler command */
-	cmdptr = strtok(idi->buffered_input[IDO_DATA_SERVICEEVENTHANDLER], "!");
-	argptr = strtok(NULL, "\x0");
+	cmdptr = strtok_r(idi->buffered_input[IDO_DATA_SERVICEEVENTHANDLER], "!", &saveptr);
+	argptr = strtok_r(NULL, "\x0", &saveptr);
 
 	result = ido2db_get_object_id_with_insert(idi, IDO2DB_OBJECTTYPE_COMMAND, cmdptr, NULL, &eventhandler_command_id);
 
@@ -6489,6 +6793,7 @@ int ido2db_handle_servicedefinition(ido2db_idi *idi) {
 }
 
 int ido2db_handle_servicegroupdefinition(ido2db_idi *idi) {
+	char *saveptr = NULL;
 	int type, flags, attr;
 	struct timeval tstamp;
 	unsigned long object_id = 0L;
@@ -6593,8 +6898,8 @@ int ido2db_handle_servicegroupdefinition(ido2db_idi *idi) {
 			continue;
 
 		/* split the host/service name */
-		hptr = strtok(mbuf.buffer[x], ";");
-		sptr = strtok(NULL, "\x0");
+		hptr = strtok_r(mbuf.buffer[x], ";", &saveptr);
+		sptr = strtok_r(NULL, "\x0", &saveptr);
 
 		/* get the object id of the member */
 		result = ido2db_get_object_id_with_insert(idi,
@@ -7072,6 +7377,7 @@ int ido2db_handle_commanddefinition(ido2db_idi *idi) {
 }
 
 int ido2db_handle_timeperiodefinition(ido2db_idi *idi) {
+	char *saveptr = NULL;
 	int type, flags, attr;
 	struct timeval tstamp;
 	unsigned long object_id = 0L;
@@ -7185,9 +7491,9 @@ int ido2db_handle_timeperiodefinition(ido2db_idi *idi) {
 		if (mbuf.buffer[x] == NULL)
 			continue;
 		/* get var name/val pair */
-		dayptr = strtok(mbuf.buffer[x], ":");
-		startptr = strtok(NULL, "-");
-		endptr = strtok(NULL, "\x0");
+		dayptr = strtok_r(mbuf.buffer[x], ":", &saveptr);
+		startptr = strtok_r(NULL, "-", &saveptr);
+		endptr = strtok_r(NULL, "\x0", &saveptr);
 
 		if (startptr == NULL || endptr == NULL)
 			continue;
@@ -7303,6 +7609,7 @@ int ido2db_handle_timeperiodefinition(ido2db_idi *idi) {
 }
 
 int ido2db_handle_contactdefinition(ido2db_idi *idi) {
+	char *saveptr = NULL;
 	int type, flags, attr;
 	struct timeval tstamp;
 	unsigned long contact_id = 0L;
@@ -7421,8 +7728,8 @@ int ido2db_handle_contactdefinition(ido2db_idi *idi) {
 		if (mbuf.buffer[x] == NULL)
 			continue;
 
-		numptr = strtok(mbuf.buffer[x], ":");
-		addressptr = strtok(NULL, "\x0");
+		numptr = strtok_r(mbuf.buffer[x], ":", &saveptr);
+		addressptr = strtok_r(NULL, "\x0", &saveptr);
 
 		if (numptr == NULL || addressptr == NULL)
 			continue;
@@ -7448,8 +7755,8 @@ int ido2db_handle_contactdefinition(ido2db_idi *idi) {
 		if (mbuf.buffer[x] == NULL)
 			continue;
 
-		cmdptr = strtok(mbuf.buffer[x], "!");
-		argptr = strtok(NULL, "\x0");
+		cmdptr = strtok_r(mbuf.buffer[x], "!", &saveptr);
+		argptr = strtok_r(NULL, "\x0", &saveptr);
 
 		if (cmdptr == NULL)
 			continue;
@@ -7478,8 +7785,8 @@ int ido2db_handle_contactdefinition(ido2db_idi *idi) {
 		if (mbuf.buffer[x] == NULL)
 			continue;
 
-		cmdptr = strtok(mbuf.buffer[x], "!");
-		argptr = strtok(NULL, "\x0");
+		cmdptr = strtok_r(mbuf.buffer[x], "!", &saveptr);
+		argptr = strtok_r(NULL, "\x0", &saveptr);
 
 		if (cmdptr == NULL)
 			continue;
@@ -7511,6 +7818,7 @@ int ido2db_handle_contactdefinition(ido2db_idi *idi) {
 }
 
 int ido2db_save_custom_variables(ido2db_idi *idi, int table_idx, unsigned long o_id, char *ts, unsigned long tstamp) {
+	char *saveptr = NULL;
 	char *buf = NULL;
 	ido2db_mbuf mbuf;
 	char *es[2];
@@ -7535,16 +7843,16 @@ int ido2db_save_custom_variables(ido2db_idi *idi, int table_idx, unsigned long o
 		if (mbuf.buffer[x] == NULL)
 			continue;
 
-		if ((ptr1 = strtok(mbuf.buffer[x], ":")) == NULL)
+		if ((ptr1 = strtok_r(mbuf.buffer[x], ":", &saveptr)) == NULL)
 			continue;
 
 		es[0] = strdup(ptr1);
 
-		if ((ptr2 = strtok(NULL, ":")) == NULL)
+		if ((ptr2 = strtok_r(NULL, ":", &saveptr)) == NULL)
 			continue;
 
 		has_been_modified = atoi(ptr2);
-		ptr3 = strtok(NULL, "\n");
+		ptr3 = strtok_r(NULL, "\n", &saveptr);
 		buf = strdup((ptr3 == NULL) ? "" : ptr3);
 		es[1] = ido2db_db_escape_string(idi, buf);
 		free(buf);
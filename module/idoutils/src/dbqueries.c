@@ -25,6 +25,55 @@ extern int errno;
 
 extern char *ido2db_db_tablenames[IDO2DB_MAX_DBTABLES];
 
+/* column lists of the history tables whose rows are queued for multi-row inserts */
+static char ido2db_servicechecks_columns[] =
+	"instance_id, service_object_id, check_type, "
+	"current_check_attempt, max_check_attempts, state, state_type, "
+	"start_time, start_time_usec, end_time, end_time_usec, timeout, "
+	"early_timeout, execution_time, latency, return_code, output, "
+	"long_output, perfdata, command_object_id, command_args, command_line";
+static char ido2db_hostchecks_columns[] =
+	"command_object_id, command_args, command_line, "
+	"instance_id, host_object_id, check_type, is_raw_check, current_check_attempt, "
+	"max_check_attempts, state, state_type, start_time, start_time_usec, end_time, "
+	"end_time_usec, timeout, early_timeout, execution_time, latency, return_code, "
+	"output, long_output, perfdata";
+
+/* column lists of the status tables, also used to define their prepared statements */
+static char ido2db_hoststatus_columns[] =
+	"instance_id, host_object_id, status_update_time, output, long_output, "
+	"perfdata, current_state, has_been_checked, should_be_scheduled, "
+	"current_check_attempt, max_check_attempts, last_check, next_check, "
+	"check_type, last_state_change, last_hard_state_change, "
+	"last_hard_state, last_time_up, last_time_down, last_time_unreachable, "
+	"state_type, last_notification, next_notification, "
+	"no_more_notifications, notifications_enabled, "
+	"problem_has_been_acknowledged, acknowledgement_type, "
+	"current_notification_number, passive_checks_enabled, "
+	"active_checks_enabled, event_handler_enabled, flap_detection_enabled, "
+	"is_flapping, percent_state_change, latency, execution_time, "
+	"scheduled_downtime_depth, failure_prediction_enabled, "
+	"process_performance_data, obsess_over_host, modified_host_attributes, "
+	"event_handler, check_command, normal_check_interval, "
+	"retry_check_interval, check_timeperiod_object_id";
+static char ido2db_servicestatus_columns[] =
+	"instance_id, service_object_id, status_update_time, output, "
+	"long_output, perfdata, current_state, has_been_checked, "
+	"should_be_scheduled, current_check_attempt, max_check_attempts, "
+	"last_check, next_check, check_type, last_state_change, "
+	"last_hard_state_change, last_hard_state, last_time_ok, "
+	"last_time_warning, last_time_unknown, last_time_critical, state_type, "
+	"last_notification, next_notification, no_more_notifications, "
+	"notifications_enabled, problem_has_been_acknowledged, "
+	"acknowledgement_type, current_notification_number, "
+	"passive_checks_enabled, active_checks_enabled, event_handler_enabled, "
+	"flap_detection_enabled, is_flapping, percent_state_change, latency, "
+	"execution_time, scheduled_downtime_depth, failure_prediction_enabled, "
+	"process_performance_data, obsess_over_service, "
+	"modified_service_attributes, event_handler, check_command, "
+	"normal_check_interval, retry_check_interval, "
+	"check_timeperiod_object_id";
+
 /****************************************************************************/
 /* INSERT QUERIES                                                           */
 /****************************************************************************/
@@ -1541,14 +1590,7 @@ int ido2db_query_insert_servicecheckdata_add(ido2db_idi *idi, void **data) {
 				}
 			}
 		}
-                asprintf(&query1,
-                		"INSERT INTO %s (instance_id, service_object_id, check_type, "
-                		"current_check_attempt, max_check_attempts, state, state_type, "
-                		"start_time, start_time_usec, end_time, end_time_usec, timeout, "
-                		"early_timeout, execution_time, latency, return_code, output, "
-                		"long_output, perfdata, command_object_id, command_args, command_line) "
-                		"VALUES (%lu, %lu, %d, %d, %d, %d, %d, %s, %lu, %s, %lu, %d, %d, %lf, %lf, %d, '%s', '%s', '%s', %lu, '%s', '%s')",
-                                 ido2db_db_tablenames[IDO2DB_DBTABLE_SERVICECHECKS],
+                asprintf(&query1, "(%lu, %lu, %d, %d, %d, %d, %d, %s, %lu, %s, %lu, %d, %d, %lf, %lf, %d, '%s', '%s', '%s', %lu, '%s', '%s')",
                                  *(unsigned long *) data[0],     /* insert start */
                                  *(unsigned long *) data[1],
                                  *(int *) data[2],
@@ -1572,16 +1614,12 @@ int ido2db_query_insert_servicecheckdata_add(ido2db_idi *idi, void **data) {
                                  *(char **) data[20],
                                  *(char **) data[21]            /* insert end */
                                 );
-                /* send query to db */
-                result = ido2db_db_query(idi, query1);
+                /* queue the row for a multi-row insert */
+                result = ido2db_db_txbuf_add_insert(idi, IDO2DB_INSERT_BATCH_SERVICECHECKS, IDO2DB_DBTABLE_SERVICECHECKS, ido2db_servicechecks_columns, query1);
                 free(query1);
-		/* free last dbi_result */
-		dbi_result_free(idi->dbinfo.dbi_result);
-		idi->dbinfo.dbi_result = NULL;
                 break;
 	case IDO2DB_DBSERVER_PGSQL:
-		asprintf(&query1, "INSERT INTO %s (instance_id, service_object_id, check_type, current_check_attempt, max_check_attempts, state, state_type, start_time, start_time_usec, end_time, end_time_usec, timeout, early_timeout, execution_time, latency, return_code, output, long_output, perfdata, command_object_id, command_args, command_line) VALUES (%lu, %lu, %d, %d, %d, %d, %d, %s, %lu, %s, %lu, %d, %d, %lf, %lf, %d, E'%s', E'%s', E'%s', %lu, E'%s', E'%s')",
-		                 ido2db_db_tablenames[IDO2DB_DBTABLE_SERVICECHECKS],
+		asprintf(&query1, "(%lu, %lu, %d, %d, %d, %d, %d, %s, %lu, %s, %lu, %d, %d, %lf, %lf, %d, E'%s', E'%s', E'%s', %lu, E'%s', E'%s')",
 		                 *(unsigned long *) data[0],     /* insert start */
 		                 *(unsigned long *) data[1],
 		                 *(int *) data[2],
@@ -1605,12 +1643,9 @@ int ido2db_query_insert_servicecheckdata_add(ido2db_idi *idi, void **data) {
 		                 *(char **) data[20],
 		                 *(char **) data[21]     	/* insert end */
 		                );
-		/* send query to db */
-		result = ido2db_db_query(idi, query1);
+		/* queue the row for a multi-row insert */
+		result = ido2db_db_txbuf_add_insert(idi, IDO2DB_INSERT_BATCH_SERVICECHECKS, IDO2DB_DBTABLE_SERVICECHECKS, ido2db_servicechecks_columns, query1);
 		free(query1);
-		/* free last dbi_result */
-		dbi_result_free(idi->dbinfo.dbi_result);
-		idi->dbinfo.dbi_result = NULL;
 		break;
 	default:
 		break;
@@ -1792,13 +1827,7 @@ int ido2db_query_insert_hostcheckdata_add(ido2db_idi *idi, void **data) {
 				}
 			}
 		}
-                asprintf(&query1, "INSERT INTO %s (command_object_id, command_args, command_line, "
-                				"instance_id, host_object_id, check_type, is_raw_check, current_check_attempt, "
-                				"max_check_attempts, state, state_type, start_time, start_time_usec, end_time, "
-                				"end_time_usec, timeout, early_timeout, execution_time, latency, return_code, "
-                				"output, long_output, perfdata) "
-                				"VALUES (%lu, '%s', '%s', %lu, %lu, %d, %d, %d, %d, %d, %d, %s, %lu, %s, %lu, %d, %d, %lf, %lf, %d, '%s', '%s', '%s')",
-                                 ido2db_db_tablenames[IDO2DB_DBTABLE_HOSTCHECKS],
+                asprintf(&query1, "(%lu, '%s', '%s', %lu, %lu, %d, %d, %d, %d, %d, %d, %s, %lu, %s, %lu, %d, %d, %lf, %lf, %d, '%s', '%s', '%s')",
                                  *(unsigned long *) data[0],     /* insert start */
                                  *(char **) data[1],
                                  *(char **) data[2],
@@ -1823,16 +1852,12 @@ int ido2db_query_insert_hostcheckdata_add(ido2db_idi *idi, void **data) {
                                  *(char **) data[21],
                                  *(char **) data[22]            /* insert end */
                                 );
-                /* send query to db */
-                result = ido2db_db_query(idi, query1);
+                /* queue the row for a multi-row insert */
+                result = ido2db_db_txbuf_add_insert(idi, IDO2DB_INSERT_BATCH_HOSTCHECKS, IDO2DB_DBTABLE_HOSTCHECKS, ido2db_hostchecks_columns, query1);
                 free(query1);
-		/* free last dbi_result */
-		dbi_result_free(idi->dbinfo.dbi_result);
-		idi->dbinfo.dbi_result = NULL;
                 break;
 	case IDO2DB_DBSERVER_PGSQL:
-		asprintf(&query1, "INSERT INTO %s (command_object_id, command_args, command_line, instance_id, host_object_id, check_type, is_raw_check, current_check_attempt, max_check_attempts, state, state_type, start_time, start_time_usec, end_time, end_time_usec, timeout, early_timeout, execution_time, latency, return_code, output, long_output, perfdata) VALUES (%lu, E'%s', E'%s', %lu, %lu, %d, %d, %d, %d, %d, %d, %s, %lu, %s, %lu, %d, %d, %lf, %lf, %d, E'%s', E'%s', E'%s')",
-		                 ido2db_db_tablenames[IDO2DB_DBTABLE_HOSTCHECKS],
+		asprintf(&query1, "(%lu, E'%s', E'%s', %lu, %lu, %d, %d, %d, %d, %d, %d, %s, %lu, %s, %lu, %d, %d, %lf, %lf, %d, E'%s', E'%s', E'%s')",
 		                 *(unsigned long *) data[0],     /* insert start */
 		                 *(char **) data[1],
 		                 *(char **) data[2],
@@ -1857,12 +1882,9 @@ int ido2db_query_insert_hostcheckdata_add(ido2db_idi *idi, void **data) {
 		                 *(char **) data[21],
 		                 *(char **) data[22]            /* insert end */
 		                );
-		/* send query to db */
-		result = ido2db_db_query(idi, query1);
+		/* queue the row for a multi-row insert */
+		result = ido2db_db_txbuf_add_insert(idi, IDO2DB_INSERT_BATCH_HOSTCHECKS, IDO2DB_DBTABLE_HOSTCHECKS, ido2db_hostchecks_columns, query1);
 		free(query1);
-		/* free last dbi_result */
-		dbi_result_free(idi->dbinfo.dbi_result);
-		idi->dbinfo.dbi_result = NULL;
 		break;
 	default:
 		break;
@@ -3585,9 +3607,8 @@ int ido2db_query_insert_or_update_hoststatusdata_add(ido2db_idi *idi, void **dat
 
 
 	case IDO2DB_DBSERVER_PGSQL:
-		asprintf(&query1, "UPDATE %s SET instance_id=%lu, host_object_id=%lu, status_update_time=%s, output=E'%s', long_output=E'%s', perfdata=E'%s', current_state=%d, has_been_checked=%d, should_be_scheduled=%d, current_check_attempt=%d, max_check_attempts=%d, last_check=%s, next_check=%s, check_type=%d, last_state_change=%s, last_hard_state_change=%s, last_hard_state=%d, last_time_up=%s, last_time_down=%s, last_time_unreachable=%s, state_type=%d, last_notification=%s, next_notification=%s, no_more_notifications=%d, notifications_enabled=%d, problem_has_been_acknowledged=%d, acknowledgement_type=%d, current_notification_number=%d, passive_checks_enabled=%d, active_checks_enabled=%d, event_handler_enabled=%d, flap_detection_enabled=%d, is_flapping=%d, percent_state_change='%lf', latency='%lf', execution_time='%lf', scheduled_downtime_depth=%d, failure_prediction_enabled=%d, process_performance_data=%d, obsess_over_host=%d, modified_host_attributes=%lu, event_handler=E'%s', check_command=E'%s', normal_check_interval='%lf', retry_check_interval='%lf', check_timeperiod_object_id=%lu WHERE host_object_id=%lu",
-		                 ido2db_db_tablenames[IDO2DB_DBTABLE_HOSTSTATUS],
-		                 *(unsigned long *) data[0],     /* update start */
+		asprintf(&query1, "(%lu, %lu, %s, E'%s', E'%s', E'%s', %d, %d, %d, %d, %d, %s, %s, %d, %s, %s, %d, %s, %s, %s, %d, %s, %s, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %lf, %lf, %lf, %d, %d, %d, %d, %lu, E'%s', E'%s', %lf, %lf, %lu)",
+		                 *(unsigned long *) data[0],     /* values start */
 		                 *(unsigned long *) data[1],
 		                 *(char **) data[2],
 		                 *(char **) data[3],
@@ -3632,12 +3653,10 @@ int ido2db_query_insert_or_update_hoststatusdata_add(ido2db_idi *idi, void **dat
 		                 *(char **) data[42],
 		                 *(double *) data[43],
 		                 *(double *) data[44],
-		                 *(unsigned long *) data[45],     /* update end */
-		                 *(unsigned long *) data[1]     /* unique constraint start/end */
+		                 *(unsigned long *) data[45]     /* values end */
 		                );
-		/* send query to db */
-		result = ido2db_db_query(idi, query1);
-		free(query1);
+		/* send query to db, as statement prepared once per connection */
+		result = ido2db_db_query_prepared(idi, IDO2DB_PREPARED_HOSTSTATUS_UPDATE, IDO2DB_DBTABLE_HOSTSTATUS, ido2db_hoststatus_columns, "host_object_id", query1);
 
 		/* check result if update was ok */
 		if (dbi_result_get_numrows_affected(idi->dbinfo.dbi_result) == 0) {
@@ -3645,59 +3664,9 @@ int ido2db_query_insert_or_update_hoststatusdata_add(ido2db_idi *idi, void **dat
 			idi->dbinfo.dbi_result = NULL;
 
 			/* try insert instead */
-			asprintf(&query2, "INSERT INTO %s (instance_id, host_object_id, status_update_time, output, long_output, perfdata, current_state, has_been_checked, should_be_scheduled, current_check_attempt, max_check_attempts, last_check, next_check, check_type, last_state_change, last_hard_state_change, last_hard_state, last_time_up, last_time_down, last_time_unreachable, state_type, last_notification, next_notification, no_more_notifications, notifications_enabled, problem_has_been_acknowledged, acknowledgement_type, current_notification_number, passive_checks_enabled, active_checks_enabled, event_handler_enabled, flap_detection_enabled, is_flapping, percent_state_change, latency, execution_time, scheduled_downtime_depth, failure_prediction_enabled, process_performance_data, obsess_over_host, modified_host_attributes, event_handler, check_command, normal_check_interval, retry_check_interval, check_timeperiod_object_id) VALUES (%lu, %lu, %s, E'%s', E'%s', E'%s', %d, %d, %d, %d, %d, %s, %s, %d, %s, %s, %d, %s, %s, %s, %d, %s, %s, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %lf, %lf, %lf, %d, %d, %d, %d, %lu, E'%s', E'%s', %lf, %lf, %lu)",
-			                 ido2db_db_tablenames[IDO2DB_DBTABLE_HOSTSTATUS],
-			                 *(unsigned long *) data[0],     /* insert start */
-			                 *(unsigned long *) data[1],
-			                 *(char **) data[2],
-			                 *(char **) data[3],
-			                 *(char **) data[4],
-			                 *(char **) data[5],
-			                 *(int *) data[6],
-			                 *(int *) data[7],
-			                 *(int *) data[8],
-			                 *(int *) data[9],
-			                 *(int *) data[10],
-			                 *(char **) data[11],
-			                 *(char **) data[12],
-			                 *(int *) data[13],
-			                 *(char **) data[14],
-			                 *(char **) data[15],
-			                 *(int *) data[16],
-			                 *(char **) data[17],
-			                 *(char **) data[18],
-			                 *(char **) data[19],
-			                 *(int *) data[20],
-			                 *(char **) data[21],
-			                 *(char **) data[22],
-			                 *(int *) data[23],
-			                 *(int *) data[24],
-			                 *(int *) data[25],
-			                 *(int *) data[26],
-			                 *(int *) data[27],
-			                 *(int *) data[28],
-			                 *(int *) data[29],
-			                 *(int *) data[30],
-			                 *(int *) data[31],
-			                 *(int *) data[32],
-			                 *(double *) data[33],
-			                 *(double *) data[34],
-			                 *(double *) data[35],
-			                 *(int *) data[36],
-			                 *(int *) data[37],
-			                 *(int *) data[38],
-			                 *(int *) data[39],
-			                 *(unsigned long *) data[40],
-			                 *(char **) data[41],
-			                 *(char **) data[42],
-			                 *(double *) data[43],
-			                 *(double *) data[44],
-			                 *(unsigned long *) data[45]     /* insert end */
-			                );
-			/* send query to db */
-			result = ido2db_db_query(idi, query2);
-			free(query2);
+			result = ido2db_db_query_prepared(idi, IDO2DB_PREPARED_HOSTSTATUS_INSERT, IDO2DB_DBTABLE_HOSTSTATUS, ido2db_hoststatus_columns, NULL, query1);
 		}
+		free(query1);
 		/* free last dbi_result */
 		dbi_result_free(idi->dbinfo.dbi_result);
 		idi->dbinfo.dbi_result = NULL;
@@ -4110,9 +4079,8 @@ int ido2db_query_insert_or_update_servicestatusdata_add(ido2db_idi *idi, void **
                 break;
 
 	case IDO2DB_DBSERVER_PGSQL:
-		asprintf(&query1, "UPDATE %s SET instance_id=%lu, service_object_id=%lu, status_update_time=%s, output=E'%s', long_output=E'%s', perfdata=E'%s', current_state=%d, has_been_checked=%d, should_be_scheduled=%d, current_check_attempt=%d, max_check_attempts=%d, last_check=%s, next_check=%s, check_type=%d, last_state_change=%s, last_hard_state_change=%s, last_hard_state=%d, last_time_ok=%s, last_time_warning=%s, last_time_unknown=%s, last_time_critical=%s, state_type=%d, last_notification=%s, next_notification=%s, no_more_notifications=%d, notifications_enabled=%d, problem_has_been_acknowledged=%d, acknowledgement_type=%d, current_notification_number=%d, passive_checks_enabled=%d, active_checks_enabled=%d, event_handler_enabled=%d, flap_detection_enabled=%d, is_flapping=%d, percent_state_change='%lf', latency='%lf', execution_time='%lf', scheduled_downtime_depth=%d, failure_prediction_enabled=%d, process_performance_data=%d, obsess_over_service=%d, modified_service_attributes=%lu, event_handler=E'%s', check_command=E'%s', normal_check_interval='%lf', retry_check_interval='%lf', check_timeperiod_object_id=%lu WHERE service_object_id=%lu",
-		                 ido2db_db_tablenames[IDO2DB_DBTABLE_SERVICESTATUS],
-		                 *(unsigned long *) data[0],     /* update start */
+		asprintf(&query1, "(%lu, %lu, %s, E'%s', E'%s', E'%s', %d, %d, %d, %d, %d, %s, %s, %d, %s, %s, %d, %s, %s, %s, %s, %d, %s, %s, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, '%lf', '%lf', '%lf', %d, %d, %d, %d, %lu, E'%s', E'%s', '%lf', '%lf', %lu)",
+		                 *(unsigned long *) data[0],     /* values start */
 		                 *(unsigned long *) data[1],
 		                 *(char **) data[2],
 		                 *(char **) data[3],
@@ -4158,13 +4126,10 @@ int ido2db_query_insert_or_update_servicestatusdata_add(ido2db_idi *idi, void **
 		                 *(char **) data[43],
 		                 *(double *) data[44],
 		                 *(double *) data[45],
-		                 *(unsigned long *) data[46],     /* update end */
-		                 *(unsigned long *) data[1]     /* unique constraint start/end */
+		                 *(unsigned long *) data[46]     /* values end */
 		                );
-
-		/* send query to db */
-		result = ido2db_db_query(idi, query1);
-		free(query1);
+		/* send query to db, as statement prepared once per connection */
+		result = ido2db_db_query_prepared(idi, IDO2DB_PREPARED_SERVICESTATUS_UPDATE, IDO2DB_DBTABLE_SERVICESTATUS, ido2db_servicestatus_columns, "service_object_id", query1);
 
 		/* check result if update was ok */
 		if (dbi_result_get_numrows_affected(idi->dbinfo.dbi_result) == 0) {
@@ -4172,60 +4137,9 @@ int ido2db_query_insert_or_update_servicestatusdata_add(ido2db_idi *idi, void **
 			idi->dbinfo.dbi_result = NULL;
 
 			/* try insert instead */
-			asprintf(&query2, "INSERT INTO %s (instance_id, service_object_id, status_update_time, output, long_output, perfdata, current_state, has_been_checked, should_be_scheduled, current_check_attempt, max_check_attempts, last_check, next_check, check_type, last_state_change, last_hard_state_change, last_hard_state, last_time_ok, last_time_warning, last_time_unknown, last_time_critical, state_type, last_notification, next_notification, no_more_notifications, notifications_enabled, problem_has_been_acknowledged, acknowledgement_type, current_notification_number, passive_checks_enabled, active_checks_enabled, event_handler_enabled, flap_detection_enabled, is_flapping, percent_state_change, latency, execution_time, scheduled_downtime_depth, failure_prediction_enabled, process_performance_data, obsess_over_service, modified_service_attributes, event_handler, check_command, normal_check_interval, retry_check_interval, check_timeperiod_object_id) VALUES (%lu, %lu, %s, E'%s', E'%s', E'%s', %d, %d, %d, %d, %d, %s, %s, %d, %s, %s, %d, %s, %s, %s, %s, %d, %s, %s, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, '%lf', '%lf', '%lf', %d, %d, %d, %d, %lu, E'%s', E'%s', '%lf', '%lf', %lu)",
-			                 ido2db_db_tablenames[IDO2DB_DBTABLE_SERVICESTATUS],
-			                 *(unsigned long *) data[0],     /* insert start */
-			                 *(unsigned long *) data[1],
-			                 *(char **) data[2],
-			                 *(char **) data[3],
-			                 *(char **) data[4],
-			                 *(char **) data[5],
-			                 *(int *) data[6],
-			                 *(int *) data[7],
-			                 *(int *) data[8],
-			                 *(int *) data[9],
-			                 *(int *) data[10],
-			                 *(char **) data[11],
-			                 *(char **) data[12],
-			                 *(int *) data[13],
-			                 *(char **) data[14],
-			                 *(char **) data[15],
-			                 *(int *) data[16],
-			                 *(char **) data[17],
-			                 *(char **) data[18],
-			                 *(char **) data[19],
-			                 *(char **) data[20],
-			                 *(int *) data[21],
-			                 *(char **) data[22],
-			                 *(char **) data[23],
-			                 *(int *) data[24],
-			                 *(int *) data[25],
-			                 *(int *) data[26],
-			                 *(int *) data[27],
-			                 *(int *) data[28],
-			                 *(int *) data[29],
-			                 *(int *) data[30],
-			                 *(int *) data[31],
-			                 *(int *) data[32],
-			                 *(int *) data[33],
-			                 *(double *) data[34],
-			                 *(double *) data[35],
-			                 *(double *) data[36],
-			                 *(int *) data[37],
-			                 *(int *) data[38],
-			                 *(int *) data[39],
-			                 *(int *) data[40],
-			                 *(unsigned long *) data[41],
-			                 *(char **) data[42],
-			                 *(char **) data[43],
-			                 *(double *) data[44],
-			                 *(double *) data[45],
-			                 *(unsigned long *) data[46]     /* insert end */
-			                );
-			/* send query to db */
-			result = ido2db_db_query(idi, query2);
-			free(query2);
+			result = ido2db_db_query_prepared(idi, IDO2DB_PREPARED_SERVICESTATUS_INSERT, IDO2DB_DBTABLE_SERVICESTATUS, ido2db_servicestatus_columns, NULL, query1);
 		}
+		free(query1);
 		/* free last dbi_result */
 		dbi_result_free(idi->dbinfo.dbi_result);
 		idi->dbinfo.dbi_result = NULL;
@@ -40,12 +40,17 @@ extern char *ido2db_db_tablenames[IDO2DB_MAX_DBTABLES];
 extern int ido2db_check_dbd_driver(void);
 #endif
 
-/* use global dynamic buffer for mutex locks */
-ido_dbuf dbuf;
 //static pthread_mutex_t ido2db_dbuf_lock;
 
 static void *ido2db_thread_cleanup_exit_handler(void *);
 static void *ido2db_thread_worker_exit_handler(void *);
+#if defined(HAVE_SYS_EPOLL_H) && defined(USE_LIBDBI)
+static int ido2db_serve_clients(void);
+#endif
+static int ido2db_answer_client(int, char *, char *);
+static int ido2db_start_client_decompression(ido2db_idi *, ido_dbuf *, unsigned long);
+static char *ido2db_format_binary_number(unsigned long long, int);
+static int ido2db_decode_binary_field(char **, char *, int *, char **);
 
 /*
 pthread_mutex_lock(&ido2db_dbuf_lock);
@@ -77,6 +82,8 @@ int ido2db_show_help = IDO_FALSE;
 
 int ido2db_run_foreground = IDO_FALSE;
 
+int ido2db_db_writer_threads = DEFAULT_DB_WRITER_THREADS;
+
 ido2db_dbconfig ido2db_db_settings;
 ido2db_idi thread_idi;
 pthread_t thread_pool[IDO2DB_NR_OF_THREADS];
@@ -628,6 +635,24 @@ int ido2db_process_config_var(char *arg) {
 	else if (!strcmp(var, "housekeeping_thread_startup_delay"))
 		ido2db_db_settings.housekeeping_thread_startup_delay = strtoul(val, NULL, 0);
 
+	else if (!strcmp(var, "housekeeping_chunk_size"))
+		ido2db_db_settings.housekeeping_chunk_size = strtoul(val, NULL, 0);
+
+	else if (!strcmp(var, "housekeeping_rows_per_second"))
+		ido2db_db_settings.housekeeping_rows_per_second = strtoul(val, NULL, 0);
+
+	else if (!strcmp(var, "housekeeping_drop_partitions"))
+		ido2db_db_settings.housekeeping_drop_partitions = (atoi(val) > 0) ? IDO_TRUE : IDO_FALSE;
+
+	else if (!strcmp(var, "db_writer_threads"))
+		ido2db_db_writer_threads = atoi(val);
+
+	else if (!strcmp(var, "insert_batch_size"))
+		ido2db_db_settings.insert_batch_size = atoi(val);
+
+	else if (!strcmp(var, "status_flush_interval"))
+		ido2db_db_settings.status_flush_interval = strtoul(val, NULL, 0);
+
 	else if ((!strcmp(var, "ido2db_user")) || (!strcmp(var, "ido2db_user")))
 		ido2db_user = strdup(val);
 	else if ((!strcmp(var, "ido2db_group")) || (!strcmp(var, "ido2db_group")))
@@ -720,6 +745,11 @@ int ido2db_initialize_variables(void) {
 	ido2db_db_settings.max_downtimehistory_age = 0L;
 	ido2db_db_settings.trim_db_interval = (unsigned long)DEFAULT_TRIM_DB_INTERVAL; /* set the default if missing in ido2db.cfg */
 	ido2db_db_settings.housekeeping_thread_startup_delay = (unsigned long)DEFAULT_HOUSEKEEPING_THREAD_STARTUP_DELAY; /* set the default if missing in ido2db.cfg */
+	ido2db_db_settings.housekeeping_chunk_size = DEFAULT_HOUSEKEEPING_CHUNK_SIZE;
+	ido2db_db_settings.housekeeping_rows_per_second = 0L;
+	ido2db_db_settings.housekeeping_drop_partitions = IDO_FALSE;
+	ido2db_db_settings.insert_batch_size = DEFAULT_INSERT_BATCH_SIZE;
+	ido2db_db_settings.status_flush_interval = DEFAULT_STATUS_FLUSH_INTERVAL;
 	ido2db_db_settings.clean_realtime_tables_on_core_startup = IDO_TRUE; /* default is cleaning on startup */
 	ido2db_db_settings.clean_config_tables_on_core_startup = IDO_TRUE;
 	ido2db_db_settings.oci_errors_to_syslog = DEFAULT_OCI_ERRORS_TO_SYSLOG;
@@ -737,6 +767,7 @@ int ido2db_initialize_variables(void) {
 
 /* free program memory */
 int ido2db_free_program_memory(void) {
+	register int x;
 
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_free_program_memory() start\n");
 
@@ -788,6 +819,10 @@ int ido2db_free_program_memory(void) {
 		free(libdbi_driver_dir);
 		libdbi_driver_dir = NULL;
 	}
+	for (x = 0; x < IDO2DB_MAX_DBTABLES; x++) {
+		free(ido2db_db_tablenames[x]);
+		ido2db_db_tablenames[x] = NULL;
+	}
 
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_free_program_memory() end\n");
 	return IDO_OK;
@@ -1397,6 +1432,18 @@ int ido2db_wait_for_connections(void) {
 		syslog(LOG_USER | LOG_INFO, "Finished daemonizing... (New PID=%d)\n", (int)getpid());
 	}
 
+	/* serve all clients from this process? */
+	if (ido2db_db_writer_threads > 0) {
+#if defined(HAVE_SYS_EPOLL_H) && defined(USE_LIBDBI)
+		if (use_ssl == IDO_FALSE) {
+			ido2db_serve_clients();
+			ido2db_cleanup_socket();
+			return IDO_ERROR;
+		}
+#endif
+		syslog(LOG_USER | LOG_INFO, "Warning: db_writer_threads needs epoll, libdbi and use_ssl=0, forking a child per client instead\n");
+	}
+
 	/* accept connections... */
 	while (1) {
 
@@ -1493,11 +1540,15 @@ int ido2db_wait_for_connections(void) {
 
 int ido2db_handle_client_connection(int sd, ido2db_proxy *proxy) {
 	int dbuf_chunk = 2048;
+	ido_dbuf dbuf;
 	ido2db_idi idi;
 	char buf[16 * 1024];
 	int result = 0;
 	int error = IDO_FALSE;
 	int in_transaction = 0, io_since_last_commit = 0;
+	struct pollfd pfd;
+	time_t next_flush = (time_t)0L;
+	time_t current_time;
 
 	int pthread_ret = 0;
 	//sigset_t newmask;
@@ -1554,6 +1605,7 @@ int ido2db_handle_client_connection(int sd, ido2db_proxy *proxy) {
 
 	/* initialize input data information */
 	ido2db_idi_init(&idi);
+	idi.client_sd = sd;
 
 	/* initialize dynamic buffer (2KB chunk size) */
 	ido_dbuf_init(&dbuf, dbuf_chunk);
@@ -1607,6 +1659,34 @@ int ido2db_handle_client_connection(int sd, ido2db_proxy *proxy) {
 
 	/* read all data from client */
 	while (1) {
+
+		/* don't sit in read() while held back status updates are due */
+		if (use_ssl == IDO_FALSE && (next_flush = ido2db_status_cache_next_flush(&idi)) > (time_t)0L) {
+
+			pfd.fd = sd;
+			pfd.events = POLLIN;
+			time(&current_time);
+
+			if (poll(&pfd, 1, (next_flush > current_time) ? (int)(next_flush - current_time) * 1000 : 0) == 0) {
+
+				ido2db_db_reconnect(&idi, IDO_TRUE);
+
+				result = (in_transaction == IDO_FALSE) ? ido2db_db_tx_begin(&idi) : IDO_OK;
+
+				ido2db_status_cache_flush(&idi, IDO_TRUE);
+
+				/* no input is coming to commit a transaction left open, so commit it now */
+				if (result == IDO_OK && ido2db_db_tx_commit(&idi) != IDO_OK)
+					syslog(LOG_ERR, "IDO2DB commit failed. Some data may have been lost.\n");
+
+				in_transaction = IDO_FALSE;
+				idi.in_transaction = IDO_FALSE;
+				io_since_last_commit = 0;
+
+				continue;
+			}
+		}
+
 #ifdef HAVE_SSL
 		if (use_ssl == IDO_FALSE)
 			result = read(sd, buf, sizeof(buf) - 1);
@@ -1665,18 +1745,17 @@ int ido2db_handle_client_connection(int sd, ido2db_proxy *proxy) {
 		printf("BYTESREAD: %d\n", result);
 #endif
 		ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_handle_client_connection() BYTESREAD: %d\n", result);
-		if (result > 0 && result < 50) {
+		if (result > 0 && result < 50 && idi.compressed_input == IDO_FALSE) {
 			ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2,
 			    "ido2db_handle_client_connection() Small packet (%d octets) -- skipping.\n", result);
 			continue;
 		}
 
 		/* append data we just read to dynamic buffer */
-		buf[result] = '\x0';
 		/* 2011-02-23 MF: lock dynamic buffer with a mutex when writing */
 		/* 2011-07-22 MF: redo it the old way, it may cause dead locks */
 		/* pthread_mutex_lock(&ido2db_dbuf_lock); */
-		ido_dbuf_strcat(&dbuf, buf);
+		ido2db_append_client_data(&idi, &dbuf, buf, result);
 		/* pthread_mutex_unlock(&ido2db_dbuf_lock); */
 
 		/* check for completed lines of input */
@@ -1693,7 +1772,10 @@ int ido2db_handle_client_connection(int sd, ido2db_proxy *proxy) {
 			result = ido2db_db_tx_begin(&idi);
 
 		/* check for client input */
-		ido2db_check_for_client_input(&idi);
+		ido2db_check_for_client_input(&idi, &dbuf);
+
+		/* write held back status updates once they are due */
+		ido2db_status_cache_flush(&idi, IDO_FALSE);
 
 		if (result == IDO_OK) {
 			in_transaction = (proxy && ido2db_proxy_get_size_left(proxy) > 16 * 1024) ? IDO_TRUE : IDO_FALSE;
@@ -1731,6 +1813,8 @@ int ido2db_handle_client_connection(int sd, ido2db_proxy *proxy) {
 	printf("BYTES: %lu, LINES: %lu\n", idi.bytes_processed, idi.lines_processed);
 #endif
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "BYTES: %lu, LINES: %lu\n", idi.bytes_processed, idi.lines_processed);
+	if (idi.compressed_input == IDO_TRUE)
+		syslog(LOG_USER | LOG_INFO, "Client sent %lu bytes compressed, %lu bytes uncompressed\n", idi.compressed_bytes, idi.uncompressed_bytes);
 
 	/* terminate threads */
 	ido2db_terminate_threads();
@@ -1758,6 +1842,384 @@ int ido2db_handle_client_connection(int sd, ido2db_proxy *proxy) {
 }
 
 
+#if defined(HAVE_SYS_EPOLL_H) && defined(USE_LIBDBI)
+
+/* all clients and the ones waiting for a writer thread - protected by ido2db_clients_lock */
+static pthread_mutex_t ido2db_clients_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ido2db_clients_cond = PTHREAD_COND_INITIALIZER;
+static ido2db_client *ido2db_clients = NULL;
+static ido2db_client *ido2db_client_queue_head = NULL;
+static ido2db_client *ido2db_client_queue_tail = NULL;
+static int ido2db_epoll_fd = -1;
+
+
+/* hands a client to the writer threads - must be called with ido2db_clients_lock held */
+static void ido2db_queue_client(ido2db_client *client) {
+
+	client->state = IDO2DB_CLIENT_QUEUED;
+	client->next_queued = NULL;
+
+	if (ido2db_client_queue_tail)
+		ido2db_client_queue_tail->next_queued = client;
+	else
+		ido2db_client_queue_head = client;
+	ido2db_client_queue_tail = client;
+
+	pthread_cond_signal(&ido2db_clients_cond);
+
+	return;
+}
+
+
+/* checks whether the tables of a client's instance are due for trimming */
+static int ido2db_client_needs_maintenance(ido2db_client *client, time_t current_time) {
+	unsigned long delay = client->idi.dbinfo.housekeeping_thread_startup_delay;
+
+	struct timeval now;
+
+	if (client->idi.dbinfo.instance_id == 0L)
+		return IDO_FALSE;
+
+	/* a pass in progress goes on as soon as its rows per second budget allows */
+	if (client->idi.dbinfo.trim_table >= 0) {
+		gettimeofday(&now, NULL);
+		return timercmp(&now, &client->idi.dbinfo.trim_next_chunk, <) ? IDO_FALSE : IDO_TRUE;
+	}
+
+	/* same startup delay as the housekeeping thread of a forked child */
+	if (delay < DEFAULT_HOUSEKEEPING_THREAD_STARTUP_DELAY)
+		delay = DEFAULT_HOUSEKEEPING_THREAD_STARTUP_DELAY;
+	if ((unsigned long)(current_time - client->connect_time) < delay)
+		return IDO_FALSE;
+
+	if (((unsigned long)current_time - client->idi.dbinfo.trim_db_interval) <= (unsigned long)client->idi.dbinfo.last_table_trim_time)
+		return IDO_FALSE;
+
+	return IDO_TRUE;
+}
+
+
+/* checks whether held back status updates of a client are due */
+static int ido2db_client_needs_status_flush(ido2db_client *client, time_t current_time) {
+	time_t next_flush = ido2db_status_cache_next_flush(&client->idi);
+
+	if (next_flush == (time_t)0L || current_time < next_flush)
+		return IDO_FALSE;
+
+	return IDO_TRUE;
+}
+
+
+/* reads what a client sent and writes it to the database - runs in a writer thread */
+static int ido2db_dispatch_client(ido2db_client *client) {
+	char buf[16 * 1024];
+	ssize_t result = 0;
+	size_t bytes_read = 0;
+	int eof = IDO_FALSE;
+	time_t current_time;
+
+	/* connect on the first dispatch, so a slow database doesn't hold up the event loop */
+	if (client->initialized == IDO_FALSE) {
+		client->initialized = IDO_TRUE;
+
+		ido2db_db_init(&client->idi);
+
+		if (ido2db_db_connect(&client->idi) == IDO_ERROR && client->idi.dbinfo.connected != IDO_TRUE) {
+			syslog(LOG_USER | LOG_INFO, "Error: database connection failed, forced client disconnect...\n");
+			return IDO_ERROR;
+		}
+	}
+
+	/* drain the socket, but give other clients a turn after a while */
+	while (bytes_read < IDO2DB_CLIENT_READ_BUDGET) {
+
+		result = read(client->sd, buf, sizeof(buf) - 1);
+
+		if (result == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				eof = IDO_TRUE;
+			break;
+		}
+
+		/* zero bytes read means we lost the connection with the client */
+		if (result == 0) {
+			ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "received 0 bytes from socket. ido2db will disconnect.\n");
+			eof = IDO_TRUE;
+			break;
+		}
+
+		ido2db_append_client_data(&client->idi, &client->dbuf, buf, result);
+		bytes_read += result;
+	}
+
+	time(&current_time);
+
+	/* everything read so far goes into one transaction, along with due status updates */
+	if (bytes_read > 0 || ido2db_client_needs_status_flush(client, current_time) == IDO_TRUE) {
+
+		ido2db_db_reconnect(&client->idi, IDO_TRUE);
+
+		if ((result = ido2db_db_tx_begin(&client->idi)) == IDO_OK)
+			client->idi.in_transaction = IDO_TRUE;
+
+		if (bytes_read > 0)
+			ido2db_check_for_client_input(&client->idi, &client->dbuf);
+
+		ido2db_status_cache_flush(&client->idi, IDO_FALSE);
+
+		if (result == IDO_OK && ido2db_db_tx_commit(&client->idi) != IDO_OK)
+			syslog(LOG_ERR, "IDO2DB commit failed. Some data may have been lost.\n");
+
+		client->idi.in_transaction = IDO_FALSE;
+	}
+
+	if (eof == IDO_TRUE || client->idi.disconnect_client == IDO_TRUE) {
+
+		ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "client input data ended, disconnecting.\n");
+
+		/* gracefully back out of current operation... */
+		ido2db_db_goodbye(&client->idi);
+
+		return IDO_ERROR;
+	}
+
+	/* there's no housekeeping thread per client in this mode */
+	if (ido2db_client_needs_maintenance(client, current_time) == IDO_TRUE)
+		ido2db_db_perform_maintenance(&client->idi);
+
+	return IDO_OK;
+}
+
+
+/* disconnects a client - runs in the writer thread that owns it */
+static void ido2db_close_client(ido2db_client *client) {
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "BYTES: %lu, LINES: %lu\n", client->idi.bytes_processed, client->idi.lines_processed);
+	if (client->idi.compressed_input == IDO_TRUE)
+		syslog(LOG_USER | LOG_INFO, "Client sent %lu bytes compressed, %lu bytes uncompressed\n", client->idi.compressed_bytes, client->idi.uncompressed_bytes);
+
+	epoll_ctl(ido2db_epoll_fd, EPOLL_CTL_DEL, client->sd, NULL);
+	close(client->sd);
+
+	if (client->initialized == IDO_TRUE) {
+		ido2db_db_disconnect(&client->idi);
+		ido2db_db_deinit(&client->idi);
+	}
+
+	ido2db_free_input_memory(&client->idi);
+	ido2db_free_connection_memory(&client->idi);
+	ido_dbuf_free(&client->dbuf);
+
+	/* the event loop may still hold an event for it, so it frees the client */
+	pthread_mutex_lock(&ido2db_clients_lock);
+	client->state = IDO2DB_CLIENT_CLOSED;
+	pthread_mutex_unlock(&ido2db_clients_lock);
+
+	syslog(LOG_USER | LOG_INFO, "Client disconnected.\n");
+
+	return;
+}
+
+
+/* db writer thread - takes queued clients one at a time */
+static void *ido2db_client_writer_thread(void *arg) {
+	ido2db_client *client = NULL;
+	struct epoll_event event;
+
+	pthread_mutex_lock(&ido2db_clients_lock);
+
+	while (1) {
+
+		if ((client = ido2db_client_queue_head) == NULL) {
+			pthread_cond_wait(&ido2db_clients_cond, &ido2db_clients_lock);
+			continue;
+		}
+
+		if ((ido2db_client_queue_head = client->next_queued) == NULL)
+			ido2db_client_queue_tail = NULL;
+		client->state = IDO2DB_CLIENT_BUSY;
+
+		pthread_mutex_unlock(&ido2db_clients_lock);
+
+		if (ido2db_dispatch_client(client) == IDO_ERROR) {
+			ido2db_close_client(client);
+			pthread_mutex_lock(&ido2db_clients_lock);
+			continue;
+		}
+
+		pthread_mutex_lock(&ido2db_clients_lock);
+
+		/* back to the event loop */
+		client->state = IDO2DB_CLIENT_IDLE;
+		event.events = EPOLLIN | EPOLLONESHOT;
+		event.data.ptr = client;
+		epoll_ctl(ido2db_epoll_fd, EPOLL_CTL_MOD, client->sd, &event);
+	}
+
+	pthread_mutex_unlock(&ido2db_clients_lock);
+
+	return NULL;
+}
+
+
+/* accepts a new client and adds it to the event loop */
+static void ido2db_accept_client(void) {
+	ido2db_client *client = NULL;
+	struct epoll_event event;
+	int sd = 0;
+	int flags = 0;
+
+	while ((sd = accept(ido2db_sd, NULL, NULL)) >= 0) {
+
+		flags = fcntl(sd, F_GETFL, 0);
+		fcntl(sd, F_SETFL, flags | O_NONBLOCK);
+		fcntl(sd, F_SETFD, FD_CLOEXEC);
+
+		if ((client = (ido2db_client *)calloc(1, sizeof(ido2db_client))) == NULL) {
+			close(sd);
+			continue;
+		}
+
+		client->sd = sd;
+		client->initialized = IDO_FALSE;
+		time(&client->connect_time);
+		ido2db_idi_init(&client->idi);
+		client->idi.client_sd = sd;
+		ido_dbuf_init(&client->dbuf, 2048);
+
+		pthread_mutex_lock(&ido2db_clients_lock);
+
+		client->next = ido2db_clients;
+		ido2db_clients = client;
+
+		/* the first dispatch connects to the database */
+		ido2db_queue_client(client);
+
+		event.events = EPOLLIN | EPOLLONESHOT;
+		event.data.ptr = client;
+		epoll_ctl(ido2db_epoll_fd, EPOLL_CTL_ADD, sd, &event);
+
+		pthread_mutex_unlock(&ido2db_clients_lock);
+
+		syslog(LOG_USER | LOG_INFO, "Client connected, data available.\n");
+	}
+
+	if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+		syslog(LOG_ERR, "Accept error: %s\n", strerror(errno));
+
+	return;
+}
+
+
+/* serves all clients from this process with a fixed number of db writer threads */
+static int ido2db_serve_clients(void) {
+	struct epoll_event event;
+	struct epoll_event events[IDO2DB_CLIENT_MAX_EVENTS];
+	ido2db_client *client = NULL;
+	ido2db_client **prev = NULL;
+	pthread_t thread;
+	sigset_t newmask;
+	time_t current_time;
+	time_t last_sweep = 0L;
+	int nfds = 0;
+	int flags = 0;
+	int x = 0;
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_serve_clients() start\n");
+
+	if ((ido2db_epoll_fd = epoll_create(IDO2DB_CLIENT_MAX_EVENTS)) < 0) {
+		syslog(LOG_ERR, "Error: Could not create epoll instance: %s\n", strerror(errno));
+		return IDO_ERROR;
+	}
+
+	flags = fcntl(ido2db_sd, F_GETFL, 0);
+	fcntl(ido2db_sd, F_SETFL, flags | O_NONBLOCK);
+
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+	if (epoll_ctl(ido2db_epoll_fd, EPOLL_CTL_ADD, ido2db_sd, &event) < 0) {
+		syslog(LOG_ERR, "Error: Could not add socket to epoll instance: %s\n", strerror(errno));
+		close(ido2db_epoll_fd);
+		return IDO_ERROR;
+	}
+
+	/* writer threads should block all signals */
+	sigfillset(&newmask);
+	pthread_sigmask(SIG_BLOCK, &newmask, NULL);
+
+	for (x = 0; x < ido2db_db_writer_threads; x++) {
+		if (pthread_create(&thread, NULL, ido2db_client_writer_thread, NULL) != 0) {
+			syslog(LOG_ERR, "Could not create thread... exiting with error '%s'\n", strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		pthread_detach(thread);
+	}
+
+	/* event loop should unblock all signals */
+	pthread_sigmask(SIG_UNBLOCK, &newmask, NULL);
+
+	syslog(LOG_USER | LOG_INFO, "Serving clients with %d db writer threads\n", ido2db_db_writer_threads);
+
+	while (1) {
+
+		nfds = epoll_wait(ido2db_epoll_fd, events, IDO2DB_CLIENT_MAX_EVENTS, 1000);
+
+		if (nfds < 0 && errno != EINTR) {
+			syslog(LOG_ERR, "Error: epoll_wait() failed: %s\n", strerror(errno));
+			break;
+		}
+
+		for (x = 0; x < nfds; x++) {
+
+			if (events[x].data.ptr == NULL) {
+				ido2db_accept_client();
+				continue;
+			}
+
+			pthread_mutex_lock(&ido2db_clients_lock);
+			client = (ido2db_client *)events[x].data.ptr;
+			if (client->state == IDO2DB_CLIENT_IDLE)
+				ido2db_queue_client(client);
+			pthread_mutex_unlock(&ido2db_clients_lock);
+		}
+
+		time(&current_time);
+		if (current_time == last_sweep)
+			continue;
+		last_sweep = current_time;
+
+		/* free closed clients and wake up idle ones whose tables need trimming or status updates are due */
+		pthread_mutex_lock(&ido2db_clients_lock);
+
+		for (prev = &ido2db_clients; (client = *prev) != NULL;) {
+
+			if (client->state == IDO2DB_CLIENT_CLOSED) {
+				*prev = client->next;
+				free(client);
+				continue;
+			}
+
+			if (client->state == IDO2DB_CLIENT_IDLE && (ido2db_client_needs_maintenance(client, current_time) == IDO_TRUE || ido2db_client_needs_status_flush(client, current_time) == IDO_TRUE))
+				ido2db_queue_client(client);
+
+			prev = &client->next;
+		}
+
+		pthread_mutex_unlock(&ido2db_clients_lock);
+	}
+
+	close(ido2db_epoll_fd);
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_serve_clients() end\n");
+
+	return IDO_ERROR;
+}
+
+#endif
+
+
 /* initializes structure for tracking data */
 int ido2db_idi_init(ido2db_idi *idi) {
 	int x = 0;
@@ -1770,6 +2232,14 @@ int ido2db_idi_init(ido2db_idi *idi) {
 	idi->disconnect_client = IDO_FALSE;
 	idi->ignore_client_data = IDO_FALSE;
 	idi->protocol_version = 0;
+	idi->client_sd = -1;
+	idi->binary_encoding = IDO_FALSE;
+	idi->compressed_input = IDO_FALSE;
+	idi->compressed_bytes = 0L;
+	idi->uncompressed_bytes = 0L;
+#ifdef HAVE_ZLIB_H
+	idi->zstream = NULL;
+#endif
 	idi->instance_name = NULL;
 	idi->buffered_input = NULL;
 	idi->agent_name = NULL;
@@ -1790,6 +2260,15 @@ int ido2db_idi_init(ido2db_idi *idi) {
 
 	ido2db_db_txbuf_init(&(idi->txbuf));
 
+	/* initialize status cache */
+	idi->status_cache.hashlist = NULL;
+	idi->status_cache.head = NULL;
+	idi->status_cache.tail = NULL;
+	idi->status_cache.last_flush_time = (time_t)0L;
+	idi->status_cache.flushing = IDO_FALSE;
+	idi->status_cache.updates = 0L;
+	idi->status_cache.coalesced = 0L;
+
 	/* initialize mbuf */
 	for (x = 0; x < IDO2DB_MAX_MBUF_ITEMS; x++) {
 		idi->mbuf[x].used_lines = 0;
@@ -1806,59 +2285,94 @@ int ido2db_idi_init(ido2db_idi *idi) {
 /* checks for single lines of input from a client connection */
 /* 2011-02-23 MF: called in worker thread */
 /* 2011-05-02 MF: restructured sequential */
-int ido2db_check_for_client_input(ido2db_idi *idi) {
-	char *buf = NULL;
-	register int x;
+int ido2db_check_for_client_input(ido2db_idi *idi, ido_dbuf *dbuf) {
+	char *line = NULL;
+	char *eol = NULL;
+	char *end = NULL;
+	unsigned long record_size = 0L;
+	unsigned long offset = 0L;
+	int was_compressed = IDO_FALSE;
 
 	//ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_check_for_client_input() start\n");
 
-	/*	if(&dbuf==NULL)
-			return IDO_OK;*/
-	if (dbuf.buf == NULL)
+	if (dbuf == NULL || dbuf->buf == NULL)
 		return IDO_OK;
 	/* check if buffer full? bail out and tell main to disconnect the client! FIXME */
-	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_check_for_client_input() dbuf.size=%lu\n", dbuf.used_size);
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_check_for_client_input() dbuf.size=%lu\n", dbuf->used_size);
 
 	//ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_check_for_client_input() ido2db_dbuf_lock start\n");
 
 #ifdef DEBUG_IDO2DB2
-	printf("RAWBUF: %s\n", dbuf.buf);
-	printf("  USED1: %lu, BYTES: %lu, LINES: %lu\n", dbuf.used_size, idi->bytes_processed, idi->lines_processed);
+	printf("RAWBUF: %s\n", dbuf->buf);
+	printf("  USED1: %lu, BYTES: %lu, LINES: %lu\n", dbuf->used_size, idi->bytes_processed, idi->lines_processed);
 #endif
 
-	/* search for complete lines of input */
-	for (x = 0; dbuf.buf[x] != '\x0'; x++) {
+	/* handle all complete lines of input in place */
+	line = dbuf->buf;
+	end = dbuf->buf + dbuf->used_size;
+	while (line < end) {
 
-		/* we found the end of a line */
-		if (dbuf.buf[x] == '\n') {
+		/* binary records start where a line would, but may contain anything */
+		if (*line == IDO_API_BINARY_RECORD && idi->binary_encoding == IDO_TRUE) {
 
-#ifdef DEBUG_IDO2DB2
-			printf("BUF[%d]='\\n'\n", x);
-#endif
-
-			/* handle this line of input */
-			dbuf.buf[x] = '\x0';
+			if (end - line < IDO_API_BINARY_HEADER_SIZE)
+				break;
 
-			if ((buf = strdup(dbuf.buf))) {
-				ido2db_handle_client_input(idi, buf);
+			record_size = (unsigned long)ido_binary_get(line + 1, 4);
 
-				free(buf);
-				buf = NULL;
-				idi->lines_processed++;
-				idi->bytes_processed += (x + 1);
+			/* we lost track of the records, there's no way to find the next one */
+			if (record_size < IDO_API_BINARY_HEADER_SIZE || record_size > IDO_API_BINARY_MAX_RECORD_SIZE) {
+				syslog(LOG_USER | LOG_INFO, "Error: Client sent a binary record of %lu bytes.  Disconnecting client...", record_size);
+				idi->disconnect_client = IDO_TRUE;
+				idi->ignore_client_data = IDO_TRUE;
+				line = end;
+				break;
 			}
 
-			/* shift data back to front of buffer and adjust counters */
-			memmove((void *)&dbuf.buf[0], (void *)&dbuf.buf[x+1], (size_t)((int)dbuf.used_size - x - 1));
-			dbuf.used_size -= (x + 1);
-			dbuf.buf[dbuf.used_size] = '\x0';
-			x = -1;
-#ifdef DEBUG_IDO2DB2
-			printf("  USED2: %lu, BYTES: %lu, LINES: %lu\n", dbuf.used_size, idi->bytes_processed, idi->lines_processed);
-#endif
+			if ((unsigned long)(end - line) < record_size)
+				break;
+
+			ido2db_handle_client_binary_input(idi, line, record_size);
+
+			idi->bytes_processed += record_size;
+
+			line += record_size;
+			continue;
+		}
+
+		if ((eol = memchr(line, '\n', end - line)) == NULL)
+			break;
+
+		/* handle this line of input */
+		*eol = '\x0';
+		was_compressed = idi->compressed_input;
+		ido2db_handle_client_input(idi, line);
+
+		idi->lines_processed++;
+		idi->bytes_processed += (eol - line + 1);
+
+		line = eol + 1;
+
+		/* the client compresses everything after the line that asked for it */
+		if (was_compressed == IDO_FALSE && idi->compressed_input == IDO_TRUE) {
+			offset = line - dbuf->buf;
+			ido2db_start_client_decompression(idi, dbuf, offset);
+			line = dbuf->buf + offset;
+			end = dbuf->buf + dbuf->used_size;
 		}
 	}
 
+	/* shift the incomplete line (if any) back to front of buffer - once per read */
+	if (line != dbuf->buf) {
+		dbuf->used_size = end - line;
+		memmove((void *)dbuf->buf, (void *)line, (size_t)dbuf->used_size);
+		dbuf->buf[dbuf->used_size] = '\x0';
+	}
+
+#ifdef DEBUG_IDO2DB2
+	printf("  USED2: %lu, BYTES: %lu, LINES: %lu\n", dbuf->used_size, idi->bytes_processed, idi->lines_processed);
+#endif
+
 	//ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_check_for_client_input() ido2db_dbuf_lock end\n");
 
 	//ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_check_for_client_input() end\n");
@@ -1867,8 +2381,85 @@ int ido2db_check_for_client_input(ido2db_idi *idi) {
 }
 
 
+/* adds data read from a client to its input buffer, decompressing it if necessary */
+int ido2db_append_client_data(ido2db_idi *idi, ido_dbuf *dbuf, char *buf, unsigned long len) {
+#ifdef HAVE_ZLIB_H
+	char outbuf[16 * 1024];
+	int result = Z_OK;
+
+	if (idi->compressed_input == IDO_FALSE)
+		return ido_dbuf_append(dbuf, buf, len);
+
+	if (idi->ignore_client_data == IDO_TRUE)
+		return IDO_OK;
+
+	if (idi->zstream == NULL) {
+		if ((idi->zstream = (z_stream *)calloc(1, sizeof(z_stream))) == NULL || inflateInit(idi->zstream) != Z_OK) {
+			my_free(idi->zstream);
+			syslog(LOG_USER | LOG_INFO, "Error: Could not set up decompression.  Disconnecting client...");
+			idi->disconnect_client = IDO_TRUE;
+			idi->ignore_client_data = IDO_TRUE;
+			return IDO_ERROR;
+		}
+	}
+
+	idi->compressed_bytes += len;
+
+	idi->zstream->next_in = (Bytef *)buf;
+	idi->zstream->avail_in = len;
+
+	do {
+		idi->zstream->next_out = (Bytef *)outbuf;
+		idi->zstream->avail_out = sizeof(outbuf);
+
+		result = inflate(idi->zstream, Z_SYNC_FLUSH);
+
+		if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+			syslog(LOG_USER | LOG_INFO, "Error: Could not decompress client data (%s).  Disconnecting client...", (idi->zstream->msg) ? idi->zstream->msg : "zlib error");
+			idi->disconnect_client = IDO_TRUE;
+			idi->ignore_client_data = IDO_TRUE;
+			return IDO_ERROR;
+		}
+
+		ido_dbuf_append(dbuf, outbuf, sizeof(outbuf) - idi->zstream->avail_out);
+		idi->uncompressed_bytes += sizeof(outbuf) - idi->zstream->avail_out;
+
+	} while (idi->zstream->avail_out == 0 && result == Z_OK);
+
+	return IDO_OK;
+#else
+	return ido_dbuf_append(dbuf, buf, len);
+#endif
+}
+
+
+/* decompresses what's left in the input buffer after the client switched to compression */
+static int ido2db_start_client_decompression(ido2db_idi *idi, ido_dbuf *dbuf, unsigned long offset) {
+	char *rest = NULL;
+	unsigned long len = 0L;
+
+	if (offset >= dbuf->used_size)
+		return IDO_OK;
+
+	len = dbuf->used_size - offset;
+	if ((rest = (char *)malloc(len)) == NULL)
+		return IDO_ERROR;
+	memcpy(rest, dbuf->buf + offset, len);
+
+	dbuf->used_size = offset;
+	dbuf->buf[offset] = '\x0';
+
+	ido2db_append_client_data(idi, dbuf, rest, len);
+
+	free(rest);
+
+	return IDO_OK;
+}
+
+
 /* handles a single line of input from a client connection */
 int ido2db_handle_client_input(ido2db_idi *idi, char *buf) {
+	char *saveptr = NULL;
 	char *var = NULL;
 	char *val = NULL;
 	unsigned long data_type_long = 0L;
@@ -1900,8 +2491,8 @@ int ido2db_handle_client_input(ido2db_idi *idi, char *buf) {
 
 	case IDO2DB_INPUT_SECTION_NONE:
 
-		var = strtok(buf, ":");
-		val = strtok(NULL, "\n");
+		var = strtok_r(buf, ":", &saveptr);
+		val = strtok_r(NULL, "\n", &saveptr);
 
 		if (!strcmp(var, IDO_API_HELLO)) {
 
@@ -1916,8 +2507,8 @@ int ido2db_handle_client_input(ido2db_idi *idi, char *buf) {
 
 	case IDO2DB_INPUT_SECTION_HEADER:
 
-		var = strtok(buf, ":");
-		val = strtok(NULL, "\n");
+		var = strtok_r(buf, ":", &saveptr);
+		val = strtok_r(NULL, "\n", &saveptr);
 
 		if (!strcmp(var, IDO_API_STARTDATADUMP)) {
 
@@ -1965,12 +2556,33 @@ int ido2db_handle_client_input(ido2db_idi *idi, char *buf) {
 		else if (!strcmp(var, IDO_API_STARTTIME))
 			ido2db_convert_string_to_unsignedlong((val + 1), &idi->data_start_time);
 
+		/* the client waits for us to answer the encoding and compression it asked for - over SSL we only read */
+		else if (!strcmp(var, IDO_API_ENCODING) && val != NULL && use_ssl == IDO_FALSE && idi->client_sd >= 0) {
+
+			if (!strcmp(val + 1, IDO_API_ENCODING_BINARY) && ido2db_answer_client(idi->client_sd, IDO_API_ENCODING, IDO_API_ENCODING_BINARY) == IDO_OK) {
+				idi->binary_encoding = IDO_TRUE;
+				syslog(LOG_USER | LOG_INFO, "Client uses binary encoding");
+			} else
+				ido2db_answer_client(idi->client_sd, IDO_API_ENCODING, IDO_API_ENCODING_TEXT);
+		}
+
+		else if (!strcmp(var, IDO_API_COMPRESSION) && val != NULL && use_ssl == IDO_FALSE && idi->client_sd >= 0) {
+
+#ifdef HAVE_ZLIB_H
+			if (!strcmp(val + 1, IDO_API_COMPRESSION_ZLIB) && ido2db_answer_client(idi->client_sd, IDO_API_COMPRESSION, IDO_API_COMPRESSION_ZLIB) == IDO_OK) {
+				idi->compressed_input = IDO_TRUE;
+				syslog(LOG_USER | LOG_INFO, "Client uses compression");
+			} else
+#endif
+				ido2db_answer_client(idi->client_sd, IDO_API_COMPRESSION, IDO_API_COMPRESSION_NONE);
+		}
+
 		break;
 
 	case IDO2DB_INPUT_SECTION_FOOTER:
 
-		var = strtok(buf, ":");
-		val = strtok(NULL, "\n");
+		var = strtok_r(buf, ":", &saveptr);
+		val = strtok_r(NULL, "\n", &saveptr);
 
 		/* client is saying goodbye... */
 		if (!strcmp(var, IDO_API_GOODBYE))
@@ -1985,8 +2597,8 @@ int ido2db_handle_client_input(ido2db_idi *idi, char *buf) {
 
 		if (idi->current_input_data == IDO2DB_INPUT_DATA_NONE) {
 
-			var = strtok(buf, ":");
-			val = strtok(NULL, "\n");
+			var = strtok_r(buf, ":", &saveptr);
+			val = strtok_r(NULL, "\n", &saveptr);
 
 			input_type = atoi(var);
 
@@ -2010,151 +2622,8 @@ int ido2db_handle_client_input(ido2db_idi *idi, char *buf) {
 				syslog(LOG_USER | LOG_INFO, "Config dump completed");
 				break;
 
-				/* archived data */
-			case IDO_API_LOGENTRY:
-				idi->current_input_data = IDO2DB_INPUT_DATA_LOGENTRY;
-				break;
-
-				/* realtime data */
-			case IDO_API_PROCESSDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_PROCESSDATA;
-				break;
-			case IDO_API_LOGDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_LOGDATA;
-				break;
-			case IDO_API_SYSTEMCOMMANDDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_SYSTEMCOMMANDDATA;
-				break;
-			case IDO_API_EVENTHANDLERDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_EVENTHANDLERDATA;
-				break;
-			case IDO_API_NOTIFICATIONDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_NOTIFICATIONDATA;
-				break;
-			case IDO_API_SERVICECHECKDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_SERVICECHECKDATA;
-				break;
-			case IDO_API_HOSTCHECKDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_HOSTCHECKDATA;
-				break;
-			case IDO_API_COMMENTDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_COMMENTDATA;
-				break;
-			case IDO_API_DOWNTIMEDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_DOWNTIMEDATA;
-				break;
-			case IDO_API_FLAPPINGDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_FLAPPINGDATA;
-				break;
-			case IDO_API_PROGRAMSTATUSDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_PROGRAMSTATUSDATA;
-				break;
-			case IDO_API_HOSTSTATUSDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_HOSTSTATUSDATA;
-				break;
-			case IDO_API_SERVICESTATUSDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_SERVICESTATUSDATA;
-				break;
-			case IDO_API_CONTACTSTATUSDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_CONTACTSTATUSDATA;
-				break;
-			case IDO_API_ADAPTIVEPROGRAMDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_ADAPTIVEPROGRAMDATA;
-				break;
-			case IDO_API_ADAPTIVEHOSTDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_ADAPTIVEHOSTDATA;
-				break;
-			case IDO_API_ADAPTIVESERVICEDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_ADAPTIVESERVICEDATA;
-				break;
-			case IDO_API_ADAPTIVECONTACTDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_ADAPTIVECONTACTDATA;
-				break;
-			case IDO_API_EXTERNALCOMMANDDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_EXTERNALCOMMANDDATA;
-				break;
-			case IDO_API_AGGREGATEDSTATUSDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_AGGREGATEDSTATUSDATA;
-				break;
-			case IDO_API_RETENTIONDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_RETENTIONDATA;
-				break;
-			case IDO_API_CONTACTNOTIFICATIONDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_CONTACTNOTIFICATIONDATA;
-				break;
-			case IDO_API_CONTACTNOTIFICATIONMETHODDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_CONTACTNOTIFICATIONMETHODDATA;
-				break;
-			case IDO_API_ACKNOWLEDGEMENTDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_ACKNOWLEDGEMENTDATA;
-				break;
-			case IDO_API_STATECHANGEDATA:
-				idi->current_input_data = IDO2DB_INPUT_DATA_STATECHANGEDATA;
-				break;
-
-				/* config variables */
-			case IDO_API_MAINCONFIGFILEVARIABLES:
-				idi->current_input_data = IDO2DB_INPUT_DATA_MAINCONFIGFILEVARIABLES;
-				break;
-			case IDO_API_RESOURCECONFIGFILEVARIABLES:
-				idi->current_input_data = IDO2DB_INPUT_DATA_RESOURCECONFIGFILEVARIABLES;
-				break;
-			case IDO_API_CONFIGVARIABLES:
-				idi->current_input_data = IDO2DB_INPUT_DATA_CONFIGVARIABLES;
-				break;
-			case IDO_API_RUNTIMEVARIABLES:
-				idi->current_input_data = IDO2DB_INPUT_DATA_RUNTIMEVARIABLES;
-				break;
-
-				/* object configuration */
-			case IDO_API_HOSTDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_HOSTDEFINITION;
-				break;
-			case IDO_API_HOSTGROUPDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_HOSTGROUPDEFINITION;
-				break;
-			case IDO_API_SERVICEDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_SERVICEDEFINITION;
-				break;
-			case IDO_API_SERVICEGROUPDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_SERVICEGROUPDEFINITION;
-				break;
-			case IDO_API_HOSTDEPENDENCYDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_HOSTDEPENDENCYDEFINITION;
-				break;
-			case IDO_API_SERVICEDEPENDENCYDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_SERVICEDEPENDENCYDEFINITION;
-				break;
-			case IDO_API_HOSTESCALATIONDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_HOSTESCALATIONDEFINITION;
-				break;
-			case IDO_API_SERVICEESCALATIONDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_SERVICEESCALATIONDEFINITION;
-				break;
-			case IDO_API_COMMANDDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_COMMANDDEFINITION;
-				break;
-			case IDO_API_TIMEPERIODDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_TIMEPERIODDEFINITION;
-				break;
-			case IDO_API_CONTACTDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_CONTACTDEFINITION;
-				break;
-			case IDO_API_CONTACTGROUPDEFINITION:
-				idi->current_input_data = IDO2DB_INPUT_DATA_CONTACTGROUPDEFINITION;
-				break;
-			case IDO_API_HOSTEXTINFODEFINITION:
-				/* deprecated - merged with host definitions */
-			case IDO_API_SERVICEEXTINFODEFINITION:
-				/* deprecated - merged with service definitions */
-			case IDO_API_ENABLEOBJECT:
-				idi->current_input_data = IDO2DB_INPUT_DATA_ENABLEOBJECT;
-				break;
-			case IDO_API_DISABLEOBJECT:
-				idi->current_input_data = IDO2DB_INPUT_DATA_DISABLEOBJECT;
-				break;
-
 			default:
+				idi->current_input_data = ido2db_get_input_data_type(input_type);
 				break;
 			}
 
@@ -2165,8 +2634,8 @@ int ido2db_handle_client_input(ido2db_idi *idi, char *buf) {
 		/* we are processing some type of data already... */
 		else {
 
-			var = strtok(buf, "=");
-			val = strtok(NULL, "\n");
+			var = strtok_r(buf, "=", &saveptr);
+			val = strtok_r(NULL, "\n", &saveptr);
 
 			/* get the data type */
 			data_type_long = strtoul(var, NULL, 0);
@@ -2217,6 +2686,294 @@ int ido2db_handle_client_input(ido2db_idi *idi, char *buf) {
 }
 
 
+/* answers an option the client asked for in its hello */
+static int ido2db_answer_client(int sd, char *var, char *val) {
+	char reply[64];
+	int len = 0;
+
+	len = snprintf(reply, sizeof(reply), "%s: %s\n", var, val);
+
+	if (write(sd, reply, len) != (ssize_t)len)
+		return IDO_ERROR;
+
+	return IDO_OK;
+}
+
+
+/* formats a number of a binary record the way the handlers expect it */
+static char *ido2db_format_binary_number(unsigned long long value, int negative) {
+	char temp_buffer[24];
+	char *ptr = temp_buffer + sizeof(temp_buffer) - 1;
+
+	*ptr = '\x0';
+	do {
+		*(--ptr) = '0' + (char)(value % 10);
+		value /= 10;
+	} while (value > 0);
+
+	if (negative == IDO_TRUE)
+		*(--ptr) = '-';
+
+	return strdup(ptr);
+}
+
+
+/* decodes the next field of a binary record, advancing ptr */
+static int ido2db_decode_binary_field(char **ptr, char *end, int *data_type, char **value) {
+	char *field = *ptr;
+	unsigned long long key = 0L;
+	unsigned long long number = 0L;
+	unsigned long long usec = 0L;
+	int len = 0;
+	union {
+		unsigned long long u;
+		double d;
+	} dvalue;
+
+	*value = NULL;
+
+	if ((len = ido_binary_get_varint(field, end, &key)) == 0 || (key >> 3) >= IDO_MAX_DATA_TYPES)
+		return IDO_ERROR;
+	field += len;
+
+	*data_type = (int)(key >> 3);
+
+	switch ((int)(key & 7)) {
+
+	case IDO_API_BINARY_INT:
+		if ((len = ido_binary_get_varint(field, end, &number)) == 0)
+			return IDO_ERROR;
+		field += len;
+		if (number & 1)
+			*value = ido2db_format_binary_number((number + 1) >> 1, IDO_TRUE);
+		else
+			*value = ido2db_format_binary_number(number >> 1, IDO_FALSE);
+		break;
+
+	case IDO_API_BINARY_ULONG:
+		if ((len = ido_binary_get_varint(field, end, &number)) == 0)
+			return IDO_ERROR;
+		field += len;
+		*value = ido2db_format_binary_number(number, IDO_FALSE);
+		break;
+
+	case IDO_API_BINARY_DOUBLE:
+		if (end - field < 8)
+			return IDO_ERROR;
+		dvalue.u = ido_binary_get(field, 8);
+		field += 8;
+		if (asprintf(value, "%lf", dvalue.d) == -1)
+			*value = NULL;
+		break;
+
+	case IDO_API_BINARY_TIMEVAL:
+		if ((len = ido_binary_get_varint(field, end, &number)) == 0)
+			return IDO_ERROR;
+		field += len;
+		if ((len = ido_binary_get_varint(field, end, &usec)) == 0)
+			return IDO_ERROR;
+		field += len;
+		if (asprintf(value, "%lu.%lu", (unsigned long)number, (unsigned long)usec) == -1)
+			*value = NULL;
+		break;
+
+	case IDO_API_BINARY_STRING:
+		if ((len = ido_binary_get_varint(field, end, &number)) == 0)
+			return IDO_ERROR;
+		field += len;
+		if ((unsigned long long)(end - field) < number)
+			return IDO_ERROR;
+		if ((*value = (char *)malloc(number + 1)) != NULL) {
+			memcpy(*value, field, number);
+			(*value)[number] = '\x0';
+		}
+		field += number;
+		break;
+
+	default:
+		return IDO_ERROR;
+	}
+
+	*ptr = field;
+
+	return IDO_OK;
+}
+
+
+/* handles a binary record from a client connection */
+int ido2db_handle_client_binary_input(ido2db_idi *idi, char *buf, unsigned long len) {
+	char *ptr = NULL;
+	char *end = NULL;
+	char *val = NULL;
+	int input_type = 0;
+	int data_type = IDO_DATA_NONE;
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_handle_client_binary_input() start\n");
+
+	if (buf == NULL || idi == NULL)
+		return IDO_ERROR;
+
+	if (idi->ignore_client_data == IDO_TRUE)
+		return IDO_ERROR;
+
+	/* a record is a complete data item, so it can't show up anywhere else */
+	if (idi->current_input_section != IDO2DB_INPUT_SECTION_DATA || idi->current_input_data != IDO2DB_INPUT_DATA_NONE)
+		return IDO_ERROR;
+
+	input_type = (int)ido_binary_get(buf + 5, 2);
+
+	if ((idi->current_input_data = ido2db_get_input_data_type(input_type)) == IDO2DB_INPUT_DATA_NONE)
+		return IDO_ERROR;
+
+	/* initialize input data */
+	ido2db_start_input_data(idi);
+
+	ptr = buf + IDO_API_BINARY_HEADER_SIZE;
+	end = buf + len;
+
+	while (ptr < end) {
+
+		if (ido2db_decode_binary_field(&ptr, end, &data_type, &val) == IDO_ERROR)
+			break;
+
+		ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_handle_client_binary_input() type: %d, VAL: %s\n", data_type, (val == NULL) ? "" : val);
+
+		ido2db_store_input_data_item(idi, data_type, val);
+	}
+
+	/* don't store half a data item */
+	if (ptr != end) {
+		syslog(LOG_USER | LOG_INFO, "Error: Discarding malformed binary record of type %d", input_type);
+		ido2db_free_input_memory(idi);
+		idi->current_input_data = IDO2DB_INPUT_DATA_NONE;
+		return IDO_ERROR;
+	}
+
+	/* finish current data processing */
+	ido2db_end_input_data(idi);
+
+	idi->current_input_data = IDO2DB_INPUT_DATA_NONE;
+	idi->lines_processed++;
+
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_handle_client_binary_input() end\n");
+
+	return IDO_OK;
+}
+
+
+/* returns the input data kind of a data type sent by the client */
+int ido2db_get_input_data_type(int input_type) {
+
+	switch (input_type) {
+
+		/* archived data */
+	case IDO_API_LOGENTRY:
+		return IDO2DB_INPUT_DATA_LOGENTRY;
+
+		/* realtime data */
+	case IDO_API_PROCESSDATA:
+		return IDO2DB_INPUT_DATA_PROCESSDATA;
+	case IDO_API_LOGDATA:
+		return IDO2DB_INPUT_DATA_LOGDATA;
+	case IDO_API_SYSTEMCOMMANDDATA:
+		return IDO2DB_INPUT_DATA_SYSTEMCOMMANDDATA;
+	case IDO_API_EVENTHANDLERDATA:
+		return IDO2DB_INPUT_DATA_EVENTHANDLERDATA;
+	case IDO_API_NOTIFICATIONDATA:
+		return IDO2DB_INPUT_DATA_NOTIFICATIONDATA;
+	case IDO_API_SERVICECHECKDATA:
+		return IDO2DB_INPUT_DATA_SERVICECHECKDATA;
+	case IDO_API_HOSTCHECKDATA:
+		return IDO2DB_INPUT_DATA_HOSTCHECKDATA;
+	case IDO_API_COMMENTDATA:
+		return IDO2DB_INPUT_DATA_COMMENTDATA;
+	case IDO_API_DOWNTIMEDATA:
+		return IDO2DB_INPUT_DATA_DOWNTIMEDATA;
+	case IDO_API_FLAPPINGDATA:
+		return IDO2DB_INPUT_DATA_FLAPPINGDATA;
+	case IDO_API_PROGRAMSTATUSDATA:
+		return IDO2DB_INPUT_DATA_PROGRAMSTATUSDATA;
+	case IDO_API_HOSTSTATUSDATA:
+		return IDO2DB_INPUT_DATA_HOSTSTATUSDATA;
+	case IDO_API_SERVICESTATUSDATA:
+		return IDO2DB_INPUT_DATA_SERVICESTATUSDATA;
+	case IDO_API_CONTACTSTATUSDATA:
+		return IDO2DB_INPUT_DATA_CONTACTSTATUSDATA;
+	case IDO_API_ADAPTIVEPROGRAMDATA:
+		return IDO2DB_INPUT_DATA_ADAPTIVEPROGRAMDATA;
+	case IDO_API_ADAPTIVEHOSTDATA:
+		return IDO2DB_INPUT_DATA_ADAPTIVEHOSTDATA;
+	case IDO_API_ADAPTIVESERVICEDATA:
+		return IDO2DB_INPUT_DATA_ADAPTIVESERVICEDATA;
+	case IDO_API_ADAPTIVECONTACTDATA:
+		return IDO2DB_INPUT_DATA_ADAPTIVECONTACTDATA;
+	case IDO_API_EXTERNALCOMMANDDATA:
+		return IDO2DB_INPUT_DATA_EXTERNALCOMMANDDATA;
+	case IDO_API_AGGREGATEDSTATUSDATA:
+		return IDO2DB_INPUT_DATA_AGGREGATEDSTATUSDATA;
+	case IDO_API_RETENTIONDATA:
+		return IDO2DB_INPUT_DATA_RETENTIONDATA;
+	case IDO_API_CONTACTNOTIFICATIONDATA:
+		return IDO2DB_INPUT_DATA_CONTACTNOTIFICATIONDATA;
+	case IDO_API_CONTACTNOTIFICATIONMETHODDATA:
+		return IDO2DB_INPUT_DATA_CONTACTNOTIFICATIONMETHODDATA;
+	case IDO_API_ACKNOWLEDGEMENTDATA:
+		return IDO2DB_INPUT_DATA_ACKNOWLEDGEMENTDATA;
+	case IDO_API_STATECHANGEDATA:
+		return IDO2DB_INPUT_DATA_STATECHANGEDATA;
+
+		/* config variables */
+	case IDO_API_MAINCONFIGFILEVARIABLES:
+		return IDO2DB_INPUT_DATA_MAINCONFIGFILEVARIABLES;
+	case IDO_API_RESOURCECONFIGFILEVARIABLES:
+		return IDO2DB_INPUT_DATA_RESOURCECONFIGFILEVARIABLES;
+	case IDO_API_CONFIGVARIABLES:
+		return IDO2DB_INPUT_DATA_CONFIGVARIABLES;
+	case IDO_API_RUNTIMEVARIABLES:
+		return IDO2DB_INPUT_DATA_RUNTIMEVARIABLES;
+
+		/* object configuration */
+	case IDO_API_HOSTDEFINITION:
+		return IDO2DB_INPUT_DATA_HOSTDEFINITION;
+	case IDO_API_HOSTGROUPDEFINITION:
+		return IDO2DB_INPUT_DATA_HOSTGROUPDEFINITION;
+	case IDO_API_SERVICEDEFINITION:
+		return IDO2DB_INPUT_DATA_SERVICEDEFINITION;
+	case IDO_API_SERVICEGROUPDEFINITION:
+		return IDO2DB_INPUT_DATA_SERVICEGROUPDEFINITION;
+	case IDO_API_HOSTDEPENDENCYDEFINITION:
+		return IDO2DB_INPUT_DATA_HOSTDEPENDENCYDEFINITION;
+	case IDO_API_SERVICEDEPENDENCYDEFINITION:
+		return IDO2DB_INPUT_DATA_SERVICEDEPENDENCYDEFINITION;
+	case IDO_API_HOSTESCALATIONDEFINITION:
+		return IDO2DB_INPUT_DATA_HOSTESCALATIONDEFINITION;
+	case IDO_API_SERVICEESCALATIONDEFINITION:
+		return IDO2DB_INPUT_DATA_SERVICEESCALATIONDEFINITION;
+	case IDO_API_COMMANDDEFINITION:
+		return IDO2DB_INPUT_DATA_COMMANDDEFINITION;
+	case IDO_API_TIMEPERIODDEFINITION:
+		return IDO2DB_INPUT_DATA_TIMEPERIODDEFINITION;
+	case IDO_API_CONTACTDEFINITION:
+		return IDO2DB_INPUT_DATA_CONTACTDEFINITION;
+	case IDO_API_CONTACTGROUPDEFINITION:
+		return IDO2DB_INPUT_DATA_CONTACTGROUPDEFINITION;
+	case IDO_API_HOSTEXTINFODEFINITION:
+		/* deprecated - merged with host definitions */
+	case IDO_API_SERVICEEXTINFODEFINITION:
+		/* deprecated - merged with service definitions */
+	case IDO_API_ENABLEOBJECT:
+		return IDO2DB_INPUT_DATA_ENABLEOBJECT;
+	case IDO_API_DISABLEOBJECT:
+		return IDO2DB_INPUT_DATA_DISABLEOBJECT;
+
+	default:
+		break;
+	}
+
+	return IDO2DB_INPUT_DATA_NONE;
+}
+
+
 int ido2db_start_input_data(ido2db_idi *idi) {
 	int x;
 
@@ -2352,6 +3109,16 @@ int ido2db_add_input_data_item(ido2db_idi *idi, int type, char *buf) {
 		return IDO_ERROR;
 	}
 
+	return ido2db_store_input_data_item(idi, type, newbuf);
+}
+
+
+/* stores an unescaped data item - takes over the memory */
+int ido2db_store_input_data_item(ido2db_idi *idi, int type, char *newbuf) {
+
+	if (idi == NULL || newbuf == NULL)
+		return IDO_ERROR;
+
 	/* store the buffered data */
 	switch (type) {
 
@@ -2416,7 +3183,7 @@ int ido2db_add_input_data_item(ido2db_idi *idi, int type, char *buf) {
 		idi->buffered_input[type] = newbuf;
 	}
 
-	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_start_input_data() end\n");
+	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_store_input_data_item() end\n");
 	return IDO_OK;
 }
 
@@ -2733,6 +3500,13 @@ int ido2db_free_connection_memory(ido2db_idi *idi) {
 		free(idi->connect_type);
 		idi->connect_type = NULL;
 	}
+#ifdef HAVE_ZLIB_H
+	if (idi->zstream) {
+		inflateEnd(idi->zstream);
+		free(idi->zstream);
+		idi->zstream = NULL;
+	}
+#endif
 
 	ido2db_log_debug_info(IDO2DB_DEBUGL_PROCESSINFO, 2, "ido2db_free_connection_memory() end\n");
 	return IDO_OK;
@@ -2865,6 +3639,7 @@ int ido2db_convert_string_to_unsignedlong(char *buf, unsigned long *ul) {
 
 
 int ido2db_convert_string_to_timeval(char *buf, struct timeval *tv) {
+	char *saveptr = NULL;
 	char *newbuf = NULL;
 	char *ptr = NULL;
 	int result = IDO_OK;
@@ -2880,9 +3655,9 @@ int ido2db_convert_string_to_timeval(char *buf, struct timeval *tv) {
 	if ((newbuf = strdup(buf)) == NULL)
 		return IDO_ERROR;
 
-	ptr = strtok(newbuf, ".");
+	ptr = strtok_r(newbuf, ".", &saveptr);
 	if ((result = ido2db_convert_string_to_unsignedlong(ptr, (unsigned long *)&tv->tv_sec)) == IDO_OK) {
-		ptr = strtok(NULL, "\n");
+		ptr = strtok_r(NULL, "\n", &saveptr);
 		result = ido2db_convert_string_to_unsignedlong(ptr, (unsigned long *)&tv->tv_usec);
 	}
 
@@ -2984,6 +3759,8 @@ void * ido2db_thread_cleanup(void *data) {
 	ido2db_idi *idi = (ido2db_idi*) data;
 
 	struct timespec delay;
+	struct timeval now;
+	struct timeval wait;
 	delay.tv_sec = 0;
 	delay.tv_nsec = 500;
 
@@ -3068,6 +3845,18 @@ void * ido2db_thread_cleanup(void *data) {
 		/* should we shutdown? */
 		pthread_testcancel();
 
+		/* a pass in progress goes on once its rows per second budget allows */
+		if (thread_idi.dbinfo.trim_table >= 0) {
+			gettimeofday(&now, NULL);
+			if (timercmp(&now, &thread_idi.dbinfo.trim_next_chunk, <)) {
+				timersub(&thread_idi.dbinfo.trim_next_chunk, &now, &wait);
+				delay.tv_sec = wait.tv_sec;
+				delay.tv_nsec = wait.tv_usec * 1000L;
+				nanosleep(&delay, NULL);
+			}
+			continue;
+		}
+
 		sleep(thread_idi.dbinfo.trim_db_interval + 1);
 	}
 
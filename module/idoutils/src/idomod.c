@@ -54,6 +54,11 @@ int idomod_allow_sink_activity = IDO_TRUE;
 unsigned long idomod_process_options = IDOMOD_PROCESS_EVERYTHING;
 int idomod_config_output_options = IDOMOD_CONFIG_DUMP_ALL;
 unsigned long idomod_sink_buffer_slots = 5000;
+unsigned long idomod_sink_buffer_size = 0L;
+char *idomod_sink_buffer_file = NULL;
+int idomod_use_writer_thread = IDO_FALSE;
+int idomod_use_binary_encoding = IDO_FALSE;
+int idomod_compression_level = 0;
 idomod_sink_buffer sinkbuf;
 
 int dump_customvar_status = IDO_TRUE;
@@ -69,6 +74,39 @@ int idomod_close_debug_log(void);
 
 static char *broker_data_temp_buffer;
 
+/* writer thread - see idomod_start_writer_thread() */
+static pthread_t idomod_writer_thread;
+static volatile int idomod_writer_running = IDO_FALSE;
+static volatile int idomod_writer_shutdown = IDO_FALSE;
+static volatile int idomod_writer_waiting = IDO_FALSE;
+static int idomod_writer_wakeup_pipe[2] = { -1, -1 };
+static pthread_mutex_t idomod_writer_log_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *idomod_writer_log_messages[IDOMOD_WRITER_LOG_MESSAGES];
+static int idomod_writer_log_flags[IDOMOD_WRITER_LOG_MESSAGES];
+static volatile int idomod_writer_log_count = 0;
+
+static pthread_mutex_t idomod_debug_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* set while the current sink takes binary records */
+static volatile int idomod_sink_binary = IDO_FALSE;
+
+/* ido2db's answers to the hello options still to come - the core doesn't wait for them */
+static int idomod_hello_want_binary = IDO_FALSE;
+static int idomod_hello_want_compression = IDO_FALSE;
+static int idomod_hello_compressed = IDO_FALSE;
+static time_t idomod_hello_deadline = 0L;
+static char idomod_hello_answer[64];
+static int idomod_hello_answer_len = 0;
+
+static int idomod_queue_for_writer(char *, unsigned long, int);
+static int idomod_defer_writer_log(char *, int);
+static void idomod_write_writer_logs(void);
+static void idomod_log_writer_stats(void);
+static int idomod_read_hello_answer(int);
+static void idomod_check_hello_answer(int);
+static char *idomod_binary_to_text(char *, unsigned long);
+static void *idomod_writer_thread_main(void *);
+
 extern int errno;
 
 /**** Icinga VARIABLES ****/
@@ -93,6 +131,8 @@ extern char *global_service_event_handler;
 extern int __icinga_object_structure_version;
 
 extern int use_ssl;
+extern unsigned long ido_sink_uncompressed_bytes;
+extern unsigned long ido_sink_compressed_bytes;
 
 #define DEBUG_IDO 1
 
@@ -199,7 +239,9 @@ int idomod_init(void) {
 	idomod_allow_sink_activity = IDO_TRUE;
 
 	/* initialize data sink buffer */
-	idomod_sink_buffer_init(&sinkbuf, idomod_sink_buffer_slots);
+	if (idomod_sink_buffer_size == 0L)
+		idomod_sink_buffer_size = idomod_sink_buffer_slots * IDOMOD_SINK_BUFFER_ITEM_SIZE;
+	idomod_sink_buffer_init(&sinkbuf, idomod_sink_buffer_size, idomod_sink_buffer_file);
 
 	/* read unprocessed data from buffer file */
 	idomod_load_unprocessed_data(idomod_buffer_file);
@@ -208,6 +250,9 @@ int idomod_init(void) {
 	/* 05/04/06 - modified to flush buffer items that may have been read in from file */
 	idomod_write_to_sink("\n", IDO_FALSE, IDO_TRUE);
 
+	/* hand all further writing to the writer thread, if enabled */
+	idomod_start_writer_thread();
+
 	/* register callbacks */
 	if (idomod_register_callbacks() == IDO_ERROR)
 		return IDO_ERROR;
@@ -244,6 +289,9 @@ int idomod_deinit(void) {
 	/* deregister callbacks */
 	idomod_deregister_callbacks();
 
+	/* let the writer thread write what it can */
+	idomod_stop_writer_thread();
+
 	/* save unprocessed data to buffer file */
 	idomod_save_unprocessed_data(idomod_buffer_file);
 	free(idomod_buffer_file);
@@ -251,6 +299,8 @@ int idomod_deinit(void) {
 
 	/* clear sink buffer */
 	idomod_sink_buffer_deinit(&sinkbuf);
+	free(idomod_sink_buffer_file);
+	idomod_sink_buffer_file = NULL;
 
 	/* close data sink */
 	idomod_goodbye_sink();
@@ -439,6 +489,24 @@ int idomod_process_config_var(char *arg) {
 	else if (!strcmp(var, "output_buffer_items"))
 		idomod_sink_buffer_slots = strtoul(val, NULL, 0);
 
+	else if (!strcmp(var, "output_buffer_size"))
+		idomod_sink_buffer_size = strtoul(val, NULL, 0);
+
+	else if (!strcmp(var, "output_buffer_file"))
+		idomod_sink_buffer_file = strdup(val);
+
+	else if (!strcmp(var, "use_writer_thread"))
+		idomod_use_writer_thread = (atoi(val) > 0) ? IDO_TRUE : IDO_FALSE;
+
+	else if (!strcmp(var, "use_binary_encoding"))
+		idomod_use_binary_encoding = (atoi(val) > 0) ? IDO_TRUE : IDO_FALSE;
+
+	else if (!strcmp(var, "compression_level")) {
+		idomod_compression_level = atoi(val);
+		if (idomod_compression_level < 0 || idomod_compression_level > 9)
+			return IDO_ERROR;
+	}
+
 	else if (!strcmp(var, "reconnect_interval"))
 		idomod_sink_reconnect_interval = strtoul(val, NULL, 0);
 
@@ -514,6 +582,10 @@ int idomod_write_to_logs(char *buf, int flags) {
 	if (buf == NULL)
 		return IDO_ERROR;
 
+	/* the core's logging isn't thread safe, so the main thread logs for the writer thread */
+	if (idomod_writer_running == IDO_TRUE && pthread_equal(pthread_self(), idomod_writer_thread))
+		return idomod_defer_writer_log(buf, flags);
+
 	return write_to_all_logs(buf, flags);
 }
 
@@ -563,12 +635,19 @@ int idomod_close_sink(void) {
 	/* flush sink */
 	ido_sink_flush(idomod_sink_fd);
 
+	if (ido_sink_uncompressed_bytes > 0)
+		idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 0, "idomod: %lu bytes compressed to %lu bytes so far\n", ido_sink_uncompressed_bytes, ido_sink_compressed_bytes);
+
 	/* close sink */
 	ido_sink_close(idomod_sink_fd);
 
 	/* mark the sink as being closed */
 	idomod_sink_is_open = IDO_FALSE;
 
+	/* a hello answer won't come anymore */
+	idomod_hello_want_binary = IDO_FALSE;
+	idomod_hello_want_compression = IDO_FALSE;
+
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_close_sink() end\n");
 
 	return IDO_OK;
@@ -580,6 +659,8 @@ int idomod_hello_sink(int reconnect, int problem_disconnect) {
 	char temp_buffer[IDOMOD_MAX_BUFLEN];
 	char *connection_type = NULL;
 	char *connect_type = NULL;
+	int request_binary = IDO_FALSE;
+	int request_compression = IDO_FALSE;
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_hello_sink() start\n");
 
@@ -597,8 +678,15 @@ int idomod_hello_sink(int reconnect, int problem_disconnect) {
 	else
 		connect_type = IDO_API_CONNECTTYPE_INITIAL;
 
+	/* ido2db has to answer, so this takes a socket - and we don't read from SSL connections */
+	if (idomod_sink_type != IDO_SINK_FD && idomod_sink_type != IDO_SINK_FILE && use_ssl == IDO_FALSE) {
+		request_binary = idomod_use_binary_encoding;
+		request_compression = (idomod_compression_level > 0) ? IDO_TRUE : IDO_FALSE;
+	}
+
+	/* with compression the data dump starts after ido2db answered, as it may already be compressed */
 	snprintf(temp_buffer, sizeof(temp_buffer) - 1
-	         , "\n\n%s\n%s: %d\n%s: %s\n%s: %s\n%s: %lu\n%s: %s\n%s: %s\n%s: %s\n%s: %s\n%s\n\n"
+	         , "\n\n%s\n%s: %d\n%s: %s\n%s: %s\n%s: %lu\n%s: %s\n%s: %s\n%s: %s\n%s: %s\n%s%s%s%s"
 	         , IDO_API_HELLO
 	         , IDO_API_PROTOCOL
 	         , IDO_API_PROTOVERSION
@@ -616,19 +704,155 @@ int idomod_hello_sink(int reconnect, int problem_disconnect) {
 	         , connect_type
 	         , IDO_API_INSTANCENAME
 	         , (idomod_instance_name == NULL) ? "default" : idomod_instance_name
-	         , IDO_API_STARTDATADUMP
+	         , (request_binary == IDO_TRUE) ? IDO_API_ENCODING ": " IDO_API_ENCODING_BINARY "\n" : ""
+	         , (request_compression == IDO_TRUE) ? IDO_API_COMPRESSION ": " IDO_API_COMPRESSION_ZLIB "\n" : ""
+	         , (request_compression == IDO_TRUE) ? "" : IDO_API_STARTDATADUMP
+	         , (request_compression == IDO_TRUE) ? "" : "\n\n"
 	        );
 
 	temp_buffer[sizeof(temp_buffer)-1] = '\x0';
 
+	idomod_sink_binary = IDO_FALSE;
+	idomod_hello_want_binary = IDO_FALSE;
+	idomod_hello_want_compression = IDO_FALSE;
+	idomod_hello_compressed = IDO_FALSE;
+
 	idomod_write_to_sink(temp_buffer, IDO_FALSE, IDO_FALSE);
 
+	/* ido2db answers in the order we asked - older versions don't answer at all */
+	if (idomod_sink_is_open == IDO_TRUE && (request_binary == IDO_TRUE || request_compression == IDO_TRUE)) {
+
+		idomod_hello_want_binary = request_binary;
+		idomod_hello_want_compression = request_compression;
+		idomod_hello_answer_len = 0;
+
+		time(&idomod_hello_deadline);
+		idomod_hello_deadline += IDOMOD_HELLO_TIMEOUT;
+
+		/* only the writer thread may wait for the answer, the core carries on with text meanwhile */
+		idomod_check_hello_answer((idomod_writer_running == IDO_TRUE && pthread_equal(pthread_self(), idomod_writer_thread)) ? IDO_TRUE : IDO_FALSE);
+	}
+
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_hello_sink() end\n");
 
 	return IDO_OK;
 }
 
 
+/* handles what ido2db answered to the hello options so far - anything else than an answer means it doesn't know them */
+static void idomod_check_hello_answer(int wait) {
+	char temp_buffer[64];
+	int answered = IDO_TRUE;
+	int result = 0;
+
+	while (idomod_hello_want_binary == IDO_TRUE || idomod_hello_want_compression == IDO_TRUE) {
+
+		/* nothing more yet */
+		if ((result = idomod_read_hello_answer(wait)) == 0)
+			return;
+
+		if (result < 0) {
+			answered = IDO_FALSE;
+			break;
+		}
+
+		if (idomod_hello_want_binary == IDO_TRUE) {
+
+			idomod_hello_want_binary = IDO_FALSE;
+
+			if (!strcmp(idomod_hello_answer, IDO_API_ENCODING ": " IDO_API_ENCODING_BINARY))
+				idomod_sink_binary = IDO_TRUE;
+			else if (strncmp(idomod_hello_answer, IDO_API_ENCODING ":", strlen(IDO_API_ENCODING ":"))) {
+				answered = IDO_FALSE;
+				break;
+			}
+		} else {
+
+			idomod_hello_want_compression = IDO_FALSE;
+
+			if (!strcmp(idomod_hello_answer, IDO_API_COMPRESSION ": " IDO_API_COMPRESSION_ZLIB)) {
+
+				/* ido2db expects a compressed stream now, there's no way back */
+				if (ido_sink_start_compression(idomod_compression_level) == IDO_ERROR) {
+					idomod_write_to_logs("idomod: Could not set up compression, closing data sink.", NSLOG_RUNTIME_ERROR);
+					idomod_close_sink();
+					return;
+				}
+				idomod_hello_compressed = IDO_TRUE;
+
+				/* the data dump starts after the answer, as it is compressed */
+				snprintf(temp_buffer, sizeof(temp_buffer) - 1, "%s\n\n", IDO_API_STARTDATADUMP);
+				temp_buffer[sizeof(temp_buffer)-1] = '\x0';
+				idomod_write_to_sink(temp_buffer, IDO_FALSE, IDO_FALSE);
+			} else if (strncmp(idomod_hello_answer, IDO_API_COMPRESSION ":", strlen(IDO_API_COMPRESSION ":"))) {
+				answered = IDO_FALSE;
+				break;
+			}
+		}
+	}
+
+	if (answered == IDO_FALSE) {
+
+		idomod_hello_want_binary = IDO_FALSE;
+		idomod_sink_binary = IDO_FALSE;
+
+		/* the data dump was held back for the compression answer */
+		if (idomod_hello_want_compression == IDO_TRUE) {
+			idomod_hello_want_compression = IDO_FALSE;
+			snprintf(temp_buffer, sizeof(temp_buffer) - 1, "%s\n\n", IDO_API_STARTDATADUMP);
+			temp_buffer[sizeof(temp_buffer)-1] = '\x0';
+			idomod_write_to_sink(temp_buffer, IDO_FALSE, IDO_FALSE);
+		}
+
+		idomod_write_to_logs("idomod: ido2db did not answer, sending uncompressed text.  Set use_binary_encoding=0 and compression_level=0 for older versions of ido2db.", NSLOG_INFO_MESSAGE);
+	} else
+		idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 0, "ido2db answered, binary encoding %s, compression %s\n", (idomod_sink_binary == IDO_TRUE) ? "on" : "off", (idomod_hello_compressed == IDO_TRUE) ? "on" : "off");
+
+	return;
+}
+
+
+/* reads ido2db's answer to the hello up to the newline - returns 1 for a complete line, 0 if more is to come and -1 if none will */
+static int idomod_read_hello_answer(int wait) {
+	struct pollfd pfd;
+	time_t current_time;
+	int result = 0;
+
+	pfd.fd = idomod_sink_fd;
+	pfd.events = POLLIN;
+
+	while (idomod_hello_answer_len < (int)sizeof(idomod_hello_answer) - 1) {
+
+		time(&current_time);
+		if (current_time >= idomod_hello_deadline)
+			return -1;
+
+		if ((result = poll(&pfd, 1, (wait == IDO_TRUE) ? (int)(idomod_hello_deadline - current_time) * 1000 : 0)) <= 0) {
+			if (result == -1 && errno == EINTR)
+				continue;
+			return (result == 0 && wait == IDO_FALSE) ? 0 : -1;
+		}
+
+		/* don't read beyond the answer */
+		if ((result = read(idomod_sink_fd, idomod_hello_answer + idomod_hello_answer_len, 1)) <= 0) {
+			if (result == -1 && (errno == EINTR || errno == EAGAIN))
+				continue;
+			return -1;
+		}
+
+		if (idomod_hello_answer[idomod_hello_answer_len] == '\n') {
+			idomod_hello_answer[idomod_hello_answer_len] = '\x0';
+			idomod_hello_answer_len = 0;
+			return 1;
+		}
+
+		idomod_hello_answer_len++;
+	}
+
+	return -1;
+}
+
+
 /* say goodbye */
 int idomod_goodbye_sink(void) {
 	char temp_buffer[IDOMOD_MAX_BUFLEN];
@@ -701,12 +925,23 @@ int idomod_rotate_sink_file(void *args) {
 
 /* writes data to sink */
 int idomod_write_to_sink(char *buf, int buffer_write, int flush_buffer) {
+
+	/* we have nothing to write... */
+	if (buf == NULL)
+		return IDO_OK;
+
+	return idomod_write_data_to_sink(buf, strlen(buf), IDO_FALSE, buffer_write, flush_buffer);
+}
+
+
+/* writes data of the given length to sink - binary records are only written if ido2db takes them */
+int idomod_write_data_to_sink(char *buf, unsigned long buflen, int binary, int buffer_write, int flush_buffer) {
 	char *temp_buffer = NULL;
-	char *sbuf = NULL;
-	int buflen = 0;
+	char *text = NULL;
 	int result = IDO_OK;
 	time_t current_time;
 	int reconnect = IDO_FALSE;
+	int opened = IDO_FALSE;
 	unsigned long items_to_flush = 0L;
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_write_to_sink() start\n");
@@ -715,12 +950,17 @@ int idomod_write_to_sink(char *buf, int buffer_write, int flush_buffer) {
 	if (buf == NULL)
 		return IDO_OK;
 
-	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_write_to_sink(%s)\n", buf);
+	if (binary == IDO_FALSE)
+		idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_write_to_sink(%s)\n", buf);
 
 	/* we shouldn't be messing with things... */
 	if (idomod_allow_sink_activity == IDO_FALSE)
 		return IDO_ERROR;
 
+	/* the writer thread does the actual writing */
+	if (idomod_writer_running == IDO_TRUE && !pthread_equal(pthread_self(), idomod_writer_thread))
+		return idomod_queue_for_writer(buf, buflen, binary);
+
 	/* open the sink if necessary... */
 	if (idomod_sink_is_open == IDO_FALSE) {
 
@@ -742,18 +982,20 @@ int idomod_write_to_sink(char *buf, int buffer_write, int flush_buffer) {
 			/* sink was (re)opened... */
 			if (result == IDO_OK) {
 
+				opened = IDO_TRUE;
+
 				if (reconnect == IDO_TRUE) {
-					if (asprintf(&temp_buffer, "idomod: Successfully reconnected to data sink!  %lu items lost, %lu queued items to flush.", sinkbuf.overflow, sinkbuf.items) == -1)
+					if (asprintf(&temp_buffer, "idomod: Successfully reconnected to data sink!  %lu items lost, %lu queued items to flush.", sinkbuf.overflow, idomod_sink_buffer_items(&sinkbuf)) == -1)
 						temp_buffer = NULL;
 
 					idomod_hello_sink(TRUE, TRUE);
 
 				} else {
 					if (sinkbuf.overflow == 0L) {
-						if (asprintf(&temp_buffer, "idomod: Successfully connected to data sink.  %lu queued items to flush.", sinkbuf.items) == -1)
+						if (asprintf(&temp_buffer, "idomod: Successfully connected to data sink.  %lu queued items to flush.", idomod_sink_buffer_items(&sinkbuf)) == -1)
 							;//temp_buffer=NULL;
 					} else {
-						if (asprintf(&temp_buffer, "idomod: Successfully connected to data sink.  %lu items lost, %lu queued items to flush.", sinkbuf.overflow, sinkbuf.items) == -1)
+						if (asprintf(&temp_buffer, "idomod: Successfully connected to data sink.  %lu items lost, %lu queued items to flush.", sinkbuf.overflow, idomod_sink_buffer_items(&sinkbuf)) == -1)
 							;//temp_buffer=NULL;
 					}
 
@@ -772,13 +1014,13 @@ int idomod_write_to_sink(char *buf, int buffer_write, int flush_buffer) {
 
 				if ((unsigned long)((unsigned long)current_time - idomod_sink_reconnect_warning_interval) > (unsigned long)idomod_sink_last_reconnect_warning) {
 					if (reconnect == IDO_TRUE) {
-						if (asprintf(&temp_buffer, "idomod: Still unable to reconnect to data sink.  %lu items lost, %lu queued items to flush. Is ido2db running and processing data?", sinkbuf.overflow, sinkbuf.items) == -1)
+						if (asprintf(&temp_buffer, "idomod: Still unable to reconnect to data sink.  %lu items lost, %lu queued items to flush. Is ido2db running and processing data?", sinkbuf.overflow, idomod_sink_buffer_items(&sinkbuf)) == -1)
 							temp_buffer = NULL;
 					} else if (idomod_sink_connect_attempt == 1) {
 						if (asprintf(&temp_buffer, "idomod: Could not open data sink!  I'll keep trying, but some output may get lost. Is ido2db running and processing data?") == -1)
 							temp_buffer = NULL;
 					} else {
-						if (asprintf(&temp_buffer, "idomod: Still unable to connect to data sink.  %lu items lost, %lu queued items to flush. Is ido2db running and processing data?", sinkbuf.overflow, sinkbuf.items) == -1)
+						if (asprintf(&temp_buffer, "idomod: Still unable to connect to data sink.  %lu items lost, %lu queued items to flush. Is ido2db running and processing data?", sinkbuf.overflow, idomod_sink_buffer_items(&sinkbuf)) == -1)
 							temp_buffer = NULL;
 					}
 
@@ -792,13 +1034,17 @@ int idomod_write_to_sink(char *buf, int buffer_write, int flush_buffer) {
 		}
 	}
 
-	/* we weren't able to (re)connect */
-	if (idomod_sink_is_open == IDO_FALSE) {
+	/* ido2db may have answered the hello options by now */
+	if (idomod_hello_want_binary == IDO_TRUE || idomod_hello_want_compression == IDO_TRUE)
+		idomod_check_hello_answer(IDO_FALSE);
+
+	/* we weren't able to (re)connect - or the stream may be compressed from here on, and ido2db didn't tell yet */
+	if (idomod_sink_is_open == IDO_FALSE || idomod_hello_want_compression == IDO_TRUE) {
 
 		/***** BUFFER OUTPUT FOR LATER *****/
 
 		if (buffer_write == IDO_TRUE)
-			idomod_sink_buffer_push(&sinkbuf, buf);
+			idomod_sink_buffer_push(&sinkbuf, buf, buflen, binary);
 
 		return IDO_ERROR;
 	}
@@ -808,61 +1054,63 @@ int idomod_write_to_sink(char *buf, int buffer_write, int flush_buffer) {
 
 	if (flush_buffer == IDO_TRUE && (items_to_flush = idomod_sink_buffer_items(&sinkbuf)) > 0) {
 
-		while (idomod_sink_buffer_items(&sinkbuf) > 0) {
-
-			/* get next item from buffer */
-			sbuf = idomod_sink_buffer_peek(&sinkbuf);
+		/* write the buffered items in as few writes as possible */
+		if (idomod_sink_buffer_write(&sinkbuf, idomod_sink_fd, idomod_sink_binary) == IDO_ERROR) {
 
-			buflen = strlen(sbuf);
-			result = ido_sink_write(idomod_sink_fd, sbuf, buflen);
+			/* sink problem! */
+			if (errno != EAGAIN) {
 
-			/* an error occurred... */
-			if (result < 0) {
+				/* close the sink */
+				idomod_close_sink();
 
-				/* sink problem! */
-				if (errno != EAGAIN) {
-
-					/* close the sink */
-					idomod_close_sink();
-
-					if (asprintf(&temp_buffer, "idomod: Error writing to data sink!  Some output may get lost.  %lu queued items to flush.", sinkbuf.items) == -1)
-						temp_buffer = NULL;
-
-					idomod_write_to_logs(temp_buffer, NSLOG_INFO_MESSAGE);
-					free(temp_buffer);
+				if (asprintf(&temp_buffer, "idomod: Error writing to data sink!  Some output may get lost.  %lu queued items to flush.", idomod_sink_buffer_items(&sinkbuf)) == -1)
 					temp_buffer = NULL;
 
-					time(&current_time);
-					idomod_sink_last_reconnect_attempt = current_time;
-					idomod_sink_last_reconnect_warning = current_time;
-				}
+				idomod_write_to_logs(temp_buffer, NSLOG_INFO_MESSAGE);
+				free(temp_buffer);
+				temp_buffer = NULL;
 
-				/***** BUFFER ORIGINAL OUTPUT FOR LATER *****/
+				time(&current_time);
+				idomod_sink_last_reconnect_attempt = current_time;
+				idomod_sink_last_reconnect_warning = current_time;
+			}
 
-				if (buffer_write == IDO_TRUE)
-					idomod_sink_buffer_push(&sinkbuf, buf);
+			/***** BUFFER ORIGINAL OUTPUT FOR LATER *****/
 
-				return IDO_ERROR;
-			}
+			if (buffer_write == IDO_TRUE)
+				idomod_sink_buffer_push(&sinkbuf, buf, buflen, binary);
 
-			/* buffer was written okay, so remove it from buffer */
-			idomod_sink_buffer_pop(&sinkbuf);
+			return IDO_ERROR;
 		}
 
-		if (asprintf(&temp_buffer, "idomod: Successfully flushed %lu queued items to data sink.", items_to_flush) == -1)
-			temp_buffer = NULL;
+		/* with a writer thread, items are always queued - only tell about the backlog of a reconnect */
+		if (idomod_writer_running == IDO_FALSE || opened == IDO_TRUE) {
 
-		idomod_write_to_logs(temp_buffer, NSLOG_INFO_MESSAGE);
-		free(temp_buffer);
-		temp_buffer = NULL;
+			if (asprintf(&temp_buffer, "idomod: Successfully flushed %lu queued items to data sink.", items_to_flush) == -1)
+				temp_buffer = NULL;
+
+			idomod_write_to_logs(temp_buffer, NSLOG_INFO_MESSAGE);
+			free(temp_buffer);
+			temp_buffer = NULL;
+		}
 	}
 
 
 	/***** WRITE ORIGINAL DATA *****/
 
-	/* write the data */
-	buflen = strlen(buf);
-	result = ido_sink_write(idomod_sink_fd, buf, buflen);
+	/* encoded before we learned ido2db doesn't know binary records */
+	if (binary == IDO_TRUE && idomod_sink_binary == IDO_FALSE) {
+		if ((text = idomod_binary_to_text(buf, buflen)) == NULL) {
+			__sync_fetch_and_add(&sinkbuf.overflow, 1);
+			return IDO_ERROR;
+		}
+		result = ido_sink_write(idomod_sink_fd, text, strlen(text));
+		my_free(text);
+	} else {
+
+		/* write the data */
+		result = ido_sink_write(idomod_sink_fd, buf, buflen);
+	}
 
 	/* an error occurred... */
 	if (result < 0) {
@@ -894,7 +1142,7 @@ int idomod_write_to_sink(char *buf, int buffer_write, int flush_buffer) {
 		/***** BUFFER OUTPUT FOR LATER *****/
 
 		if (buffer_write == IDO_TRUE)
-			idomod_sink_buffer_push(&sinkbuf, buf);
+			idomod_sink_buffer_push(&sinkbuf, buf, buflen, binary);
 
 		return IDO_ERROR;
 	}
@@ -906,11 +1154,248 @@ int idomod_write_to_sink(char *buf, int buffer_write, int flush_buffer) {
 
 
 
+/****************************************************************************/
+/* WRITER THREAD FUNCTIONS                                                  */
+/****************************************************************************/
+
+/*
+ * With use_writer_thread=1 the main thread only queues event data in the
+ * sink buffer.  The writer thread takes care of the sink: it (re)connects,
+ * writes queued items in batches and keeps them while the sink is down, so
+ * a slow or unreachable ido2db doesn't hold up the core.
+ */
+
+/* starts the writer thread */
+int idomod_start_writer_thread(void) {
+	sigset_t newmask;
+	sigset_t oldmask;
+	int result = 0;
+	int x = 0;
+
+	if (idomod_use_writer_thread == IDO_FALSE || idomod_writer_running == IDO_TRUE)
+		return IDO_OK;
+
+	/* file sinks get rotated by the main thread */
+	if (idomod_sink_type == IDO_SINK_FILE) {
+		idomod_write_to_logs("idomod: use_writer_thread=1 is not available with output_type=file, writing synchronously.", NSLOG_INFO_MESSAGE);
+		return IDO_OK;
+	}
+
+	if (pipe(idomod_writer_wakeup_pipe) == -1) {
+		idomod_write_to_logs("idomod: Could not create writer thread wakeup pipe, writing synchronously.", NSLOG_INFO_MESSAGE);
+		return IDO_ERROR;
+	}
+	for (x = 0; x < 2; x++)
+		fcntl(idomod_writer_wakeup_pipe[x], F_SETFL, fcntl(idomod_writer_wakeup_pipe[x], F_GETFL) | O_NONBLOCK);
+
+	idomod_writer_shutdown = IDO_FALSE;
+
+	/* the writer thread waits for this lock, so it doesn't look at its thread id before we have it */
+	pthread_mutex_lock(&idomod_writer_log_lock);
+
+	idomod_writer_running = IDO_TRUE;
+
+	/* new thread should block all signals */
+	sigfillset(&newmask);
+	pthread_sigmask(SIG_BLOCK, &newmask, &oldmask);
+
+	if ((result = pthread_create(&idomod_writer_thread, NULL, idomod_writer_thread_main, NULL)) != 0)
+		idomod_writer_running = IDO_FALSE;
+
+	pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
+
+	pthread_mutex_unlock(&idomod_writer_log_lock);
+
+	if (result != 0) {
+		close(idomod_writer_wakeup_pipe[0]);
+		close(idomod_writer_wakeup_pipe[1]);
+		idomod_writer_wakeup_pipe[0] = -1;
+		idomod_writer_wakeup_pipe[1] = -1;
+		idomod_write_to_logs("idomod: Could not create writer thread, writing synchronously.", NSLOG_INFO_MESSAGE);
+		return IDO_ERROR;
+	}
+
+	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 0, "idomod_start_writer_thread() writer thread started\n");
+
+	return IDO_OK;
+}
+
+
+/* stops the writer thread, after it wrote what it could */
+int idomod_stop_writer_thread(void) {
+
+	if (idomod_writer_running == IDO_FALSE)
+		return IDO_OK;
+
+	idomod_writer_shutdown = IDO_TRUE;
+	__sync_synchronize();
+	write(idomod_writer_wakeup_pipe[1], "", 1);
+
+	pthread_join(idomod_writer_thread, NULL);
+
+	idomod_writer_running = IDO_FALSE;
+
+	close(idomod_writer_wakeup_pipe[0]);
+	close(idomod_writer_wakeup_pipe[1]);
+	idomod_writer_wakeup_pipe[0] = -1;
+	idomod_writer_wakeup_pipe[1] = -1;
+
+	/* log what the writer thread left for us */
+	idomod_write_writer_logs();
+
+	return IDO_OK;
+}
+
+
+/* queues data for the writer thread - never blocks on the sink */
+static int idomod_queue_for_writer(char *buf, unsigned long len, int binary) {
+
+	/* log what the writer thread left for us */
+	if (idomod_writer_log_count > 0)
+		idomod_write_writer_logs();
+
+	if (idomod_sink_buffer_push(&sinkbuf, buf, len, binary) == IDO_ERROR)
+		return IDO_ERROR;
+
+	/* wake up the writer thread if it is waiting for data */
+	__sync_synchronize();
+	if (idomod_writer_waiting == IDO_TRUE)
+		write(idomod_writer_wakeup_pipe[1], "", 1);
+
+	return IDO_OK;
+}
+
+
+/* keeps a log message of the writer thread for the main thread */
+static int idomod_defer_writer_log(char *buf, int flags) {
+	char *temp_buffer = NULL;
+
+	pthread_mutex_lock(&idomod_writer_log_lock);
+
+	if (idomod_writer_log_count < IDOMOD_WRITER_LOG_MESSAGES && (temp_buffer = strdup(buf)) != NULL) {
+		idomod_writer_log_messages[idomod_writer_log_count] = temp_buffer;
+		idomod_writer_log_flags[idomod_writer_log_count] = flags;
+		idomod_writer_log_count++;
+	}
+
+	pthread_mutex_unlock(&idomod_writer_log_lock);
+
+	return IDO_OK;
+}
+
+
+/* writes the log messages the writer thread left - main thread only */
+static void idomod_write_writer_logs(void) {
+	char *messages[IDOMOD_WRITER_LOG_MESSAGES];
+	int flags[IDOMOD_WRITER_LOG_MESSAGES];
+	int count = 0;
+	int x = 0;
+
+	pthread_mutex_lock(&idomod_writer_log_lock);
+
+	for (count = 0; count < idomod_writer_log_count; count++) {
+		messages[count] = idomod_writer_log_messages[count];
+		flags[count] = idomod_writer_log_flags[count];
+	}
+	idomod_writer_log_count = 0;
+
+	pthread_mutex_unlock(&idomod_writer_log_lock);
+
+	for (x = 0; x < count; x++) {
+		write_to_all_logs(messages[x], flags[x]);
+		free(messages[x]);
+	}
+
+	return;
+}
+
+
+/* writes queue depth and latency of the items written since the last time to the debug log */
+static void idomod_log_writer_stats(void) {
+
+	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 0, "idomod writer: %lu items written, %lu queued, max queue depth %lu, latency avg %.3fs max %.3fs, %lu items lost\n",
+	                      sinkbuf.written,
+	                      idomod_sink_buffer_items(&sinkbuf),
+	                      sinkbuf.max_queued,
+	                      (sinkbuf.written > 0) ? sinkbuf.total_latency / (double)sinkbuf.written : 0.0,
+	                      sinkbuf.max_latency,
+	                      sinkbuf.overflow);
+
+	if (ido_sink_uncompressed_bytes > 0)
+		idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 0, "idomod writer: %lu bytes compressed to %lu bytes so far\n", ido_sink_uncompressed_bytes, ido_sink_compressed_bytes);
+
+	sinkbuf.written = 0L;
+	sinkbuf.max_queued = 0L;
+	sinkbuf.total_latency = 0.0;
+	sinkbuf.max_latency = 0.0;
+
+	return;
+}
+
+
+/* writer thread - writes queued items to the sink */
+static void *idomod_writer_thread_main(void *arg) {
+	struct pollfd pfd;
+	char drain[64];
+	time_t last_stats;
+	time_t current_time;
+	int result = IDO_OK;
+
+	/* wait until idomod_start_writer_thread() is done */
+	pthread_mutex_lock(&idomod_writer_log_lock);
+	pthread_mutex_unlock(&idomod_writer_log_lock);
+
+	time(&last_stats);
+
+	while (idomod_writer_shutdown == IDO_FALSE) {
+
+		/* (re)connects if necessary and writes everything queued so far */
+		result = IDO_OK;
+		if (idomod_sink_buffer_items(&sinkbuf) > 0)
+			result = idomod_write_to_sink("", IDO_FALSE, IDO_TRUE);
+
+		time(&current_time);
+		if ((unsigned long)(current_time - last_stats) >= IDOMOD_WRITER_STATS_INTERVAL) {
+			idomod_log_writer_stats();
+			last_stats = current_time;
+		}
+
+		/* sleep until there is something to write - or a second, while the sink is down */
+		if (result == IDO_OK) {
+			idomod_writer_waiting = IDO_TRUE;
+			__sync_synchronize();
+		}
+
+		if (result != IDO_OK || idomod_sink_buffer_items(&sinkbuf) == 0) {
+			pfd.fd = idomod_writer_wakeup_pipe[0];
+			pfd.events = POLLIN;
+			if (poll(&pfd, 1, 1000) > 0) {
+				while (read(idomod_writer_wakeup_pipe[0], drain, sizeof(drain)) > 0)
+					;
+			}
+		}
+
+		idomod_writer_waiting = IDO_FALSE;
+	}
+
+	/* one last try, whatever is left gets saved to the buffer file */
+	if (idomod_sink_buffer_items(&sinkbuf) > 0)
+		idomod_write_to_sink("", IDO_FALSE, IDO_TRUE);
+
+	idomod_log_writer_stats();
+
+	return NULL;
+}
+
+
+
 /* save unprocessed data to buffer file */
 int idomod_save_unprocessed_data(char *f) {
 	FILE *fp = NULL;
 	char *buf = NULL;
 	char *ebuf = NULL;
+	char *text = NULL;
+	int binary = IDO_FALSE;
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_save_unprocessed_data() start\n");
 
@@ -926,7 +1411,15 @@ int idomod_save_unprocessed_data(char *f) {
 	while (idomod_sink_buffer_items(&sinkbuf) > 0) {
 
 		/* get next item from buffer */
-		buf = idomod_sink_buffer_pop(&sinkbuf);
+		buf = idomod_sink_buffer_pop(&sinkbuf, &binary);
+
+		/* the next ido2db might not take binary records, so they are saved as text */
+		if (binary == IDO_TRUE) {
+			text = idomod_binary_to_text(buf, (unsigned long)ido_binary_get(buf + 1, 4));
+			my_free(buf);
+			if ((buf = text) == NULL)
+				continue;
+		}
 
 		/* escape the string */
 		ebuf = ido_escape_buffer(buf);
@@ -970,7 +1463,7 @@ int idomod_load_unprocessed_data(char *f) {
 		buf = ido_unescape_buffer(ebuf);
 
 		/* save the data to the sink buffer */
-		idomod_sink_buffer_push(&sinkbuf, buf);
+		idomod_sink_buffer_push(&sinkbuf, buf, strlen(buf), IDO_FALSE);
 
 		/* free memory */
 		free(ebuf);
@@ -989,27 +1482,82 @@ int idomod_load_unprocessed_data(char *f) {
 
 
 
+/*
+ * The sink buffer is a byte ring of items, each prefixed by its length and
+ * the time it was queued.  One thread may push items while another one
+ * writes them out: the pushing side owns head and items_in, the writing
+ * side owns tail and items_out, so neither needs a lock.
+ */
+
+/* copies data into the sink buffer, starting at offset */
+static void idomod_sink_buffer_copy_in(idomod_sink_buffer *sbuf, unsigned long offset, char *data, unsigned long len) {
+	unsigned long chunk = 0L;
+
+	chunk = sbuf->size - offset;
+	if (chunk > len)
+		chunk = len;
+
+	memcpy(sbuf->buffer + offset, data, chunk);
+	memcpy(sbuf->buffer, data + chunk, len - chunk);
+
+	return;
+}
+
+
+/* copies data out of the sink buffer, starting at offset */
+static void idomod_sink_buffer_copy_out(idomod_sink_buffer *sbuf, unsigned long offset, char *data, unsigned long len) {
+	unsigned long chunk = 0L;
+
+	chunk = sbuf->size - offset;
+	if (chunk > len)
+		chunk = len;
+
+	memcpy(data, sbuf->buffer + offset, chunk);
+	memcpy(data + chunk, sbuf->buffer, len - chunk);
+
+	return;
+}
+
+
 /* initializes sink buffer */
-int idomod_sink_buffer_init(idomod_sink_buffer *sbuf, unsigned long maxitems) {
-	unsigned long x;
+int idomod_sink_buffer_init(idomod_sink_buffer *sbuf, unsigned long size, char *mmap_file) {
+	char *temp_buffer = NULL;
+	int fd = -1;
+	void *mmap_buf = MAP_FAILED;
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_init() start\n");
 
-	if (sbuf == NULL || maxitems <= 0)
+	if (sbuf == NULL || size <= 0)
 		return IDO_ERROR;
 
-	/* allocate memory for the buffer */
-	if ((sbuf->buffer = (char **)malloc(sizeof(char *) * maxitems))) {
-		for (x = 0; x < maxitems; x++)
-			sbuf->buffer[x] = NULL;
+	memset(sbuf, 0, sizeof(idomod_sink_buffer));
+
+	/* keep the buffer in a file instead of anonymous memory */
+	if (mmap_file != NULL) {
+
+		if ((fd = open(mmap_file, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)) >= 0) {
+			if (ftruncate(fd, (off_t)size) == 0)
+				mmap_buf = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (mmap_buf == MAP_FAILED)
+				unlink(mmap_file);
+			close(fd);
+		}
+
+		if (mmap_buf == MAP_FAILED) {
+			if (asprintf(&temp_buffer, "idomod: Could not map output buffer file '%s', buffering in memory.", mmap_file) == -1)
+				temp_buffer = NULL;
+			idomod_write_to_logs(temp_buffer, NSLOG_INFO_MESSAGE);
+			free(temp_buffer);
+		} else {
+			sbuf->buffer = (char *)mmap_buf;
+			sbuf->mmap_file = strdup(mmap_file);
+		}
 	}
 
-	sbuf->size = 0L;
-	sbuf->head = 0L;
-	sbuf->tail = 0L;
-	sbuf->items = 0L;
-	sbuf->maxitems = maxitems;
-	sbuf->overflow = 0L;
+	if (sbuf->buffer == NULL && (sbuf->buffer = (char *)malloc(size)) == NULL)
+		return IDO_ERROR;
+
+	sbuf->size = size;
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_init() end\n");
 
@@ -1019,7 +1567,6 @@ int idomod_sink_buffer_init(idomod_sink_buffer *sbuf, unsigned long maxitems) {
 
 /* deinitializes sink buffer */
 int idomod_sink_buffer_deinit(idomod_sink_buffer *sbuf) {
-	unsigned long x;
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_deinit() start\n");
 
@@ -1027,11 +1574,14 @@ int idomod_sink_buffer_deinit(idomod_sink_buffer *sbuf) {
 		return IDO_ERROR;
 
 	/* free any allocated memory */
-	for (x = 0; x < sbuf->maxitems; x++)
-		free(sbuf->buffer[x]);
+	if (sbuf->mmap_file != NULL) {
+		munmap(sbuf->buffer, sbuf->size);
+		unlink(sbuf->mmap_file);
+		free(sbuf->mmap_file);
+	} else
+		free(sbuf->buffer);
 
-	free(sbuf->buffer);
-	sbuf->buffer = NULL;
+	memset(sbuf, 0, sizeof(idomod_sink_buffer));
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_deinit() end\n");
 
@@ -1040,23 +1590,41 @@ int idomod_sink_buffer_deinit(idomod_sink_buffer *sbuf) {
 
 
 /* buffers output */
-int idomod_sink_buffer_push(idomod_sink_buffer *sbuf, char *buf) {
+int idomod_sink_buffer_push(idomod_sink_buffer *sbuf, char *buf, unsigned long len, int binary) {
+	idomod_sink_item item;
+	unsigned long tail = 0L;
+	unsigned long free_bytes = 0L;
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_push() start\n");
 
 	if (sbuf == NULL || buf == NULL)
 		return IDO_ERROR;
 
+	item.len = len;
+	item.binary = binary;
+	gettimeofday(&item.queued, NULL);
+
+	/* one byte stays unused, so a full buffer can be told from an empty one */
+	tail = sbuf->tail;
+	free_bytes = (tail + sbuf->size - sbuf->head - 1) % sbuf->size;
+
 	/* no space to store buffer */
-	if (sbuf->buffer == NULL || sbuf->items == sbuf->maxitems) {
-		sbuf->overflow++;
+	if (sbuf->buffer == NULL || free_bytes < sizeof(item) + item.len) {
+		__sync_fetch_and_add(&sbuf->overflow, 1);
 		return IDO_ERROR;
 	}
 
+	/* don't write before we saw the tail that freed the space */
+	__sync_synchronize();
+
 	/* store buffer */
-	sbuf->buffer[sbuf->head] = strdup(buf);
-	sbuf->head = (sbuf->head + 1) % sbuf->maxitems;
-	sbuf->items++;
+	idomod_sink_buffer_copy_in(sbuf, sbuf->head, (char *)&item, sizeof(item));
+	idomod_sink_buffer_copy_in(sbuf, (sbuf->head + sizeof(item)) % sbuf->size, buf, item.len);
+	sbuf->head = (sbuf->head + sizeof(item) + item.len) % sbuf->size;
+
+	/* publish the item after its data */
+	__sync_synchronize();
+	sbuf->items_in++;
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_push() end\n");
 
@@ -1065,7 +1633,8 @@ int idomod_sink_buffer_push(idomod_sink_buffer *sbuf, char *buf) {
 
 
 /* gets and removes next item from buffer */
-char *idomod_sink_buffer_pop(idomod_sink_buffer *sbuf) {
+char *idomod_sink_buffer_pop(idomod_sink_buffer *sbuf, int *binary) {
+	idomod_sink_item item;
 	char *buf = NULL;
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_pop() start\n");
@@ -1076,14 +1645,26 @@ char *idomod_sink_buffer_pop(idomod_sink_buffer *sbuf) {
 	if (sbuf->buffer == NULL)
 		return NULL;
 
-	if (sbuf->items == 0)
+	if (idomod_sink_buffer_items(sbuf) == 0)
+		return NULL;
+
+	__sync_synchronize();
+
+	idomod_sink_buffer_copy_out(sbuf, sbuf->tail, (char *)&item, sizeof(item));
+
+	if ((buf = (char *)malloc(item.len + 1)) == NULL)
 		return NULL;
 
 	/* remove item from buffer */
-	buf = sbuf->buffer[sbuf->tail];
-	sbuf->buffer[sbuf->tail] = NULL;
-	sbuf->tail = (sbuf->tail + 1) % sbuf->maxitems;
-	sbuf->items--;
+	idomod_sink_buffer_copy_out(sbuf, (sbuf->tail + sizeof(item)) % sbuf->size, buf, item.len);
+	buf[item.len] = '\x0';
+
+	if (binary != NULL)
+		*binary = item.binary;
+
+	__sync_synchronize();
+	sbuf->tail = (sbuf->tail + sizeof(item) + item.len) % sbuf->size;
+	sbuf->items_out++;
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_pop() end\n");
 
@@ -1091,35 +1672,139 @@ char *idomod_sink_buffer_pop(idomod_sink_buffer *sbuf) {
 }
 
 
-/* gets next items from buffer */
-char *idomod_sink_buffer_peek(idomod_sink_buffer *sbuf) {
-	char *buf = NULL;
+/* writes all buffered items to the sink, straight from the buffer - binary records are sent as text if the sink can't take them */
+int idomod_sink_buffer_write(idomod_sink_buffer *sbuf, int fd, int binary_ok) {
+	struct iovec iov[IDOMOD_SINK_BUFFER_IOVECS];
+	idomod_sink_item item;
+	struct timeval now;
+	char *record = NULL;
+	char *text = NULL;
+	double latency = 0.0;
+	unsigned long queued = 0L;
+	unsigned long offset = 0L;
+	unsigned long start = 0L;
+	unsigned long items = 0L;
+	unsigned long batch = 0L;
+	int iovcnt = 0;
+	int written = 0;
+
+	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_write() start\n");
+
+	if (sbuf == NULL || sbuf->buffer == NULL)
+		return IDO_ERROR;
 
-	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_peek() start\n");
+	while ((queued = idomod_sink_buffer_items(sbuf)) > 0) {
 
-	if (sbuf == NULL)
-		return NULL;
+		/* don't look at items before we saw them published */
+		__sync_synchronize();
 
-	if (sbuf->buffer == NULL)
-		return NULL;
+		if (queued > sbuf->max_queued)
+			sbuf->max_queued = queued;
 
-	buf = sbuf->buffer[sbuf->tail];
+		gettimeofday(&now, NULL);
 
-	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_peek() end\n");
+		/* queued before we learned ido2db doesn't know binary records - these are sent as text, one at a time */
+		idomod_sink_buffer_copy_out(sbuf, sbuf->tail, (char *)&item, sizeof(item));
+		if (item.binary == IDO_TRUE && binary_ok == IDO_FALSE) {
 
-	return buf;
+			if ((record = (char *)malloc(item.len)) == NULL)
+				return IDO_ERROR;
+			idomod_sink_buffer_copy_out(sbuf, (sbuf->tail + sizeof(item)) % sbuf->size, record, item.len);
+			text = idomod_binary_to_text(record, item.len);
+			my_free(record);
+
+			/* only a malformed record is lost */
+			if (text == NULL)
+				__sync_fetch_and_add(&sbuf->overflow, 1);
+			else if (ido_sink_write(fd, text, strlen(text)) < 0) {
+				my_free(text);
+				return IDO_ERROR;
+			}
+			my_free(text);
+
+			__sync_synchronize();
+			sbuf->tail = (sbuf->tail + sizeof(item) + item.len) % sbuf->size;
+			sbuf->items_out++;
+			sbuf->written++;
+			continue;
+		}
+
+		/* gather as many items as fit into one writev() */
+		offset = sbuf->tail;
+		items = 0L;
+		iovcnt = 0;
+
+		while (items < queued && iovcnt + 2 <= IDOMOD_SINK_BUFFER_IOVECS) {
+
+			idomod_sink_buffer_copy_out(sbuf, offset, (char *)&item, sizeof(item));
+			start = (offset + sizeof(item)) % sbuf->size;
+
+			/* the next writev() starts with it */
+			if (item.binary == IDO_TRUE && binary_ok == IDO_FALSE)
+				break;
+
+			/* items wrapping around the end take two buffers */
+			if (start + item.len <= sbuf->size) {
+				iov[iovcnt].iov_base = sbuf->buffer + start;
+				iov[iovcnt++].iov_len = item.len;
+			} else {
+				iov[iovcnt].iov_base = sbuf->buffer + start;
+				iov[iovcnt++].iov_len = sbuf->size - start;
+				iov[iovcnt].iov_base = sbuf->buffer;
+				iov[iovcnt++].iov_len = item.len - (sbuf->size - start);
+			}
+
+			latency = (double)(now.tv_sec - item.queued.tv_sec) + (double)(now.tv_usec - item.queued.tv_usec) / 1000000.0;
+			sbuf->total_latency += latency;
+			if (latency > sbuf->max_latency)
+				sbuf->max_latency = latency;
+
+			offset = (start + item.len) % sbuf->size;
+			items++;
+		}
+
+		if (iovcnt > 0 && ido_sink_writev(fd, iov, iovcnt, &written) < 0) {
+
+			/* items the sink got completely before the error are not sent again after reconnecting */
+			batch = items;
+			for (offset = sbuf->tail, items = 0L; items < batch; items++) {
+				idomod_sink_buffer_copy_out(sbuf, offset, (char *)&item, sizeof(item));
+				if ((unsigned long)written < item.len)
+					break;
+				written -= item.len;
+				offset = (offset + sizeof(item) + item.len) % sbuf->size;
+			}
+
+			__sync_synchronize();
+			sbuf->tail = offset;
+			sbuf->items_out += items;
+			sbuf->written += items;
+
+			return IDO_ERROR;
+		}
+
+		/* items were written okay, so remove them from buffer */
+		__sync_synchronize();
+		sbuf->tail = offset;
+		sbuf->items_out += items;
+		sbuf->written += items;
+	}
+
+	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_write() end\n");
+
+	return IDO_OK;
 }
 
 
 /* returns number of items buffered */
-int idomod_sink_buffer_items(idomod_sink_buffer *sbuf) {
+unsigned long idomod_sink_buffer_items(idomod_sink_buffer *sbuf) {
 
 	idomod_log_debug_info(IDOMOD_DEBUGL_PROCESSINFO, 2, "idomod_sink_buffer_items()\n");
 
 	if (sbuf == NULL)
 		return 0;
 	else
-		return sbuf->items;
+		return sbuf->items_in - sbuf->items_out;
 }
 
 
@@ -1151,6 +1836,495 @@ int idomod_sink_buffer_set_overflow(idomod_sink_buffer *sbuf, unsigned long num)
 
 
 
+/****************************************************************************/
+/* BINARY ENCODING FUNCTIONS                                                */
+/****************************************************************************/
+
+/*
+ * Once ido2db confirmed ENCODING: BINARY, the most frequent data items are
+ * sent as binary records (see protoapi.h) - no escaping and no formatting
+ * of numbers.  Everything else is sent as text, in the same stream.
+ */
+
+/* turns a binary record back into its text form, for a sink that doesn't take binary records - returns NULL if it is malformed */
+static char *idomod_binary_to_text(char *buf, unsigned long len) {
+	ido_dbuf dbuf;
+	char temp_buffer[64];
+	char *ptr = buf + IDO_API_BINARY_HEADER_SIZE;
+	char *end = buf + len;
+	char *value = NULL;
+	char *evalue = NULL;
+	unsigned long long key = 0L;
+	unsigned long long number = 0L;
+	unsigned long long usec = 0L;
+	int field_len = 0;
+	int result = IDO_OK;
+	union {
+		unsigned long long u;
+		double d;
+	} dvalue;
+
+	if (buf == NULL || len < IDO_API_BINARY_HEADER_SIZE || buf[0] != IDO_API_BINARY_RECORD)
+		return NULL;
+
+	ido_dbuf_init(&dbuf, 2048);
+
+	snprintf(temp_buffer, sizeof(temp_buffer), "\n%d:\n", (int)ido_binary_get(buf + 5, 2));
+	result = ido_dbuf_strcat(&dbuf, temp_buffer);
+
+	while (ptr < end && result == IDO_OK) {
+
+		if ((field_len = ido_binary_get_varint(ptr, end, &key)) == 0)
+			break;
+		ptr += field_len;
+
+		snprintf(temp_buffer, sizeof(temp_buffer), "%d=", (int)(key >> 3));
+		result = ido_dbuf_strcat(&dbuf, temp_buffer);
+
+		switch ((int)(key & 7)) {
+
+		case IDO_API_BINARY_INT:
+			if ((field_len = ido_binary_get_varint(ptr, end, &number)) == 0)
+				break;
+			ptr += field_len;
+			if (number & 1)
+				snprintf(temp_buffer, sizeof(temp_buffer), "-%llu\n", (number + 1) >> 1);
+			else
+				snprintf(temp_buffer, sizeof(temp_buffer), "%llu\n", number >> 1);
+			result = ido_dbuf_strcat(&dbuf, temp_buffer);
+			continue;
+
+		case IDO_API_BINARY_ULONG:
+			if ((field_len = ido_binary_get_varint(ptr, end, &number)) == 0)
+				break;
+			ptr += field_len;
+			snprintf(temp_buffer, sizeof(temp_buffer), "%llu\n", number);
+			result = ido_dbuf_strcat(&dbuf, temp_buffer);
+			continue;
+
+		case IDO_API_BINARY_DOUBLE:
+			if (end - ptr < 8)
+				break;
+			dvalue.u = ido_binary_get(ptr, 8);
+			ptr += 8;
+			snprintf(temp_buffer, sizeof(temp_buffer), "%lf\n", dvalue.d);
+			result = ido_dbuf_strcat(&dbuf, temp_buffer);
+			continue;
+
+		case IDO_API_BINARY_TIMEVAL:
+			if ((field_len = ido_binary_get_varint(ptr, end, &number)) == 0)
+				break;
+			ptr += field_len;
+			if ((field_len = ido_binary_get_varint(ptr, end, &usec)) == 0)
+				break;
+			ptr += field_len;
+			snprintf(temp_buffer, sizeof(temp_buffer), "%lu.%06lu\n", (unsigned long)number, (unsigned long)usec);
+			result = ido_dbuf_strcat(&dbuf, temp_buffer);
+			continue;
+
+		case IDO_API_BINARY_STRING:
+			if ((field_len = ido_binary_get_varint(ptr, end, &number)) == 0 || (unsigned long long)(end - ptr - field_len) < number)
+				break;
+			ptr += field_len;
+			if ((value = (char *)malloc(number + 1)) == NULL) {
+				result = IDO_ERROR;
+				break;
+			}
+			memcpy(value, ptr, number);
+			value[number] = '\x0';
+			ptr += number;
+			evalue = ido_escape_buffer(value);
+			if (evalue == NULL || ido_dbuf_strcat(&dbuf, evalue) == IDO_ERROR || ido_dbuf_strcat(&dbuf, "\n") == IDO_ERROR)
+				result = IDO_ERROR;
+			my_free(value);
+			my_free(evalue);
+			continue;
+
+		default:
+			break;
+		}
+
+		/* truncated or unknown field */
+		break;
+	}
+
+	snprintf(temp_buffer, sizeof(temp_buffer), "%d\n\n", IDO_API_ENDDATA);
+
+	if (ptr != end || result == IDO_ERROR || ido_dbuf_strcat(&dbuf, temp_buffer) == IDO_ERROR) {
+		ido_dbuf_free(&dbuf);
+		return NULL;
+	}
+
+	return dbuf.buf;
+}
+
+
+/* starts a binary record - returns its offset in the buffer */
+static unsigned long idomod_binary_start(ido_dbuf *dbuf, int data_type) {
+	char header[IDO_API_BINARY_HEADER_SIZE];
+	unsigned long start = dbuf->used_size;
+
+	header[0] = IDO_API_BINARY_RECORD;
+	ido_binary_put(header + 1, 0, 4);
+	ido_binary_put(header + 5, data_type, 2);
+
+	ido_dbuf_append(dbuf, header, sizeof(header));
+
+	return start;
+}
+
+
+/* finishes a binary record by filling in its length */
+static void idomod_binary_end(ido_dbuf *dbuf, unsigned long start) {
+
+	if (dbuf->buf != NULL)
+		ido_binary_put(dbuf->buf + start + 1, dbuf->used_size - start, 4);
+
+	return;
+}
+
+
+/* fields start with their data attribute and field type */
+static int idomod_binary_key(char *field, int data_type, int field_type) {
+
+	return ido_binary_put_varint(field, ((unsigned long long)data_type << 3) | field_type);
+}
+
+
+static void idomod_binary_int(ido_dbuf *dbuf, int data_type, int value) {
+	char field[32];
+	int len = 0;
+
+	len = idomod_binary_key(field, data_type, IDO_API_BINARY_INT);
+
+	/* zigzag - small negative numbers stay small */
+	if (value < 0)
+		len += ido_binary_put_varint(field + len, ((unsigned long long)(-(long long)value) << 1) - 1);
+	else
+		len += ido_binary_put_varint(field + len, (unsigned long long)value << 1);
+
+	ido_dbuf_append(dbuf, field, len);
+
+	return;
+}
+
+
+static void idomod_binary_ulong(ido_dbuf *dbuf, int data_type, unsigned long value) {
+	char field[32];
+	int len = 0;
+
+	len = idomod_binary_key(field, data_type, IDO_API_BINARY_ULONG);
+	len += ido_binary_put_varint(field + len, value);
+
+	ido_dbuf_append(dbuf, field, len);
+
+	return;
+}
+
+
+static void idomod_binary_double(ido_dbuf *dbuf, int data_type, double value) {
+	char field[32];
+	int len = 0;
+	union {
+		unsigned long long u;
+		double d;
+	} dvalue;
+
+	dvalue.d = value;
+
+	len = idomod_binary_key(field, data_type, IDO_API_BINARY_DOUBLE);
+	ido_binary_put(field + len, dvalue.u, 8);
+	len += 8;
+
+	ido_dbuf_append(dbuf, field, len);
+
+	return;
+}
+
+
+static void idomod_binary_timeval(ido_dbuf *dbuf, int data_type, struct timeval *tv) {
+	char field[32];
+	int len = 0;
+
+	len = idomod_binary_key(field, data_type, IDO_API_BINARY_TIMEVAL);
+	len += ido_binary_put_varint(field + len, (unsigned long)tv->tv_sec);
+	len += ido_binary_put_varint(field + len, (unsigned long)tv->tv_usec);
+
+	ido_dbuf_append(dbuf, field, len);
+
+	return;
+}
+
+
+/* adds a string as is, cut to max_len bytes (if not zero) */
+static void idomod_binary_string(ido_dbuf *dbuf, int data_type, char *value, unsigned long max_len) {
+	char field[32];
+	unsigned long value_len = 0L;
+	int len = 0;
+
+	if (value != NULL)
+		value_len = strlen(value);
+	if (max_len > 0 && value_len > max_len)
+		value_len = max_len;
+
+	len = idomod_binary_key(field, data_type, IDO_API_BINARY_STRING);
+	len += ido_binary_put_varint(field + len, value_len);
+
+	ido_dbuf_append(dbuf, field, len);
+	if (value_len > 0)
+		ido_dbuf_append(dbuf, value, value_len);
+
+	return;
+}
+
+
+/* adds the custom variable status lines of a host or service */
+static void idomod_binary_customvar_status(ido_dbuf *dbuf, customvariablesmember *customvars) {
+	customvariablesmember *temp_customvar = NULL;
+	char *es[2];
+	char *temp_buffer = NULL;
+
+	/* ido2db takes these apart itself and expects them escaped, just like in text */
+	for (temp_customvar = customvars; temp_customvar != NULL; temp_customvar = temp_customvar->next) {
+
+		es[0] = ido_escape_buffer(temp_customvar->variable_name);
+		es[1] = ido_escape_buffer(temp_customvar->variable_value);
+
+		if (asprintf(&temp_buffer, "%s:%d:%s", (es[0] == NULL) ? "" : es[0], temp_customvar->has_been_modified, (es[1] == NULL) ? "" : es[1]) != -1) {
+			idomod_binary_string(dbuf, IDO_DATA_CUSTOMVARIABLESTATUS, temp_buffer, 0);
+			free(temp_buffer);
+			temp_buffer = NULL;
+		}
+
+		free(es[0]);
+		free(es[1]);
+	}
+
+	return;
+}
+
+
+static void idomod_binary_log_data(ido_dbuf *dbuf, nebstruct_log_data *logdata) {
+	unsigned long start = 0L;
+
+	start = idomod_binary_start(dbuf, IDO_API_LOGDATA);
+
+	idomod_binary_int(dbuf, IDO_DATA_TYPE, logdata->type);
+	idomod_binary_int(dbuf, IDO_DATA_FLAGS, logdata->flags);
+	idomod_binary_int(dbuf, IDO_DATA_ATTRIBUTES, logdata->attr);
+	idomod_binary_timeval(dbuf, IDO_DATA_TIMESTAMP, &logdata->timestamp);
+	idomod_binary_ulong(dbuf, IDO_DATA_LOGENTRYTIME, (unsigned long)logdata->entry_time);
+	idomod_binary_int(dbuf, IDO_DATA_LOGENTRYTYPE, logdata->data_type);
+	idomod_binary_string(dbuf, IDO_DATA_LOGENTRY, logdata->data, 0);
+	idomod_binary_string(dbuf, IDO_DATA_HOST, logdata->host_name, 0);
+	idomod_binary_string(dbuf, IDO_DATA_SERVICE, logdata->service_description, 0);
+
+	idomod_binary_end(dbuf, start);
+
+	return;
+}
+
+
+static void idomod_binary_service_check_data(ido_dbuf *dbuf, nebstruct_service_check_data *scdata) {
+	unsigned long start = 0L;
+
+	start = idomod_binary_start(dbuf, IDO_API_SERVICECHECKDATA);
+
+	idomod_binary_int(dbuf, IDO_DATA_TYPE, scdata->type);
+	idomod_binary_int(dbuf, IDO_DATA_FLAGS, scdata->flags);
+	idomod_binary_int(dbuf, IDO_DATA_ATTRIBUTES, scdata->attr);
+	idomod_binary_timeval(dbuf, IDO_DATA_TIMESTAMP, &scdata->timestamp);
+	idomod_binary_string(dbuf, IDO_DATA_HOST, scdata->host_name, 0);
+	idomod_binary_string(dbuf, IDO_DATA_SERVICE, scdata->service_description, 0);
+	idomod_binary_int(dbuf, IDO_DATA_CHECKTYPE, scdata->check_type);
+	idomod_binary_int(dbuf, IDO_DATA_CURRENTCHECKATTEMPT, scdata->current_attempt);
+	idomod_binary_int(dbuf, IDO_DATA_MAXCHECKATTEMPTS, scdata->max_attempts);
+	idomod_binary_int(dbuf, IDO_DATA_STATETYPE, scdata->state_type);
+	idomod_binary_int(dbuf, IDO_DATA_STATE, scdata->state);
+	idomod_binary_int(dbuf, IDO_DATA_TIMEOUT, scdata->timeout);
+	idomod_binary_string(dbuf, IDO_DATA_COMMANDNAME, scdata->command_name, 0);
+	idomod_binary_string(dbuf, IDO_DATA_COMMANDARGS, scdata->command_args, 0);
+	idomod_binary_string(dbuf, IDO_DATA_COMMANDLINE, scdata->command_line, 0);
+	idomod_binary_timeval(dbuf, IDO_DATA_STARTTIME, &scdata->start_time);
+	idomod_binary_timeval(dbuf, IDO_DATA_ENDTIME, &scdata->end_time);
+	idomod_binary_int(dbuf, IDO_DATA_EARLYTIMEOUT, scdata->early_timeout);
+	idomod_binary_double(dbuf, IDO_DATA_EXECUTIONTIME, scdata->execution_time);
+	idomod_binary_double(dbuf, IDO_DATA_LATENCY, scdata->latency);
+	idomod_binary_int(dbuf, IDO_DATA_RETURNCODE, scdata->return_code);
+	idomod_binary_string(dbuf, IDO_DATA_OUTPUT, scdata->output, 0);
+	idomod_binary_string(dbuf, IDO_DATA_LONGOUTPUT, scdata->long_output, IDOMOD_MAX_TEXT_LEN);
+	idomod_binary_string(dbuf, IDO_DATA_PERFDATA, scdata->perf_data, IDOMOD_MAX_TEXT_LEN);
+
+	idomod_binary_end(dbuf, start);
+
+	return;
+}
+
+
+static void idomod_binary_host_check_data(ido_dbuf *dbuf, nebstruct_host_check_data *hcdata) {
+	unsigned long start = 0L;
+
+	start = idomod_binary_start(dbuf, IDO_API_HOSTCHECKDATA);
+
+	idomod_binary_int(dbuf, IDO_DATA_TYPE, hcdata->type);
+	idomod_binary_int(dbuf, IDO_DATA_FLAGS, hcdata->flags);
+	idomod_binary_int(dbuf, IDO_DATA_ATTRIBUTES, hcdata->attr);
+	idomod_binary_timeval(dbuf, IDO_DATA_TIMESTAMP, &hcdata->timestamp);
+	idomod_binary_string(dbuf, IDO_DATA_HOST, hcdata->host_name, 0);
+	idomod_binary_int(dbuf, IDO_DATA_CHECKTYPE, hcdata->check_type);
+	idomod_binary_int(dbuf, IDO_DATA_CURRENTCHECKATTEMPT, hcdata->current_attempt);
+	idomod_binary_int(dbuf, IDO_DATA_MAXCHECKATTEMPTS, hcdata->max_attempts);
+	idomod_binary_int(dbuf, IDO_DATA_STATETYPE, hcdata->state_type);
+	idomod_binary_int(dbuf, IDO_DATA_STATE, hcdata->state);
+	idomod_binary_int(dbuf, IDO_DATA_TIMEOUT, hcdata->timeout);
+	idomod_binary_string(dbuf, IDO_DATA_COMMANDNAME, hcdata->command_name, 0);
+	idomod_binary_string(dbuf, IDO_DATA_COMMANDARGS, hcdata->command_args, 0);
+	idomod_binary_string(dbuf, IDO_DATA_COMMANDLINE, hcdata->command_line, 0);
+	idomod_binary_timeval(dbuf, IDO_DATA_STARTTIME, &hcdata->start_time);
+	idomod_binary_timeval(dbuf, IDO_DATA_ENDTIME, &hcdata->end_time);
+	idomod_binary_int(dbuf, IDO_DATA_EARLYTIMEOUT, hcdata->early_timeout);
+	idomod_binary_double(dbuf, IDO_DATA_EXECUTIONTIME, hcdata->execution_time);
+	idomod_binary_double(dbuf, IDO_DATA_LATENCY, hcdata->latency);
+	idomod_binary_int(dbuf, IDO_DATA_RETURNCODE, hcdata->return_code);
+	idomod_binary_string(dbuf, IDO_DATA_OUTPUT, hcdata->output, 0);
+	idomod_binary_string(dbuf, IDO_DATA_LONGOUTPUT, hcdata->long_output, IDOMOD_MAX_TEXT_LEN);
+	idomod_binary_string(dbuf, IDO_DATA_PERFDATA, hcdata->perf_data, IDOMOD_MAX_TEXT_LEN);
+
+	idomod_binary_end(dbuf, start);
+
+	return;
+}
+
+
+static void idomod_binary_host_status_data(ido_dbuf *dbuf, nebstruct_host_status_data *hsdata, host *temp_host) {
+	unsigned long start = 0L;
+
+	start = idomod_binary_start(dbuf, IDO_API_HOSTSTATUSDATA);
+
+	idomod_binary_int(dbuf, IDO_DATA_TYPE, hsdata->type);
+	idomod_binary_int(dbuf, IDO_DATA_FLAGS, hsdata->flags);
+	idomod_binary_int(dbuf, IDO_DATA_ATTRIBUTES, hsdata->attr);
+	idomod_binary_timeval(dbuf, IDO_DATA_TIMESTAMP, &hsdata->timestamp);
+	idomod_binary_string(dbuf, IDO_DATA_HOST, temp_host->name, 0);
+	idomod_binary_string(dbuf, IDO_DATA_OUTPUT, temp_host->plugin_output, 0);
+	idomod_binary_string(dbuf, IDO_DATA_LONGOUTPUT, temp_host->long_plugin_output, IDOMOD_MAX_TEXT_LEN);
+	idomod_binary_string(dbuf, IDO_DATA_PERFDATA, temp_host->perf_data, IDOMOD_MAX_TEXT_LEN);
+	idomod_binary_int(dbuf, IDO_DATA_CURRENTSTATE, temp_host->current_state);
+	idomod_binary_int(dbuf, IDO_DATA_HASBEENCHECKED, temp_host->has_been_checked);
+	idomod_binary_int(dbuf, IDO_DATA_SHOULDBESCHEDULED, temp_host->should_be_scheduled);
+	idomod_binary_int(dbuf, IDO_DATA_CURRENTCHECKATTEMPT, temp_host->current_attempt);
+	idomod_binary_int(dbuf, IDO_DATA_MAXCHECKATTEMPTS, temp_host->max_attempts);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTHOSTCHECK, (unsigned long)temp_host->last_check);
+	idomod_binary_ulong(dbuf, IDO_DATA_NEXTHOSTCHECK, (unsigned long)temp_host->next_check);
+	idomod_binary_int(dbuf, IDO_DATA_CHECKTYPE, temp_host->check_type);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTSTATECHANGE, (unsigned long)temp_host->last_state_change);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTHARDSTATECHANGE, (unsigned long)temp_host->last_hard_state_change);
+	idomod_binary_int(dbuf, IDO_DATA_LASTHARDSTATE, temp_host->last_hard_state);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTTIMEUP, (unsigned long)temp_host->last_time_up);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTTIMEDOWN, (unsigned long)temp_host->last_time_down);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTTIMEUNREACHABLE, (unsigned long)temp_host->last_time_unreachable);
+	idomod_binary_int(dbuf, IDO_DATA_STATETYPE, temp_host->state_type);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTHOSTNOTIFICATION, (unsigned long)temp_host->last_host_notification);
+	idomod_binary_ulong(dbuf, IDO_DATA_NEXTHOSTNOTIFICATION, (unsigned long)temp_host->next_host_notification);
+	idomod_binary_int(dbuf, IDO_DATA_NOMORENOTIFICATIONS, temp_host->no_more_notifications);
+	idomod_binary_int(dbuf, IDO_DATA_NOTIFICATIONSENABLED, temp_host->notifications_enabled);
+	idomod_binary_int(dbuf, IDO_DATA_PROBLEMHASBEENACKNOWLEDGED, temp_host->problem_has_been_acknowledged);
+	idomod_binary_int(dbuf, IDO_DATA_ACKNOWLEDGEMENTTYPE, temp_host->acknowledgement_type);
+	idomod_binary_int(dbuf, IDO_DATA_CURRENTNOTIFICATIONNUMBER, temp_host->current_notification_number);
+	idomod_binary_int(dbuf, IDO_DATA_PASSIVEHOSTCHECKSENABLED, temp_host->accept_passive_host_checks);
+	idomod_binary_int(dbuf, IDO_DATA_EVENTHANDLERENABLED, temp_host->event_handler_enabled);
+	idomod_binary_int(dbuf, IDO_DATA_ACTIVEHOSTCHECKSENABLED, temp_host->checks_enabled);
+	idomod_binary_int(dbuf, IDO_DATA_FLAPDETECTIONENABLED, temp_host->flap_detection_enabled);
+	idomod_binary_int(dbuf, IDO_DATA_ISFLAPPING, temp_host->is_flapping);
+	idomod_binary_double(dbuf, IDO_DATA_PERCENTSTATECHANGE, temp_host->percent_state_change);
+	idomod_binary_double(dbuf, IDO_DATA_LATENCY, temp_host->latency);
+	idomod_binary_double(dbuf, IDO_DATA_EXECUTIONTIME, temp_host->execution_time);
+	idomod_binary_int(dbuf, IDO_DATA_SCHEDULEDDOWNTIMEDEPTH, temp_host->scheduled_downtime_depth);
+	idomod_binary_int(dbuf, IDO_DATA_FAILUREPREDICTIONENABLED, temp_host->failure_prediction_enabled);
+	idomod_binary_int(dbuf, IDO_DATA_PROCESSPERFORMANCEDATA, temp_host->process_performance_data);
+	idomod_binary_int(dbuf, IDO_DATA_OBSESSOVERHOST, temp_host->obsess_over_host);
+	idomod_binary_ulong(dbuf, IDO_DATA_MODIFIEDHOSTATTRIBUTES, temp_host->modified_attributes);
+	idomod_binary_string(dbuf, IDO_DATA_EVENTHANDLER, temp_host->event_handler, 0);
+	idomod_binary_string(dbuf, IDO_DATA_CHECKCOMMAND, temp_host->host_check_command, 0);
+	idomod_binary_double(dbuf, IDO_DATA_NORMALCHECKINTERVAL, (double)temp_host->check_interval);
+	idomod_binary_double(dbuf, IDO_DATA_RETRYCHECKINTERVAL, (double)temp_host->retry_interval);
+	idomod_binary_string(dbuf, IDO_DATA_HOSTCHECKPERIOD, temp_host->check_period, 0);
+
+	if (dump_customvar_status == IDO_TRUE)
+		idomod_binary_customvar_status(dbuf, temp_host->custom_variables);
+
+	idomod_binary_end(dbuf, start);
+
+	return;
+}
+
+
+static void idomod_binary_service_status_data(ido_dbuf *dbuf, nebstruct_service_status_data *ssdata, service *temp_service) {
+	unsigned long start = 0L;
+
+	start = idomod_binary_start(dbuf, IDO_API_SERVICESTATUSDATA);
+
+	idomod_binary_int(dbuf, IDO_DATA_TYPE, ssdata->type);
+	idomod_binary_int(dbuf, IDO_DATA_FLAGS, ssdata->flags);
+	idomod_binary_int(dbuf, IDO_DATA_ATTRIBUTES, ssdata->attr);
+	idomod_binary_timeval(dbuf, IDO_DATA_TIMESTAMP, &ssdata->timestamp);
+	idomod_binary_string(dbuf, IDO_DATA_HOST, temp_service->host_name, 0);
+	idomod_binary_string(dbuf, IDO_DATA_SERVICE, temp_service->description, 0);
+	idomod_binary_string(dbuf, IDO_DATA_OUTPUT, temp_service->plugin_output, 0);
+	idomod_binary_string(dbuf, IDO_DATA_LONGOUTPUT, temp_service->long_plugin_output, IDOMOD_MAX_TEXT_LEN);
+	idomod_binary_string(dbuf, IDO_DATA_PERFDATA, temp_service->perf_data, IDOMOD_MAX_TEXT_LEN);
+	idomod_binary_int(dbuf, IDO_DATA_CURRENTSTATE, temp_service->current_state);
+	idomod_binary_int(dbuf, IDO_DATA_HASBEENCHECKED, temp_service->has_been_checked);
+	idomod_binary_int(dbuf, IDO_DATA_SHOULDBESCHEDULED, temp_service->should_be_scheduled);
+	idomod_binary_int(dbuf, IDO_DATA_CURRENTCHECKATTEMPT, temp_service->current_attempt);
+	idomod_binary_int(dbuf, IDO_DATA_MAXCHECKATTEMPTS, temp_service->max_attempts);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTSERVICECHECK, (unsigned long)temp_service->last_check);
+	idomod_binary_ulong(dbuf, IDO_DATA_NEXTSERVICECHECK, (unsigned long)temp_service->next_check);
+	idomod_binary_int(dbuf, IDO_DATA_CHECKTYPE, temp_service->check_type);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTSTATECHANGE, (unsigned long)temp_service->last_state_change);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTHARDSTATECHANGE, (unsigned long)temp_service->last_hard_state_change);
+	idomod_binary_int(dbuf, IDO_DATA_LASTHARDSTATE, temp_service->last_hard_state);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTTIMEOK, (unsigned long)temp_service->last_time_ok);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTTIMEWARNING, (unsigned long)temp_service->last_time_warning);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTTIMEUNKNOWN, (unsigned long)temp_service->last_time_unknown);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTTIMECRITICAL, (unsigned long)temp_service->last_time_critical);
+	idomod_binary_int(dbuf, IDO_DATA_STATETYPE, temp_service->state_type);
+	idomod_binary_ulong(dbuf, IDO_DATA_LASTSERVICENOTIFICATION, (unsigned long)temp_service->last_notification);
+	idomod_binary_ulong(dbuf, IDO_DATA_NEXTSERVICENOTIFICATION, (unsigned long)temp_service->next_notification);
+	idomod_binary_int(dbuf, IDO_DATA_NOMORENOTIFICATIONS, temp_service->no_more_notifications);
+	idomod_binary_int(dbuf, IDO_DATA_NOTIFICATIONSENABLED, temp_service->notifications_enabled);
+	idomod_binary_int(dbuf, IDO_DATA_PROBLEMHASBEENACKNOWLEDGED, temp_service->problem_has_been_acknowledged);
+	idomod_binary_int(dbuf, IDO_DATA_ACKNOWLEDGEMENTTYPE, temp_service->acknowledgement_type);
+	idomod_binary_int(dbuf, IDO_DATA_CURRENTNOTIFICATIONNUMBER, temp_service->current_notification_number);
+	idomod_binary_int(dbuf, IDO_DATA_PASSIVESERVICECHECKSENABLED, temp_service->accept_passive_service_checks);
+	idomod_binary_int(dbuf, IDO_DATA_EVENTHANDLERENABLED, temp_service->event_handler_enabled);
+	idomod_binary_int(dbuf, IDO_DATA_ACTIVESERVICECHECKSENABLED, temp_service->checks_enabled);
+	idomod_binary_int(dbuf, IDO_DATA_FLAPDETECTIONENABLED, temp_service->flap_detection_enabled);
+	idomod_binary_int(dbuf, IDO_DATA_ISFLAPPING, temp_service->is_flapping);
+	idomod_binary_double(dbuf, IDO_DATA_PERCENTSTATECHANGE, temp_service->percent_state_change);
+	idomod_binary_double(dbuf, IDO_DATA_LATENCY, temp_service->latency);
+	idomod_binary_double(dbuf, IDO_DATA_EXECUTIONTIME, temp_service->execution_time);
+	idomod_binary_int(dbuf, IDO_DATA_SCHEDULEDDOWNTIMEDEPTH, temp_service->scheduled_downtime_depth);
+	idomod_binary_int(dbuf, IDO_DATA_FAILUREPREDICTIONENABLED, temp_service->failure_prediction_enabled);
+	idomod_binary_int(dbuf, IDO_DATA_PROCESSPERFORMANCEDATA, temp_service->process_performance_data);
+	idomod_binary_int(dbuf, IDO_DATA_OBSESSOVERSERVICE, temp_service->obsess_over_service);
+	idomod_binary_ulong(dbuf, IDO_DATA_MODIFIEDSERVICEATTRIBUTES, temp_service->modified_attributes);
+	idomod_binary_string(dbuf, IDO_DATA_EVENTHANDLER, temp_service->event_handler, 0);
+	idomod_binary_string(dbuf, IDO_DATA_CHECKCOMMAND, temp_service->service_check_command, 0);
+	idomod_binary_double(dbuf, IDO_DATA_NORMALCHECKINTERVAL, (double)temp_service->check_interval);
+	idomod_binary_double(dbuf, IDO_DATA_RETRYCHECKINTERVAL, (double)temp_service->retry_interval);
+	idomod_binary_string(dbuf, IDO_DATA_SERVICECHECKPERIOD, temp_service->check_period, 0);
+
+	if (dump_customvar_status == IDO_TRUE)
+		idomod_binary_customvar_status(dbuf, temp_service->custom_variables);
+
+	idomod_binary_end(dbuf, start);
+
+	return;
+}
+
+
+
 /****************************************************************************/
 /* CALLBACK FUNCTIONS                                                       */
 /****************************************************************************/
@@ -1262,6 +2436,7 @@ int idomod_broker_data(int event_type, void *data) {
 	char *temp_buffer;
 	ido_dbuf dbuf;
 	int write_to_sink = IDO_TRUE;
+	int binary = IDO_FALSE;
 	host *temp_host = NULL;
 	service *temp_service = NULL;
 	contact *temp_contact = NULL;
@@ -1470,6 +2645,12 @@ int idomod_broker_data(int event_type, void *data) {
 
 		logdata = (nebstruct_log_data *)data;
 
+		if (idomod_sink_binary == IDO_TRUE) {
+			idomod_binary_log_data(&dbuf, logdata);
+			binary = IDO_TRUE;
+			break;
+		}
+
 		es[0] = ido_escape_buffer(logdata->host_name);
 		es[1] = ido_escape_buffer(logdata->service_description);
 
@@ -1683,6 +2864,12 @@ int idomod_broker_data(int event_type, void *data) {
 		if (scdata->type != NEBTYPE_SERVICECHECK_PROCESSED)
 			break;
 
+		if (idomod_sink_binary == IDO_TRUE) {
+			idomod_binary_service_check_data(&dbuf, scdata);
+			binary = IDO_TRUE;
+			break;
+		}
+
 		es[0] = ido_escape_buffer(scdata->host_name);
 		es[1] = ido_escape_buffer(scdata->service_description);
 		es[2] = ido_escape_buffer(scdata->command_name);
@@ -1774,6 +2961,12 @@ int idomod_broker_data(int event_type, void *data) {
 		if (hcdata->type != NEBTYPE_HOSTCHECK_PROCESSED)
 			break;
 
+		if (idomod_sink_binary == IDO_TRUE) {
+			idomod_binary_host_check_data(&dbuf, hcdata);
+			binary = IDO_TRUE;
+			break;
+		}
+
 		es[0] = ido_escape_buffer(hcdata->host_name);
 		es[1] = ido_escape_buffer(hcdata->command_name);
 		es[2] = ido_escape_buffer(hcdata->command_args);
@@ -2092,6 +3285,12 @@ int idomod_broker_data(int event_type, void *data) {
 			return 0;
 		}
 
+		if (idomod_sink_binary == IDO_TRUE) {
+			idomod_binary_host_status_data(&dbuf, hsdata, temp_host);
+			binary = IDO_TRUE;
+			break;
+		}
+
 		es[0] = ido_escape_buffer(temp_host->name);
 		es[1] = ido_escape_buffer(temp_host->plugin_output);
 		es[2] = ido_escape_buffer(temp_host->long_plugin_output);
@@ -2264,6 +3463,12 @@ int idomod_broker_data(int event_type, void *data) {
 			return 0;
 		}
 
+		if (idomod_sink_binary == IDO_TRUE) {
+			idomod_binary_service_status_data(&dbuf, ssdata, temp_service);
+			binary = IDO_TRUE;
+			break;
+		}
+
 		es[0] = ido_escape_buffer(temp_service->host_name);
 		es[1] = ido_escape_buffer(temp_service->description);
 		es[2] = ido_escape_buffer(temp_service->plugin_output);
@@ -3053,8 +4258,12 @@ int idomod_broker_data(int event_type, void *data) {
 	}
 
 	/* write data to sink */
-	if (write_to_sink == IDO_TRUE)
-		idomod_write_to_sink(dbuf.buf, IDO_TRUE, IDO_TRUE);
+	if (write_to_sink == IDO_TRUE) {
+		if (binary == IDO_TRUE)
+			idomod_write_data_to_sink(dbuf.buf, dbuf.used_size, IDO_TRUE, IDO_TRUE, IDO_TRUE);
+		else
+			idomod_write_to_sink(dbuf.buf, IDO_TRUE, IDO_TRUE);
+	}
 
 	/* free dynamic buffer */
 	ido_dbuf_free(&dbuf);
@@ -4633,8 +5842,13 @@ int idomod_log_debug_info(int level, int verbosity, const char *fmt, ...) {
 	if (verbosity > idomod_debug_verbosity)
 		return IDO_OK;
 
-	if (idomod_debug_file_fp == NULL)
+	/* the writer thread logs, too */
+	pthread_mutex_lock(&idomod_debug_lock);
+
+	if (idomod_debug_file_fp == NULL) {
+		pthread_mutex_unlock(&idomod_debug_lock);
 		return IDO_ERROR;
+	}
 
 	/* write the timestamp */
 	gettimeofday(&current_time, NULL);
@@ -4674,6 +5888,8 @@ int idomod_log_debug_info(int level, int verbosity, const char *fmt, ...) {
 		idomod_open_debug_log();
 	}
 
+	pthread_mutex_unlock(&idomod_debug_lock);
+
 	return IDO_OK;
 }
 
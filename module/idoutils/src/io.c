@@ -20,6 +20,17 @@ int use_ssl = IDO_FALSE;
 int use_ssl = IDO_FALSE;
 #endif
 
+#ifdef HAVE_ZLIB_H
+static z_stream *ido_sink_zstream = NULL;
+#endif
+unsigned long ido_sink_uncompressed_bytes = 0L;
+unsigned long ido_sink_compressed_bytes = 0L;
+
+static int ido_sink_write_plain(int, char *, int);
+#ifdef HAVE_ZLIB_H
+static int ido_sink_write_compressed(int, struct iovec *, int);
+#endif
+
 
 
 /**************************************************************/
@@ -269,14 +280,32 @@ int ido_sink_open(char *name, int fd, int type, int port, int flags, int *nfd) {
 
 /* writes to data sink */
 int ido_sink_write(int fd, char *buf, int buflen) {
-	int tbytes = 0;
-	int result = 0;
+#ifdef HAVE_ZLIB_H
+	struct iovec iov;
+#endif
 
 	if (buf == NULL)
 		return IDO_ERROR;
 	if (buflen <= 0)
 		return 0;
 
+#ifdef HAVE_ZLIB_H
+	if (ido_sink_zstream != NULL) {
+		iov.iov_base = buf;
+		iov.iov_len = buflen;
+		return ido_sink_write_compressed(fd, &iov, 1);
+	}
+#endif
+
+	return ido_sink_write_plain(fd, buf, buflen);
+}
+
+
+/* writes to data sink as is */
+static int ido_sink_write_plain(int fd, char *buf, int buflen) {
+	int tbytes = 0;
+	int result = 0;
+
 	while (tbytes < buflen) {
 
 		/* try to write everything we have left */
@@ -303,6 +332,152 @@ int ido_sink_write(int fd, char *buf, int buflen) {
 }
 
 
+/* writes a vector of buffers to data sink, returns the number of bytes written - on errors the bytes the sink got before are stored in *written */
+int ido_sink_writev(int fd, struct iovec *iov, int iovcnt, int *written) {
+	int tbytes = 0;
+	int result = 0;
+#ifdef HAVE_SSL
+	int x = 0;
+#endif
+
+	if (written != NULL)
+		*written = 0;
+
+	if (iov == NULL)
+		return IDO_ERROR;
+
+#ifdef HAVE_ZLIB_H
+	/* the compressed stream is only flushed after the last buffer, so nothing counts as written before */
+	if (ido_sink_zstream != NULL) {
+		if ((result = ido_sink_write_compressed(fd, iov, iovcnt)) < 0)
+			return IDO_ERROR;
+		if (written != NULL)
+			*written = result;
+		return result;
+	}
+#endif
+
+#ifdef HAVE_SSL
+	/* no scatter/gather with SSL */
+	if (use_ssl == IDO_TRUE) {
+		for (x = 0; x < iovcnt; x++) {
+			if ((result = ido_sink_write_plain(fd, iov[x].iov_base, iov[x].iov_len)) < 0)
+				return IDO_ERROR;
+			tbytes += result;
+			if (written != NULL)
+				*written = tbytes;
+		}
+		return tbytes;
+	}
+#endif
+
+	while (iovcnt > 0) {
+
+		if ((result = writev(fd, iov, iovcnt)) == -1) {
+
+			/* unless we encountered a recoverable error, bail out */
+			if (errno != EAGAIN && errno != EINTR)
+				return IDO_ERROR;
+
+			continue;
+		}
+
+		tbytes += result;
+		if (written != NULL)
+			*written = tbytes;
+
+		/* skip what was written, the vector is the caller's scratch space */
+		while (iovcnt > 0 && (size_t)result >= iov->iov_len) {
+			result -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt > 0) {
+			iov->iov_base = (char *)iov->iov_base + result;
+			iov->iov_len -= result;
+		}
+	}
+
+	return tbytes;
+}
+
+
+#ifdef HAVE_ZLIB_H
+/* compresses a vector of buffers and writes it to data sink, flushed so the reader gets all of it */
+static int ido_sink_write_compressed(int fd, struct iovec *iov, int iovcnt) {
+	char outbuf[16 * 1024];
+	int tbytes = 0;
+	int result = Z_OK;
+	int x = 0;
+
+	for (x = 0; x < iovcnt; x++) {
+
+		ido_sink_zstream->next_in = (Bytef *)iov[x].iov_base;
+		ido_sink_zstream->avail_in = iov[x].iov_len;
+
+		/* the last buffer flushes the stream */
+		do {
+			ido_sink_zstream->next_out = (Bytef *)outbuf;
+			ido_sink_zstream->avail_out = sizeof(outbuf);
+
+			result = deflate(ido_sink_zstream, (x == iovcnt - 1) ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+			if (result == Z_STREAM_ERROR)
+				return IDO_ERROR;
+
+			if (ido_sink_write_plain(fd, outbuf, sizeof(outbuf) - ido_sink_zstream->avail_out) < 0)
+				return IDO_ERROR;
+
+			ido_sink_compressed_bytes += sizeof(outbuf) - ido_sink_zstream->avail_out;
+
+		} while (ido_sink_zstream->avail_out == 0);
+
+		ido_sink_uncompressed_bytes += iov[x].iov_len;
+		tbytes += iov[x].iov_len;
+	}
+
+	return tbytes;
+}
+#endif
+
+
+/* compresses everything written to data sink from now on, until it's closed */
+int ido_sink_start_compression(int level) {
+
+#ifdef HAVE_ZLIB_H
+	if (ido_sink_zstream != NULL)
+		return IDO_OK;
+
+	if ((ido_sink_zstream = (z_stream *)calloc(1, sizeof(z_stream))) == NULL)
+		return IDO_ERROR;
+
+	if (deflateInit(ido_sink_zstream, level) != Z_OK) {
+		free(ido_sink_zstream);
+		ido_sink_zstream = NULL;
+		return IDO_ERROR;
+	}
+
+	return IDO_OK;
+#else
+	return IDO_ERROR;
+#endif
+}
+
+
+/* stops compressing data sink output */
+int ido_sink_end_compression(void) {
+
+#ifdef HAVE_ZLIB_H
+	if (ido_sink_zstream != NULL) {
+		deflateEnd(ido_sink_zstream);
+		free(ido_sink_zstream);
+		ido_sink_zstream = NULL;
+	}
+#endif
+
+	return IDO_OK;
+}
+
+
 /* writes a newline to data sink */
 int ido_sink_write_newline(int fd) {
 
@@ -323,6 +498,8 @@ int ido_sink_flush(int fd) {
 /* closes data sink */
 int ido_sink_close(int fd) {
 
+	ido_sink_end_compression();
+
 	/* no need to close STDOUT */
 	if (fd == STDOUT_FILENO)
 		return IDO_OK;
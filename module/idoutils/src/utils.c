@@ -50,8 +50,17 @@ int ido_dbuf_free(ido_dbuf *db) {
 
 /* dynamically expands a string */
 int ido_dbuf_strcat(ido_dbuf *db, char *buf) {
+
+	if (db == NULL || buf == NULL)
+		return IDO_ERROR;
+
+	return ido_dbuf_append(db, buf, strlen(buf));
+}
+
+
+/* appends data of the given length, which may contain zero bytes - the buffer stays terminated */
+int ido_dbuf_append(ido_dbuf *db, char *buf, unsigned long buflen) {
 	char *newbuf = NULL;
-	unsigned long buflen = 0L;
 	unsigned long new_size = 0L;
 	unsigned long memory_needed = 0L;
 
@@ -59,7 +68,6 @@ int ido_dbuf_strcat(ido_dbuf *db, char *buf) {
 		return IDO_ERROR;
 
 	/* how much memory should we allocate (if any)? */
-	buflen = strlen(buf);
 	new_size = db->used_size + buflen + 1;
 
 	/* we need more memory */
@@ -67,7 +75,7 @@ int ido_dbuf_strcat(ido_dbuf *db, char *buf) {
 
 		memory_needed = ((ceil(new_size / db->chunk_size) + 1) * db->chunk_size);
 
-		/* allocate memory to store old and new string */
+		/* allocate memory to store old and new data */
 		if ((newbuf = (char *)realloc((void *)db->buf, (size_t)memory_needed)) == NULL)
 			return IDO_ERROR;
 
@@ -76,22 +84,84 @@ int ido_dbuf_strcat(ido_dbuf *db, char *buf) {
 
 		/* update allocated size */
 		db->allocated_size = memory_needed;
-
-		/* terminate buffer */
-		db->buf[db->used_size] = '\x0';
 	}
 
-	/* append the new string */
-	strcat(db->buf, buf);
+	/* append the new data - no need to look for the end of the old one */
+	memcpy(db->buf + db->used_size, buf, buflen);
 
 	/* update size allocated */
 	db->used_size += buflen;
 
+	/* terminate buffer */
+	db->buf[db->used_size] = '\x0';
+
 	return IDO_OK;
 }
 
 
 
+/****************************************************************************/
+/* BINARY ENCODING FUNCTIONS                                                */
+/****************************************************************************/
+
+/* stores a number in network byte order */
+void ido_binary_put(char *buf, unsigned long long value, int bytes) {
+	int x = 0;
+
+	for (x = bytes - 1; x >= 0; x--) {
+		buf[x] = (char)(value & 0xff);
+		value >>= 8;
+	}
+
+	return;
+}
+
+
+/* stores a varint - returns its length, at most 10 bytes */
+int ido_binary_put_varint(char *buf, unsigned long long value) {
+	int len = 0;
+
+	while (value >= 0x80) {
+		buf[len++] = (char)((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	buf[len++] = (char)value;
+
+	return len;
+}
+
+
+/* reads a number stored in network byte order */
+unsigned long long ido_binary_get(char *buf, int bytes) {
+	unsigned long long value = 0L;
+	int x = 0;
+
+	for (x = 0; x < bytes; x++)
+		value = (value << 8) | (unsigned char)buf[x];
+
+	return value;
+}
+
+
+/* reads a varint that has to end before end - returns its length, 0 if it doesn't */
+int ido_binary_get_varint(char *buf, char *end, unsigned long long *value) {
+	int len = 0;
+	int shift = 0;
+
+	*value = 0L;
+
+	while (buf + len < end && shift < 64) {
+		*value |= (unsigned long long)((unsigned char)buf[len] & 0x7f) << shift;
+		if (!((unsigned char)buf[len++] & 0x80))
+			return len;
+		shift += 7;
+	}
+
+	return 0;
+}
+
+
+
 /******************************************************************/
 /************************* FILE FUNCTIONS *************************/
 /******************************************************************/
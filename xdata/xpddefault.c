@@ -47,6 +47,8 @@ command *xpddefault_service_perfdata_command_ptr = NULL;
 
 char    *xpddefault_host_perfdata_file_template = NULL;
 char    *xpddefault_service_perfdata_file_template = NULL;
+macro_template *xpddefault_host_perfdata_file_macro_template = NULL;
+macro_template *xpddefault_service_perfdata_file_macro_template = NULL;
 
 char    *xpddefault_host_perfdata_file = NULL;
 char    *xpddefault_service_perfdata_file = NULL;
@@ -246,6 +248,10 @@ int xpddefault_initialize_performance_data(char *config_file) {
 	xpddefault_preprocess_file_templates(xpddefault_host_perfdata_file_template);
 	xpddefault_preprocess_file_templates(xpddefault_service_perfdata_file_template);
 
+	/* parse the templates once, they are processed for every check result */
+	xpddefault_host_perfdata_file_macro_template = compile_macro_template(xpddefault_host_perfdata_file_template);
+	xpddefault_service_perfdata_file_macro_template = compile_macro_template(xpddefault_service_perfdata_file_template);
+
 	/* open the performance data files */
 	xpddefault_open_host_perfdata_file();
 	xpddefault_open_service_perfdata_file();
@@ -367,6 +373,10 @@ int xpddefault_cleanup_performance_data(char *config_file) {
 	my_free(xpddefault_service_perfdata_command);
 	my_free(xpddefault_host_perfdata_file_template);
 	my_free(xpddefault_service_perfdata_file_template);
+	free_macro_template(xpddefault_host_perfdata_file_macro_template);
+	free_macro_template(xpddefault_service_perfdata_file_macro_template);
+	xpddefault_host_perfdata_file_macro_template = NULL;
+	xpddefault_service_perfdata_file_macro_template = NULL;
 	my_free(xpddefault_host_perfdata_file);
 	my_free(xpddefault_service_perfdata_file);
 	my_free(xpddefault_host_perfdata_file_processing_command);
@@ -481,7 +491,6 @@ int xpddefault_update_host_performance_data(host *hst) {
 
 /* runs the service performance data command */
 int xpddefault_run_service_performance_data_command(icinga_macros *mac, service *svc) {
-	char *raw_command_line = NULL;
 	char *processed_command_line = NULL;
 	int early_timeout = FALSE;
 	double exectime;
@@ -498,16 +507,8 @@ int xpddefault_run_service_performance_data_command(icinga_macros *mac, service
 	if (xpddefault_service_perfdata_command == NULL)
 		return OK;
 
-	/* get the raw command line */
-	get_raw_command_line_r(mac, xpddefault_service_perfdata_command_ptr, xpddefault_service_perfdata_command, &raw_command_line, macro_options);
-	if (raw_command_line == NULL)
-		return ERROR;
-
-	log_debug_info(DEBUGL_PERFDATA, 2, "Raw service performance data command line: %s\n", raw_command_line);
-
-	/* process any macros in the raw command line */
-	process_macros_r(mac, raw_command_line, &processed_command_line, macro_options);
-	my_free(raw_command_line);
+	/* get the command line and process any macros in it */
+	get_processed_command_line_r(mac, xpddefault_service_perfdata_command_ptr, xpddefault_service_perfdata_command, &processed_command_line, macro_options);
 	if (processed_command_line == NULL)
 		return ERROR;
 
@@ -529,7 +530,6 @@ int xpddefault_run_service_performance_data_command(icinga_macros *mac, service
 
 /* runs the host performance data command */
 int xpddefault_run_host_performance_data_command(icinga_macros *mac, host *hst) {
-	char *raw_command_line = NULL;
 	char *processed_command_line = NULL;
 	int early_timeout = FALSE;
 	double exectime;
@@ -545,23 +545,15 @@ int xpddefault_run_host_performance_data_command(icinga_macros *mac, host *hst)
 	if (xpddefault_host_perfdata_command == NULL)
 		return OK;
 
-	/* get the raw command line */
-	get_raw_command_line_r(mac, xpddefault_host_perfdata_command_ptr, xpddefault_host_perfdata_command, &raw_command_line, macro_options);
-	if (raw_command_line == NULL)
+	/* get the command line and process any macros in it */
+	get_processed_command_line_r(mac, xpddefault_host_perfdata_command_ptr, xpddefault_host_perfdata_command, &processed_command_line, macro_options);
+	if (processed_command_line == NULL)
 		return ERROR;
 
-	log_debug_info(DEBUGL_PERFDATA, 2, "Raw host performance data command line: %s\n", raw_command_line);
-
-	/* process any macros in the raw command line */
-	process_macros_r(mac, raw_command_line, &processed_command_line, macro_options);
-
 	log_debug_info(DEBUGL_PERFDATA, 2, "Processed host performance data command line: %s\n", processed_command_line);
 
 	/* run the command */
 	my_system_r(mac, processed_command_line, xpddefault_perfdata_timeout, &early_timeout, &exectime, NULL, 0);
-	my_free(raw_command_line);
-	if (processed_command_line == NULL)
-		return ERROR;
 
 	/* check to see if the command timed out */
 	if (early_timeout == TRUE)
@@ -696,7 +688,6 @@ int xpddefault_preprocess_file_templates(char *template) {
 
 /* updates service performance data file */
 int xpddefault_update_service_performance_data_file(icinga_macros *mac, service *svc) {
-	char *raw_output = NULL;
 	char *processed_output = NULL;
 	int result = OK;
 
@@ -709,13 +700,13 @@ int xpddefault_update_service_performance_data_file(icinga_macros *mac, service
 	if (xpddefault_service_perfdata_fp == NULL || xpddefault_service_perfdata_file_template == NULL)
 		return OK;
 
-	/* get the raw line to write */
-	raw_output = (char *)strdup(xpddefault_service_perfdata_file_template);
-
-	log_debug_info(DEBUGL_PERFDATA, 2, "Raw service performance data file output: %s\n", raw_output);
+	log_debug_info(DEBUGL_PERFDATA, 2, "Raw service performance data file output: %s\n", xpddefault_service_perfdata_file_template);
 
 	/* process any macros in the raw output line */
-	process_macros_r(mac, raw_output, &processed_output, 0);
+	if (xpddefault_service_perfdata_file_macro_template != NULL)
+		process_macro_template_r(mac, xpddefault_service_perfdata_file_macro_template, &processed_output, 0);
+	else
+		process_macros_r(mac, xpddefault_service_perfdata_file_template, &processed_output, 0);
 	if (processed_output == NULL)
 		return ERROR;
 
@@ -729,7 +720,6 @@ int xpddefault_update_service_performance_data_file(icinga_macros *mac, service
 	pthread_mutex_unlock(&xpddefault_service_perfdata_fp_lock);
 
 	/* free memory */
-	my_free(raw_output);
 	my_free(processed_output);
 
 	return result;
@@ -738,7 +728,6 @@ int xpddefault_update_service_performance_data_file(icinga_macros *mac, service
 
 /* updates host performance data file */
 int xpddefault_update_host_performance_data_file(icinga_macros *mac, host *hst) {
-	char *raw_output = NULL;
 	char *processed_output = NULL;
 	int result = OK;
 
@@ -751,13 +740,13 @@ int xpddefault_update_host_performance_data_file(icinga_macros *mac, host *hst)
 	if (xpddefault_host_perfdata_fp == NULL || xpddefault_host_perfdata_file_template == NULL)
 		return OK;
 
-	/* get the raw output */
-	raw_output = (char *)strdup(xpddefault_host_perfdata_file_template);
-
-	log_debug_info(DEBUGL_PERFDATA, 2, "Raw host performance file output: %s\n", raw_output);
+	log_debug_info(DEBUGL_PERFDATA, 2, "Raw host performance file output: %s\n", xpddefault_host_perfdata_file_template);
 
 	/* process any macros in the raw output */
-	process_macros_r(mac, raw_output, &processed_output, 0);
+	if (xpddefault_host_perfdata_file_macro_template != NULL)
+		process_macro_template_r(mac, xpddefault_host_perfdata_file_macro_template, &processed_output, 0);
+	else
+		process_macros_r(mac, xpddefault_host_perfdata_file_template, &processed_output, 0);
 	if (processed_output == NULL)
 		return ERROR;
 
@@ -771,7 +760,6 @@ int xpddefault_update_host_performance_data_file(icinga_macros *mac, host *hst)
 	pthread_mutex_unlock(&xpddefault_host_perfdata_fp_lock);
 
 	/* free memory */
-	my_free(raw_output);
 	my_free(processed_output);
 
 	return result;
@@ -780,7 +768,6 @@ int xpddefault_update_host_performance_data_file(icinga_macros *mac, host *hst)
 
 /* periodically process the host perf data file */
 int xpddefault_process_host_perfdata_file(void) {
-	char *raw_command_line = NULL;
 	char *processed_command_line = NULL;
 	int early_timeout = FALSE;
 	double exectime = 0.0;
@@ -797,18 +784,8 @@ int xpddefault_process_host_perfdata_file(void) {
 	/* init macros */
 	memset(&mac, 0, sizeof(mac));
 
-	/* get the raw command line */
-	get_raw_command_line_r(&mac, xpddefault_host_perfdata_file_processing_command_ptr, xpddefault_host_perfdata_file_processing_command, &raw_command_line, macro_options);
-	if (raw_command_line == NULL) {
-		clear_volatile_macros_r(&mac);
-		return ERROR;
-	}
-
-	log_debug_info(DEBUGL_PERFDATA, 2, "Raw host performance data file processing command line: %s\n", raw_command_line);
-
-	/* process any macros in the raw command line */
-	process_macros_r(&mac, raw_command_line, &processed_command_line, macro_options);
-	my_free(raw_command_line);
+	/* get the command line and process any macros in it */
+	get_processed_command_line_r(&mac, xpddefault_host_perfdata_file_processing_command_ptr, xpddefault_host_perfdata_file_processing_command, &processed_command_line, macro_options);
 	if (processed_command_line == NULL) {
 		clear_volatile_macros_r(&mac);
 		return ERROR;
@@ -841,7 +818,6 @@ int xpddefault_process_host_perfdata_file(void) {
 
 /* periodically process the service perf data file */
 int xpddefault_process_service_perfdata_file(void) {
-	char *raw_command_line = NULL;
 	char *processed_command_line = NULL;
 	int early_timeout = FALSE;
 	double exectime = 0.0;
@@ -858,18 +834,8 @@ int xpddefault_process_service_perfdata_file(void) {
 	/* init macros */
 	memset(&mac, 0, sizeof(mac));
 
-	/* get the raw command line */
-	get_raw_command_line_r(&mac, xpddefault_service_perfdata_file_processing_command_ptr, xpddefault_service_perfdata_file_processing_command, &raw_command_line, macro_options);
-	if (raw_command_line == NULL) {
-		clear_volatile_macros_r(&mac);
-		return ERROR;
-	}
-
-	log_debug_info(DEBUGL_PERFDATA, 2, "Raw service performance data file processing command line: %s\n", raw_command_line);
-
-	/* process any macros in the raw command line */
-	process_macros_r(&mac, raw_command_line, &processed_command_line, macro_options);
-	my_free(raw_command_line);
+	/* get the command line and process any macros in it */
+	get_processed_command_line_r(&mac, xpddefault_service_perfdata_file_processing_command_ptr, xpddefault_service_perfdata_file_processing_command, &processed_command_line, macro_options);
 	if (processed_command_line == NULL) {
 		clear_volatile_macros_r(&mac);
 		return ERROR;
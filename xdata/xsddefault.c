@@ -47,6 +47,10 @@
 /**** IMPLEMENTATION SPECIFIC HEADER FILES ****/
 #include "xsddefault.h"
 
+#ifdef NSCORE
+#include <sys/uio.h>
+#endif
+
 
 
 #ifdef NSCGI
@@ -98,9 +102,6 @@ extern int process_performance_data;
 extern int aggregate_status_updates;
 extern int check_external_commands;
 
-extern int external_command_buffer_slots;
-extern circular_buffer external_command_buffer;
-
 extern host *host_list;
 extern service *service_list;
 extern contact *contact_list;
@@ -121,12 +122,60 @@ extern char           *global_host_event_handler;
 extern char           *global_service_event_handler;
 
 extern check_stats    check_statistics[MAX_CHECK_STATS_TYPES];
+
+extern int            check_worker_processes;
+extern check_worker   *check_workers;
 #endif
 
 
 char *xsddefault_status_log = NULL;
 char *xsddefault_temp_file = NULL;
 
+#ifdef NSCORE
+/*
+ * host, service and contact status blocks are cached between dumps.
+ * a block is only formatted again if the fingerprint of the values
+ * it shows changed - all other blocks are written straight from the
+ * cache with writev().  the last_update line is the only part that
+ * changes with every dump, so it is left out of the cached blocks.
+ */
+typedef struct xsddefault_status_block_struct {
+	void *object;
+	unsigned long fingerprint;
+	char *data;
+	size_t length;
+	size_t split;			/* where the last_update line goes */
+} xsddefault_status_block;
+
+typedef struct xsddefault_status_cache_struct {
+	xsddefault_status_block *blocks;
+	int size;
+} xsddefault_status_cache;
+
+/* a status block being fingerprinted (render == FALSE) or formatted */
+typedef struct xsddefault_output_struct {
+	int render;
+	unsigned long fingerprint;
+	char *buffer;
+	size_t length;
+	size_t size;
+	size_t split;
+	int error;
+} xsddefault_output;
+
+#ifdef IOV_MAX
+#define XSDDEFAULT_IOV_BATCH	IOV_MAX
+#else
+#define XSDDEFAULT_IOV_BATCH	16
+#endif
+
+static xsddefault_status_cache xsddefault_host_cache;
+static xsddefault_status_cache xsddefault_service_cache;
+static xsddefault_status_cache xsddefault_contact_cache;
+
+static void xsddefault_free_status_cache(xsddefault_status_cache *);
+#endif
+
 
 
 /******************************************************************/
@@ -273,6 +322,11 @@ int xsddefault_cleanup_status_data(char *config_file, int delete_status_data) {
 	my_free(xsddefault_status_log);
 	my_free(xsddefault_temp_file);
 
+	/* objects are about to go away, so their cached status blocks do too */
+	xsddefault_free_status_cache(&xsddefault_host_cache);
+	xsddefault_free_status_cache(&xsddefault_service_cache);
+	xsddefault_free_status_cache(&xsddefault_contact_cache);
+
 	return OK;
 }
 
@@ -281,10 +335,441 @@ int xsddefault_cleanup_status_data(char *config_file, int delete_status_data) {
 /****************** STATUS DATA OUTPUT FUNCTIONS ******************/
 /******************************************************************/
 
+/* frees all cached status blocks */
+static void xsddefault_free_status_cache(xsddefault_status_cache *cache) {
+	register int x = 0;
+
+	for (x = 0; x < cache->size; x++)
+		my_free(cache->blocks[x].data);
+	my_free(cache->blocks);
+	cache->size = 0;
+
+	return;
+}
+
+
+/* returns the cache slot of the nth object of a list */
+static xsddefault_status_block *xsddefault_get_status_block(xsddefault_status_cache *cache, int index) {
+	xsddefault_status_block *new_blocks = NULL;
+	int new_size = 0;
+
+	if (index >= cache->size) {
+		new_size = (cache->size > 0) ? cache->size * 2 : 1024;
+		while (new_size <= index)
+			new_size *= 2;
+		if ((new_blocks = (xsddefault_status_block *)realloc(cache->blocks, new_size * sizeof(xsddefault_status_block))) == NULL)
+			return NULL;
+		memset(new_blocks + cache->size, 0, (new_size - cache->size) * sizeof(xsddefault_status_block));
+		cache->blocks = new_blocks;
+		cache->size = new_size;
+	}
+
+	return &cache->blocks[index];
+}
+
+
+/* adds raw data to a status block fingerprint (FNV-1a) */
+static void xsddefault_fingerprint(xsddefault_output *out, const void *data, size_t length) {
+	const unsigned char *p = (const unsigned char *)data;
+
+	while (length-- > 0) {
+		out->fingerprint ^= *p++;
+		out->fingerprint *= 16777619UL;
+	}
+
+	return;
+}
+
+
+/* appends formatted text to a status block */
+static void xsddefault_printf(xsddefault_output *out, const char *fmt, ...) {
+	va_list ap;
+	char *new_buffer = NULL;
+	size_t new_size = 0;
+	int length = 0;
+
+	if (out->buffer == NULL) {
+		if ((out->buffer = (char *)malloc(4096)) == NULL) {
+			out->error = TRUE;
+			return;
+		}
+		out->size = 4096;
+	}
+
+	while (1) {
+		va_start(ap, fmt);
+		length = vsnprintf(out->buffer + out->length, out->size - out->length, fmt, ap);
+		va_end(ap);
+
+		if (length < 0) {
+			out->error = TRUE;
+			return;
+		}
+		if ((size_t)length < out->size - out->length)
+			break;
+
+		/* make room and try again */
+		new_size = out->size * 2;
+		while (new_size <= out->length + length)
+			new_size *= 2;
+		if ((new_buffer = (char *)realloc(out->buffer, new_size)) == NULL) {
+			out->error = TRUE;
+			return;
+		}
+		out->buffer = new_buffer;
+		out->size = new_size;
+	}
+	out->length += length;
+
+	return;
+}
+
+
+/* each value of a status block is fingerprinted or formatted by one of these */
+static void xsddefault_int(xsddefault_output *out, const char *name, int value) {
+
+	if (out->render == TRUE)
+		xsddefault_printf(out, "\t%s=%d\n", name, value);
+	else
+		xsddefault_fingerprint(out, &value, sizeof(value));
+}
+
+static void xsddefault_ulong(xsddefault_output *out, const char *name, unsigned long value) {
+
+	if (out->render == TRUE)
+		xsddefault_printf(out, "\t%s=%lu\n", name, value);
+	else
+		xsddefault_fingerprint(out, &value, sizeof(value));
+}
+
+static void xsddefault_double(xsddefault_output *out, const char *name, int precision, double value) {
+
+	if (out->render == TRUE)
+		xsddefault_printf(out, "\t%s=%.*f\n", name, precision, value);
+	else
+		xsddefault_fingerprint(out, &value, sizeof(value));
+}
+
+static void xsddefault_string(xsddefault_output *out, const char *name, const char *value) {
+
+	if (value == NULL)
+		value = "";
+
+	if (out->render == TRUE)
+		xsddefault_printf(out, "\t%s=%s\n", name, value);
+	else
+		xsddefault_fingerprint(out, value, strlen(value) + 1);
+}
+
+static void xsddefault_custom_variables(xsddefault_output *out, customvariablesmember *variables) {
+	customvariablesmember *temp_customvariablesmember = NULL;
+
+	for (temp_customvariablesmember = variables; temp_customvariablesmember != NULL; temp_customvariablesmember = temp_customvariablesmember->next) {
+		if (temp_customvariablesmember->variable_name == NULL)
+			continue;
+		if (out->render == TRUE)
+			xsddefault_printf(out, "\t_%s=%d;%s\n", temp_customvariablesmember->variable_name, temp_customvariablesmember->has_been_modified, (temp_customvariablesmember->variable_value == NULL) ? "" : temp_customvariablesmember->variable_value);
+		else {
+			xsddefault_string(out, NULL, temp_customvariablesmember->variable_name);
+			xsddefault_int(out, NULL, temp_customvariablesmember->has_been_modified);
+			xsddefault_string(out, NULL, temp_customvariablesmember->variable_value);
+		}
+	}
+}
+
+static void xsddefault_text(xsddefault_output *out, const char *text) {
+
+	if (out->render == TRUE)
+		xsddefault_printf(out, "%s", text);
+}
+
+static void xsddefault_last_update(xsddefault_output *out) {
+
+	out->split = out->length;
+}
+
+
+/* host status block - every value must go through the functions above */
+static void xsddefault_host_status(xsddefault_output *out, void *data) {
+	host *temp_host = (host *)data;
+
+	xsddefault_text(out, "hoststatus {\n");
+	xsddefault_string(out, "host_name", temp_host->name);
+
+	xsddefault_ulong(out, "modified_attributes", temp_host->modified_attributes);
+	xsddefault_string(out, "check_command", temp_host->host_check_command);
+	xsddefault_string(out, "check_period", temp_host->check_period);
+	xsddefault_string(out, "notification_period", temp_host->notification_period);
+	xsddefault_double(out, "check_interval", 6, temp_host->check_interval);
+	xsddefault_double(out, "retry_interval", 6, temp_host->retry_interval);
+	xsddefault_string(out, "event_handler", temp_host->event_handler);
+
+	xsddefault_int(out, "has_been_checked", temp_host->has_been_checked);
+	xsddefault_int(out, "should_be_scheduled", temp_host->should_be_scheduled);
+	xsddefault_double(out, "check_execution_time", 3, temp_host->execution_time);
+	xsddefault_double(out, "check_latency", 3, temp_host->latency);
+	xsddefault_int(out, "check_type", temp_host->check_type);
+	xsddefault_int(out, "current_state", temp_host->current_state);
+	xsddefault_int(out, "last_hard_state", temp_host->last_hard_state);
+	xsddefault_ulong(out, "last_event_id", temp_host->last_event_id);
+	xsddefault_ulong(out, "current_event_id", temp_host->current_event_id);
+	xsddefault_ulong(out, "current_problem_id", temp_host->current_problem_id);
+	xsddefault_ulong(out, "last_problem_id", temp_host->last_problem_id);
+	xsddefault_string(out, "plugin_output", temp_host->plugin_output);
+	xsddefault_string(out, "long_plugin_output", temp_host->long_plugin_output);
+	xsddefault_string(out, "performance_data", temp_host->perf_data);
+	xsddefault_ulong(out, "last_check", temp_host->last_check);
+	xsddefault_ulong(out, "next_check", temp_host->next_check);
+	xsddefault_int(out, "check_options", temp_host->check_options);
+	xsddefault_int(out, "current_attempt", temp_host->current_attempt);
+	xsddefault_int(out, "max_attempts", temp_host->max_attempts);
+	xsddefault_int(out, "state_type", temp_host->state_type);
+	xsddefault_ulong(out, "last_state_change", temp_host->last_state_change);
+	xsddefault_ulong(out, "last_hard_state_change", temp_host->last_hard_state_change);
+	xsddefault_ulong(out, "last_time_up", temp_host->last_time_up);
+	xsddefault_ulong(out, "last_time_down", temp_host->last_time_down);
+	xsddefault_ulong(out, "last_time_unreachable", temp_host->last_time_unreachable);
+	xsddefault_ulong(out, "last_notification", temp_host->last_host_notification);
+	xsddefault_ulong(out, "next_notification", temp_host->next_host_notification);
+	xsddefault_int(out, "no_more_notifications", temp_host->no_more_notifications);
+	xsddefault_int(out, "current_notification_number", temp_host->current_notification_number);
+	/* state based escalation ranges */
+	xsddefault_int(out, "current_down_notification_number", temp_host->current_down_notification_number);
+	xsddefault_int(out, "current_unreachable_notification_number", temp_host->current_unreachable_notification_number);
+
+	xsddefault_ulong(out, "current_notification_id", temp_host->current_notification_id);
+	xsddefault_int(out, "notifications_enabled", temp_host->notifications_enabled);
+	xsddefault_int(out, "problem_has_been_acknowledged", temp_host->problem_has_been_acknowledged);
+	xsddefault_int(out, "acknowledgement_type", temp_host->acknowledgement_type);
+	xsddefault_ulong(out, "acknowledgement_end_time", temp_host->acknowledgement_end_time);
+	xsddefault_int(out, "active_checks_enabled", temp_host->checks_enabled);
+	xsddefault_int(out, "passive_checks_enabled", temp_host->accept_passive_host_checks);
+	xsddefault_int(out, "event_handler_enabled", temp_host->event_handler_enabled);
+	xsddefault_int(out, "flap_detection_enabled", temp_host->flap_detection_enabled);
+	xsddefault_int(out, "failure_prediction_enabled", temp_host->failure_prediction_enabled);
+	xsddefault_int(out, "process_performance_data", temp_host->process_performance_data);
+	xsddefault_int(out, "obsess_over_host", temp_host->obsess_over_host);
+	xsddefault_last_update(out);
+	xsddefault_int(out, "is_flapping", temp_host->is_flapping);
+	xsddefault_double(out, "percent_state_change", 2, temp_host->percent_state_change);
+	xsddefault_int(out, "scheduled_downtime_depth", temp_host->scheduled_downtime_depth);
+	/* custom variables */
+	xsddefault_custom_variables(out, temp_host->custom_variables);
+	xsddefault_text(out, "\t}\n\n");
+}
+
+
+/* service status block - every value must go through the functions above */
+static void xsddefault_service_status(xsddefault_output *out, void *data) {
+	service *temp_service = (service *)data;
+
+	xsddefault_text(out, "servicestatus {\n");
+	xsddefault_string(out, "host_name", temp_service->host_name);
+
+	xsddefault_string(out, "service_description", temp_service->description);
+	xsddefault_ulong(out, "modified_attributes", temp_service->modified_attributes);
+	xsddefault_string(out, "check_command", temp_service->service_check_command);
+	xsddefault_string(out, "check_period", temp_service->check_period);
+	xsddefault_string(out, "notification_period", temp_service->notification_period);
+	xsddefault_double(out, "check_interval", 6, temp_service->check_interval);
+	xsddefault_double(out, "retry_interval", 6, temp_service->retry_interval);
+	xsddefault_string(out, "event_handler", temp_service->event_handler);
+
+	xsddefault_int(out, "has_been_checked", temp_service->has_been_checked);
+	xsddefault_int(out, "should_be_scheduled", temp_service->should_be_scheduled);
+	xsddefault_double(out, "check_execution_time", 3, temp_service->execution_time);
+	xsddefault_double(out, "check_latency", 3, temp_service->latency);
+	xsddefault_int(out, "check_type", temp_service->check_type);
+	xsddefault_int(out, "current_state", temp_service->current_state);
+	xsddefault_int(out, "last_hard_state", temp_service->last_hard_state);
+	xsddefault_ulong(out, "last_event_id", temp_service->last_event_id);
+	xsddefault_ulong(out, "current_event_id", temp_service->current_event_id);
+	xsddefault_ulong(out, "current_problem_id", temp_service->current_problem_id);
+	xsddefault_ulong(out, "last_problem_id", temp_service->last_problem_id);
+	xsddefault_int(out, "current_attempt", temp_service->current_attempt);
+	xsddefault_int(out, "max_attempts", temp_service->max_attempts);
+	xsddefault_int(out, "state_type", temp_service->state_type);
+	xsddefault_ulong(out, "last_state_change", temp_service->last_state_change);
+	xsddefault_ulong(out, "last_hard_state_change", temp_service->last_hard_state_change);
+	xsddefault_ulong(out, "last_time_ok", temp_service->last_time_ok);
+	xsddefault_ulong(out, "last_time_warning", temp_service->last_time_warning);
+	xsddefault_ulong(out, "last_time_unknown", temp_service->last_time_unknown);
+	xsddefault_ulong(out, "last_time_critical", temp_service->last_time_critical);
+	xsddefault_string(out, "plugin_output", temp_service->plugin_output);
+	xsddefault_string(out, "long_plugin_output", temp_service->long_plugin_output);
+	xsddefault_string(out, "performance_data", temp_service->perf_data);
+	xsddefault_ulong(out, "last_check", temp_service->last_check);
+	xsddefault_ulong(out, "next_check", temp_service->next_check);
+	xsddefault_int(out, "check_options", temp_service->check_options);
+	xsddefault_int(out, "current_notification_number", temp_service->current_notification_number);
+	/* state based escalation ranges */
+	xsddefault_int(out, "current_warning_notification_number", temp_service->current_warning_notification_number);
+	xsddefault_int(out, "current_critical_notification_number", temp_service->current_critical_notification_number);
+	xsddefault_int(out, "current_unknown_notification_number", temp_service->current_unknown_notification_number);
+
+	xsddefault_ulong(out, "current_notification_id", temp_service->current_notification_id);
+	xsddefault_ulong(out, "last_notification", temp_service->last_notification);
+	xsddefault_ulong(out, "next_notification", temp_service->next_notification);
+	xsddefault_int(out, "no_more_notifications", temp_service->no_more_notifications);
+	xsddefault_int(out, "notifications_enabled", temp_service->notifications_enabled);
+	xsddefault_int(out, "active_checks_enabled", temp_service->checks_enabled);
+	xsddefault_int(out, "passive_checks_enabled", temp_service->accept_passive_service_checks);
+	xsddefault_int(out, "event_handler_enabled", temp_service->event_handler_enabled);
+	xsddefault_int(out, "problem_has_been_acknowledged", temp_service->problem_has_been_acknowledged);
+	xsddefault_int(out, "acknowledgement_type", temp_service->acknowledgement_type);
+	xsddefault_ulong(out, "acknowledgement_end_time", temp_service->acknowledgement_end_time);
+	xsddefault_int(out, "flap_detection_enabled", temp_service->flap_detection_enabled);
+	xsddefault_int(out, "failure_prediction_enabled", temp_service->failure_prediction_enabled);
+	xsddefault_int(out, "process_performance_data", temp_service->process_performance_data);
+	xsddefault_int(out, "obsess_over_service", temp_service->obsess_over_service);
+	xsddefault_last_update(out);
+	xsddefault_int(out, "is_flapping", temp_service->is_flapping);
+	xsddefault_double(out, "percent_state_change", 2, temp_service->percent_state_change);
+	xsddefault_int(out, "scheduled_downtime_depth", temp_service->scheduled_downtime_depth);
+	/* custom variables */
+	xsddefault_custom_variables(out, temp_service->custom_variables);
+	xsddefault_text(out, "\t}\n\n");
+}
+
+
+/* contact status block - every value must go through the functions above */
+static void xsddefault_contact_status(xsddefault_output *out, void *data) {
+	contact *temp_contact = (contact *)data;
+
+	xsddefault_text(out, "contactstatus {\n");
+	xsddefault_string(out, "contact_name", temp_contact->name);
+
+	xsddefault_ulong(out, "modified_attributes", temp_contact->modified_attributes);
+	xsddefault_ulong(out, "modified_host_attributes", temp_contact->modified_host_attributes);
+	xsddefault_ulong(out, "modified_service_attributes", temp_contact->modified_service_attributes);
+	xsddefault_string(out, "host_notification_period", temp_contact->host_notification_period);
+	xsddefault_string(out, "service_notification_period", temp_contact->service_notification_period);
+
+	xsddefault_ulong(out, "last_host_notification", temp_contact->last_host_notification);
+	xsddefault_ulong(out, "last_service_notification", temp_contact->last_service_notification);
+	xsddefault_int(out, "host_notifications_enabled", temp_contact->host_notifications_enabled);
+	xsddefault_int(out, "service_notifications_enabled", temp_contact->service_notifications_enabled);
+	/* custom variables */
+	xsddefault_custom_variables(out, temp_contact->custom_variables);
+	xsddefault_text(out, "\t}\n\n");
+
+	/* contacts have no last_update line, so nothing goes in after the block */
+	xsddefault_last_update(out);
+}
+
+
+/* writes out a batch of buffers, dealing with short writes */
+static int xsddefault_writev(int fd, struct iovec *iov, int count) {
+	ssize_t written = 0;
+
+	while (count > 0) {
+
+		if ((written = writev(fd, iov, count)) < 0) {
+			if (errno == EINTR)
+				continue;
+			return ERROR;
+		}
+
+		/* skip what made it */
+		while (count > 0 && (size_t)written >= iov->iov_len) {
+			written -= iov->iov_len;
+			iov++;
+			count--;
+		}
+		if (count > 0) {
+			iov->iov_base = (char *)iov->iov_base + written;
+			iov->iov_len -= written;
+		}
+	}
+
+	return OK;
+}
+
+
+/* queues a buffer for writing, writing out the queue when it's full */
+static int xsddefault_queue_write(int fd, struct iovec *iov, int *count, const void *data, size_t length) {
+
+	if (length == 0)
+		return OK;
+
+	if (*count == XSDDEFAULT_IOV_BATCH) {
+		if (xsddefault_writev(fd, iov, *count) == ERROR)
+			return ERROR;
+		*count = 0;
+	}
+
+	iov[*count].iov_base = (void *)data;
+	iov[*count].iov_len = length;
+	(*count)++;
+
+	return OK;
+}
+
+
+/* writes the status block of an object, formatting it again only if its values changed since the last time */
+static int xsddefault_write_status_block(int fd, struct iovec *iov, int *count, xsddefault_status_cache *cache, int index, void *object, void (*format)(xsddefault_output *, void *), xsddefault_output *out, const char *last_update, size_t last_update_length) {
+	xsddefault_status_block *block = NULL;
+
+	/* fingerprint the current values */
+	out->render = FALSE;
+	out->fingerprint = 2166136261UL;
+	format(out, object);
+
+	block = xsddefault_get_status_block(cache, index);
+
+	if (block == NULL || block->data == NULL || block->object != object || block->fingerprint != out->fingerprint) {
+
+		out->render = TRUE;
+		out->error = FALSE;
+		out->length = 0;
+		out->split = 0;
+		format(out, object);
+		if (out->error == TRUE)
+			return ERROR;
+
+		if (block != NULL) {
+			if (block->data == NULL || block->length != out->length) {
+				my_free(block->data);
+				block->data = (char *)malloc(out->length);
+			}
+			if (block->data != NULL) {
+				memcpy(block->data, out->buffer, out->length);
+				block->object = object;
+				block->fingerprint = out->fingerprint;
+				block->length = out->length;
+				block->split = out->split;
+			}
+		}
+
+		/* no room to cache it - write it out before the buffer gets reused */
+		if (block == NULL || block->data == NULL) {
+			if (xsddefault_writev(fd, iov, *count) == ERROR)
+				return ERROR;
+			*count = 0;
+			iov[0].iov_base = out->buffer;
+			iov[0].iov_len = out->split;
+			iov[1].iov_base = (void *)last_update;
+			iov[1].iov_len = last_update_length;
+			iov[2].iov_base = out->buffer + out->split;
+			iov[2].iov_len = out->length - out->split;
+			return xsddefault_writev(fd, iov, 3);
+		}
+	}
+
+	if (xsddefault_queue_write(fd, iov, count, block->data, block->split) == ERROR)
+		return ERROR;
+	if (xsddefault_queue_write(fd, iov, count, last_update, last_update_length) == ERROR)
+		return ERROR;
+	if (xsddefault_queue_write(fd, iov, count, block->data + block->split, block->length - block->split) == ERROR)
+		return ERROR;
+
+	return OK;
+}
+
+
 /* write all status data to file */
 int xsddefault_save_status_data(void) {
 	char *temp_file = NULL;
-	customvariablesmember *temp_customvariablesmember = NULL;
 	host *temp_host = NULL;
 	service *temp_service = NULL;
 	contact *temp_contact = NULL;
@@ -295,7 +780,13 @@ int xsddefault_save_status_data(void) {
 	FILE *fp = NULL;
 	int used_external_command_buffer_slots = 0;
 	int high_external_command_buffer_slots = 0;
+	struct iovec iov[XSDDEFAULT_IOV_BATCH];
+	int iov_count = 0;
+	xsddefault_output out;
+	char last_update[64];
+	size_t last_update_length = 0;
 	int result = OK;
+	register int x = 0;
 
 	log_debug_info(DEBUGL_FUNCTIONS, 0, "save_status_data()\n");
 
@@ -337,13 +828,12 @@ int xsddefault_save_status_data(void) {
 		return ERROR;
 	}
 
-	/* get number of items in the command buffer */
-	if (check_external_commands == TRUE) {
-		pthread_mutex_lock(&external_command_buffer.buffer_lock);
-		used_external_command_buffer_slots = external_command_buffer.items;
-		high_external_command_buffer_slots = external_command_buffer.high;
-		pthread_mutex_unlock(&external_command_buffer.buffer_lock);
-	} else {
+	memset(&out, 0, sizeof(out));
+
+	/* get number of blocks in the ring the command file is read into */
+	if (check_external_commands == TRUE)
+		get_command_file_ring_usage(&used_external_command_buffer_slots, &high_external_command_buffer_slots);
+	else {
 		used_external_command_buffer_slots = 0;
 		high_external_command_buffer_slots = 0;
 	}
@@ -397,7 +887,7 @@ int xsddefault_save_status_data(void) {
 	fprintf(fp, "\tnext_event_id=%lu\n", next_event_id);
 	fprintf(fp, "\tnext_problem_id=%lu\n", next_problem_id);
 	fprintf(fp, "\tnext_notification_id=%lu\n", next_notification_id);
-	fprintf(fp, "\ttotal_external_command_buffer_slots=%d\n", external_command_buffer_slots);
+	fprintf(fp, "\ttotal_external_command_buffer_slots=%d\n", COMMAND_FILE_RING_SLOTS);
 	fprintf(fp, "\tused_external_command_buffer_slots=%d\n", used_external_command_buffer_slots);
 	fprintf(fp, "\thigh_external_command_buffer_slots=%d\n", high_external_command_buffer_slots);
 	fprintf(fp, "\tactive_scheduled_host_check_stats=%d,%d,%d\n", check_statistics[ACTIVE_SCHEDULED_HOST_CHECK_STATS].minute_stats[0], check_statistics[ACTIVE_SCHEDULED_HOST_CHECK_STATS].minute_stats[1], check_statistics[ACTIVE_SCHEDULED_HOST_CHECK_STATS].minute_stats[2]);
@@ -416,186 +906,42 @@ int xsddefault_save_status_data(void) {
 	fprintf(fp, "\t}\n\n");
 
 
-	/* save host status data */
-	for (temp_host = host_list; temp_host != NULL; temp_host = temp_host->next) {
-
-		fprintf(fp, "hoststatus {\n");
-		fprintf(fp, "\thost_name=%s\n", temp_host->name);
-
-		fprintf(fp, "\tmodified_attributes=%lu\n", temp_host->modified_attributes);
-		fprintf(fp, "\tcheck_command=%s\n", (temp_host->host_check_command == NULL) ? "" : temp_host->host_check_command);
-		fprintf(fp, "\tcheck_period=%s\n", (temp_host->check_period == NULL) ? "" : temp_host->check_period);
-		fprintf(fp, "\tnotification_period=%s\n", (temp_host->notification_period == NULL) ? "" : temp_host->notification_period);
-		fprintf(fp, "\tcheck_interval=%f\n", temp_host->check_interval);
-		fprintf(fp, "\tretry_interval=%f\n", temp_host->retry_interval);
-		fprintf(fp, "\tevent_handler=%s\n", (temp_host->event_handler == NULL) ? "" : temp_host->event_handler);
-
-		fprintf(fp, "\thas_been_checked=%d\n", temp_host->has_been_checked);
-		fprintf(fp, "\tshould_be_scheduled=%d\n", temp_host->should_be_scheduled);
-		fprintf(fp, "\tcheck_execution_time=%.3f\n", temp_host->execution_time);
-		fprintf(fp, "\tcheck_latency=%.3f\n", temp_host->latency);
-		fprintf(fp, "\tcheck_type=%d\n", temp_host->check_type);
-		fprintf(fp, "\tcurrent_state=%d\n", temp_host->current_state);
-		fprintf(fp, "\tlast_hard_state=%d\n", temp_host->last_hard_state);
-		fprintf(fp, "\tlast_event_id=%lu\n", temp_host->last_event_id);
-		fprintf(fp, "\tcurrent_event_id=%lu\n", temp_host->current_event_id);
-		fprintf(fp, "\tcurrent_problem_id=%lu\n", temp_host->current_problem_id);
-		fprintf(fp, "\tlast_problem_id=%lu\n", temp_host->last_problem_id);
-		fprintf(fp, "\tplugin_output=%s\n", (temp_host->plugin_output == NULL) ? "" : temp_host->plugin_output);
-		fprintf(fp, "\tlong_plugin_output=%s\n", (temp_host->long_plugin_output == NULL) ? "" : temp_host->long_plugin_output);
-		fprintf(fp, "\tperformance_data=%s\n", (temp_host->perf_data == NULL) ? "" : temp_host->perf_data);
-		fprintf(fp, "\tlast_check=%lu\n", temp_host->last_check);
-		fprintf(fp, "\tnext_check=%lu\n", temp_host->next_check);
-		fprintf(fp, "\tcheck_options=%d\n", temp_host->check_options);
-		fprintf(fp, "\tcurrent_attempt=%d\n", temp_host->current_attempt);
-		fprintf(fp, "\tmax_attempts=%d\n", temp_host->max_attempts);
-		fprintf(fp, "\tstate_type=%d\n", temp_host->state_type);
-		fprintf(fp, "\tlast_state_change=%lu\n", temp_host->last_state_change);
-		fprintf(fp, "\tlast_hard_state_change=%lu\n", temp_host->last_hard_state_change);
-		fprintf(fp, "\tlast_time_up=%lu\n", temp_host->last_time_up);
-		fprintf(fp, "\tlast_time_down=%lu\n", temp_host->last_time_down);
-		fprintf(fp, "\tlast_time_unreachable=%lu\n", temp_host->last_time_unreachable);
-		fprintf(fp, "\tlast_notification=%lu\n", temp_host->last_host_notification);
-		fprintf(fp, "\tnext_notification=%lu\n", temp_host->next_host_notification);
-		fprintf(fp, "\tno_more_notifications=%d\n", temp_host->no_more_notifications);
-		fprintf(fp, "\tcurrent_notification_number=%d\n", temp_host->current_notification_number);
-		/* state based escalation ranges */
-		fprintf(fp, "\tcurrent_down_notification_number=%d\n", temp_host->current_down_notification_number);
-		fprintf(fp, "\tcurrent_unreachable_notification_number=%d\n", temp_host->current_unreachable_notification_number);
-
-		fprintf(fp, "\tcurrent_notification_id=%lu\n", temp_host->current_notification_id);
-		fprintf(fp, "\tnotifications_enabled=%d\n", temp_host->notifications_enabled);
-		fprintf(fp, "\tproblem_has_been_acknowledged=%d\n", temp_host->problem_has_been_acknowledged);
-		fprintf(fp, "\tacknowledgement_type=%d\n", temp_host->acknowledgement_type);
-		fprintf(fp, "\tacknowledgement_end_time=%lu\n", temp_host->acknowledgement_end_time);
-		fprintf(fp, "\tactive_checks_enabled=%d\n", temp_host->checks_enabled);
-		fprintf(fp, "\tpassive_checks_enabled=%d\n", temp_host->accept_passive_host_checks);
-		fprintf(fp, "\tevent_handler_enabled=%d\n", temp_host->event_handler_enabled);
-		fprintf(fp, "\tflap_detection_enabled=%d\n", temp_host->flap_detection_enabled);
-		fprintf(fp, "\tfailure_prediction_enabled=%d\n", temp_host->failure_prediction_enabled);
-		fprintf(fp, "\tprocess_performance_data=%d\n", temp_host->process_performance_data);
-		fprintf(fp, "\tobsess_over_host=%d\n", temp_host->obsess_over_host);
-		fprintf(fp, "\tlast_update=%lu\n", current_time);
-		fprintf(fp, "\tis_flapping=%d\n", temp_host->is_flapping);
-		fprintf(fp, "\tpercent_state_change=%.2f\n", temp_host->percent_state_change);
-		fprintf(fp, "\tscheduled_downtime_depth=%d\n", temp_host->scheduled_downtime_depth);
-		/*
-		fprintf(fp,"\tstate_history=");
-		for(x=0;x<MAX_STATE_HISTORY_ENTRIES;x++)
-			fprintf(fp,"%s%d",(x>0)?",":"",temp_host->state_history[(x+temp_host->state_history_index)%MAX_STATE_HISTORY_ENTRIES]);
-		fprintf(fp,"\n");
-		*/
-		/* custom variables */
-		for (temp_customvariablesmember = temp_host->custom_variables; temp_customvariablesmember != NULL; temp_customvariablesmember = temp_customvariablesmember->next) {
-			if (temp_customvariablesmember->variable_name)
-				fprintf(fp, "\t_%s=%d;%s\n", temp_customvariablesmember->variable_name, temp_customvariablesmember->has_been_modified, (temp_customvariablesmember->variable_value == NULL) ? "" : temp_customvariablesmember->variable_value);
-		}
+	/* save check worker status data */
+	for (x = 0; check_workers != NULL && x < check_worker_processes; x++) {
+
+		fprintf(fp, "checkworkerstatus {\n");
+		fprintf(fp, "\tworker_id=%d\n", check_workers[x].id);
+		fprintf(fp, "\tpid=%d\n", (int)check_workers[x].pid);
+		fprintf(fp, "\trunning_checks=%d\n", check_workers[x].running_checks);
+		fprintf(fp, "\ttotal_checks=%lu\n", check_workers[x].total_checks);
+		fprintf(fp, "\ttimed_out_checks=%lu\n", check_workers[x].timed_out_checks);
+		fprintf(fp, "\trestarts=%lu\n", check_workers[x].restarts);
+		fprintf(fp, "\tstart_time=%lu\n", (unsigned long)check_workers[x].start_time);
 		fprintf(fp, "\t}\n\n");
 	}
 
+
+	/* everything so far has to be in the file before the status blocks go in */
+	fflush(fp);
+
+	/* the same last_update line goes into every host and service block */
+	last_update_length = snprintf(last_update, sizeof(last_update), "\tlast_update=%lu\n", current_time);
+
+	/* save host status data */
+	for (temp_host = host_list, x = 0; temp_host != NULL && result == OK; temp_host = temp_host->next, x++)
+		result = xsddefault_write_status_block(fd, iov, &iov_count, &xsddefault_host_cache, x, temp_host, xsddefault_host_status, &out, last_update, last_update_length);
+
 	/* save service status data */
-	for (temp_service = service_list; temp_service != NULL; temp_service = temp_service->next) {
-
-		fprintf(fp, "servicestatus {\n");
-		fprintf(fp, "\thost_name=%s\n", temp_service->host_name);
-
-		fprintf(fp, "\tservice_description=%s\n", temp_service->description);
-		fprintf(fp, "\tmodified_attributes=%lu\n", temp_service->modified_attributes);
-		fprintf(fp, "\tcheck_command=%s\n", (temp_service->service_check_command == NULL) ? "" : temp_service->service_check_command);
-		fprintf(fp, "\tcheck_period=%s\n", (temp_service->check_period == NULL) ? "" : temp_service->check_period);
-		fprintf(fp, "\tnotification_period=%s\n", (temp_service->notification_period == NULL) ? "" : temp_service->notification_period);
-		fprintf(fp, "\tcheck_interval=%f\n", temp_service->check_interval);
-		fprintf(fp, "\tretry_interval=%f\n", temp_service->retry_interval);
-		fprintf(fp, "\tevent_handler=%s\n", (temp_service->event_handler == NULL) ? "" : temp_service->event_handler);
-
-		fprintf(fp, "\thas_been_checked=%d\n", temp_service->has_been_checked);
-		fprintf(fp, "\tshould_be_scheduled=%d\n", temp_service->should_be_scheduled);
-		fprintf(fp, "\tcheck_execution_time=%.3f\n", temp_service->execution_time);
-		fprintf(fp, "\tcheck_latency=%.3f\n", temp_service->latency);
-		fprintf(fp, "\tcheck_type=%d\n", temp_service->check_type);
-		fprintf(fp, "\tcurrent_state=%d\n", temp_service->current_state);
-		fprintf(fp, "\tlast_hard_state=%d\n", temp_service->last_hard_state);
-		fprintf(fp, "\tlast_event_id=%lu\n", temp_service->last_event_id);
-		fprintf(fp, "\tcurrent_event_id=%lu\n", temp_service->current_event_id);
-		fprintf(fp, "\tcurrent_problem_id=%lu\n", temp_service->current_problem_id);
-		fprintf(fp, "\tlast_problem_id=%lu\n", temp_service->last_problem_id);
-		fprintf(fp, "\tcurrent_attempt=%d\n", temp_service->current_attempt);
-		fprintf(fp, "\tmax_attempts=%d\n", temp_service->max_attempts);
-		fprintf(fp, "\tstate_type=%d\n", temp_service->state_type);
-		fprintf(fp, "\tlast_state_change=%lu\n", temp_service->last_state_change);
-		fprintf(fp, "\tlast_hard_state_change=%lu\n", temp_service->last_hard_state_change);
-		fprintf(fp, "\tlast_time_ok=%lu\n", temp_service->last_time_ok);
-		fprintf(fp, "\tlast_time_warning=%lu\n", temp_service->last_time_warning);
-		fprintf(fp, "\tlast_time_unknown=%lu\n", temp_service->last_time_unknown);
-		fprintf(fp, "\tlast_time_critical=%lu\n", temp_service->last_time_critical);
-		fprintf(fp, "\tplugin_output=%s\n", (temp_service->plugin_output == NULL) ? "" : temp_service->plugin_output);
-		fprintf(fp, "\tlong_plugin_output=%s\n", (temp_service->long_plugin_output == NULL) ? "" : temp_service->long_plugin_output);
-		fprintf(fp, "\tperformance_data=%s\n", (temp_service->perf_data == NULL) ? "" : temp_service->perf_data);
-		fprintf(fp, "\tlast_check=%lu\n", temp_service->last_check);
-		fprintf(fp, "\tnext_check=%lu\n", temp_service->next_check);
-		fprintf(fp, "\tcheck_options=%d\n", temp_service->check_options);
-		fprintf(fp, "\tcurrent_notification_number=%d\n", temp_service->current_notification_number);
-		/* state based escalation ranges */
-		fprintf(fp, "\tcurrent_warning_notification_number=%d\n", temp_service->current_warning_notification_number);
-		fprintf(fp, "\tcurrent_critical_notification_number=%d\n", temp_service->current_critical_notification_number);
-		fprintf(fp, "\tcurrent_unknown_notification_number=%d\n", temp_service->current_unknown_notification_number);
-
-		fprintf(fp, "\tcurrent_notification_id=%lu\n", temp_service->current_notification_id);
-		fprintf(fp, "\tlast_notification=%lu\n", temp_service->last_notification);
-		fprintf(fp, "\tnext_notification=%lu\n", temp_service->next_notification);
-		fprintf(fp, "\tno_more_notifications=%d\n", temp_service->no_more_notifications);
-		fprintf(fp, "\tnotifications_enabled=%d\n", temp_service->notifications_enabled);
-		fprintf(fp, "\tactive_checks_enabled=%d\n", temp_service->checks_enabled);
-		fprintf(fp, "\tpassive_checks_enabled=%d\n", temp_service->accept_passive_service_checks);
-		fprintf(fp, "\tevent_handler_enabled=%d\n", temp_service->event_handler_enabled);
-		fprintf(fp, "\tproblem_has_been_acknowledged=%d\n", temp_service->problem_has_been_acknowledged);
-		fprintf(fp, "\tacknowledgement_type=%d\n", temp_service->acknowledgement_type);
-		fprintf(fp, "\tacknowledgement_end_time=%lu\n", temp_service->acknowledgement_end_time);
-		fprintf(fp, "\tflap_detection_enabled=%d\n", temp_service->flap_detection_enabled);
-		fprintf(fp, "\tfailure_prediction_enabled=%d\n", temp_service->failure_prediction_enabled);
-		fprintf(fp, "\tprocess_performance_data=%d\n", temp_service->process_performance_data);
-		fprintf(fp, "\tobsess_over_service=%d\n", temp_service->obsess_over_service);
-		fprintf(fp, "\tlast_update=%lu\n", current_time);
-		fprintf(fp, "\tis_flapping=%d\n", temp_service->is_flapping);
-		fprintf(fp, "\tpercent_state_change=%.2f\n", temp_service->percent_state_change);
-		fprintf(fp, "\tscheduled_downtime_depth=%d\n", temp_service->scheduled_downtime_depth);
-		/*
-		fprintf(fp,"\tstate_history=");
-		for(x=0;x<MAX_STATE_HISTORY_ENTRIES;x++)
-			fprintf(fp,"%s%d",(x>0)?",":"",temp_service->state_history[(x+temp_service->state_history_index)%MAX_STATE_HISTORY_ENTRIES]);
-		fprintf(fp,"\n");
-		*/
-		/* custom variables */
-		for (temp_customvariablesmember = temp_service->custom_variables; temp_customvariablesmember != NULL; temp_customvariablesmember = temp_customvariablesmember->next) {
-			if (temp_customvariablesmember->variable_name)
-				fprintf(fp, "\t_%s=%d;%s\n", temp_customvariablesmember->variable_name, temp_customvariablesmember->has_been_modified, (temp_customvariablesmember->variable_value == NULL) ? "" : temp_customvariablesmember->variable_value);
-		}
-		fprintf(fp, "\t}\n\n");
-	}
+	for (temp_service = service_list, x = 0; temp_service != NULL && result == OK; temp_service = temp_service->next, x++)
+		result = xsddefault_write_status_block(fd, iov, &iov_count, &xsddefault_service_cache, x, temp_service, xsddefault_service_status, &out, last_update, last_update_length);
 
 	/* save contact status data */
-	for (temp_contact = contact_list; temp_contact != NULL; temp_contact = temp_contact->next) {
-
-		fprintf(fp, "contactstatus {\n");
-		fprintf(fp, "\tcontact_name=%s\n", temp_contact->name);
-
-		fprintf(fp, "\tmodified_attributes=%lu\n", temp_contact->modified_attributes);
-		fprintf(fp, "\tmodified_host_attributes=%lu\n", temp_contact->modified_host_attributes);
-		fprintf(fp, "\tmodified_service_attributes=%lu\n", temp_contact->modified_service_attributes);
-		fprintf(fp, "\thost_notification_period=%s\n", (temp_contact->host_notification_period == NULL) ? "" : temp_contact->host_notification_period);
-		fprintf(fp, "\tservice_notification_period=%s\n", (temp_contact->service_notification_period == NULL) ? "" : temp_contact->service_notification_period);
-
-		fprintf(fp, "\tlast_host_notification=%lu\n", temp_contact->last_host_notification);
-		fprintf(fp, "\tlast_service_notification=%lu\n", temp_contact->last_service_notification);
-		fprintf(fp, "\thost_notifications_enabled=%d\n", temp_contact->host_notifications_enabled);
-		fprintf(fp, "\tservice_notifications_enabled=%d\n", temp_contact->service_notifications_enabled);
-		/* custom variables */
-		for (temp_customvariablesmember = temp_contact->custom_variables; temp_customvariablesmember != NULL; temp_customvariablesmember = temp_customvariablesmember->next) {
-			if (temp_customvariablesmember->variable_name)
-				fprintf(fp, "\t_%s=%d;%s\n", temp_customvariablesmember->variable_name, temp_customvariablesmember->has_been_modified, (temp_customvariablesmember->variable_value == NULL) ? "" : temp_customvariablesmember->variable_value);
-		}
-		fprintf(fp, "\t}\n\n");
-	}
+	for (temp_contact = contact_list, x = 0; temp_contact != NULL && result == OK; temp_contact = temp_contact->next, x++)
+		result = xsddefault_write_status_block(fd, iov, &iov_count, &xsddefault_contact_cache, x, temp_contact, xsddefault_contact_status, &out, NULL, 0);
+
+	if (result == OK)
+		result = xsddefault_writev(fd, iov, iov_count);
+	my_free(out.buffer);
 
 	/* save all comments */
 	for (temp_comment = comment_list; temp_comment != NULL; temp_comment = temp_comment->next) {
@@ -654,10 +1000,11 @@ int xsddefault_save_status_data(void) {
 	fsync(fd);
 
 	/* close the temp file */
-	result = fclose(fp);
+	if (fclose(fp) != 0)
+		result = ERROR;
 
 	/* save/close was successful */
-	if (result == 0) {
+	if (result == OK) {
 
 		result = OK;
 